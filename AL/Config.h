@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef ALCONFIG_INCLUDED
 #define ALCONFIG_INCLUDED
 
-#define ALSUPPORT_CONFIG_HAVE_OPENAL 1
+#define ALSUPPORT_CONFIG_HAVE_OPENAL 0
 
 #if ALSUPPORT_CONFIG_HAVE_OPENAL
 #ifdef __APPLE__
@@ -0,0 +1,208 @@
+/***********************************************************************
+BlockCodec - Class implementing a fast byte-oriented LZ77 codec to
+compress blocks of data sent over cluster pipes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Cluster/BlockCodec.h>
+
+#include <string.h>
+#include <stdexcept>
+
+namespace Cluster {
+
+/***********************************************************************
+Compressed block format: A compressed block is a sequence of
+(literals, match) pairs, each starting with a token byte containing the
+number of literals in its high nibble and the match length minus 4 in
+its low nibble. A nibble of 15 indicates that the length continues in
+following bytes, which are added until a byte less than 255 is found.
+The token is followed by the literals, a two-byte little-endian match
+offset, and the match length continuation. The last pair in a block
+consists of literals only.
+***********************************************************************/
+
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+const size_t minMatchLength=4; // Minimum length of a match
+const size_t maxMatchOffset=65535; // Maximum distance between a match and its source
+
+/****************
+Helper functions:
+****************/
+
+inline Misc::UInt32 read32(const BlockCodec::Byte* ptr)
+	{
+	Misc::UInt32 result;
+	memcpy(&result,ptr,sizeof(Misc::UInt32));
+	return result;
+	}
+
+inline BlockCodec::Byte* writeLength(BlockCodec::Byte* destPtr,size_t length)
+	{
+	/* Write the length continuation as a sequence of 255s and a final remainder: */
+	for(;length>=255;length-=255)
+		*(destPtr++)=255;
+	*(destPtr++)=BlockCodec::Byte(length);
+	return destPtr;
+	}
+
+inline size_t readLength(const BlockCodec::Byte*& sourcePtr,const BlockCodec::Byte* sourceEnd,size_t length)
+	{
+	/* Add the length continuation if the length nibble is saturated: */
+	if(length==15)
+		{
+		BlockCodec::Byte b;
+		do
+			{
+			if(sourcePtr==sourceEnd)
+				throw std::runtime_error("Cluster::BlockCodec::decompress: Truncated block");
+			b=*(sourcePtr++);
+			length+=b;
+			}
+		while(b==255);
+		}
+	return length;
+	}
+
+}
+
+/***************************
+Methods of class BlockCodec:
+***************************/
+
+BlockCodec::BlockCodec(void)
+	{
+	memset(hashTable,0,sizeof(hashTable));
+	}
+
+size_t BlockCodec::compress(const BlockCodec::Byte* source,size_t sourceSize,BlockCodec::Byte* dest,size_t destCapacity)
+	{
+	/* Reset the match finder's hash table: */
+	memset(hashTable,0,sizeof(hashTable));
+	
+	const Byte* sourceEnd=source+sourceSize;
+	Byte* destPtr=dest;
+	Byte* destEnd=dest+destCapacity;
+	
+	/* Find matches until there are not enough bytes left to form a match: */
+	const Byte* anchor=source;
+	const Byte* sourcePtr=source;
+	while(sourceEnd-sourcePtr>=ptrdiff_t(minMatchLength))
+		{
+		/* Look up the most recent occurrence of the next four bytes: */
+		Misc::UInt32 sequence=read32(sourcePtr);
+		Misc::UInt32& entry=hashTable[(sequence*2654435761U)>>(32-hashTableBits)];
+		const Byte* matchPtr=entry!=0?source+(entry-1):0;
+		entry=Misc::UInt32(sourcePtr-source)+1;
+		if(matchPtr==0||size_t(sourcePtr-matchPtr)>maxMatchOffset||read32(matchPtr)!=sequence)
+			{
+			/* Skip ahead faster the longer no match has been found: */
+			sourcePtr+=1+((sourcePtr-anchor)>>6);
+			continue;
+			}
+		
+		/* Extend the match: */
+		size_t matchLength=minMatchLength;
+		while(sourcePtr+matchLength!=sourceEnd&&matchPtr[matchLength]==sourcePtr[matchLength])
+			++matchLength;
+		
+		/* Check if the pair fits into the destination buffer, assuming worst-case length continuations: */
+		size_t literalLength=sourcePtr-anchor;
+		if(size_t(destEnd-destPtr)<1+literalLength/255+1+literalLength+2+matchLength/255+1)
+			return 0;
+		
+		/* Write the (literals, match) pair: */
+		size_t matchCode=matchLength-minMatchLength;
+		*(destPtr++)=Byte(((literalLength<15?literalLength:15)<<4)|(matchCode<15?matchCode:15));
+		if(literalLength>=15)
+			destPtr=writeLength(destPtr,literalLength-15);
+		memcpy(destPtr,anchor,literalLength);
+		destPtr+=literalLength;
+		size_t offset=sourcePtr-matchPtr;
+		*(destPtr++)=Byte(offset&0xffU);
+		*(destPtr++)=Byte(offset>>8);
+		if(matchCode>=15)
+			destPtr=writeLength(destPtr,matchCode-15);
+		
+		/* Continue after the match: */
+		sourcePtr+=matchLength;
+		anchor=sourcePtr;
+		}
+	
+	/* Write the final literals: */
+	size_t literalLength=sourceEnd-anchor;
+	if(size_t(destEnd-destPtr)<1+literalLength/255+1+literalLength)
+		return 0;
+	*(destPtr++)=Byte((literalLength<15?literalLength:15)<<4);
+	if(literalLength>=15)
+		destPtr=writeLength(destPtr,literalLength-15);
+	memcpy(destPtr,anchor,literalLength);
+	destPtr+=literalLength;
+	
+	return destPtr-dest;
+	}
+
+size_t BlockCodec::decompress(const BlockCodec::Byte* source,size_t sourceSize,BlockCodec::Byte* dest,size_t destCapacity)
+	{
+	const Byte* sourcePtr=source;
+	const Byte* sourceEnd=source+sourceSize;
+	Byte* destPtr=dest;
+	Byte* destEnd=dest+destCapacity;
+	
+	while(sourcePtr!=sourceEnd)
+		{
+		/* Read the next pair's token: */
+		Byte token=*(sourcePtr++);
+		
+		/* Copy the literals: */
+		size_t literalLength=readLength(sourcePtr,sourceEnd,token>>4);
+		if(size_t(sourceEnd-sourcePtr)<literalLength||size_t(destEnd-destPtr)<literalLength)
+			throw std::runtime_error("Cluster::BlockCodec::decompress: Corrupted block");
+		memcpy(destPtr,sourcePtr,literalLength);
+		sourcePtr+=literalLength;
+		destPtr+=literalLength;
+		
+		/* Check for the end of the block: */
+		if(sourcePtr==sourceEnd)
+			break;
+		
+		/* Read the match offset and length: */
+		if(sourceEnd-sourcePtr<2)
+			throw std::runtime_error("Cluster::BlockCodec::decompress: Truncated block");
+		size_t offset=size_t(sourcePtr[0])|(size_t(sourcePtr[1])<<8);
+		sourcePtr+=2;
+		size_t matchLength=readLength(sourcePtr,sourceEnd,token&0x0fU)+minMatchLength;
+		if(offset==0||size_t(destPtr-dest)<offset||size_t(destEnd-destPtr)<matchLength)
+			throw std::runtime_error("Cluster::BlockCodec::decompress: Corrupted block");
+		
+		/* Copy the match byte by byte, as it may overlap the bytes it produces: */
+		const Byte* matchPtr=destPtr-offset;
+		for(Byte* matchEnd=destPtr+matchLength;destPtr!=matchEnd;++destPtr,++matchPtr)
+			*destPtr=*matchPtr;
+		}
+	
+	return destPtr-dest;
+	}
+
+}
@@ -0,0 +1,54 @@
+/***********************************************************************
+BlockCodec - Class implementing a fast byte-oriented LZ77 codec to
+compress blocks of data sent over cluster pipes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef CLUSTER_BLOCKCODEC_INCLUDED
+#define CLUSTER_BLOCKCODEC_INCLUDED
+
+#include <stddef.h>
+#include <Misc/SizedTypes.h>
+
+namespace Cluster {
+
+class BlockCodec
+	{
+	/* Embedded classes: */
+	public:
+	typedef unsigned char Byte; // Type for uncompressed and compressed data
+	
+	private:
+	static const int hashTableBits=12; // Number of bits in the match finder's hash table index
+	
+	/* Elements: */
+	Misc::UInt32 hashTable[1<<hashTableBits]; // Hash table mapping 4-byte sequences to their most recent positions in the current block, plus one
+	
+	/* Constructors and destructors: */
+	public:
+	BlockCodec(void); // Creates a codec
+	
+	/* Methods: */
+	size_t compress(const Byte* source,size_t sourceSize,Byte* dest,size_t destCapacity); // Compresses the given source block into the given destination buffer; returns the compressed size, or 0 if the compressed block would not fit into the destination buffer
+	static size_t decompress(const Byte* source,size_t sourceSize,Byte* dest,size_t destCapacity); // Decompresses the given compressed block into the given destination buffer; returns the decompressed size; throws exception if the compressed block is corrupted or does not fit into the destination buffer
+	};
+
+}
+
+#endif
@@ -2,7 +2,7 @@
 MulticastPipe - Class to represent data streams between a single master
 and several slaves, with the bulk of communication from the master to
 all the slaves in parallel.
-Copyright (c) 2005-2015 Oliver Kreylos
+Copyright (c) 2005-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -23,18 +23,184 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <Cluster/MulticastPipe.h>
 
+#include <string.h>
+#include <Misc/SizedTypes.h>
 #include <Misc/ThrowStdErr.h>
+#include <Realtime/Time.h>
 #include <Cluster/Packet.h>
 #include <Cluster/Multiplexer.h>
+#include <Cluster/BlockCodec.h>
 
 namespace Cluster {
 
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+const size_t compressionBlockSize=65536; // Size of write and read buffers of compressed pipes
+const size_t minCompressSize=64; // Blocks smaller than this are always sent uncompressed
+const Misc::UInt32 compressedBlockFlag=0x80000000U; // Flag in a block header indicating a compressed block
+const unsigned int maxBypassInterval=32; // Maximum number of blocks sent uncompressed after an incompressible block
+
+}
+
 /******************************
 Methods of class MulticastPipe:
 ******************************/
 
+void MulticastPipe::sendPackets(Packet* const packets[],unsigned int numPackets)
+	{
+	if(async)
+		{
+		/* Append the packets to the current message: */
+		for(unsigned int i=0;i<numPackets;++i)
+			{
+			packets[i]->succ=0;
+			if(messageTail!=0)
+				messageTail->succ=packets[i];
+			else
+				messageHead=packets[i];
+			messageTail=packets[i];
+			}
+		messageNumPackets+=numPackets;
+		}
+	else
+		{
+		/* Pass the packets to the multiplexer: */
+		multiplexer->sendPackets(pipeId,packets,numPackets);
+		}
+	}
+
+void MulticastPipe::sendBlock(const IO::File::Byte* buffer,size_t bufferSize)
+	{
+	/* Try compressing the block unless it is too small or recent blocks were incompressible: */
+	const Byte* payload=buffer;
+	size_t payloadSize=bufferSize;
+	Misc::UInt32 header=0U;
+	if(bufferSize>=minCompressSize)
+		{
+		if(numBypassBlocks==0)
+			{
+			/* Only accept the compressed block if it saves at least one eighth of the block's size: */
+			Realtime::TimePointMonotonic compressStart;
+			size_t compressedSize=codec->compress(buffer,bufferSize,compressBuffer,bufferSize-bufferSize/8);
+			compressionStatistics.codecTime+=double(compressStart.setAndDiff());
+			if(compressedSize!=0)
+				{
+				payload=compressBuffer;
+				payloadSize=compressedSize;
+				header=compressedBlockFlag;
+				bypassInterval=0;
+				}
+			else
+				{
+				/* Send the next blocks uncompressed, backing off exponentially while data remains incompressible: */
+				bypassInterval=bypassInterval==0?1:(bypassInterval*2<maxBypassInterval?bypassInterval*2:maxBypassInterval);
+				numBypassBlocks=bypassInterval;
+				}
+			}
+		else
+			--numBypassBlocks;
+		}
+	header|=Misc::UInt32(payloadSize);
+	
+	/* Update the compression statistics: */
+	++compressionStatistics.numBlocks;
+	if(header&compressedBlockFlag)
+		++compressionStatistics.numCompressedBlocks;
+	compressionStatistics.numUncompressedBytes+=bufferSize;
+	compressionStatistics.numSentBytes+=sizeof(Misc::UInt32)+payloadSize;
+	
+	/* Split the block header and payload into packets and pass them to the multiplexer in batches: */
+	Packet* batch[Multiplexer::maxBatchSize];
+	unsigned int batchSize=0;
+	bool first=true;
+	while(first||payloadSize>0)
+		{
+		Packet* sendPacket=multiplexer->newPacket();
+		size_t packetPos=0;
+		if(first)
+			{
+			/* Write the block header into the first packet: */
+			memcpy(sendPacket->packet,&header,sizeof(Misc::UInt32));
+			packetPos=sizeof(Misc::UInt32);
+			first=false;
+			}
+		size_t copySize=packetDataSize-packetPos;
+		if(copySize>payloadSize)
+			copySize=payloadSize;
+		memcpy(sendPacket->packet+packetPos,payload,copySize);
+		sendPacket->packetSize=packetPos+copySize;
+		payload+=copySize;
+		payloadSize-=copySize;
+		
+		batch[batchSize]=sendPacket;
+		if(++batchSize==Multiplexer::maxBatchSize||payloadSize==0)
+			{
+			sendPackets(batch,batchSize);
+			batchSize=0;
+			}
+		}
+	}
+
+size_t MulticastPipe::receiveBlock(IO::File::Byte* buffer,size_t bufferSize)
+	{
+	/* Receive the first packet and read the block header: */
+	Packet* receivedPacket=multiplexer->receivePacket(pipeId);
+	Misc::UInt32 header;
+	memcpy(&header,receivedPacket->packet,sizeof(Misc::UInt32));
+	size_t payloadSize=header&~compressedBlockFlag;
+	bool blockCompressed=(header&compressedBlockFlag)!=0U;
+	if(payloadSize>bufferSize)
+		{
+		multiplexer->deletePacket(receivedPacket);
+		Misc::throwStdErr("Cluster::MulticastPipe: Received oversized block");
+		}
+	
+	/* Collect the payload from the first and following packets: */
+	Byte* payload=blockCompressed?compressBuffer:buffer;
+	size_t packetPos=sizeof(Misc::UInt32);
+	size_t received=0;
+	while(true)
+		{
+		size_t copySize=receivedPacket->packetSize-packetPos;
+		if(copySize>payloadSize-received)
+			copySize=payloadSize-received;
+		memcpy(payload+received,receivedPacket->packet+packetPos,copySize);
+		received+=copySize;
+		multiplexer->deletePacket(receivedPacket);
+		if(received==payloadSize)
+			break;
+		receivedPacket=multiplexer->receivePacket(pipeId);
+		packetPos=0;
+		}
+	
+	/* Update the compression statistics: */
+	++compressionStatistics.numBlocks;
+	compressionStatistics.numSentBytes+=sizeof(Misc::UInt32)+payloadSize;
+	
+	size_t blockSize=payloadSize;
+	if(blockCompressed)
+		{
+		/* Decompress the block into the given buffer: */
+		Realtime::TimePointMonotonic decompressStart;
+		blockSize=BlockCodec::decompress(compressBuffer,payloadSize,buffer,bufferSize);
+		compressionStatistics.codecTime+=double(decompressStart.setAndDiff());
+		++compressionStatistics.numCompressedBlocks;
+		}
+	compressionStatistics.numUncompressedBytes+=blockSize;
+	
+	return blockSize;
+	}
+
 size_t MulticastPipe::readData(IO::File::Byte* buffer,size_t bufferSize)
 	{
+	/* Receive the next block into the read buffer if the pipe is compressed: */
+	if(compressed)
+		return receiveBlock(buffer,bufferSize);
+	
 	/* Delete the current (completely read) packet: */
 	if(packet!=0)
 		{
@@ -54,32 +220,80 @@ size_t MulticastPipe::readData(IO::File::Byte* buffer,size_t bufferSize)
 
 void MulticastPipe::writeData(const IO::File::Byte* buffer,size_t bufferSize)
 	{
-	/* Pass the current packet to the multiplexer: */
-	{
-	Packet* sendPacket=packet;
-	packet=0;
-	sendPacket->packetSize=bufferSize;
-	multiplexer->sendPacket(pipeId,sendPacket);
-	}
+	/* Split the data into blocks if the pipe is compressed: */
+	if(compressed)
+		{
+		while(bufferSize>compressionBlockSize)
+			{
+			sendBlock(buffer,compressionBlockSize);
+			buffer+=compressionBlockSize;
+			bufferSize-=compressionBlockSize;
+			}
+		sendBlock(buffer,bufferSize);
+		return;
+		}
 	
-	/* Install a fresh cluster packet as the write buffer: */
-	packet=multiplexer->newPacket();
-	setWriteBuffer(Packet::maxPacketSize,reinterpret_cast<Byte*>(packet->packet),false);
+	/* Check if the data is in the write buffer or is written through from the caller's buffer: */
+	if(buffer==reinterpret_cast<Byte*>(packet->packet))
+		{
+		/* Pass the current packet to the multiplexer: */
+		{
+		Packet* sendPacket=packet;
+		packet=0;
+		sendPacket->packetSize=bufferSize;
+		sendPackets(&sendPacket,1);
+		}
+		
+		/* Install a fresh cluster packet as the write buffer: */
+		packet=multiplexer->newPacket();
+		setWriteBuffer(packetDataSize,reinterpret_cast<Byte*>(packet->packet),false);
+		}
+	else
+		{
+		/* Split the data into full-sized packets and pass them to the multiplexer in batches: */
+		Packet* batch[Multiplexer::maxBatchSize];
+		while(bufferSize>=packetDataSize)
+			{
+			unsigned int batchSize=0;
+			while(batchSize<Multiplexer::maxBatchSize&&bufferSize>=packetDataSize)
+				{
+				Packet* sendPacket=multiplexer->newPacket();
+				memcpy(sendPacket->packet,buffer,packetDataSize);
+				sendPacket->packetSize=packetDataSize;
+				batch[batchSize]=sendPacket;
+				++batchSize;
+				buffer+=packetDataSize;
+				bufferSize-=packetDataSize;
+				}
+			sendPackets(batch,batchSize);
+			}
+		
+		/* Copy the remaining data into the (empty) write buffer: */
+		memcpy(packet->packet,buffer,bufferSize);
+		setWritePtr(bufferSize);
+		}
 	}
 
 size_t MulticastPipe::writeDataUpTo(const IO::File::Byte* buffer,size_t bufferSize)
 	{
+	/* Send the write buffer as a single block if the pipe is compressed: */
+	if(compressed)
+		{
+		sendBlock(buffer,bufferSize);
+		return bufferSize;
+		}
+	
 	/* Pass the current packet to the multiplexer: */
 	{
 	Packet* sendPacket=packet;
 	packet=0;
 	sendPacket->packetSize=bufferSize;
-	multiplexer->sendPacket(pipeId,sendPacket);
+	sendPackets(&sendPacket,1);
 	}
 	
 	/* Install a fresh cluster packet as the write buffer: */
 	packet=multiplexer->newPacket();
-	setWriteBuffer(Packet::maxPacketSize,reinterpret_cast<Byte*>(packet->packet),false);
+	setWriteBuffer(packetDataSize,reinterpret_cast<Byte*>(packet->packet),false);
 	
 	return bufferSize;
 	}
@@ -88,21 +302,48 @@ void MulticastPipe::flushPipe(void)
 	{
 	/* Call IO::File's flush method: */
 	flush();
+	
+	/* Queue all written data as a message in asynchronous mode: */
+	if(async)
+		finishMessage();
 	}
 
-MulticastPipe::MulticastPipe(Multiplexer* sMultiplexer)
+MulticastPipe::MulticastPipe(Multiplexer* sMultiplexer,bool sCompressed)
 	:IO::File(),ClusterPipe(sMultiplexer),
-	 packet(0)
+	 packetDataSize(multiplexer->getMaxPacketDataSize()),
+	 packet(0),
+	 compressed(sCompressed),codec(0),compressBuffer(0),
+	 bypassInterval(0),numBypassBlocks(0),
+	 async(false),messageHead(0),messageTail(0),messageNumPackets(0),
+	 framed(false),lastMessageIndex(0)
 	{
 	/* Set up the master or slave buffers: */
-	if(isMaster())
+	if(compressed)
+		{
+		/* Install a large write or read buffer holding uncompressed blocks, and a buffer for compressed blocks: */
+		compressBuffer=new Byte[compressionBlockSize];
+		if(isMaster())
+			{
+			codec=new BlockCodec;
+			IO::File::resizeWriteBuffer(compressionBlockSize);
+			
+			/* Enable direct writes to compress large blocks of data straight from the caller's buffer: */
+			canWriteThrough=true;
+			}
+		else
+			{
+			IO::File::resizeReadBuffer(compressionBlockSize);
+			canReadThrough=false;
+			}
+		}
+	else if(isMaster())
 		{
 		/* Install a fresh cluster packet as the write buffer: */
 		packet=multiplexer->newPacket();
-		setWriteBuffer(Packet::maxPacketSize,reinterpret_cast<Byte*>(packet->packet),false);
+		setWriteBuffer(packetDataSize,reinterpret_cast<Byte*>(packet->packet),false);
 		
-		/* Disable direct writes: */
-		canWriteThrough=false;
+		/* Enable direct writes to send large blocks of data in batches of packets: */
+		canWriteThrough=true;
 		}
 	else
 		{
@@ -113,7 +354,24 @@ MulticastPipe::MulticastPipe(Multiplexer* sMultiplexer)
 
 MulticastPipe::~MulticastPipe(void)
 	{
-	if(isMaster())
+	if(compressed)
+		{
+		/* Send the final block: */
+		if(isMaster())
+			{
+			flush();
+			if(async)
+				{
+				/* Wait for room in the asynchronous send queue and queue the final message: */
+				multiplexer->flushAsync(pipeId);
+				finishMessage();
+				}
+			}
+		
+		delete codec;
+		delete[] compressBuffer;
+		}
+	else if(isMaster())
 		{
 		/* Check if there is unsent data in the write buffer: */
 		size_t unwrittenSize=getWritePtr();
@@ -124,10 +382,17 @@ MulticastPipe::~MulticastPipe(void)
 			Packet* sendPacket=packet;
 			packet=0;
 			sendPacket->packetSize=unwrittenSize;
-			multiplexer->sendPacket(pipeId,sendPacket);
+			sendPackets(&sendPacket,1);
 			}
 			}
 		
+		if(async)
+			{
+			/* Wait for room in the asynchronous send queue and queue the final message: */
+			multiplexer->flushAsync(pipeId);
+			finishMessage();
+			}
+		
 		/* Uninstall the buffered file's write buffer: */
 		setWriteBuffer(0,0,false);
 		}
@@ -144,20 +409,20 @@ MulticastPipe::~MulticastPipe(void)
 
 size_t MulticastPipe::getReadBufferSize(void) const
 	{
-	/* Return the maximum cluster packet size: */
-	return Packet::maxPacketSize;
+	/* Return the maximum cluster packet size, or the block size of a compressed pipe: */
+	return compressed?compressionBlockSize:Packet::maxPacketSize;
 	}
 
 size_t MulticastPipe::getWriteBufferSize(void) const
 	{
-	/* Return the maximum cluster packet size: */
-	return Packet::maxPacketSize;
+	/* Return the maximum amount of data per cluster packet, or the block size of a compressed pipe: */
+	return compressed?compressionBlockSize:packetDataSize;
 	}
 
 size_t MulticastPipe::resizeReadBuffer(size_t newReadBufferSize)
 	{
-	/* Ignore the request and return the maximum cluster packet size: */
-	return Packet::maxPacketSize;
+	/* Ignore the request and return the maximum cluster packet size, or the block size of a compressed pipe: */
+	return compressed?compressionBlockSize:Packet::maxPacketSize;
 	}
 
 void MulticastPipe::resizeWriteBuffer(size_t newWriteBufferSize)
@@ -165,4 +430,135 @@ void MulticastPipe::resizeWriteBuffer(size_t newWriteBufferSize)
 	/* Ignore the request */
 	}
 
+void MulticastPipe::bulkBroadcast(void* data,size_t dataSize)
+	{
+	if(isMaster())
+		{
+		/* Send all buffered data ahead of the bulk transfer: */
+		flush();
+		if(async)
+			finishMessage();
+		
+		/* Send the data directly from the caller's buffer: */
+		multiplexer->sendBulk(pipeId,data,dataSize);
+		}
+	else
+		{
+		/* Check that the bulk transfer does not overtake unread data: */
+		if(getUnreadDataSize()!=0)
+			Misc::throwStdErr("Cluster::MulticastPipe::bulkBroadcast: Unread data in pipe");
+		
+		/* Receive the data directly into the caller's buffer: */
+		multiplexer->receiveBulk(pipeId,data,dataSize);
+		}
+	}
+
+void MulticastPipe::setAsyncSend(unsigned int asyncQueueSize,Multiplexer::AsyncQueuePolicy asyncQueuePolicy)
+	{
+	/* Asynchronous sending only affects the master: */
+	if(!isMaster())
+		return;
+	
+	/* Queue all data written in asynchronous mode before switching modes: */
+	if(async)
+		{
+		flush();
+		finishMessage();
+		}
+	
+	/* Configure the pipe's asynchronous send queue: */
+	multiplexer->setAsyncSend(pipeId,asyncQueueSize,asyncQueuePolicy);
+	async=asyncQueueSize>0;
+	
+	/* Frame messages if the multiplexer might drop some of them: */
+	framed=async&&asyncQueuePolicy==Multiplexer::ASYNC_DROP_OLDEST;
+	}
+
+unsigned int MulticastPipe::finishMessage(Multiplexer::AsyncSendCallback* callback)
+	{
+	if(!async)
+		{
+		/* Send all buffered data and report it as sent: */
+		flush();
+		if(callback!=0)
+			{
+			Multiplexer::AsyncSendResult result;
+			result.pipeId=pipeId;
+			result.messageId=0;
+			result.messageSize=0;
+			result.sent=true;
+			(*callback)(result);
+			delete callback;
+			}
+		return 0;
+		}
+	
+	/* Move all buffered data into the current message: */
+	flush();
+	
+	/* Don't bother queueing an empty message nobody is waiting for: */
+	if(messageNumPackets==0&&callback==0)
+		return 0;
+	
+	if(framed&&messageNumPackets>0)
+		{
+		/* Detach the message's packets: */
+		Packet* bodyHead=messageHead;
+		Packet* bodyTail=messageTail;
+		unsigned int bodyNumPackets=messageNumPackets;
+		messageHead=0;
+		messageTail=0;
+		messageNumPackets=0;
+		
+		/* Start the message with a header containing its sequence number, so that slaves can detect dropped messages: */
+		Misc::UInt32 header=++lastMessageIndex;
+		if(compressed)
+			sendBlock(reinterpret_cast<const Byte*>(&header),sizeof(Misc::UInt32));
+		else
+			{
+			Packet* headerPacket=multiplexer->newPacket();
+			memcpy(headerPacket->packet,&header,sizeof(Misc::UInt32));
+			headerPacket->packetSize=sizeof(Misc::UInt32);
+			sendPackets(&headerPacket,1);
+			}
+		
+		/* Append the message's packets to the header: */
+		messageTail->succ=bodyHead;
+		messageTail=bodyTail;
+		messageNumPackets+=bodyNumPackets;
+		}
+	
+	/* Pass the current message to the multiplexer: */
+	Packet* packets=messageHead;
+	unsigned int numPackets=messageNumPackets;
+	messageHead=0;
+	messageTail=0;
+	messageNumPackets=0;
+	return multiplexer->sendAsync(pipeId,packets,numPackets,callback);
+	}
+
+void MulticastPipe::flushAsync(void)
+	{
+	if(isMaster())
+		{
+		/* Queue the current message and wait until the queue has drained: */
+		finishMessage();
+		multiplexer->flushAsync(pipeId);
+		}
+	}
+
+unsigned int MulticastPipe::beginMessage(void)
+	{
+	if(isMaster())
+		return 0;
+	
+	/* Read the message header and compare its sequence number to that of the previous message: */
+	Misc::UInt32 header;
+	readRaw(&header,sizeof(Misc::UInt32));
+	unsigned int numDropped=header-lastMessageIndex-1U;
+	lastMessageIndex=header;
+	
+	return numDropped;
+	}
+
 }
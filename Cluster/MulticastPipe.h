@@ -2,7 +2,7 @@
 MulticastPipe - Class to represent data streams between a single master
 and several slaves, with the bulk of communication from the master to
 all the slaves in parallel.
-Copyright (c) 2005-2015 Oliver Kreylos
+Copyright (c) 2005-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -25,22 +25,63 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #define CLUSTER_MULTICASTPIPE_INCLUDED
 
 #include <stddef.h>
+#include <Misc/SizedTypes.h>
 #include <IO/File.h>
+#include <Cluster/Multiplexer.h>
 #include <Cluster/ClusterPipe.h>
 
 /* Forward declarations: */
 namespace Cluster {
 struct Packet;
+class BlockCodec;
 }
 
 namespace Cluster {
 
 class MulticastPipe:public IO::File,public ClusterPipe
 	{
+	/* Embedded classes: */
+	public:
+	struct CompressionStatistics // Structure reporting the effect of a pipe's compression stage
+		{
+		/* Elements: */
+		public:
+		size_t numBlocks; // Number of blocks sent or received
+		size_t numCompressedBlocks; // Number of blocks sent or received in compressed form
+		size_t numUncompressedBytes; // Total size of all blocks before compression
+		size_t numSentBytes; // Total size of all blocks as sent or received across the network, including block headers
+		double codecTime; // Total time spent compressing blocks on the master or decompressing blocks on the slaves in seconds
+		
+		/* Constructors and destructors: */
+		CompressionStatistics(void)
+			:numBlocks(0),numCompressedBlocks(0),numUncompressedBytes(0),numSentBytes(0),
+			 codecTime(0.0)
+			{
+			}
+		};
+	
 	/* Elements: */
 	private:
+	size_t packetDataSize; // Maximum amount of data written into each packet
 	Packet* packet; // Pointer to current packet
 	size_t packetPos; // Data position in current packet
+	bool compressed; // Flag whether data is sent through the pipe in compressed blocks
+	BlockCodec* codec; // Codec to compress blocks on the master
+	Byte* compressBuffer; // Buffer holding a compressed block
+	unsigned int bypassInterval; // Number of blocks to send uncompressed after the most recent incompressible block
+	unsigned int numBypassBlocks; // Number of blocks still to be sent uncompressed before trying compression again
+	CompressionStatistics compressionStatistics; // Statistics of the pipe's compression stage
+	bool async; // Flag whether the pipe sends data asynchronously in messages
+	Packet* messageHead; // First packet of the message currently being written in asynchronous mode
+	Packet* messageTail; // Last packet of the message currently being written in asynchronous mode
+	unsigned int messageNumPackets; // Number of packets in the message currently being written in asynchronous mode
+	bool framed; // Flag whether each message sent in asynchronous mode starts with a header containing its sequence number, to let slaves detect dropped messages
+	Misc::UInt32 lastMessageIndex; // Sequence number of the most recently sent framed message on the master, or the most recently received framed message on a slave
+	
+	/* Private methods: */
+	void sendPackets(Packet* const packets[],unsigned int numPackets); // Passes the given packets to the multiplexer, or appends them to the current message in asynchronous mode
+	void sendBlock(const Byte* buffer,size_t bufferSize); // Compresses the given block if it is compressible and sends it to the slaves
+	size_t receiveBlock(Byte* buffer,size_t bufferSize); // Receives a block from the master and decompresses it into the given buffer if necessary
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -53,7 +94,7 @@ class MulticastPipe:public IO::File,public ClusterPipe
 	
 	/* Constructors and destructors: */
 	public:
-	MulticastPipe(Multiplexer* sMultiplexer); // Creates new pipe for the given multiplexer
+	MulticastPipe(Multiplexer* sMultiplexer,bool sCompressed =false); // Creates new pipe for the given multiplexer; pipe compresses data in large blocks if flag is true, which must be the same on all nodes
 	private:
 	MulticastPipe(const MulticastPipe& source); // Prohibit copy constructor
 	MulticastPipe& operator=(const MulticastPipe& source); // Prohibit assignment operato
@@ -85,6 +126,23 @@ class MulticastPipe:public IO::File,public ClusterPipe
 		else
 			readRaw(data,sizeof(DataParam)*numItems);
 		}
+	void bulkBroadcast(void* data,size_t dataSize); // Sends a large block of data from master to all slaves directly from the master's buffer into the slaves' buffers; slaves must have read all data previously written to the pipe
+	bool isCompressed(void) const // Returns true if the pipe compresses data
+		{
+		return compressed;
+		}
+	const CompressionStatistics& getCompressionStatistics(void) const // Returns the statistics of the pipe's compression stage
+		{
+		return compressionStatistics;
+		}
+	void setAsyncSend(unsigned int asyncQueueSize,Multiplexer::AsyncQueuePolicy asyncQueuePolicy =Multiplexer::ASYNC_BLOCK); // Sends data written on the master asynchronously in messages through a queue holding up to the given number of packets, applying the given policy when the queue is full; 0 returns to synchronous sending; ignored on slaves; with the ASYNC_DROP_OLDEST policy, each non-empty message starts with a header that slaves must read via beginMessage, and messages must be finished before calling flushPipe, barrier, gather, or bulkBroadcast, which implicitly end the current message
+	bool isAsync(void) const // Returns true if the pipe sends data asynchronously
+		{
+		return async;
+		}
+	unsigned int finishMessage(Multiplexer::AsyncSendCallback* callback =0); // Queues all data written since the previous message as a new message without waiting for the slaves; pipe adopts the optional callback object, which is called when the message has been sent or dropped; returns the message's sequence number; flushes and reports immediately on synchronous pipes
+	void flushAsync(void); // Finishes the current message and blocks until all queued messages have been sent
+	unsigned int beginMessage(void); // Starts reading the next non-empty message on a slave when the master sends with the ASYNC_DROP_OLDEST policy; returns the number of messages the master dropped since the previously read message; does nothing and returns 0 on the master
 	};
 
 }
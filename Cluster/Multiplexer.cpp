@@ -32,8 +32,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <algorithm>
 #include <Misc/ThrowStdErr.h>
+#include <Realtime/Time.h>
 #include <Cluster/Config.h>
+#if CLUSTER_CONFIG_HAVE_MMSG
+#include <stdint.h>
+#include <netinet/udp.h>
+#endif
 
 #if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 #include <iostream>
@@ -43,6 +49,29 @@ namespace Cluster {
 
 namespace {
 
+/****************
+Helper constants:
+****************/
+
+const unsigned int fecParityFlag=0x80000000U; // Flag in a packet's pipe ID field marking a forward error correction parity packet
+const unsigned int fecIndexShift=24; // Bit position of a data packet's one-based index in its forward error correction group inside its pipe ID field
+const unsigned int fecIndexMask=0x7fU; // Mask for a data packet's forward error correction group index after shifting
+const unsigned int bulkFlag=0x00800000U; // Flag in a packet's pipe ID field marking a packet of a bulk transfer
+const unsigned int pipeIdMask=0x007fffffU; // Mask to extract the pipe ID from a packet's pipe ID field
+const unsigned int subtreeMessageFlag=0x80000000U; // Value in a message's node index field marking a message from a slave to its parent slave in the barrier tree; would be a parity packet for the non-existent pipe 0
+const unsigned int maxFecPendingPackets=256; // Maximum number of out-of-order packets held back on slaves while waiting for parity packets
+const unsigned int bulkAckInterval=16; // Number of bulk transfer packets received by a slave between acknowledgments
+const unsigned int minBulkWindowSize=2*bulkAckInterval; // Minimum number of unacknowledged packets the master sends ahead during bulk transfers
+const unsigned int initialBulkWindowSize=64; // Number of unacknowledged packets the master sends ahead at the beginning of a bulk transfer
+const size_t maxBulkSegmentSize=size_t(1)<<30; // Maximum amount of data in a single bulk transfer segment, to keep stream positions unambiguous
+const double bulkResendTimeout=0.005; // Time after which the master re-sends unacknowledged bulk transfer packets in seconds
+const double bulkRewindHoldoff=0.002; // Time after re-sending bulk transfer packets during which the master ignores further loss reports for the re-sent packets in seconds
+
+#if CLUSTER_CONFIG_HAVE_MMSG && defined(UDP_SEGMENT)
+const unsigned int maxGsoMessageSize=65535U-CLUSTER_CONFIG_IP_HEADER_SIZE-CLUSTER_CONFIG_UDP_HEADER_SIZE; // Maximum size of a UDP message before segmentation
+const unsigned int maxGsoSegments=maxGsoMessageSize/Packet::maxRawPacketSize<64U?maxGsoMessageSize/Packet::maxRawPacketSize:64U; // Maximum number of packets combined into a single segmentation offload message
+#endif
+
 /****************
 Helper functions:
 ****************/
@@ -53,8 +82,96 @@ inline bool isMulticast(const struct in_addr& netAddress) // Returns true if the
 	return address>=(0xe0<<24)&&address<(0xf0<<24);
 	}
 
+inline void clearParity(Packet* parityPacket) // Resets the parity data in the given parity packet
+	{
+	memset(parityPacket->packet+Multiplexer::fecHeaderSize,0,parityPacket->packetSize);
+	parityPacket->packetSize=0;
+	}
+
+inline void accumulateParity(Packet* parityPacket,const Packet* packet) // Adds the given packet's data to the parity data in the given parity packet
+	{
+	char* pPtr=parityPacket->packet+Multiplexer::fecHeaderSize;
+	for(size_t i=0;i<packet->packetSize;++i)
+		pPtr[i]^=packet->packet[i];
+	
+	/* The parity data is as long as the longest accumulated packet: */
+	if(parityPacket->packetSize<packet->packetSize)
+		parityPacket->packetSize=packet->packetSize;
+	}
+
+inline unsigned int combineGatherValues(unsigned int value,const unsigned int values[],unsigned int numValues,GatherOperation::OpCode op) // Combines the given value with the given array of values using the given gather operation
+	{
+	switch(op)
+		{
+		case GatherOperation::AND:
+			for(unsigned int i=0;i<numValues;++i)
+				value=value&&values[i];
+			break;
+		
+		case GatherOperation::OR:
+			for(unsigned int i=0;i<numValues;++i)
+				value=value||values[i];
+			break;
+		
+		case GatherOperation::MIN:
+			for(unsigned int i=0;i<numValues;++i)
+				if(value>values[i])
+					value=values[i];
+			break;
+		
+		case GatherOperation::MAX:
+			for(unsigned int i=0;i<numValues;++i)
+				if(value<values[i])
+					value=values[i];
+			break;
+		
+		case GatherOperation::SUM:
+			for(unsigned int i=0;i<numValues;++i)
+				value+=values[i];
+			break;
+		
+		case GatherOperation::PRODUCT:
+			for(unsigned int i=0;i<numValues;++i)
+				value*=values[i];
+			break;
+		}
+	
+	return value;
+	}
+
+inline bool comparePipeIds(const Multiplexer::PipeStatistics& ps1,const Multiplexer::PipeStatistics& ps2) // Orders pipe statistics by pipe ID
+	{
+	return ps1.pipeId<ps2.pipeId;
+	}
+
 }
 
+/***********************************************
+Methods of class Multiplexer::WaitTimeHistogram:
+***********************************************/
+
+Multiplexer::WaitTimeHistogram::WaitTimeHistogram(void)
+	:numWaits(0),totalWaitTime(0.0),maxWaitTime(0.0)
+	{
+	for(unsigned int i=0;i<numWaitTimeBins;++i)
+		bins[i]=0;
+	}
+
+void Multiplexer::WaitTimeHistogram::addWait(double waitTime)
+	{
+	/* Update the totals: */
+	++numWaits;
+	totalWaitTime+=waitTime;
+	if(maxWaitTime<waitTime)
+		maxWaitTime=waitTime;
+	
+	/* Find the bin counting the wait: */
+	unsigned int binIndex;
+	for(binIndex=0;binIndex<numWaitTimeBins-1&&waitTime>=getBinLimit(binIndex);++binIndex)
+		;
+	++bins[binIndex];
+	}
+
 /***************************************************
 Methods of class Multiplexer::PipeState::PacketList:
 ***************************************************/
@@ -117,17 +234,18 @@ Packet* Multiplexer::PipeState::PacketList::pop_front(void)
 Methods of class Multiplexer::PipeState:
 ***************************************/
 
-Multiplexer::PipeState::PipeState(unsigned int nodeIndex,unsigned int numSlaves)
+Multiplexer::PipeState::PipeState(unsigned int nodeIndex,unsigned int numSlaves,unsigned int numChildren)
 	:pipeId(0),
 	 streamPos(0),packetLossMode(false),
 	 headStreamPos(0),
 	 slaveStreamPosOffsets(0),numHeadSlaves(0),
 	 barrierId(0),slaveBarrierIds(0),minSlaveBarrierId(0),
-	 slaveGatherValues(0)
-	 #if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-	 ,
-	 numResentPackets(0),numResentBytes(0)
-	 #endif
+	 slaveGatherValues(0),
+	 fecPacket(0),fecGroupStart(0),fecNumPackets(0),fecValid(false),
+	 bulkSendData(0),bulkReceiveData(0),bulkStreamPos(0),bulkSize(0),bulkResendOffset(0),
+	 slaveBulkReadyPos(0),
+	 asyncQueueSize(0),asyncQueuePolicy(ASYNC_BLOCK),
+	 asyncMessageHead(0),asyncMessageTail(0),lastAsyncMessageId(0)
 	{
 	if(nodeIndex==0)
 		{
@@ -137,15 +255,25 @@ Multiplexer::PipeState::PipeState(unsigned int nodeIndex,unsigned int numSlaves)
 			slaveStreamPosOffsets[i]=0;
 		numHeadSlaves=numSlaves;
 		
-		/* Initialize the slave barrier ID array: */
-		slaveBarrierIds=new unsigned int[numSlaves];
+		/* Initialize the slave bulk transfer readiness array: */
+		slaveBulkReadyPos=new unsigned int[numSlaves];
 		for(unsigned int i=0;i<numSlaves;++i)
+			slaveBulkReadyPos[i]=~0U;
+		}
+	
+	/* The master needs entries for all slaves during the flat pipe creation barrier: */
+	unsigned int numEntries=nodeIndex==0?numSlaves:numChildren;
+	if(numEntries>0)
+		{
+		/* Initialize the children's barrier ID array: */
+		slaveBarrierIds=new unsigned int[numEntries];
+		for(unsigned int i=0;i<numEntries;++i)
 			slaveBarrierIds[i]=0;
 		
-		/* Initialize the slave gather value array: */
-		slaveGatherValues=new unsigned int[numSlaves];
-		for(unsigned int i=0;i<numSlaves;++i)
-			slaveBarrierIds[i]=0;
+		/* Initialize the children's gather value array: */
+		slaveGatherValues=new unsigned int[numEntries];
+		for(unsigned int i=0;i<numEntries;++i)
+			slaveGatherValues[i]=0;
 		}
 	}
 
@@ -162,6 +290,21 @@ Multiplexer::PipeState::~PipeState(void)
 	
 	/* Destroy slave gather value array: */
 	delete[] slaveGatherValues;
+	
+	/* Destroy slave bulk transfer readiness array: */
+	delete[] slaveBulkReadyPos;
+	
+	/* Destroy the forward error correction parity packet: */
+	delete fecPacket;
+	
+	/* Destroy all messages remaining in the asynchronous send queue: */
+	while(asyncMessageHead!=0)
+		{
+		AsyncMessage* succ=asyncMessageHead->succ;
+		delete asyncMessageHead->callback;
+		delete asyncMessageHead;
+		asyncMessageHead=succ;
+		}
 	}
 	}
 
@@ -183,7 +326,8 @@ struct Message // Structure for protocol messages exchanged between master and s
 		ACKNOWLEDGMENT, // Signal that slave has received some stream packets
 		PACKETLOSS, // Signal that slave lost a stream packet
 		BARRIER, // Barrier message sent from slaves to master
-		GATHER // Message conveying a slave's gather value in a gather operation
+		GATHER, // Message conveying a slave's gather value in a gather operation
+		BULKREADY // Signal that slave is ready to receive a bulk transfer starting at its current stream position
 		};
 	
 	/* Elements: */
@@ -197,6 +341,22 @@ struct Message // Structure for protocol messages exchanged between master and s
 		}
 	};
 
+struct ConnectionMessage:public Message
+	{
+	/* Elements: */
+	public:
+	unsigned int portNumber; // Port number to which the sending slave's socket is bound, in network byte order
+	unsigned int barrierTreeDegree; // Maximum number of children of each node in the barrier tree
+	unsigned int numParents; // Number of slaves with children in the barrier tree, whose addresses and port numbers in network byte order follow the message
+	
+	/* Constructors and destructors: */
+	ConnectionMessage(unsigned int sNodeIndex,unsigned int sPortNumber,unsigned int sBarrierTreeDegree,unsigned int sNumParents)
+		:Message(sNodeIndex,CONNECTION),
+		 portNumber(sPortNumber),barrierTreeDegree(sBarrierTreeDegree),numParents(sNumParents)
+		{
+		}
+	};
+
 struct PipeMessage:public Message
 	{
 	/* Elements: */
@@ -268,12 +428,128 @@ struct GatherMessage:public BarrierMessage
 		}
 	};
 
+struct SubtreeMessage:public GatherMessage
+	{
+	/* Elements: */
+	public:
+	unsigned int senderIndex; // Index of the slave reporting the arrival of its subtree of the barrier tree
+	
+	/* Constructors and destructors: */
+	SubtreeMessage(int sMessageId,unsigned int sPipeId,unsigned int sBarrierId,unsigned int sValue,unsigned int sSenderIndex)
+		:GatherMessage(subtreeMessageFlag,sMessageId,sPipeId,sBarrierId,sValue),
+		 senderIndex(sSenderIndex)
+		{
+		}
+	};
+
 }
 
 /****************************
 Methods of class Multiplexer:
 ****************************/
 
+void Multiplexer::setBarrierTree(unsigned int newBarrierTreeDegree)
+	{
+	barrierTreeDegree=newBarrierTreeDegree;
+	
+	/* A degree of zero, or one at least as large as the number of slaves, results in a flat tree: */
+	unsigned int degree=barrierTreeDegree!=0&&barrierTreeDegree<numSlaves?barrierTreeDegree:numSlaves;
+	if(degree==0)
+		degree=1;
+	
+	/* Calculate this node's parent and range of children, with the children of node i being nodes i*degree+1 to i*degree+degree: */
+	parentIndex=nodeIndex!=0?(nodeIndex-1)/degree:0;
+	firstChildIndex=nodeIndex*degree+1;
+	numChildren=0;
+	if(firstChildIndex<=numSlaves)
+		{
+		numChildren=numSlaves-firstChildIndex+1;
+		if(numChildren>degree)
+			numChildren=degree;
+		}
+	}
+
+void Multiplexer::recordArrival(Multiplexer::PipeState& pipeState,unsigned int childIndex,unsigned int barrierId)
+	{
+	/* Ignore arrivals from nodes that are not children of this node: */
+	if(childIndex>=numChildren)
+		return;
+	
+	/* Check if this is the child's first message for the current barrier, and whether the barrier had already been completed: */
+	bool newArrival=pipeState.slaveBarrierIds[childIndex]<barrierId;
+	bool wasComplete=pipeState.minSlaveBarrierId>pipeState.barrierId;
+	pipeState.slaveBarrierIds[childIndex]=barrierId;
+	
+	/* Check if the current barrier is complete: */
+	pipeState.minSlaveBarrierId=pipeState.slaveBarrierIds[0];
+	for(unsigned int i=1;i<numChildren;++i)
+		if(pipeState.minSlaveBarrierId>pipeState.slaveBarrierIds[i])
+			pipeState.minSlaveBarrierId=pipeState.slaveBarrierIds[i];
+	if(pipeState.minSlaveBarrierId>pipeState.barrierId)
+		{
+		/* Blame the child for holding up the barrier if it was the last one to arrive: */
+		if(newArrival&&!wasComplete&&nodeIndex==0)
+			{
+			Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+			++slaveStatistics[childIndex].numLastArrivals;
+			}
+		
+		/* Wake up thread waiting on barrier: */
+		pipeState.barrierCond.signal();
+		}
+	}
+
+void Multiplexer::getPipeStatistics(const Multiplexer::PipeState& pipeState,Multiplexer::PipeStatistics& statistics) const
+	{
+	/* Copy the pipe's accumulated statistics: */
+	statistics=pipeState.statistics;
+	statistics.pipeId=pipeState.pipeId;
+	statistics.streamPos=pipeState.streamPos;
+	statistics.maxSlaveLag=0;
+	statistics.maxLagSlaveIndex=0;
+	statistics.numQueuedPackets=pipeState.asyncQueue.size();
+	
+	if(nodeIndex==0)
+		{
+		/* Find the slave that has acknowledged the least amount of the pipe's current stream segment or bulk transfer: */
+		bool bulk=pipeState.bulkSendData!=0;
+		unsigned int segmentStart=bulk?pipeState.bulkStreamPos:pipeState.headStreamPos;
+		unsigned int segmentEnd=bulk?pipeState.bulkStreamPos+pipeState.bulkSize:pipeState.streamPos;
+		for(unsigned int i=0;i<numSlaves;++i)
+			{
+			unsigned int lag=segmentEnd-(segmentStart+pipeState.slaveStreamPosOffsets[i]);
+			if(lag<0x80000000U&&statistics.maxSlaveLag<lag)
+				{
+				statistics.maxSlaveLag=lag;
+				statistics.maxLagSlaveIndex=i+1;
+				}
+			}
+		}
+	}
+
+void Multiplexer::sendArrival(unsigned int pipeId,int messageId,unsigned int barrierId,unsigned int value,bool toMaster)
+	{
+	// SocketMutex::Lock socketLock(socketMutex);
+	if(parentIndex!=0&&!toMaster)
+		{
+		/* Send a subtree message to the parent slave: */
+		SubtreeMessage msg(messageId,pipeId,barrierId,value,nodeIndex);
+		sendto(socketFd,&msg,sizeof(SubtreeMessage),0,(const sockaddr*)parentAddress,sizeof(struct sockaddr_in));
+		}
+	else if(messageId==Message::GATHER)
+		{
+		/* Send a gather message to the master: */
+		GatherMessage msg(nodeIndex|0x80000000U,Message::GATHER,pipeId,barrierId,value);
+		sendto(socketFd,&msg,sizeof(GatherMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+		}
+	else
+		{
+		/* Send a barrier message to the master: */
+		BarrierMessage msg(nodeIndex|0x80000000U,Message::BARRIER,pipeId,barrierId);
+		sendto(socketFd,&msg,sizeof(BarrierMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+		}
+	}
+
 Packet* Multiplexer::allocatePacket(void)
 	{
 	return new Packet;
@@ -281,9 +557,24 @@ Packet* Multiplexer::allocatePacket(void)
 
 void Multiplexer::processAcknowledgment(Multiplexer::LockedPipe& pipeState,int slaveIndex,unsigned int streamPos)
 	{
-	/* Check if the reported stream position points into the packet queue: */
+	if(pipeState->bulkSendData!=0)
+		{
+		/* Track the slave's progress through the current bulk transfer, ignoring stale acknowledgments: */
+		unsigned int bulkOffset=streamPos-pipeState->bulkStreamPos;
+		if(bulkOffset<=pipeState->bulkSize&&pipeState->slaveStreamPosOffsets[slaveIndex]<bulkOffset)
+			{
+			pipeState->slaveStreamPosOffsets[slaveIndex]=bulkOffset;
+			
+			/* Wake up the sender: */
+			pipeState->receiveCond.broadcast();
+			}
+		
+		return;
+		}
+	
+	/* Check if the reported stream position points into the packet queue; ignore stale acknowledgments that arrived out of order: */
 	unsigned int streamPosOffset=streamPos-pipeState->headStreamPos;
-	if(streamPosOffset>0)
+	if(streamPosOffset>0&&streamPosOffset<0x80000000U)
 		{
 		/* Check if the slave had not yet acknowledged the head of the packet list: */
 		if(pipeState->slaveStreamPosOffsets[slaveIndex]==0)
@@ -344,6 +635,10 @@ void Multiplexer::processAcknowledgment(Multiplexer::LockedPipe& pipeState,int s
 						++pipeState->numHeadSlaves;
 					}
 				
+				/* Send packets waiting in the asynchronous send queue into the freed room: */
+				if(!pipeState->asyncQueue.empty())
+					drainAsyncQueue(*pipeState);
+				
 				/* Wake up any callers that might be blocking on a full send queue: */
 				pipeState->receiveCond.broadcast();
 				}
@@ -356,6 +651,441 @@ void Multiplexer::processAcknowledgment(Multiplexer::LockedPipe& pipeState,int s
 		}
 	}
 
+Packet* Multiplexer::finishParityPacket(Multiplexer::PipeState& pipeState)
+	{
+	/* Take the pipe's parity packet: */
+	Packet* result=pipeState.fecPacket;
+	pipeState.fecPacket=0;
+	
+	/* Write the size of the protected stream segment and the number of packets in it into the parity packet's header: */
+	result->pipeId=pipeState.pipeId|fecParityFlag;
+	result->streamPos=pipeState.fecGroupStart;
+	unsigned int header[2];
+	header[0]=pipeState.streamPos-pipeState.fecGroupStart;
+	header[1]=pipeState.fecNumPackets;
+	memcpy(result->packet,header,fecHeaderSize);
+	result->packetSize+=fecHeaderSize;
+	
+	/* Start a new group: */
+	pipeState.fecNumPackets=0;
+	
+	return result;
+	}
+
+unsigned int Multiplexer::queuePackets(Multiplexer::PipeState& pipeState,Packet* const packets[],unsigned int numPackets,Packet* batch[],unsigned int& batchSize,unsigned int& numParityPackets)
+	{
+	size_t maxFecDataSize=Packet::maxPacketSize-fecHeaderSize;
+	
+	/* Append as many packets to the pipe's "recently sent" list as fit into the send queue, leaving room for two parity packets in the batch: */
+	unsigned int numQueuedPackets=0;
+	while(numQueuedPackets<numPackets&&batchSize+3<=maxBatchSize&&pipeState.packetList.size()<sendBufferSize)
+		{
+		Packet* packet=packets[numQueuedPackets];
+		packet->pipeId=pipeState.pipeId;
+		
+		/* Check if the packet can be protected by forward error correction: */
+		bool protect=fecGroupSize>0&&packet->packetSize<=maxFecDataSize;
+		if(!protect&&pipeState.fecNumPackets>0)
+			{
+			/* Finish the current forward error correction group: */
+			batch[batchSize++]=finishParityPacket(pipeState);
+			++numParityPackets;
+			}
+		if(protect)
+			{
+			if(pipeState.fecNumPackets==0)
+				{
+				/* Start a new forward error correction group: */
+				pipeState.fecPacket=newPacket();
+				memset(pipeState.fecPacket->packet,0,Packet::maxPacketSize);
+				pipeState.fecPacket->packetSize=0;
+				pipeState.fecGroupStart=pipeState.streamPos;
+				}
+			
+			/* Add the packet to the group: */
+			++pipeState.fecNumPackets;
+			packet->pipeId|=pipeState.fecNumPackets<<fecIndexShift;
+			accumulateParity(pipeState.fecPacket,packet);
+			}
+		
+		packet->streamPos=pipeState.streamPos;
+		pipeState.streamPos+=packet->packetSize;
+		pipeState.packetList.push_back(packet);
+		batch[batchSize++]=packet;
+		++numQueuedPackets;
+		
+		/* Update the pipe's statistics: */
+		++pipeState.statistics.numPackets;
+		pipeState.statistics.numBytes+=packet->packetSize;
+		
+		/* Finish the current group if it is full, or if the packet is short and therefore likely the end of a burst: */
+		if(protect&&(pipeState.fecNumPackets>=fecGroupSize||packet->packetSize<maxFecDataSize))
+			{
+			batch[batchSize++]=finishParityPacket(pipeState);
+			++numParityPackets;
+			}
+		}
+	
+	return numQueuedPackets;
+	}
+
+void Multiplexer::sendQueuedBatch(Packet* const batch[],unsigned int batchSize,unsigned int numParityPackets)
+	{
+	/* Send the batch of packets across the UDP connection: */
+	sendPacketBatch(batch,batchSize);
+	
+	if(numParityPackets>0)
+		{
+		/* Delete the sent parity packets: */
+		for(unsigned int i=0;i<batchSize;++i)
+			if(batch[i]->pipeId&fecParityFlag)
+				deletePacket(batch[i]);
+		
+		Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+		trafficStatistics.numParityPackets+=numParityPackets;
+		}
+	}
+
+void Multiplexer::drainAsyncQueue(Multiplexer::PipeState& pipeState)
+	{
+	while(!pipeState.asyncQueue.empty()&&pipeState.packetList.size()<sendBufferSize)
+		{
+		/* Take as many packets from the asynchronous send queue as are guaranteed to fit into a batch including their parity packets: */
+		Packet* packets[maxBatchSize/2-1];
+		unsigned int numPackets=0;
+		while(numPackets<maxBatchSize/2-1&&!pipeState.asyncQueue.empty()&&pipeState.packetList.size()+numPackets<sendBufferSize)
+			packets[numPackets++]=pipeState.asyncQueue.pop_front();
+		
+		/* Append the packets to the pipe's packet list and send them: */
+		Packet* batch[maxBatchSize];
+		unsigned int batchSize=0;
+		unsigned int numParityPackets=0;
+		queuePackets(pipeState,packets,numPackets,batch,batchSize,numParityPackets);
+		sendQueuedBatch(batch,batchSize,numParityPackets);
+		
+		/* Retire all messages that have been sent completely: */
+		while(numPackets>0)
+			{
+			PipeState::AsyncMessage* message=pipeState.asyncMessageHead;
+			unsigned int numSent=message->numPackets<numPackets?message->numPackets:numPackets;
+			message->numPackets-=numSent;
+			message->started=true;
+			numPackets-=numSent;
+			if(message->numPackets==0)
+				{
+				/* Remove the message from the queue and report its completion: */
+				pipeState.asyncMessageHead=message->succ;
+				if(pipeState.asyncMessageHead==0)
+					pipeState.asyncMessageTail=0;
+				message->result.sent=true;
+				if(message->callback!=0)
+					{
+					(*message->callback)(message->result);
+					delete message->callback;
+					}
+				delete message;
+				}
+			}
+		}
+	
+	/* Wake up any callers waiting for room in the asynchronous send queue: */
+	pipeState.receiveCond.broadcast();
+	}
+
+bool Multiplexer::dropOldestAsyncMessage(Multiplexer::PipeState& pipeState)
+	{
+	/* Find the oldest message that has not started sending, which is either the first or second message in the queue: */
+	PipeState::AsyncMessage* pred=0;
+	PipeState::AsyncMessage* message=pipeState.asyncMessageHead;
+	if(message!=0&&message->started)
+		{
+		pred=message;
+		message=message->succ;
+		}
+	if(message==0)
+		return false;
+	
+	/* Find the message's packets, which follow the remaining packets of the preceding message in the queue: */
+	Packet* packetPred=0;
+	Packet* packet=pipeState.asyncQueue.head;
+	for(unsigned int i=pred!=0?pred->numPackets:0;i>0;--i)
+		{
+		packetPred=packet;
+		packet=packet->succ;
+		}
+	Packet* first=packet;
+	Packet* last=packet;
+	for(unsigned int i=1;i<message->numPackets;++i)
+		last=last->succ;
+	
+	/* Unlink the message's packets from the queue and return them to the packet pool: */
+	if(packetPred!=0)
+		packetPred->succ=last->succ;
+	else
+		pipeState.asyncQueue.head=last->succ;
+	if(last->succ==0)
+		pipeState.asyncQueue.tail=packetPred;
+	pipeState.asyncQueue.numPackets-=message->numPackets;
+	{
+	Threads::Spinlock::Lock packetPoolLock(packetPoolMutex);
+	last->succ=packetPoolHead;
+	packetPoolHead=first;
+	}
+	
+	/* Unlink the message from the queue: */
+	if(pred!=0)
+		pred->succ=message->succ;
+	else
+		pipeState.asyncMessageHead=message->succ;
+	if(message->succ==0)
+		pipeState.asyncMessageTail=pred;
+	
+	/* Report the dropped message: */
+	++pipeState.statistics.numDroppedMessages;
+	message->result.sent=false;
+	if(message->callback!=0)
+		{
+		(*message->callback)(message->result);
+		delete message->callback;
+		}
+	delete message;
+	
+	return true;
+	}
+
+void Multiplexer::sendPacketLoss(Multiplexer::PipeState& pipeState,unsigned int packetStreamPos)
+	{
+	/* Send negative acknowledgment to the master: */
+	StreamMessage msg(nodeIndex|0x80000000U,Message::PACKETLOSS,pipeState.pipeId,pipeState.streamPos,packetStreamPos);
+	{
+	// SocketMutex::Lock socketLock(socketMutex);
+	for(int i=0;i<slaveMessageBurstSize;++i)
+		sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+	}
+	
+	/* Enable packet loss mode to prohibit sending further loss messages until the missing packet arrives: */
+	pipeState.packetLossMode=true;
+	++pipeState.statistics.numLossNacks;
+	
+	{
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	++trafficStatistics.numLossNacks;
+	}
+	}
+
+void Multiplexer::deliverPacket(Multiplexer::PipeState& pipeState,Packet* packet,unsigned int& sendAckIn)
+	{
+	/* Disable packet loss mode: */
+	pipeState.packetLossMode=false;
+	
+	/* Update the pipe's statistics: */
+	++pipeState.statistics.numPackets;
+	pipeState.statistics.numBytes+=packet->packetSize;
+	
+	++sendAckIn;
+	if(sendAckIn==numSlaves)
+		{
+		/* Send positive acknowledgment to the master: */
+		StreamMessage msg(nodeIndex|0x80000000U,Message::ACKNOWLEDGMENT,pipeState.pipeId,pipeState.streamPos,packet->streamPos);
+		{
+		// SocketMutex::Lock socketLock(socketMutex);
+		sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+		}
+		sendAckIn=0;
+		}
+	
+	/* Add the packet to the parity of its forward error correction group if it belongs to one: */
+	unsigned int fecIndex=(packet->pipeId>>fecIndexShift)&fecIndexMask;
+	if(fecIndex!=0)
+		{
+		if(fecIndex==1)
+			{
+			/* Start a new group: */
+			if(pipeState.fecPacket==0)
+				{
+				pipeState.fecPacket=newPacket();
+				memset(pipeState.fecPacket->packet,0,Packet::maxPacketSize);
+				pipeState.fecPacket->packetSize=0;
+				}
+			else
+				clearParity(pipeState.fecPacket);
+			pipeState.fecGroupStart=packet->streamPos;
+			pipeState.fecNumPackets=0;
+			pipeState.fecValid=true;
+			}
+		
+		/* Invalidate the group's parity if the packet is not the next one in the group: */
+		if(pipeState.fecValid&&pipeState.fecNumPackets+1==fecIndex)
+			{
+			accumulateParity(pipeState.fecPacket,packet);
+			++pipeState.fecNumPackets;
+			}
+		else
+			pipeState.fecValid=false;
+		}
+	
+	/* Wake up sleeping receivers if the delivery queue is currently empty: */
+	if(pipeState.packetList.empty())
+		pipeState.receiveCond.signal();
+	
+	/* Append the packet to the pipe state's delivery queue: */
+	pipeState.streamPos+=packet->packetSize;
+	pipeState.packetList.push_back(packet);
+	}
+
+void Multiplexer::deliverPendingPackets(Multiplexer::PipeState& pipeState,unsigned int& sendAckIn)
+	{
+	while(!pipeState.fecPendingList.empty())
+		{
+		Packet* packet=pipeState.fecPendingList.front();
+		if(packet->streamPos==pipeState.streamPos)
+			{
+			/* Deliver the packet: */
+			deliverPacket(pipeState,pipeState.fecPendingList.pop_front(),sendAckIn);
+			}
+		else if(pipeState.streamPos-packet->streamPos<=0x80000000U)
+			{
+			/* Discard the packet, which has been delivered already: */
+			deletePacket(pipeState.fecPendingList.pop_front());
+			}
+		else
+			break;
+		}
+	}
+
+void Multiplexer::processParityPacket(Multiplexer::PipeState& pipeState,const Packet* parityPacket,unsigned int& sendAckIn)
+	{
+	/* Extract the size of the protected stream segment and the number of packets in it: */
+	unsigned int header[2];
+	memcpy(header,parityPacket->packet,fecHeaderSize);
+	unsigned int groupStart=parityPacket->streamPos;
+	unsigned int groupSize=header[0];
+	unsigned int numPackets=header[1];
+	size_t parityDataSize=parityPacket->packetSize-fecHeaderSize;
+	
+	/* Check if the pipe's stream position is inside the protected segment: */
+	if(pipeState.streamPos-groupStart>=groupSize)
+		{
+		/* Report packet loss if the protected segment starts after the stream position, i.e., if data before it has been lost: */
+		if(!pipeState.packetLossMode&&groupStart-pipeState.streamPos<=0x80000000U)
+			sendPacketLoss(pipeState,groupStart);
+		
+		return;
+		}
+	
+	/* Check that the accumulated parity covers all delivered packets of the group: */
+	bool recoverable=pipeState.streamPos==groupStart||(pipeState.fecValid&&pipeState.fecGroupStart==groupStart);
+	unsigned int numDeliveredPackets=pipeState.streamPos!=groupStart?pipeState.fecNumPackets:0;
+	
+	/* Find the end of the gap and check that the held-back packets cover the rest of the group: */
+	Packet* pPtr=pipeState.fecPendingList.front();
+	unsigned int gapEnd=pPtr!=0&&pPtr->streamPos-groupStart<groupSize?pPtr->streamPos:groupStart+groupSize;
+	unsigned int nextStreamPos=gapEnd;
+	unsigned int numPendingPackets=0;
+	for(;pPtr!=0&&pPtr->streamPos-groupStart<groupSize;pPtr=pPtr->succ,++numPendingPackets)
+		{
+		if(pPtr->streamPos!=nextStreamPos)
+			recoverable=false;
+		nextStreamPos+=pPtr->packetSize;
+		}
+	size_t lostSize=gapEnd-pipeState.streamPos;
+	recoverable=recoverable&&nextStreamPos==groupStart+groupSize&&lostSize<=parityDataSize&&numDeliveredPackets+numPendingPackets+1==numPackets;
+	
+	if(recoverable)
+		{
+		/* Reconstruct the lost packet from the parity packet, the delivered packets, and the held-back packets: */
+		Packet* packet=newPacket();
+		packet->pipeId=pipeState.pipeId|((numDeliveredPackets+1)<<fecIndexShift);
+		packet->streamPos=pipeState.streamPos;
+		packet->packetSize=lostSize;
+		memcpy(packet->packet,parityPacket->packet+fecHeaderSize,lostSize);
+		if(numDeliveredPackets!=0)
+			{
+			const char* fPtr=pipeState.fecPacket->packet+fecHeaderSize;
+			for(size_t i=0;i<lostSize;++i)
+				packet->packet[i]^=fPtr[i];
+			}
+		for(pPtr=pipeState.fecPendingList.front();numPendingPackets>0;pPtr=pPtr->succ,--numPendingPackets)
+			{
+			size_t xorSize=pPtr->packetSize<lostSize?pPtr->packetSize:lostSize;
+			for(size_t i=0;i<xorSize;++i)
+				packet->packet[i]^=pPtr->packet[i];
+			}
+		
+		{
+		Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+		++trafficStatistics.numRecoveredPackets;
+		}
+		
+		/* Deliver the reconstructed packet and all held-back packets following it: */
+		deliverPacket(pipeState,packet,sendAckIn);
+		deliverPendingPackets(pipeState,sendAckIn);
+		}
+	else if(!pipeState.packetLossMode)
+		{
+		/* Fall back to having the master re-send the lost packets: */
+		sendPacketLoss(pipeState,gapEnd);
+		}
+	}
+
+void Multiplexer::processBulkPacket(Multiplexer::PipeState& pipeState,const Packet* packet)
+	{
+	/* Check if the packet belongs to the current or most recent bulk transfer: */
+	unsigned int bulkOffset=packet->streamPos-pipeState.bulkStreamPos;
+	if(bulkOffset>=pipeState.bulkSize||packet->packetSize>pipeState.bulkSize-bulkOffset)
+		return;
+	
+	unsigned int ackStreamPos;
+	if(pipeState.bulkReceiveData!=0&&packet->streamPos==pipeState.streamPos)
+		{
+		/* Copy the packet's data into the receiver's buffer: */
+		memcpy(pipeState.bulkReceiveData+bulkOffset,packet->packet,packet->packetSize);
+		pipeState.streamPos+=packet->packetSize;
+		pipeState.packetLossMode=false;
+		
+		{
+		Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+		++trafficStatistics.numBulkPackets;
+		}
+		
+		if(bulkOffset+packet->packetSize==pipeState.bulkSize)
+			{
+			/* Wake up the receiver and acknowledge the complete transfer: */
+			pipeState.receiveCond.signal();
+			ackStreamPos=pipeState.streamPos;
+			}
+		else if((bulkOffset/Packet::maxPacketSize+nodeIndex)%bulkAckInterval==0)
+			{
+			/* Acknowledge progress periodically, staggered between slaves: */
+			ackStreamPos=pipeState.streamPos;
+			}
+		else
+			return;
+		}
+	else if(packet->streamPos-pipeState.streamPos>=0x80000000U)
+		{
+		/* Periodically re-acknowledge already received packets in case earlier acknowledgments were lost: */
+		if(bulkOffset+packet->packetSize!=pipeState.bulkSize&&(bulkOffset/Packet::maxPacketSize+nodeIndex)%bulkAckInterval!=0)
+			return;
+		unsigned int receivedSize=pipeState.streamPos-pipeState.bulkStreamPos;
+		ackStreamPos=pipeState.bulkStreamPos+(receivedSize<pipeState.bulkSize?receivedSize:pipeState.bulkSize);
+		}
+	else
+		{
+		/* At least one packet must have been lost; report it to the master unless already done, or ignore the packet if there is no receiver yet: */
+		if(pipeState.bulkReceiveData!=0&&!pipeState.packetLossMode)
+			sendPacketLoss(pipeState,packet->streamPos);
+		return;
+		}
+	
+	/* Send positive acknowledgment to the master: */
+	StreamMessage msg(nodeIndex|0x80000000U,Message::ACKNOWLEDGMENT,pipeState.pipeId,ackStreamPos,packet->streamPos);
+	{
+	// SocketMutex::Lock socketLock(socketMutex);
+	sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+	}
+	}
+
 void* Multiplexer::packetHandlingThreadMaster(void)
 	{
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
@@ -363,16 +1093,23 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 	
 	/* Handle message exchange during multiplexer initialization: */
 	bool* slaveConnecteds=new bool[numSlaves];
+	unsigned int* slaveAddresses=new unsigned int[numSlaves*2];
 	for(unsigned int i=0;i<numSlaves;++i)
 		slaveConnecteds[i]=false;
 	unsigned int numConnectedSlaves=0;
 	while(numConnectedSlaves<numSlaves)
 		{
 		/* Wait for a connection initialization packet: */
-		ssize_t numBytesReceived=recv(socketFd,messageBuffer,Packet::maxRawPacketSize,0);
-		if(numBytesReceived==sizeof(Message))
+		struct sockaddr_in senderAddress;
+		#ifdef __SGI_IRIX__
+		int senderAddressLen=sizeof(struct sockaddr_in);
+		#else
+		socklen_t senderAddressLen=sizeof(struct sockaddr_in);
+		#endif
+		ssize_t numBytesReceived=recvfrom(socketFd,messageBuffer,Packet::maxRawPacketSize,0,(struct sockaddr*)&senderAddress,&senderAddressLen);
+		if(numBytesReceived==sizeof(ConnectionMessage))
 			{
-			Message* msg=static_cast<Message*>(messageBuffer);
+			ConnectionMessage* msg=static_cast<ConnectionMessage*>(messageBuffer);
 			if(msg->nodeIndex&0x80000000U) // Check if the message is from a slave
 				{
 				unsigned int slaveIndex=(msg->nodeIndex&0x7fffffffU)-1;
@@ -381,18 +1118,40 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 					/* Mark the slave as connected: */
 					slaveConnecteds[slaveIndex]=true;
 					++numConnectedSlaves;
+					
+					/* Remember the slave's unicast address, combining the sender's IP address with the port number to which the slave's socket is bound: */
+					slaveAddresses[slaveIndex*2+0]=senderAddress.sin_addr.s_addr;
+					slaveAddresses[slaveIndex*2+1]=msg->portNumber;
 					}
 				}
 			}
 		}
 	delete[] slaveConnecteds;
 	
+	/* Create the connection message containing the addresses of all slaves that have children in the barrier tree: */
+	unsigned int numParents=numSlaves>0?(numSlaves-1)/(barrierTreeDegree!=0&&barrierTreeDegree<numSlaves?barrierTreeDegree:numSlaves):0;
+	if(sizeof(ConnectionMessage)+numParents*2*sizeof(unsigned int)>Packet::maxRawPacketSize)
+		{
+		/* Fall back to a flat barrier tree if the slaves' addresses don't fit into a single message: */
+		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+		std::cerr<<"Node "<<nodeIndex<<": Too many slaves for barrier tree of degree "<<barrierTreeDegree<<"; using flat barrier tree"<<std::endl;
+		#endif
+		setBarrierTree(0);
+		numParents=0;
+		}
+	connectionMessageSize=sizeof(ConnectionMessage)+numParents*2*sizeof(unsigned int);
+	char* connectionMessageBuffer=new char[connectionMessageSize];
+	ConnectionMessage msg(0,0,barrierTreeDegree,numParents);
+	memcpy(connectionMessageBuffer,&msg,sizeof(ConnectionMessage));
+	memcpy(connectionMessageBuffer+sizeof(ConnectionMessage),slaveAddresses,numParents*2*sizeof(unsigned int));
+	connectionMessage=connectionMessageBuffer;
+	delete[] slaveAddresses;
+	
 	/* Send connection message to slaves: */
-	Message msg(0,Message::CONNECTION);
 	{
 	// SocketMutex::Lock socketLock(socketMutex);
 	for(int i=0;i<masterMessageBurstSize;++i)
-		sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+		sendto(socketFd,connectionMessage,connectionMessageSize,0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
 	}
 	
 	/* Signal connection establishment: */
@@ -407,6 +1166,15 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 		{
 		/* Wait for a message from any slave: */
 		ssize_t numBytesReceived=recv(socketFd,messageBuffer,Packet::maxRawPacketSize,0);
+		{
+		Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+		++trafficStatistics.numReceiveCalls;
+		if(numBytesReceived>0)
+			{
+			++trafficStatistics.numReceivedPackets;
+			trafficStatistics.numReceivedBytes+=numBytesReceived;
+			}
+		}
 		if(numBytesReceived>0&&size_t(numBytesReceived)>=sizeof(Message))
 			{
 			/* Check that the message is not the echo of a server message: */
@@ -420,10 +1188,9 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 					case Message::CONNECTION:
 						{
 						/* One slave must have missed the connection establishment packet; send another one: */
-						Message msg(0,Message::CONNECTION);
 						{
 						// SocketMutex::Lock socketLock(socketMutex);
-						sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+						sendto(socketFd,connectionMessage,connectionMessageSize,0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
 						}
 						break;
 						}
@@ -455,7 +1222,7 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 							if(npIt.isFinished())
 								{
 								/* If the new pipe state hasn't been created already, do it here: */
-								newPipeState=new PipeState(nodeIndex,numSlaves);
+								newPipeState=new PipeState(nodeIndex,numSlaves,numChildren);
 								
 								/* Add the new pipe state to the new pipe map: */
 								// newPipes[senderId]=newPipeState; // Gives "potentially uninitialized" warning
@@ -490,7 +1257,7 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 									do
 										{
 										++lastPipeId;
-										if(lastPipeId==0x80000000U) // Ensure that pipeId never has the MSB set
+										if(lastPipeId>pipeIdMask) // Ensure that pipeId never overlaps the flag bits in stream packets
 											lastPipeId=1;
 										}
 									while(pipeStateTable.isEntry(lastPipeId));
@@ -616,8 +1383,26 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 								/* Use the stream position reported by the client as positive acknowledgment: */
 								processAcknowledgment(pipeState,msgNodeIndex-1,msg->streamPos);
 								
-								/* Resend requested packets if there are any; otherwise, do nothing because master is busy: */
-								if(msg->streamPos!=pipeState->streamPos)
+								/* Update the pipe's and slave's statistics: */
+								++pipeState->statistics.numLossNacks;
+								{
+								Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+								++slaveStatistics[msgNodeIndex-1].numLossNacks;
+								}
+								
+								if(pipeState->bulkSendData!=0)
+									{
+									/* Re-send the current bulk transfer from the reported stream position: */
+									unsigned int bulkOffset=msg->streamPos-pipeState->bulkStreamPos;
+									if(bulkOffset<pipeState->bulkResendOffset)
+										{
+										pipeState->bulkResendOffset=bulkOffset;
+										pipeState->receiveCond.broadcast();
+										}
+									}
+								
+								/* Resend requested packets if there are any; otherwise, do nothing because master is busy; ignore stale reports that were overtaken by later acknowledgments from the same slave: */
+								else if(msg->streamPos!=pipeState->streamPos&&msg->streamPos-pipeState->headStreamPos<0x80000000U)
 									{
 									#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
 									std::cerr<<"Packet loss of "<<msg->packetPos-msg->streamPos<<" bytes from "<<msg->streamPos<<" detected by node "<<msgNodeIndex<<", stream pos is "<<pipeState->streamPos<<", buffer starts at "<<pipeState->headStreamPos<<std::endl;
@@ -633,16 +1418,30 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 										Misc::throwStdErr("Cluster::Multiplexer: Node %u: Fatal packet loss detected at stream position %u",msgNodeIndex,msg->streamPos);
 									
 									{
-									/* Resend all recent packets in order: */
+									/* Resend all recent packets in order, in batches: */
 									// SocketMutex::Lock socketLock(socketMutex);
+									Packet* batch[maxBatchSize];
+									unsigned int batchSize=0;
+									size_t numResentPackets=0;
+									size_t numResentBytes=0;
 									for(;packet!=0;packet=packet->succ)
 										{
-										sendto(socketFd,&packet->pipeId,packet->packetSize+2*sizeof(unsigned int),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
-										#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-										++pipeState->numResentPackets;
-										pipeState->numResentBytes+=packet->packetSize;
-										#endif
+										batch[batchSize++]=packet;
+										if(batchSize==maxBatchSize||packet->succ==0)
+											{
+											sendPacketBatch(batch,batchSize);
+											batchSize=0;
+											}
+										++numResentPackets;
+										numResentBytes+=packet->packetSize;
 										}
+									
+									/* Update the pipe's and the node's statistics: */
+									pipeState->statistics.numResentPackets+=numResentPackets;
+									pipeState->statistics.numResentBytes+=numResentBytes;
+									Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+									trafficStatistics.numResentPackets+=numResentPackets;
+									trafficStatistics.numResentBytes+=numResentBytes;
 									}
 									}
 								}
@@ -681,18 +1480,8 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 									}
 								else
 									{
-									pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
-									
-									/* Check if the current barrier is complete: */
-									pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
-									for(unsigned int i=1;i<numSlaves;++i)
-										if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
-											pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
-									if(pipeState->minSlaveBarrierId>pipeState->barrierId)
-										{
-										/* Wake up thread waiting on barrier: */
-										pipeState->barrierCond.signal();
-										}
+									/* Record the arrival of the slave's subtree at the barrier: */
+									recordArrival(*pipeState,msgNodeIndex-firstChildIndex,msg->barrierId);
 									}
 								}
 							else
@@ -735,19 +1524,11 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 									}
 								else
 									{
-									pipeState->slaveBarrierIds[msgNodeIndex-1]=msg->barrierId;
-									pipeState->slaveGatherValues[msgNodeIndex-1]=msg->value;
-									
-									/* Check if the current gather operation is complete: */
-									pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[0];
-									for(unsigned int i=1;i<numSlaves;++i)
-										if(pipeState->minSlaveBarrierId>pipeState->slaveBarrierIds[i])
-											pipeState->minSlaveBarrierId=pipeState->slaveBarrierIds[i];
-									if(pipeState->minSlaveBarrierId>pipeState->barrierId)
-										{
-										/* Wake up thread waiting on barrier: */
-										pipeState->barrierCond.signal();
-										}
+									/* Record the gather value of the slave's subtree and its arrival at the gather operation: */
+									unsigned int childIndex=msgNodeIndex-firstChildIndex;
+									if(childIndex<numChildren)
+										pipeState->slaveGatherValues[childIndex]=msg->value;
+									recordArrival(*pipeState,childIndex,msg->barrierId);
 									}
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
@@ -761,6 +1542,47 @@ void* Multiplexer::packetHandlingThreadMaster(void)
 						#endif
 						break;
 						}
+					
+					case Message::BULKREADY:
+						{
+						if(numBytesReceived==sizeof(StreamMessage))
+							{
+							StreamMessage* msg=static_cast<StreamMessage*>(messageBuffer);
+							
+							/* Get a handle on the state object of the pipe the packet is meant for: */
+							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+							
+							if(pipeState.isValid())
+								{
+								/* Use the stream position reported by the client as positive acknowledgment: */
+								processAcknowledgment(pipeState,msgNodeIndex-1,msg->streamPos);
+								
+								if(pipeState->bulkSendData!=0)
+									{
+									/* The slave did not receive the beginning of the current bulk transfer; re-send it: */
+									if(msg->streamPos==pipeState->bulkStreamPos&&pipeState->slaveStreamPosOffsets[msgNodeIndex-1]==0)
+										pipeState->bulkResendOffset=0;
+									}
+								else
+									{
+									/* Remember that the slave is ready to receive a bulk transfer: */
+									pipeState->slaveBulkReadyPos[msgNodeIndex-1]=msg->streamPos;
+									}
+								
+								/* Wake up the sender: */
+								pipeState->receiveCond.broadcast();
+								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received BULKREADY message for non-existent pipe "<<msg->pipeId<<std::endl;
+							#endif
+							}
+						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+						else
+							std::cerr<<"Node "<<nodeIndex<<": received BULKREADY message of wrong size "<<numBytesReceived<<std::endl;
+						#endif
+						break;
+						}
 					}
 				}
 			}
@@ -785,11 +1607,11 @@ void* Multiplexer::packetHandlingThreadSlave(void)
 	while(true)
 		{
 		/* Send connection initiation packet to master: */
-		Message msg(sendNodeIndex,Message::CONNECTION);
+		ConnectionMessage msg(sendNodeIndex,htons(getLocalPortNumber()),0,0);
 		{
 		// SocketMutex::Lock socketLock(socketMutex);
 		for(int i=0;i<slaveMessageBurstSize;++i)
-			sendto(socketFd,&msg,sizeof(Message),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+			sendto(socketFd,&msg,sizeof(ConnectionMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
 		}
 		
 		/* Wait for a connection packet from the master (but don't wait for too long): */
@@ -834,222 +1656,300 @@ void* Multiplexer::packetHandlingThreadSlave(void)
 			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Communication error",nodeIndex);
 			}
 		
-		/* Read the waiting packet: */
-		ssize_t numBytesReceived=recv(socketFd,&slaveThreadPacket->pipeId,Packet::maxRawPacketSize,0);
-		if(numBytesReceived<0)
+		/* Read all waiting packets: */
+		#if CLUSTER_CONFIG_HAVE_MMSG
+		struct mmsghdr messages[maxBatchSize];
+		struct iovec iovecs[maxBatchSize];
+		for(unsigned int i=0;i<maxBatchSize;++i)
+			{
+			iovecs[i].iov_base=&slaveThreadPackets[i]->pipeId;
+			iovecs[i].iov_len=Packet::maxRawPacketSize;
+			memset(&messages[i].msg_hdr,0,sizeof(struct msghdr));
+			messages[i].msg_hdr.msg_iov=&iovecs[i];
+			messages[i].msg_hdr.msg_iovlen=1;
+			}
+		int numPacketsReceived=recvmmsg(socketFd,messages,maxBatchSize,MSG_DONTWAIT,0);
+		#else
+		ssize_t numRawBytesReceived=recv(socketFd,&slaveThreadPackets[0]->pipeId,Packet::maxRawPacketSize,0);
+		int numPacketsReceived=numRawBytesReceived>=0?1:-1;
+		#endif
+		if(numPacketsReceived<0)
 			{
 			/* Try to recover from this error: */
 			#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-			std::cerr<<"Node "<<nodeIndex<<": Error "<<errno<<" on receive, slaveThreadPacket="<<slaveThreadPacket<<std::endl;
+			std::cerr<<"Node "<<nodeIndex<<": Error "<<errno<<" on receive"<<std::endl;
+			#endif
+			continue;
+			}
+		
+		/* Update the traffic statistics: */
+		{
+		Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+		++trafficStatistics.numReceiveCalls;
+		trafficStatistics.numReceivedPackets+=numPacketsReceived;
+		for(int packetIndex=0;packetIndex<numPacketsReceived;++packetIndex)
+			{
+			#if CLUSTER_CONFIG_HAVE_MMSG
+			trafficStatistics.numReceivedBytes+=messages[packetIndex].msg_len;
+			#else
+			trafficStatistics.numReceivedBytes+=numRawBytesReceived;
 			#endif
-			delete slaveThreadPacket;
-			slaveThreadPacket=newPacket();
 			}
-		else if(size_t(numBytesReceived)>=2*sizeof(unsigned int))
+		}
+		
+		/* Process all received packets in order: */
+		for(int packetIndex=0;packetIndex<numPacketsReceived;++packetIndex)
 			{
-			slaveThreadPacket->packetSize=size_t(numBytesReceived-2*sizeof(unsigned int));
+			/* Get the packet and its size: */
+			Packet*& slaveThreadPacket=slaveThreadPackets[packetIndex];
+			#if CLUSTER_CONFIG_HAVE_MMSG
+			ssize_t numBytesReceived=messages[packetIndex].msg_len;
+			#else
+			ssize_t numBytesReceived=numRawBytesReceived;
+			#endif
 			
-			if(slaveThreadPacket->pipeId==0)
+			if(size_t(numBytesReceived)>=2*sizeof(unsigned int))
 				{
-				/* It's a message for the pipe multiplexer itself: */
-				void* messageBuffer=&slaveThreadPacket->pipeId;
-				switch(static_cast<Message*>(messageBuffer)->messageId)
+				slaveThreadPacket->packetSize=size_t(numBytesReceived-2*sizeof(unsigned int));
+				
+				if(slaveThreadPacket->pipeId==0)
 					{
-					case Message::CONNECTION:
-						/* Signal connection establishment: */
+					/* It's a message for the pipe multiplexer itself: */
+					void* messageBuffer=&slaveThreadPacket->pipeId;
+					switch(static_cast<Message*>(messageBuffer)->messageId)
 						{
-						Threads::MutexCond::Lock connectionCondLock(connectionCond);
-						if(!connected)
+						case Message::CONNECTION:
 							{
-							connected=true;
-							connectionCond.broadcast();
+							ConnectionMessage* msg=static_cast<ConnectionMessage*>(messageBuffer);
+							if(size_t(numBytesReceived)>=sizeof(ConnectionMessage)&&size_t(numBytesReceived)==sizeof(ConnectionMessage)+msg->numParents*2*sizeof(unsigned int))
+								{
+								/* Signal connection establishment: */
+								Threads::MutexCond::Lock connectionCondLock(connectionCond);
+								if(!connected)
+									{
+									/* Calculate this slave's place in the barrier tree: */
+									setBarrierTree(msg->barrierTreeDegree);
+									if(parentIndex!=0)
+										{
+										/* Retrieve the parent slave's address: */
+										const unsigned int* parent=reinterpret_cast<const unsigned int*>(msg+1)+(parentIndex-1)*2;
+										memset(parentAddress,0,sizeof(sockaddr_in));
+										parentAddress->sin_family=AF_INET;
+										parentAddress->sin_port=parent[1];
+										parentAddress->sin_addr.s_addr=parent[0];
+										}
+									
+									connected=true;
+									connectionCond.broadcast();
+									}
+								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received CONNECTION message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
 							}
-						}
-						break;
-					
-					case Message::PING:
-						/* Just ignore the packet... */
-						break;
-					
-					case Message::CREATEPIPE1:
-						{
-						CreatePipe1Message* msg=static_cast<CreatePipe1Message*>(messageBuffer);
-						if(size_t(numBytesReceived)>=sizeof(CreatePipe1Message)&&size_t(numBytesReceived)==sizeof(CreatePipe1Message)+msg->idNumParts*sizeof(unsigned int))
-							{
+						
+						case Message::PING:
+							/* Just ignore the packet... */
+							break;
+						
+						case Message::CREATEPIPE1:
 							{
-							Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
-							
-							/* Check if the pipe is not yet in the pipe state table: */
-							if(!pipeStateTable.isEntry(msg->pipeId))
+							CreatePipe1Message* msg=static_cast<CreatePipe1Message*>(messageBuffer);
+							if(size_t(numBytesReceived)>=sizeof(CreatePipe1Message)&&size_t(numBytesReceived)==sizeof(CreatePipe1Message)+msg->idNumParts*sizeof(unsigned int))
 								{
-								/* Extract the originating thread's ID from the message: */
-								Threads::Thread::ID senderId(msg->idNumParts,reinterpret_cast<unsigned int*>(msg+1));
-								
-								/* Find the new pipe state corresponding to the thread ID: */
-								NewPipeHasher::Iterator npIt=newPipes.findEntry(senderId);
-								PipeState* newPipeState=npIt->getDest();
+								{
+								Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
 								
-								/* Remove the new pipe state from the new pipe map and insert it into the pipe state table: */
-								newPipes.removeEntry(npIt);
-								pipeStateTable[msg->pipeId]=newPipeState;
+								/* Check if the pipe is not yet in the pipe state table: */
+								if(!pipeStateTable.isEntry(msg->pipeId))
+									{
+									/* Extract the originating thread's ID from the message: */
+									Threads::Thread::ID senderId(msg->idNumParts,reinterpret_cast<unsigned int*>(msg+1));
+									
+									/* Find the new pipe state corresponding to the thread ID: */
+									NewPipeHasher::Iterator npIt=newPipes.findEntry(senderId);
+									PipeState* newPipeState=npIt->getDest();
+									
+									/* Remove the new pipe state from the new pipe map and insert it into the pipe state table: */
+									newPipes.removeEntry(npIt);
+									pipeStateTable[msg->pipeId]=newPipeState;
+									
+									/* Signal pipe creation completion: */
+									{
+									Threads::Mutex::Lock pipeStateLock(newPipeState->stateMutex);
+									newPipeState->pipeId=msg->pipeId;
+									newPipeState->barrierId=2;
+									newPipeState->barrierCond.signal();
+									}
+									}
+								}
 								
-								/* Signal pipe creation completion: */
+								/* Send a stage-two pipe creation message to the master: */
+								PipeMessage msg2(sendNodeIndex,Message::CREATEPIPE2,msg->pipeId);
 								{
-								Threads::Mutex::Lock pipeStateLock(newPipeState->stateMutex);
-								newPipeState->pipeId=msg->pipeId;
-								newPipeState->barrierId=2;
-								newPipeState->barrierCond.signal();
+								// SocketMutex::Lock socketLock(socketMutex);
+								for(int i=0;i<slaveMessageBurstSize;++i)
+									sendto(socketFd,&msg2,sizeof(PipeMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
 								}
 								}
+							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+							else
+								std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE1 message of wrong size "<<numBytesReceived<<std::endl;
+							#endif
+							break;
 							}
-							
-							/* Send a stage-two pipe creation message to the master: */
-							PipeMessage msg2(sendNodeIndex,Message::CREATEPIPE2,msg->pipeId);
-							{
-							// SocketMutex::Lock socketLock(socketMutex);
-							for(int i=0;i<slaveMessageBurstSize;++i)
-								sendto(socketFd,&msg2,sizeof(PipeMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
-							}
-							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received CREATEPIPE1 message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::BARRIER:
-						{
-						if(numBytesReceived==sizeof(BarrierMessage))
+						
+						case Message::BARRIER:
 							{
-							BarrierMessage* msg=static_cast<BarrierMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(numBytesReceived==sizeof(BarrierMessage))
 								{
-								/* Signal barrier completion if the completion message is for the current barrier: */
-								if(pipeState->barrierId<msg->barrierId)
+								BarrierMessage* msg=static_cast<BarrierMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									pipeState->barrierId=msg->barrierId;
-									pipeState->barrierCond.signal();
+									/* Signal barrier completion if the completion message is for the current barrier: */
+									if(pipeState->barrierId<msg->barrierId)
+										{
+										pipeState->barrierId=msg->barrierId;
+										pipeState->barrierCond.signal();
+										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received BARRIER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received BARRIER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received BARRIER message of wrong size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received BARRIER message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
-						}
-					
-					case Message::GATHER:
-						{
-						if(numBytesReceived==sizeof(GatherMessage))
+						
+						case Message::GATHER:
 							{
-							GatherMessage* msg=static_cast<GatherMessage*>(messageBuffer);
-							
-							/* Get a handle on the state object of the pipe the packet is meant for: */
-							LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
-							
-							if(pipeState.isValid())
+							if(numBytesReceived==sizeof(GatherMessage))
 								{
-								/* Signal barrier completion if the completion message is for the current barrier: */
-								if(pipeState->barrierId<msg->barrierId)
+								GatherMessage* msg=static_cast<GatherMessage*>(messageBuffer);
+								
+								/* Get a handle on the state object of the pipe the packet is meant for: */
+								LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
+								
+								if(pipeState.isValid())
 									{
-									pipeState->barrierId=msg->barrierId;
-									pipeState->masterGatherValue=msg->value;
-									pipeState->barrierCond.signal();
+									/* Signal barrier completion if the completion message is for the current barrier: */
+									if(pipeState->barrierId<msg->barrierId)
+										{
+										pipeState->barrierId=msg->barrierId;
+										pipeState->masterGatherValue=msg->value;
+										pipeState->barrierCond.signal();
+										}
 									}
+								#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+								else
+									std::cerr<<"Node "<<nodeIndex<<": received GATHER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								#endif
 								}
 							#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 							else
-								std::cerr<<"Node "<<nodeIndex<<": received GATHER message for non-existent pipe "<<msg->pipeId<<std::endl;
+								std::cerr<<"Node "<<nodeIndex<<": received GATHER message of wrong size "<<numBytesReceived<<std::endl;
 							#endif
+							break;
 							}
-						#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-						else
-							std::cerr<<"Node "<<nodeIndex<<": received GATHER message of wrong size "<<numBytesReceived<<std::endl;
-						#endif
-						break;
 						}
 					}
-				}
-			else
-				{
-				/* Get a handle on the state object of the pipe the packet is meant for: */
-				LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,slaveThreadPacket->pipeId);
-				
-				if(pipeState.isValid())
+				else if(slaveThreadPacket->pipeId==subtreeMessageFlag)
 					{
-					/* Check if the received packet is the next expected one: */
-					if(pipeState->streamPos==slaveThreadPacket->streamPos)
+					/* It's a message from a child of this slave in the barrier tree: */
+					SubtreeMessage* msg=reinterpret_cast<SubtreeMessage*>(&slaveThreadPacket->pipeId);
+					if(size_t(numBytesReceived)==sizeof(SubtreeMessage)&&(msg->messageId==Message::BARRIER||msg->messageId==Message::GATHER))
 						{
-						/* Disable packet loss mode: */
-						pipeState->packetLossMode=false;
+						/* Get a handle on the state object of the pipe the message is meant for: */
+						LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,msg->pipeId);
 						
-						++sendAckIn;
-						if(sendAckIn==numSlaves)
-							{
-							/* Send positive acknowledgment to the master: */
-							StreamMessage msg(sendNodeIndex,Message::ACKNOWLEDGMENT,slaveThreadPacket->pipeId,pipeState->streamPos,slaveThreadPacket->streamPos);
+						if(pipeState.isValid()&&pipeState->barrierId<msg->barrierId)
 							{
-							// SocketMutex::Lock socketLock(socketMutex);
-							sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+							/* Record the gather value of the child's subtree and its arrival at the barrier or gather operation: */
+							unsigned int childIndex=msg->senderIndex-firstChildIndex;
+							if(childIndex<numChildren&&msg->messageId==Message::GATHER)
+								pipeState->slaveGatherValues[childIndex]=msg->value;
+							recordArrival(*pipeState,childIndex,msg->barrierId);
 							}
-							sendAckIn=0;
-							}
-						
-						/* Wake up sleeping receivers if the delivery queue is currently empty: */
-						if(pipeState->packetList.empty())
-							pipeState->receiveCond.signal();
-						
-						/* Append the packet to the pipe state's delivery queue: */
-						pipeState->streamPos+=slaveThreadPacket->packetSize;
-						pipeState->packetList.push_back(slaveThreadPacket);
-						
-						/* Get a new packet: */
-						slaveThreadPacket=newPacket();
 						}
+					#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
 					else
+						std::cerr<<"Node "<<nodeIndex<<": received subtree message of wrong size "<<numBytesReceived<<std::endl;
+					#endif
+					}
+				else
+					{
+					/* Get a handle on the state object of the pipe the packet is meant for: */
+					LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,slaveThreadPacket->pipeId&pipeIdMask);
+					
+					if(pipeState.isValid())
 						{
-						/* Check if there is data missing between the packet's stream position and the pipe's stream position; watch for stream position wrap-around: */
-						if(!pipeState->packetLossMode&&slaveThreadPacket->streamPos-pipeState->streamPos<=0x80000000U)
+						if(slaveThreadPacket->pipeId&bulkFlag)
 							{
-							/* At least one packet must have been lost; send negative acknowledgment to the master: */
-							StreamMessage msg(sendNodeIndex,Message::PACKETLOSS,slaveThreadPacket->pipeId,pipeState->streamPos,slaveThreadPacket->streamPos);
+							/* Copy the bulk transfer packet directly into the receiver's buffer: */
+							processBulkPacket(*pipeState,slaveThreadPacket);
+							}
+						else if(slaveThreadPacket->pipeId&fecParityFlag)
 							{
-							// SocketMutex::Lock socketLock(socketMutex);
-							for(int i=0;i<slaveMessageBurstSize;++i)
-								sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+							/* Check the parity packet for a recoverable lost packet: */
+							if(slaveThreadPacket->packetSize>=fecHeaderSize)
+								processParityPacket(*pipeState,slaveThreadPacket,sendAckIn);
 							}
-
-							/* Enable packet loss mode to prohibit sending further loss messages until the missing packet arrives: */
-							pipeState->packetLossMode=true;
+						else if(pipeState->streamPos==slaveThreadPacket->streamPos)
+							{
+							/* Deliver the packet and any held-back packets following it: */
+							deliverPacket(*pipeState,slaveThreadPacket,sendAckIn);
+							deliverPendingPackets(*pipeState,sendAckIn);
+							
+							/* Get a new packet: */
+							slaveThreadPacket=newPacket();
+							}
+						else if(slaveThreadPacket->streamPos-pipeState->streamPos<=0x80000000U)
+							{
+							/* At least one packet must have been lost; hold back the packet if the lost packet might be reconstructed from a parity packet: */
+							PipeState::PacketList& pending=pipeState->fecPendingList;
+							if(((slaveThreadPacket->pipeId>>fecIndexShift)&fecIndexMask)!=0&&pending.size()<maxFecPendingPackets)
+								{
+								/* Append the packet to the held-back list unless it arrived out of order: */
+								if(pending.empty()||slaveThreadPacket->streamPos-pending.back()->streamPos-1U<0x80000000U)
+									{
+									pending.push_back(slaveThreadPacket);
+									slaveThreadPacket=newPacket();
+									}
+								}
+							else if(!pipeState->packetLossMode)
+								{
+								/* Send negative acknowledgment to the master: */
+								sendPacketLoss(*pipeState,slaveThreadPacket->streamPos);
+								}
 							}
 						}
+					#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+					else
+						std::cerr<<"Node "<<nodeIndex<<": received stream packet for non-existent pipe "<<slaveThreadPacket->pipeId<<std::endl;
+					#endif
 					}
-				#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-				else
-					std::cerr<<"Node "<<nodeIndex<<": received stream packet for non-existent pipe "<<slaveThreadPacket->pipeId<<std::endl;
-				#endif
 				}
+			#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
+			else
+				std::cerr<<"Node "<<nodeIndex<<": received short message of size "<<numBytesReceived<<std::endl;
+			#endif
 			}
-		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-		else
-			std::cerr<<"Node "<<nodeIndex<<": received short message of size "<<numBytesReceived<<std::endl;
-		#endif
 		}
 	
 	return 0;
 	}
 
-Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::string masterHostName,int masterPortNumber,std::string slaveMulticastGroup,int slavePortNumber)
+Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::string masterHostName,int masterPortNumber,std::string slaveMulticastGroup,int slavePortNumber,unsigned int sBarrierTreeDegree)
 	:numSlaves(sNumSlaves),nodeIndex(sNodeIndex),
 	 masterAddress(new sockaddr_in),
 	 otherAddress(new sockaddr_in),
@@ -1059,15 +1959,27 @@ Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::st
 	 lastPipeId(0),
 	 pipeStateTable(17),
 	 messageBuffer(0),
-	 slaveThreadPacket(0),
 	 masterMessageBurstSize(1),slaveMessageBurstSize(1),
 	 connectionWaitTimeout(0.5),
 	 pingTimeout(10.0),maxPingRequests(3),
 	 receiveWaitTimeout(0.25),
 	 barrierWaitTimeout(0.1),
 	 sendBufferSize(20),
-	 packetPoolHead(0)
+	 packetPoolHead(0),
+	 useSegmentationOffload(false),
+	 fecGroupSize(0),
+	 bulkWindowSize(256),
+	 barrierTreeDegree(0),parentIndex(0),parentAddress(new sockaddr_in),firstChildIndex(0),numChildren(0),
+	 connectionMessage(0),connectionMessageSize(0),
+	 slaveStatistics(0)
 	{
+	/* Set up the master's barrier tree before the packet handling thread starts accepting connections; slaves start with a flat barrier tree and receive the master's when connecting: */
+	setBarrierTree(nodeIndex==0?sBarrierTreeDegree:0);
+	memset(parentAddress,0,sizeof(sockaddr_in));
+	
+	for(unsigned int i=0;i<maxBatchSize;++i)
+		slaveThreadPackets[i]=0;
+	
 	/* Lookup master's IP address: */
 	struct hostent* masterEntry=gethostbyname(masterHostName.c_str());
 	if(masterEntry==0)
@@ -1139,6 +2051,12 @@ Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::st
 		otherAddress->sin_family=AF_INET;
 		otherAddress->sin_port=htons(slavePortNumber);
 		otherAddress->sin_addr.s_addr=htonl(slaveNetAddress.s_addr);
+		
+		#if CLUSTER_CONFIG_HAVE_MMSG && defined(UDP_SEGMENT)
+		/* Check if the kernel supports UDP generic segmentation offload: */
+		int segmentSize=0;
+		useSegmentationOffload=setsockopt(socketFd,SOL_UDP,UDP_SEGMENT,&segmentSize,sizeof(int))==0;
+		#endif
 		}
 	else
 		{
@@ -1167,11 +2085,13 @@ Multiplexer::Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::st
 	if(nodeIndex==0)
 		{
 		messageBuffer=new unsigned char[Packet::maxRawPacketSize];
+		slaveStatistics=new SlaveStatistics[numSlaves];
 		packetHandlingThread.start(this,&Multiplexer::packetHandlingThreadMaster);
 		}
 	else
 		{
-		slaveThreadPacket=newPacket();
+		for(unsigned int i=0;i<maxBatchSize;++i)
+			slaveThreadPackets[i]=newPacket();
 		packetHandlingThread.start(this,&Multiplexer::packetHandlingThreadSlave);
 		}
 	}
@@ -1182,9 +2102,12 @@ Multiplexer::~Multiplexer(void)
 	packetHandlingThread.cancel();
 	packetHandlingThread.join();
 	
-	/* Delete the packet handling thread's receive packet: */
-	delete slaveThreadPacket;
+	/* Delete the packet handling thread's receive packets: */
+	for(unsigned int i=0;i<maxBatchSize;++i)
+		delete slaveThreadPackets[i];
 	delete[] static_cast<unsigned char*>(messageBuffer);
+	delete[] static_cast<char*>(connectionMessage);
+	delete[] slaveStatistics;
 	
 	/* Close all leftover pipes: */
 	for(PipeHasher::Iterator psIt=pipeStateTable.begin();psIt!=pipeStateTable.end();++psIt)
@@ -1196,14 +2119,222 @@ Multiplexer::~Multiplexer(void)
 	/* Delete address of multicast connection's other end: */
 	delete masterAddress;
 	delete otherAddress;
+	delete parentAddress;
+	
+	/* Delete all multicast packets in the packet pool: */
+	while(packetPoolHead!=0)
+		{
+		Packet* succ=packetPoolHead->succ;
+		delete packetPoolHead;
+		packetPoolHead=succ;
+		}
+	}
+
+void Multiplexer::sendPacketBatch(Packet* const packets[],unsigned int numPackets)
+	{
+	size_t numSendCalls=0;
+	size_t numSentBytes=0;
+	
+	#if CLUSTER_CONFIG_HAVE_MMSG
+	
+	struct mmsghdr messages[maxBatchSize];
+	struct iovec iovecs[maxBatchSize];
+	unsigned int messageFirstPackets[maxBatchSize];
+	#ifdef UDP_SEGMENT
+	union
+		{
+		char buffer[CMSG_SPACE(sizeof(uint16_t))];
+		struct cmsghdr align;
+		} controls[maxBatchSize];
+	#endif
+	unsigned int firstPacket=0;
+	while(firstPacket<numPackets)
+		{
+		/* Combine runs of same-sized packets into single messages if segmentation offload is enabled: */
+		#ifdef UDP_SEGMENT
+		unsigned int maxSegments=useSegmentationOffload?maxGsoSegments:1U;
+		#else
+		unsigned int maxSegments=1U;
+		#endif
+		unsigned int numMessages=0;
+		unsigned int packetIndex=firstPacket;
+		while(packetIndex<numPackets)
+			{
+			struct msghdr& header=messages[numMessages].msg_hdr;
+			memset(&header,0,sizeof(struct msghdr));
+			header.msg_name=otherAddress;
+			header.msg_namelen=sizeof(struct sockaddr_in);
+			header.msg_iov=&iovecs[packetIndex];
+			messageFirstPackets[numMessages]=packetIndex;
+			
+			/* Add packets of the same size as the first to the message until it is full or a shorter packet ends it: */
+			size_t segmentSize=packets[packetIndex]->packetSize+2*sizeof(unsigned int);
+			unsigned int numSegments=0;
+			while(packetIndex<numPackets&&numSegments<maxSegments)
+				{
+				Packet* packet=packets[packetIndex];
+				size_t rawPacketSize=packet->packetSize+2*sizeof(unsigned int);
+				if(rawPacketSize>segmentSize)
+					break;
+				iovecs[packetIndex].iov_base=&packet->pipeId;
+				iovecs[packetIndex].iov_len=rawPacketSize;
+				++packetIndex;
+				++numSegments;
+				if(rawPacketSize<segmentSize)
+					break;
+				}
+			header.msg_iovlen=numSegments;
+			
+			#ifdef UDP_SEGMENT
+			if(numSegments>1)
+				{
+				/* Ask the kernel to split the message into individual packets: */
+				header.msg_control=controls[numMessages].buffer;
+				header.msg_controllen=sizeof(controls[numMessages].buffer);
+				struct cmsghdr* cmsg=CMSG_FIRSTHDR(&header);
+				cmsg->cmsg_level=SOL_UDP;
+				cmsg->cmsg_type=UDP_SEGMENT;
+				cmsg->cmsg_len=CMSG_LEN(sizeof(uint16_t));
+				uint16_t gsoSegmentSize=uint16_t(segmentSize);
+				memcpy(CMSG_DATA(cmsg),&gsoSegmentSize,sizeof(uint16_t));
+				}
+			#endif
+			
+			++numMessages;
+			}
+		
+		/* Send all messages in as few system calls as possible: */
+		unsigned int numSentMessages=0;
+		while(numSentMessages<numMessages)
+			{
+			int result=sendmmsg(socketFd,messages+numSentMessages,numMessages-numSentMessages,0);
+			++numSendCalls;
+			if(result>0)
+				numSentMessages+=result;
+			else if(errno!=EINTR)
+				break;
+			}
+		
+		/* Account for the sent packets: */
+		unsigned int endPacket=numSentMessages<numMessages?messageFirstPackets[numSentMessages]:numPackets;
+		for(unsigned int i=firstPacket;i<endPacket;++i)
+			numSentBytes+=packets[i]->packetSize;
+		firstPacket=endPacket;
+		
+		if(numSentMessages<numMessages)
+			{
+			if(maxSegments>1)
+				{
+				/* The network path does not support segmentation offload; disable it and send the remaining packets individually: */
+				useSegmentationOffload=false;
+				}
+			else
+				{
+				/* Skip the failed packet like a lost packet; slaves will request it again: */
+				++firstPacket;
+				}
+			}
+		}
+	
+	#else
+	
+	/* Send the packets one at a time: */
+	// SocketMutex::Lock socketLock(socketMutex);
+	for(unsigned int i=0;i<numPackets;++i)
+		{
+		sendto(socketFd,&packets[i]->pipeId,packets[i]->packetSize+2*sizeof(unsigned int),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+		++numSendCalls;
+		numSentBytes+=packets[i]->packetSize;
+		}
+	
+	#endif
+	
+	/* Update the traffic statistics: */
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	trafficStatistics.numSendCalls+=numSendCalls;
+	trafficStatistics.numSentPackets+=numPackets;
+	trafficStatistics.numSentBytes+=numSentBytes;
+	}
+
+void Multiplexer::sendBulkPackets(unsigned int pipeId,const Multiplexer::PipeState& pipeState,unsigned int offset,unsigned int numPackets)
+	{
+	size_t numSendCalls=0;
+	size_t numSentBytes=0;
+	unsigned int numSentPackets=0;
 	
-	/* Delete all multicast packets in the packet pool: */
-	while(packetPoolHead!=0)
+	/* Send packets in batches, gathering each packet from a header and a slice of the caller's buffer: */
+	unsigned int headers[maxBatchSize][2];
+	struct iovec iovecs[maxBatchSize][2];
+	#if CLUSTER_CONFIG_HAVE_MMSG
+	struct mmsghdr messages[maxBatchSize];
+	#endif
+	while(numSentPackets<numPackets)
 		{
-		Packet* succ=packetPoolHead->succ;
-		delete packetPoolHead;
-		packetPoolHead=succ;
+		unsigned int batchSize=numPackets-numSentPackets<maxBatchSize?numPackets-numSentPackets:maxBatchSize;
+		for(unsigned int i=0;i<batchSize;++i,offset+=Packet::maxPacketSize)
+			{
+			size_t packetSize=pipeState.bulkSize-offset<Packet::maxPacketSize?pipeState.bulkSize-offset:Packet::maxPacketSize;
+			headers[i][0]=pipeId|bulkFlag;
+			headers[i][1]=pipeState.bulkStreamPos+offset;
+			iovecs[i][0].iov_base=headers[i];
+			iovecs[i][0].iov_len=2*sizeof(unsigned int);
+			iovecs[i][1].iov_base=const_cast<char*>(pipeState.bulkSendData+offset);
+			iovecs[i][1].iov_len=packetSize;
+			numSentBytes+=packetSize;
+			}
+		
+		#if CLUSTER_CONFIG_HAVE_MMSG
+		
+		/* Send the batch in as few system calls as possible: */
+		for(unsigned int i=0;i<batchSize;++i)
+			{
+			struct msghdr& header=messages[i].msg_hdr;
+			memset(&header,0,sizeof(struct msghdr));
+			header.msg_name=otherAddress;
+			header.msg_namelen=sizeof(struct sockaddr_in);
+			header.msg_iov=iovecs[i];
+			header.msg_iovlen=2;
+			}
+		unsigned int numSentMessages=0;
+		while(numSentMessages<batchSize)
+			{
+			int result=sendmmsg(socketFd,messages+numSentMessages,batchSize-numSentMessages,0);
+			++numSendCalls;
+			if(result>0)
+				numSentMessages+=result;
+			else if(errno!=EINTR)
+				{
+				/* Skip the failed packet like a lost packet; slaves will request it again: */
+				++numSentMessages;
+				}
+			}
+		
+		#else
+		
+		/* Send the packets one at a time: */
+		for(unsigned int i=0;i<batchSize;++i)
+			{
+			struct msghdr header;
+			memset(&header,0,sizeof(struct msghdr));
+			header.msg_name=otherAddress;
+			header.msg_namelen=sizeof(struct sockaddr_in);
+			header.msg_iov=iovecs[i];
+			header.msg_iovlen=2;
+			sendmsg(socketFd,&header,0);
+			++numSendCalls;
+			}
+		
+		#endif
+		
+		numSentPackets+=batchSize;
 		}
+	
+	/* Update the traffic statistics: */
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	trafficStatistics.numSendCalls+=numSendCalls;
+	trafficStatistics.numSentPackets+=numSentPackets;
+	trafficStatistics.numSentBytes+=numSentBytes;
+	trafficStatistics.numBulkPackets+=numSentPackets;
 	}
 
 int Multiplexer::getLocalPortNumber(void) const
@@ -1249,6 +2380,16 @@ void Multiplexer::setSendBufferSize(unsigned int newSendBufferSize)
 	sendBufferSize=newSendBufferSize;
 	}
 
+void Multiplexer::setFecGroupSize(unsigned int newFecGroupSize)
+	{
+	fecGroupSize=newFecGroupSize<=maxFecGroupSize?newFecGroupSize:maxFecGroupSize;
+	}
+
+void Multiplexer::setBulkWindowSize(unsigned int newBulkWindowSize)
+	{
+	bulkWindowSize=newBulkWindowSize>=minBulkWindowSize?newBulkWindowSize:minBulkWindowSize;
+	}
+
 void Multiplexer::waitForConnection(void)
 	{
 	{
@@ -1261,6 +2402,75 @@ void Multiplexer::waitForConnection(void)
 	}
 	}
 
+Multiplexer::TrafficStatistics Multiplexer::getTrafficStatistics(void) const
+	{
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	return trafficStatistics;
+	}
+
+Multiplexer::PipeStatistics Multiplexer::getPipeStatistics(unsigned int pipeId) const
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to query statistics of closed pipe",nodeIndex);
+	
+	PipeStatistics result;
+	getPipeStatistics(*pipeState,result);
+	return result;
+	}
+
+void Multiplexer::getPipeStatistics(std::vector<Multiplexer::PipeStatistics>& pipeStatistics) const
+	{
+	pipeStatistics.clear();
+	
+	{
+	/* Lock the pipe state table and query all pipes: */
+	Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
+	for(PipeHasher::ConstIterator psIt=pipeStateTable.begin();!psIt.isFinished();++psIt)
+		{
+		LockedPipe pipeState(psIt->getDest());
+		pipeStatistics.push_back(PipeStatistics());
+		getPipeStatistics(*pipeState,pipeStatistics.back());
+		}
+	}
+	
+	/* Sort the pipes' statistics by pipe ID: */
+	std::sort(pipeStatistics.begin(),pipeStatistics.end(),comparePipeIds);
+	}
+
+Multiplexer::SlaveStatistics Multiplexer::getSlaveStatistics(unsigned int slaveIndex) const
+	{
+	if(nodeIndex!=0)
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to query slave statistics on a slave node",nodeIndex);
+	if(slaveIndex<1||slaveIndex>numSlaves)
+		Misc::throwStdErr("Cluster::Multiplexer: Invalid slave index %u",slaveIndex);
+	
+	/* Copy the slave's accumulated statistics: */
+	SlaveStatistics result;
+	{
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	result=slaveStatistics[slaveIndex-1];
+	}
+	
+	/* Find the slave's largest stream lag across all pipes: */
+	{
+	Threads::Mutex::Lock pipeStateTableLock(pipeStateTableMutex);
+	for(PipeHasher::ConstIterator psIt=pipeStateTable.begin();!psIt.isFinished();++psIt)
+		{
+		LockedPipe pipeState(psIt->getDest());
+		bool bulk=pipeState->bulkSendData!=0;
+		unsigned int segmentStart=bulk?pipeState->bulkStreamPos:pipeState->headStreamPos;
+		unsigned int segmentEnd=bulk?pipeState->bulkStreamPos+pipeState->bulkSize:pipeState->streamPos;
+		unsigned int lag=segmentEnd-(segmentStart+pipeState->slaveStreamPosOffsets[slaveIndex-1]);
+		if(lag<0x80000000U&&result.maxStreamLag<lag)
+			result.maxStreamLag=lag;
+		}
+	}
+	
+	return result;
+	}
+
 unsigned int Multiplexer::openPipe(void)
 	{
 	/* Get the current thread's global ID: */
@@ -1278,7 +2488,7 @@ unsigned int Multiplexer::openPipe(void)
 	if(npIt.isFinished())
 		{
 		/* If the new pipe state hasn't been created already, do it here: */
-		newPipeState=new PipeState(nodeIndex,numSlaves);
+		newPipeState=new PipeState(nodeIndex,numSlaves,numChildren);
 		
 		/* Add the new pipe state to the new pipe map: */
 		// newPipes[threadId]=newPipeState; // Gives "potentially uninitialized" warning
@@ -1391,6 +2601,10 @@ unsigned int Multiplexer::openPipe(void)
 
 void Multiplexer::closePipe(unsigned int pipeId)
 	{
+	/* Send all asynchronously queued packets: */
+	if(nodeIndex==0)
+		flushAsync(pipeId);
+	
 	/* Execute a barrier to synchronize and flush the pipe before closing it: */
 	barrier(pipeId);
 	
@@ -1409,7 +2623,7 @@ void Multiplexer::closePipe(unsigned int pipeId)
 	if(nodeIndex==0)
 		{
 		std::cerr<<"Closing pipe "<<pipeId;
-		std::cerr<<". Re-sent "<<pipeState->numResentPackets<<" packets, "<<pipeState->numResentBytes<<" bytes"<<std::endl;
+		std::cerr<<". Re-sent "<<pipeState->statistics.numResentPackets<<" packets, "<<pipeState->statistics.numResentBytes<<" bytes"<<std::endl;
 		}
 	#endif
 	
@@ -1434,40 +2648,169 @@ void Multiplexer::closePipe(unsigned int pipeId)
 	}
 
 void Multiplexer::sendPacket(unsigned int pipeId,Packet* packet)
+	{
+	/* Send the packet as a batch of one: */
+	sendPackets(pipeId,&packet,1);
+	}
+
+void Multiplexer::sendPackets(unsigned int pipeId,Packet* const packets[],unsigned int numPackets)
+	{
+	while(numPackets>0)
+		{
+		Packet* batch[maxBatchSize];
+		unsigned int batchSize=0;
+		unsigned int numParityPackets=0;
+		{
+		/* Get a handle on the state object for the given pipe: */
+		LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+		if(!pipeState.isValid())
+			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to write to closed pipe",nodeIndex);
+		
+		/* Block if the pipe's send queue is full, or if asynchronously sent packets are still waiting to keep the stream in order: */
+		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
+		bool amBlocking=pipeState->packetList.size()>=sendBufferSize;
+		if(amBlocking)
+			std::cerr<<"Pipe "<<pipeId<<": Blocking on full send buffer"<<std::endl;
+		#endif
+		while(pipeState->packetList.size()>=sendBufferSize||!pipeState->asyncQueue.empty())
+			pipeState->receiveCond.wait(pipeState->stateMutex);
+		
+		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
+		if(amBlocking)
+			std::cerr<<"Pipe "<<pipeId<<": Woke up after blocking on full send buffer"<<std::endl;
+		#endif
+		
+		/* Append as many packets to the pipe's "recently sent" list as fit into the send queue: */
+		unsigned int numQueuedPackets=queuePackets(*pipeState,packets,numPackets,batch,batchSize,numParityPackets);
+		packets+=numQueuedPackets;
+		numPackets-=numQueuedPackets;
+		}
+		
+		/* Send the batch of packets across the UDP connection: */
+		sendQueuedBatch(batch,batchSize,numParityPackets);
+		}
+	}
+
+void Multiplexer::setAsyncSend(unsigned int pipeId,unsigned int newAsyncQueueSize,Multiplexer::AsyncQueuePolicy newAsyncQueuePolicy)
 	{
 	/* Get a handle on the state object for the given pipe: */
 	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
 	if(!pipeState.isValid())
-		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to write to closed pipe",nodeIndex);
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to configure closed pipe",nodeIndex);
 	
-	/* Block if the pipe's send queue is full: */
-	#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
-	bool amBlocking=pipeState->packetList.size()==sendBufferSize;
-	if(amBlocking)
-		std::cerr<<"Pipe "<<pipeId<<": Blocking on full send buffer"<<std::endl;
-	#endif
-	while(pipeState->packetList.size()==sendBufferSize)
-		pipeState->receiveCond.wait(pipeState->stateMutex);
+	/* Set the pipe's asynchronous send queue parameters: */
+	pipeState->asyncQueueSize=newAsyncQueueSize;
+	pipeState->asyncQueuePolicy=newAsyncQueuePolicy;
+	}
+
+unsigned int Multiplexer::sendAsync(unsigned int pipeId,Packet* packets,unsigned int numPackets,Multiplexer::AsyncSendCallback* callback)
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid()||pipeState->asyncQueueSize==0)
+		{
+		/* Return the message's packets to the pool and bail out: */
+		bool closed=!pipeState.isValid();
+		pipeState.unlock();
+		while(packets!=0)
+			{
+			Packet* succ=packets->succ;
+			deletePacket(packets);
+			packets=succ;
+			}
+		delete callback;
+		if(closed)
+			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to write to closed pipe",nodeIndex);
+		else
+			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to send asynchronously on synchronous pipe %u",nodeIndex,pipeId);
+		}
 	
-	#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER_VERBOSE
-	if(amBlocking)
-		std::cerr<<"Pipe "<<pipeId<<": Woke up after blocking on full send buffer"<<std::endl;
-	#endif
+	/* Create a descriptor for the new message: */
+	PipeState::AsyncMessage* message=new PipeState::AsyncMessage;
+	message->succ=0;
+	message->result.pipeId=pipeId;
+	message->result.messageId=++pipeState->lastAsyncMessageId;
+	message->result.messageSize=0;
+	for(Packet* pPtr=packets;pPtr!=0;pPtr=pPtr->succ)
+		message->result.messageSize+=pPtr->packetSize;
+	message->result.sent=false;
+	message->numPackets=numPackets;
+	message->started=false;
+	message->callback=callback;
 	
-	/* Append the packet to the pipe's "recently sent" list: */
-	packet->pipeId=pipeId;
-	packet->streamPos=pipeState->streamPos;
-	pipeState->streamPos+=packet->packetSize;
-	pipeState->packetList.push_back(packet);
+	/* Apply the queue policy while the message does not fit into the queue; messages larger than the entire queue are accepted once the queue is empty: */
+	while(!pipeState->asyncQueue.empty())
+		{
+		if(pipeState->asyncQueue.size()+numPackets<=pipeState->asyncQueueSize)
+			break;
+		
+		if(pipeState->asyncQueuePolicy==ASYNC_DROP_OLDEST&&dropOldestAsyncMessage(*pipeState))
+			continue;
+		
+		if(pipeState->asyncQueuePolicy==ASYNC_FAIL)
+			{
+			/* Return the message's packets to the pool and throw an exception: */
+			unsigned int queueSize=pipeState->asyncQueueSize;
+			pipeState.unlock();
+			while(packets!=0)
+				{
+				Packet* succ=packets->succ;
+				deletePacket(packets);
+				packets=succ;
+				}
+			delete message->callback;
+			delete message;
+			Misc::throwStdErr("Cluster::Multiplexer: Node %u: Message of %u packets does not fit into asynchronous send queue of %u packets on pipe %u",nodeIndex,numPackets,queueSize,pipeId);
+			}
+		
+		/* Wait until the packet handling thread has sent some queued packets: */
+		pipeState->receiveCond.wait(pipeState->stateMutex);
+		}
+	unsigned int messageId=message->result.messageId;
 	
-	/* It's safe to unlock the pipe state now: */
-	pipeState.unlock();
+	if(numPackets>0)
+		{
+		/* Append the message and its packets to the asynchronous send queue: */
+		if(pipeState->asyncMessageTail!=0)
+			pipeState->asyncMessageTail->succ=message;
+		else
+			pipeState->asyncMessageHead=message;
+		pipeState->asyncMessageTail=message;
+		while(packets!=0)
+			{
+			Packet* succ=packets->succ;
+			pipeState->asyncQueue.push_back(packets);
+			packets=succ;
+			}
+		
+		/* Send as much of the queue as fits into the send queue right away: */
+		drainAsyncQueue(*pipeState);
+		}
+	else
+		{
+		/* Report the empty message as sent immediately: */
+		message->result.sent=true;
+		if(message->callback!=0)
+			{
+			(*message->callback)(message->result);
+			delete message->callback;
+			}
+		delete message;
+		}
 	
-	/* Send the packet across the UDP connection: */
-	{
-	// SocketMutex::Lock socketLock(socketMutex);
-	sendto(socketFd,&packet->pipeId,packet->packetSize+2*sizeof(unsigned int),0,(const sockaddr*)otherAddress,sizeof(sockaddr_in));
+	return messageId;
 	}
+
+void Multiplexer::flushAsync(unsigned int pipeId)
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to flush closed pipe",nodeIndex);
+	
+	/* Wait until the packet handling thread has sent all queued packets: */
+	while(!pipeState->asyncQueue.empty())
+		pipeState->receiveCond.wait(pipeState->stateMutex);
 	}
 
 Packet* Multiplexer::receivePacket(unsigned int pipeId)
@@ -1503,13 +2846,216 @@ Packet* Multiplexer::receivePacket(unsigned int pipeId)
 	return pipeState->packetList.pop_front();
 	}
 
+void Multiplexer::sendBulkSegment(unsigned int pipeId,const char* data,unsigned int dataSize)
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to write to closed pipe",nodeIndex);
+	
+	/* Wait until all asynchronously sent packets have left the asynchronous send queue: */
+	while(!pipeState->asyncQueue.empty())
+		pipeState->receiveCond.wait(pipeState->stateMutex);
+	
+	/* Finish the current forward error correction group; its parity packet is not needed because slaves read all preceding data before receiving a bulk transfer: */
+	if(pipeState->fecNumPackets>0)
+		deletePacket(finishParityPacket(*pipeState));
+	
+	/* Wait until all slaves have acknowledged all preceding stream packets and are ready to receive: */
+	unsigned int bulkStreamPos=pipeState->streamPos;
+	while(true)
+		{
+		bool ready=pipeState->packetList.empty();
+		for(unsigned int i=0;i<numSlaves&&ready;++i)
+			ready=pipeState->slaveBulkReadyPos[i]==bulkStreamPos;
+		if(ready)
+			break;
+		pipeState->receiveCond.wait(pipeState->stateMutex);
+		}
+	
+	/* Start the bulk transfer, re-using the slaves' stream position offsets to track their progress: */
+	pipeState->bulkSendData=data;
+	pipeState->bulkStreamPos=bulkStreamPos;
+	pipeState->bulkSize=dataSize;
+	pipeState->bulkResendOffset=dataSize;
+	for(unsigned int i=0;i<numSlaves;++i)
+		pipeState->slaveStreamPosOffsets[i]=0;
+	
+	/* Send the transfer's packets using a sliding window that grows while all packets are acknowledged and shrinks on packet loss: */
+	unsigned int numPackets=(dataSize+Packet::maxPacketSize-1)/Packet::maxPacketSize;
+	unsigned int windowSize=initialBulkWindowSize<bulkWindowSize?initialBulkWindowSize:bulkWindowSize;
+	unsigned int windowCredit=0;
+	unsigned int numAckedPackets=0;
+	unsigned int nextPacket=0;
+	size_t numRewinds=0;
+	Misc::Time resendTime=Misc::Time::now()+Misc::Time(bulkResendTimeout);
+	unsigned int lastRewindBegin=0;
+	unsigned int lastRewindEnd=0;
+	Misc::Time rewindHoldoffTime=Misc::Time::now();
+	while(true)
+		{
+		/* Find the number of packets acknowledged by all slaves: */
+		unsigned int minOffset=pipeState->slaveStreamPosOffsets[0];
+		for(unsigned int i=1;i<numSlaves;++i)
+			if(minOffset>pipeState->slaveStreamPosOffsets[i])
+				minOffset=pipeState->slaveStreamPosOffsets[i];
+		if(minOffset==dataSize)
+			break;
+		unsigned int newNumAckedPackets=minOffset/Packet::maxPacketSize;
+		if(numAckedPackets<newNumAckedPackets)
+			{
+			/* Grow the window by one packet for each window's worth of acknowledged packets: */
+			windowCredit+=newNumAckedPackets-numAckedPackets;
+			while(windowCredit>=windowSize)
+				{
+				windowCredit-=windowSize;
+				if(windowSize<bulkWindowSize)
+					++windowSize;
+				}
+			numAckedPackets=newNumAckedPackets;
+			resendTime=Misc::Time::now()+Misc::Time(bulkResendTimeout);
+			}
+		if(nextPacket<numAckedPackets)
+			nextPacket=numAckedPackets;
+		
+		/* Go back to the first packet a slave reported lost, or to the first unacknowledged packet if acknowledgments stopped arriving: */
+		unsigned int rewindPacket=nextPacket;
+		Misc::Time now=Misc::Time::now();
+		if(pipeState->bulkResendOffset<dataSize)
+			{
+			/* Ignore reports of packets that were re-sent by a recent rewind, as they were most likely sent before the rewind took effect: */
+			unsigned int lostPacket=pipeState->bulkResendOffset/Packet::maxPacketSize;
+			if(lostPacket<lastRewindBegin||lostPacket>=lastRewindEnd||rewindHoldoffTime<=now)
+				rewindPacket=lostPacket;
+			pipeState->bulkResendOffset=dataSize;
+			}
+		else if(resendTime<=now)
+			rewindPacket=numAckedPackets;
+		if(rewindPacket<nextPacket)
+			{
+			lastRewindEnd=nextPacket;
+			nextPacket=rewindPacket>numAckedPackets?rewindPacket:numAckedPackets;
+			lastRewindBegin=nextPacket;
+			rewindHoldoffTime=now+Misc::Time(bulkRewindHoldoff);
+			resendTime=now+Misc::Time(bulkResendTimeout);
+			
+			/* Shrink the window: */
+			windowSize=windowSize/2>minBulkWindowSize?windowSize/2:minBulkWindowSize;
+			windowCredit=0;
+			++numRewinds;
+			}
+		
+		unsigned int windowEnd=numAckedPackets+windowSize<numPackets?numAckedPackets+windowSize:numPackets;
+		if(nextPacket<windowEnd)
+			{
+			/* Send the next batch of packets inside the window without holding the pipe lock: */
+			unsigned int batchSize=windowEnd-nextPacket<maxBatchSize?windowEnd-nextPacket:maxBatchSize;
+			pipeState->stateMutex.unlock();
+			sendBulkPackets(pipeId,*pipeState,nextPacket*Packet::maxPacketSize,batchSize);
+			pipeState->stateMutex.lock();
+			nextPacket+=batchSize;
+			}
+		else
+			{
+			/* Wait for acknowledgments or loss reports: */
+			pipeState->receiveCond.timedWait(pipeState->stateMutex,resendTime);
+			}
+		}
+	
+	/* Finish the bulk transfer and reset the pipe's flow control state: */
+	pipeState->bulkSendData=0;
+	pipeState->streamPos=bulkStreamPos+dataSize;
+	pipeState->headStreamPos=pipeState->streamPos;
+	for(unsigned int i=0;i<numSlaves;++i)
+		pipeState->slaveStreamPosOffsets[i]=0;
+	pipeState->numHeadSlaves=numSlaves;
+	
+	if(numRewinds>0)
+		{
+		Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+		trafficStatistics.numBulkRewinds+=numRewinds;
+		}
+	}
+
+void Multiplexer::receiveBulkSegment(unsigned int pipeId,char* data,unsigned int dataSize)
+	{
+	/* Get a handle on the state object for the given pipe: */
+	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
+	if(!pipeState.isValid())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to read from closed pipe",nodeIndex);
+	if(!pipeState->packetList.empty())
+		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Unread stream data before bulk transfer",nodeIndex);
+	
+	/* Install the caller's buffer as the destination of the bulk transfer: */
+	pipeState->bulkReceiveData=data;
+	pipeState->bulkStreamPos=pipeState->streamPos;
+	pipeState->bulkSize=dataSize;
+	pipeState->packetLossMode=false;
+	
+	/* Wait until the packet handling thread has received the entire transfer, and possibly stream packets following it: */
+	Misc::Time waitTimeout=Misc::Time::now();
+	unsigned int lastStreamPos=pipeState->streamPos;
+	bool sendRequest=true;
+	while(pipeState->streamPos-pipeState->bulkStreamPos<dataSize)
+		{
+		if(sendRequest)
+			{
+			/* Tell the master that this slave is ready, or request the missing data if no packets arrived during the timeout: */
+			StreamMessage msg(nodeIndex|0x80000000U,pipeState->streamPos==pipeState->bulkStreamPos?Message::BULKREADY:Message::PACKETLOSS,pipeId,pipeState->streamPos,pipeState->streamPos);
+			{
+			// SocketMutex::Lock socketLock(socketMutex);
+			for(int i=0;i<slaveMessageBurstSize;++i)
+				sendto(socketFd,&msg,sizeof(StreamMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
+			}
+			}
+		
+		/* Wait for the transfer to complete: */
+		waitTimeout+=receiveWaitTimeout;
+		pipeState->receiveCond.timedWait(pipeState->stateMutex,waitTimeout);
+		sendRequest=pipeState->streamPos==lastStreamPos;
+		lastStreamPos=pipeState->streamPos;
+		}
+	
+	/* Uninstall the caller's buffer: */
+	pipeState->bulkReceiveData=0;
+	}
+
+void Multiplexer::sendBulk(unsigned int pipeId,const void* data,size_t dataSize)
+	{
+	/* Send the data in segments small enough to keep stream positions unambiguous: */
+	const char* dataPtr=static_cast<const char*>(data);
+	while(dataSize>0)
+		{
+		size_t segmentSize=dataSize<maxBulkSegmentSize?dataSize:maxBulkSegmentSize;
+		sendBulkSegment(pipeId,dataPtr,(unsigned int)segmentSize);
+		dataPtr+=segmentSize;
+		dataSize-=segmentSize;
+		}
+	}
+
+void Multiplexer::receiveBulk(unsigned int pipeId,void* data,size_t dataSize)
+	{
+	/* Receive the data in the same segments as it was sent: */
+	char* dataPtr=static_cast<char*>(data);
+	while(dataSize>0)
+		{
+		size_t segmentSize=dataSize<maxBulkSegmentSize?dataSize:maxBulkSegmentSize;
+		receiveBulkSegment(pipeId,dataPtr,(unsigned int)segmentSize);
+		dataPtr+=segmentSize;
+		dataSize-=segmentSize;
+		}
+	}
+
 void Multiplexer::barrier(unsigned int pipeId)
 	{
 	/* Get a handle on the state object for the given pipe: */
 	LockedPipe pipeState(pipeStateTable,pipeStateTableMutex,pipeId);
 	if(!pipeState.isValid())
 		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to synchronize closed pipe",nodeIndex);
-		
+	
+	/* Start measuring the time spent waiting in the barrier: */
+	Realtime::TimePointMonotonic waitTimer;
+	
 	/* Bump up barrier ID: */
 	unsigned int nextBarrierId=pipeState->barrierId+1;
 	
@@ -1553,22 +3099,41 @@ void Multiplexer::barrier(unsigned int pipeId)
 		}
 	else
 		{
-		/* Send barrier messages to master until barrier completion message is received: */
-		Misc::Time waitTimeout=Misc::Time::now();
+		/* Report the arrival of this slave's subtree to its parent until barrier completion message is received: */
+		Misc::Time sendTime=Misc::Time::now();
+		unsigned int numSends=0;
 		while(pipeState->barrierId<nextBarrierId)
 			{
-			/* Send barrier message to master: */
-			BarrierMessage msg(nodeIndex|0x80000000U,Message::BARRIER,pipeId,nextBarrierId);
-			{
-			// SocketMutex::Lock socketLock(socketMutex);
-			sendto(socketFd,&msg,sizeof(BarrierMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
-			}
-			
-			/* Wait for arrival of barrier completion message: */
+			Misc::Time now=Misc::Time::now();
+			Misc::Time waitTimeout=now;
 			waitTimeout+=barrierWaitTimeout;
+			
+			/* Check if all children in the barrier tree have arrived: */
+			if(numChildren==0||pipeState->minSlaveBarrierId>=nextBarrierId)
+				{
+				if(now>=sendTime)
+					{
+					/* Send barrier message to the parent, and to the master as well if the parent might have missed the barrier completion message: */
+					sendArrival(pipeId,Message::BARRIER,nextBarrierId,0,false);
+					if(numSends>0&&parentIndex!=0)
+						sendArrival(pipeId,Message::BARRIER,nextBarrierId,0,true);
+					++numSends;
+					sendTime=waitTimeout;
+					}
+				else
+					waitTimeout=sendTime;
+				}
+			
+			/* Wait for arrival of barrier completion message or of the remaining children: */
 			pipeState->barrierCond.timedWait(pipeState->stateMutex,waitTimeout);
 			}
 		}
+	
+	/* Record the time spent waiting in the barrier: */
+	double waitTime=waitTimer.setAndDiff();
+	pipeState->statistics.barrierWaits.addWait(waitTime);
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	trafficStatistics.barrierWaits.addWait(waitTime);
 	}
 
 unsigned int Multiplexer::gather(unsigned int pipeId,unsigned int value,GatherOperation::OpCode op)
@@ -1578,6 +3143,9 @@ unsigned int Multiplexer::gather(unsigned int pipeId,unsigned int value,GatherOp
 	if(!pipeState.isValid())
 		Misc::throwStdErr("Cluster::Multiplexer: Node %u: Attempt to gather on closed pipe",nodeIndex);
 	
+	/* Start measuring the time spent waiting in the gather operation: */
+	Realtime::TimePointMonotonic waitTimer;
+	
 	/* Bump up barrier ID: */
 	unsigned int nextBarrierId=pipeState->barrierId+1;
 	
@@ -1593,42 +3161,8 @@ unsigned int Multiplexer::gather(unsigned int pipeId,unsigned int value,GatherOp
 		/* Mark the gathering operation as completed: */
 		pipeState->barrierId=nextBarrierId;
 		
-		/* Calculate the final gather value: */
-		pipeState->masterGatherValue=value;
-		switch(op)
-			{
-			case GatherOperation::AND:
-				for(unsigned int i=0;i<numSlaves;++i)
-					pipeState->masterGatherValue=pipeState->masterGatherValue&&pipeState->slaveGatherValues[i];
-				break;
-			
-			case GatherOperation::OR:
-				for(unsigned int i=0;i<numSlaves;++i)
-					pipeState->masterGatherValue=pipeState->masterGatherValue||pipeState->slaveGatherValues[i];
-				break;
-			
-			case GatherOperation::MIN:
-				for(unsigned int i=0;i<numSlaves;++i)
-					if(pipeState->masterGatherValue>pipeState->slaveGatherValues[i])
-						pipeState->masterGatherValue=pipeState->slaveGatherValues[i];
-				break;
-			
-			case GatherOperation::MAX:
-				for(unsigned int i=0;i<numSlaves;++i)
-					if(pipeState->masterGatherValue<pipeState->slaveGatherValues[i])
-						pipeState->masterGatherValue=pipeState->slaveGatherValues[i];
-				break;
-			
-			case GatherOperation::SUM:
-				for(unsigned int i=0;i<numSlaves;++i)
-					pipeState->masterGatherValue+=pipeState->slaveGatherValues[i];
-				break;
-			
-			case GatherOperation::PRODUCT:
-				for(unsigned int i=0;i<numSlaves;++i)
-					pipeState->masterGatherValue*=pipeState->slaveGatherValues[i];
-				break;
-			}
+		/* Calculate the final gather value from the master's and its children's subtrees' values: */
+		pipeState->masterGatherValue=combineGatherValues(value,pipeState->slaveGatherValues,numChildren,op);
 		
 		/* Send gather completion message to all slaves: */
 		GatherMessage msg(0,Message::GATHER,pipeId,nextBarrierId,pipeState->masterGatherValue);
@@ -1658,23 +3192,45 @@ unsigned int Multiplexer::gather(unsigned int pipeId,unsigned int value,GatherOp
 		}
 	else
 		{
-		/* Send barrier messages to master until barrier completion message is received: */
-		Misc::Time waitTimeout=Misc::Time::now();
+		/* Report the arrival and gather value of this slave's subtree to its parent until gather completion message is received: */
+		Misc::Time sendTime=Misc::Time::now();
+		unsigned int numSends=0;
 		while(pipeState->barrierId<nextBarrierId)
 			{
-			/* Send gather message to master: */
-			GatherMessage msg(nodeIndex|0x80000000U,Message::GATHER,pipeId,nextBarrierId,value);
-			{
-			// SocketMutex::Lock socketLock(socketMutex);
-			sendto(socketFd,&msg,sizeof(GatherMessage),0,(const sockaddr*)otherAddress,sizeof(struct sockaddr_in));
-			}
-			
-			/* Wait for arrival of barrier completion message: */
+			Misc::Time now=Misc::Time::now();
+			Misc::Time waitTimeout=now;
 			waitTimeout+=barrierWaitTimeout;
+			
+			/* Check if all children in the barrier tree have arrived: */
+			if(numChildren==0||pipeState->minSlaveBarrierId>=nextBarrierId)
+				{
+				if(now>=sendTime)
+					{
+					/* Send the subtree's gather value to the parent, and to the master as well if the parent might have missed the gather completion message: */
+					unsigned int subtreeValue=combineGatherValues(value,pipeState->slaveGatherValues,numChildren,op);
+					sendArrival(pipeId,Message::GATHER,nextBarrierId,subtreeValue,false);
+					if(numSends>0&&parentIndex!=0)
+						sendArrival(pipeId,Message::GATHER,nextBarrierId,subtreeValue,true);
+					++numSends;
+					sendTime=waitTimeout;
+					}
+				else
+					waitTimeout=sendTime;
+				}
+			
+			/* Wait for arrival of gather completion message or of the remaining children: */
 			pipeState->barrierCond.timedWait(pipeState->stateMutex,waitTimeout);
 			}
 		}
 	
+	/* Record the time spent waiting in the gather operation: */
+	double waitTime=waitTimer.setAndDiff();
+	pipeState->statistics.gatherWaits.addWait(waitTime);
+	{
+	Threads::Spinlock::Lock trafficStatisticsLock(trafficStatisticsMutex);
+	trafficStatistics.gatherWaits.addWait(waitTime);
+	}
+	
 	/* Return the master gather value: */
 	return pipeState->masterGatherValue;
 	}
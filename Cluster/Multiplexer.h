@@ -1,7 +1,7 @@
 /***********************************************************************
 Multiplexer - Class to share several intra-cluster multicast pipes
 across a single UDP socket connection.
-Copyright (c) 2005-2012 Oliver Kreylos
+Copyright (c) 2005-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -24,7 +24,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #define CLUSTER_MULTIPLEXER_INCLUDED
 
 #include <string>
+#include <vector>
 #include <Misc/HashTable.h>
+#include <Misc/FunctionCalls.h>
 #include <Misc/Time.h>
 #include <Threads/Thread.h>
 #include <Threads/Mutex.h>
@@ -43,6 +45,129 @@ namespace Cluster {
 class Multiplexer
 	{
 	/* Embedded classes: */
+	public:
+	static const unsigned int maxBatchSize=64; // Maximum number of packets sent or received in a single system call
+	static const unsigned int maxFecGroupSize=127; // Maximum number of data packets protected by a single forward error correction parity packet
+	static const size_t fecHeaderSize=2*sizeof(unsigned int); // Size of the header of forward error correction parity packets
+	static const unsigned int numWaitTimeBins=16; // Number of bins in barrier and gather wait time histograms
+	
+	enum AsyncQueuePolicy // Enumerated type for policies applied when a message does not fit into a pipe's asynchronous send queue
+		{
+		ASYNC_BLOCK, // Block the sender until the packet handling thread has made room in the queue
+		ASYNC_DROP_OLDEST, // Drop the oldest queued messages that have not started sending; block if there are none; slaves only see a consistent byte stream if they can tell messages apart, see MulticastPipe::beginMessage
+		ASYNC_FAIL // Throw an exception without queueing the message
+		};
+	
+	struct AsyncSendResult // Structure reporting the outcome of an asynchronously sent message to its completion callback
+		{
+		/* Elements: */
+		public:
+		unsigned int pipeId; // ID of the pipe on which the message was sent
+		unsigned int messageId; // Sequence number of the message on its pipe, starting from 1
+		size_t messageSize; // Size of the message in bytes
+		bool sent; // True if all of the message's packets were sent to the slaves; false if the message was dropped to make room in the queue
+		};
+	
+	typedef Misc::FunctionCall<const AsyncSendResult&> AsyncSendCallback; // Type for callback functions called when an asynchronously sent message has been sent or dropped; called with the pipe's state locked, from the sending thread or the packet handling thread
+	
+	struct WaitTimeHistogram // Structure counting the times spent waiting in barriers or gather operations in logarithmic bins
+		{
+		/* Elements: */
+		public:
+		size_t numWaits; // Total number of waits
+		double totalWaitTime; // Total time spent waiting in seconds
+		double maxWaitTime; // Longest time spent waiting in seconds
+		size_t bins[numWaitTimeBins]; // Number of waits per bin; bin i counts waits shorter than 2^(i+4) microseconds and not shorter than those counted in bin i-1; last bin counts all longer waits
+		
+		/* Constructors and destructors: */
+		WaitTimeHistogram(void); // Creates an empty histogram
+		
+		/* Methods: */
+		static double getBinLimit(unsigned int binIndex) // Returns the upper limit of waits counted in the given bin in seconds
+			{
+			return double(1U<<(binIndex+4))*1.0e-6;
+			}
+		void addWait(double waitTime); // Adds a wait of the given duration in seconds to the histogram
+		double getAverageWaitTime(void) const // Returns the average time spent waiting in seconds
+			{
+			return numWaits>0?totalWaitTime/double(numWaits):0.0;
+			}
+		};
+	
+	struct TrafficStatistics // Structure reporting the amount of stream traffic handled by a multiplexer
+		{
+		/* Elements: */
+		public:
+		size_t numSendCalls; // Number of system calls used to send stream packets
+		size_t numSentPackets; // Number of stream packets sent, including re-sent packets
+		size_t numSentBytes; // Number of stream payload bytes sent, including re-sent packets
+		size_t numReceiveCalls; // Number of system calls used to receive packets
+		size_t numReceivedPackets; // Number of packets received
+		size_t numReceivedBytes; // Number of raw bytes received
+		size_t numParityPackets; // Number of forward error correction parity packets sent
+		size_t numRecoveredPackets; // Number of lost stream packets reconstructed from parity packets
+		size_t numLossNacks; // Number of stream packet losses reported to the master because they could not be reconstructed
+		size_t numBulkPackets; // Number of bulk transfer packets sent or received, including re-sent packets
+		size_t numBulkRewinds; // Number of times the master re-sent bulk transfer packets after a loss report or timeout
+		size_t numResentPackets; // Number of stream packets the master re-sent after loss reports from slaves
+		size_t numResentBytes; // Number of stream payload bytes the master re-sent after loss reports from slaves
+		WaitTimeHistogram barrierWaits; // Times spent waiting in barriers on all pipes
+		WaitTimeHistogram gatherWaits; // Times spent waiting in gather operations on all pipes
+		
+		/* Constructors and destructors: */
+		TrafficStatistics(void)
+			:numSendCalls(0),numSentPackets(0),numSentBytes(0),
+			 numReceiveCalls(0),numReceivedPackets(0),numReceivedBytes(0),
+			 numParityPackets(0),numRecoveredPackets(0),numLossNacks(0),
+			 numBulkPackets(0),numBulkRewinds(0),
+			 numResentPackets(0),numResentBytes(0)
+			{
+			}
+		};
+	
+	struct PipeStatistics // Structure reporting the traffic and synchronization behavior of a single pipe
+		{
+		/* Elements: */
+		public:
+		unsigned int pipeId; // ID of the pipe
+		unsigned int streamPos; // Current stream position of the pipe
+		size_t numPackets; // Number of stream packets sent by the master or delivered on a slave, not including re-sent packets
+		size_t numBytes; // Number of stream payload bytes sent by the master or delivered on a slave, not including re-sent packets
+		size_t numResentPackets; // Number of stream packets the master re-sent after loss reports
+		size_t numResentBytes; // Number of stream payload bytes the master re-sent after loss reports
+		size_t numLossNacks; // Number of loss reports received by the master or sent by a slave
+		unsigned int maxSlaveLag; // Number of stream bytes sent by the master that the furthest-behind slave has not acknowledged yet (master only)
+		unsigned int maxLagSlaveIndex; // Node index of the furthest-behind slave, or 0 if no slave is behind (master only)
+		unsigned int numQueuedPackets; // Number of packets currently waiting in the pipe's asynchronous send queue (master only)
+		size_t numDroppedMessages; // Number of asynchronously sent messages dropped because the queue was full (master only)
+		WaitTimeHistogram barrierWaits; // Times spent waiting in barriers on the pipe
+		WaitTimeHistogram gatherWaits; // Times spent waiting in gather operations on the pipe
+		
+		/* Constructors and destructors: */
+		PipeStatistics(void)
+			:pipeId(0),streamPos(0),
+			 numPackets(0),numBytes(0),numResentPackets(0),numResentBytes(0),numLossNacks(0),
+			 maxSlaveLag(0),maxLagSlaveIndex(0),
+			 numQueuedPackets(0),numDroppedMessages(0)
+			{
+			}
+		};
+	
+	struct SlaveStatistics // Structure reporting the health of a slave node as observed by the master
+		{
+		/* Elements: */
+		public:
+		size_t numLossNacks; // Number of loss reports received from the slave on all pipes
+		size_t numLastArrivals; // Number of barriers and gather operations in which the slave, or the part of the barrier tree reporting through the slave, was the last to arrive
+		unsigned int maxStreamLag; // Largest number of stream bytes the slave has not acknowledged yet on any pipe
+		
+		/* Constructors and destructors: */
+		SlaveStatistics(void)
+			:numLossNacks(0),numLastArrivals(0),maxStreamLag(0)
+			{
+			}
+		};
+	
 	private:
 	struct PipeState // Structure storing the current state of a pipe
 		{
@@ -81,6 +206,17 @@ class Multiplexer
 			Packet* pop_front(void); // Removes the packet at the front of the list and returns pointer to it
 			};
 		
+		struct AsyncMessage // Structure describing a message in a pipe's asynchronous send queue
+			{
+			/* Elements: */
+			public:
+			AsyncMessage* succ; // Pointer to the next message in the queue
+			AsyncSendResult result; // Result reported to the message's completion callback
+			unsigned int numPackets; // Number of the message's packets still waiting in the queue
+			bool started; // Flag whether some of the message's packets have already been sent
+			AsyncSendCallback* callback; // Callback called when the message has been sent or dropped, or null
+			};
+		
 		/* Elements: */
 		public:
 		Threads::Mutex stateMutex; // Mutex serializing access to the pipe state
@@ -94,17 +230,31 @@ class Multiplexer
 		unsigned int* slaveStreamPosOffsets; // Array of stream positions of the slaves relative to beginning of packet list
 		unsigned int numHeadSlaves; // Number of slaves that still have not acknowledged the first packet in the packet list
 		unsigned int barrierId; // Unique identifier of last completed barrier in pipe
-		unsigned int* slaveBarrierIds; // Array of most recently received barrier messages from the slaves
+		unsigned int* slaveBarrierIds; // Array of most recently received barrier messages from the node's children in the barrier tree (from all slaves on the master during pipe creation)
 		unsigned int minSlaveBarrierId; // Smallest barrier ID currently in the state array
-		unsigned int* slaveGatherValues; // Array of most recently received gather values from the slaves
+		unsigned int* slaveGatherValues; // Array of most recently received gather values from the node's children in the barrier tree
 		unsigned int masterGatherValue; // Final value of last completed gather operation in pipe
-		#if CLUSTER_CONFIG_DEBUG_MULTIPLEXER
-		size_t numResentPackets;
-		size_t numResentBytes;
-		#endif
+		Packet* fecPacket; // Packet accumulating the parity of the current forward error correction group
+		unsigned int fecGroupStart; // Stream position of the first packet of the current forward error correction group
+		unsigned int fecNumPackets; // Number of packets accumulated into the current forward error correction group
+		bool fecValid; // Flag whether the accumulated parity covers all packets of the current group received so far (slave side only)
+		PacketList fecPendingList; // List of out-of-order packets held back on slaves until lost packets are reconstructed or re-sent
+		const char* bulkSendData; // Caller's buffer holding the data of the current bulk transfer on the master, or null
+		char* bulkReceiveData; // Caller's buffer receiving the data of the current bulk transfer on a slave, or null
+		unsigned int bulkStreamPos; // Stream position of the beginning of the current or most recent bulk transfer
+		unsigned int bulkSize; // Size of the current or most recent bulk transfer
+		unsigned int bulkResendOffset; // Offset from which the master has to re-send bulk transfer data after a slave reported packet loss; equal to bulkSize if there was no report
+		unsigned int* slaveBulkReadyPos; // Array of stream positions at which the slaves are ready to receive the next bulk transfer (master side only)
+		PipeStatistics statistics; // Traffic and synchronization statistics of the pipe
+		unsigned int asyncQueueSize; // Maximum number of packets waiting in the asynchronous send queue; 0 if the pipe does not send asynchronously (master side only)
+		AsyncQueuePolicy asyncQueuePolicy; // Policy applied when a message does not fit into the asynchronous send queue
+		PacketList asyncQueue; // Queue of packets sent asynchronously, waiting for room in the packet list
+		AsyncMessage* asyncMessageHead; // First message in the asynchronous send queue
+		AsyncMessage* asyncMessageTail; // Last message in the asynchronous send queue
+		unsigned int lastAsyncMessageId; // Sequence number of the most recently queued asynchronous message
 		
 		/* Constructors and destructors: */
-		PipeState(unsigned int nodeIndex,unsigned int numSlaves); // Creates empty pipe state
+		PipeState(unsigned int nodeIndex,unsigned int numSlaves,unsigned int numChildren); // Creates empty pipe state for a node with the given number of children in the barrier tree
 		~PipeState(void); // Destroys a pipe state and all buffers in its delivery queue
 		};
 	
@@ -185,13 +335,13 @@ class Multiplexer
 	int socketFd; // File descriptor for the UDP socket
 	bool connected; // Flag to indicate whether connection between master and all slaves has been established
 	Threads::MutexCond connectionCond; // Condition variable to wait on for connection establishment
-	Threads::Mutex pipeStateTableMutex; // Mutex serializing access to the the pipe state table
+	mutable Threads::Mutex pipeStateTableMutex; // Mutex serializing access to the the pipe state table
 	NewPipeHasher newPipes; // Hash table to map from thread IDs to pipe states not completely opened yet
 	unsigned int lastPipeId; // ID of the most-recently created pipe
 	PipeHasher pipeStateTable; // Hash table to map from pipe IDs to pipe state table entries
 	void* messageBuffer; // A buffer to receive message packets on the master node
 	Threads::Thread packetHandlingThread; // Packet handling thread
-	Packet* slaveThreadPacket; // Pointer to the one packet always held by the packet handling thread on slave nodes
+	Packet* slaveThreadPackets[maxBatchSize]; // Array of packets always held by the packet handling thread on slave nodes to receive batches of packets
 	int masterMessageBurstSize; // Number of server messages sent in a single burst
 	int slaveMessageBurstSize; // Number of client messages sent in a single burst
 	Misc::Time connectionWaitTimeout; // Timeout between connection messages from the slaves
@@ -202,16 +352,47 @@ class Multiplexer
 	unsigned int sendBufferSize; // Maximum number of packets buffered for each pipe
 	Threads::Spinlock packetPoolMutex; // Mutex protecting the free packet pool
 	Packet* packetPoolHead; // Pool of recently deleted packets to minimize number of new/delete calls
+	bool useSegmentationOffload; // Flag whether the master sends runs of full-sized packets as single UDP generic segmentation offload messages
+	unsigned int fecGroupSize; // Number of data packets protected by each forward error correction parity packet; 0 disables forward error correction
+	unsigned int bulkWindowSize; // Maximum number of unacknowledged packets the master sends ahead during bulk transfers
+	unsigned int barrierTreeDegree; // Maximum number of children of each node in the barrier tree; 0 makes all slaves children of the master
+	unsigned int parentIndex; // Node index of this node's parent in the barrier tree
+	struct sockaddr_in* parentAddress; // Pointer to socket address of this node's parent in the barrier tree if the parent is a slave
+	unsigned int firstChildIndex; // Node index of this node's first child in the barrier tree
+	unsigned int numChildren; // Number of this node's children in the barrier tree
+	void* connectionMessage; // Connection message sent by the master to the slaves, containing the barrier tree's layout
+	size_t connectionMessageSize; // Size of the connection message in bytes
+	mutable Threads::Spinlock trafficStatisticsMutex; // Mutex protecting the traffic statistics
+	TrafficStatistics trafficStatistics; // Amount of stream traffic handled so far
+	SlaveStatistics* slaveStatistics; // Array of health statistics of the slaves as observed by the master (master side only); protected by the traffic statistics mutex
 	
 	/* Private methods: */
+	void setBarrierTree(unsigned int newBarrierTreeDegree); // Calculates this node's place in a barrier tree of the given degree
+	void recordArrival(PipeState& pipeState,unsigned int childIndex,unsigned int barrierId); // Records the arrival of the subtree rooted at the given child of this node at a barrier or gather operation
+	void sendArrival(unsigned int pipeId,int messageId,unsigned int barrierId,unsigned int value,bool toMaster); // Reports the arrival of the subtree rooted at this slave at a barrier or gather operation to its parent in the barrier tree, or directly to the master
+	void getPipeStatistics(const PipeState& pipeState,PipeStatistics& statistics) const; // Copies the given pipe's statistics and calculates its slaves' stream lag
 	Packet* allocatePacket(void);
+	void sendPacketBatch(Packet* const packets[],unsigned int numPackets); // Sends at most maxBatchSize stream packets to the slaves using as few system calls as possible
 	void processAcknowledgment(LockedPipe& pipeState,int slaveIndex,unsigned int streamPos); // Processes an acknowlegment (positive or implied-positive) from a slave
+	Packet* finishParityPacket(PipeState& pipeState); // Finishes the current forward error correction group of the given pipe on the master and returns its parity packet
+	unsigned int queuePackets(PipeState& pipeState,Packet* const packets[],unsigned int numPackets,Packet* batch[],unsigned int& batchSize,unsigned int& numParityPackets); // Appends as many of the given packets to the given pipe's packet list as fit into the send queue and the given batch, adding parity packets to the batch as needed; returns number of appended packets
+	void sendQueuedBatch(Packet* const batch[],unsigned int batchSize,unsigned int numParityPackets); // Sends a batch created by queuePackets and deletes its parity packets
+	void drainAsyncQueue(PipeState& pipeState); // Sends packets from the given pipe's asynchronous send queue while there is room in its packet list
+	bool dropOldestAsyncMessage(PipeState& pipeState); // Drops the oldest message from the given pipe's asynchronous send queue that has not started sending; returns false if there is no such message
+	void sendPacketLoss(PipeState& pipeState,unsigned int packetStreamPos); // Reports packet loss on the given pipe to the master and enters packet loss mode
+	void deliverPacket(PipeState& pipeState,Packet* packet,unsigned int& sendAckIn); // Appends the next expected stream packet to the given pipe's delivery queue on a slave
+	void deliverPendingPackets(PipeState& pipeState,unsigned int& sendAckIn); // Delivers held-back packets that have become the next expected stream packets on a slave
+	void processParityPacket(PipeState& pipeState,const Packet* parityPacket,unsigned int& sendAckIn); // Reconstructs a lost packet from the given parity packet on a slave, or reports packet loss to the master
+	void sendBulkPackets(unsigned int pipeId,const PipeState& pipeState,unsigned int offset,unsigned int numPackets); // Sends the given range of packets of the current bulk transfer directly from the caller's buffer
+	void processBulkPacket(PipeState& pipeState,const Packet* packet); // Copies a received bulk transfer packet into the destination buffer on a slave
+	void sendBulkSegment(unsigned int pipeId,const char* data,unsigned int dataSize); // Sends a bulk transfer segment that fits into the stream position range
+	void receiveBulkSegment(unsigned int pipeId,char* data,unsigned int dataSize); // Receives a bulk transfer segment that fits into the stream position range
 	void* packetHandlingThreadMaster(void); // Packet handling thread method for the master
 	void* packetHandlingThreadSlave(void); // Packet handling thread method for the slaves
 	
 	/* Constructors and destructors: */
 	public:
-	Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::string masterHostName,int masterPortNumber,std::string slaveMulticastGroup,int slavePortNumber);
+	Multiplexer(unsigned int sNumSlaves,unsigned int sNodeIndex,std::string masterHostName,int masterPortNumber,std::string slaveMulticastGroup,int slavePortNumber,unsigned int sBarrierTreeDegree =0); // Creates a multiplexer; barrier tree degree is the maximum number of children of each node in the tree along which slaves report barriers and gather operations to the master, and is only used on the master; 0 makes all slaves report directly to the master
 	~Multiplexer(void);
 	
 	/* Methods: */
@@ -256,7 +437,25 @@ class Multiplexer
 	void setReceiveWaitTimeout(Misc::Time newReceiveWaitTimeout); // Sets the timeout when waiting for data packages
 	void setBarrierWaitTimeout(Misc::Time newBarrierWaitTimeout); // Sets the timeout when waiting for barrier messages
 	void setSendBufferSize(unsigned int newSendBufferSize); // Sets the maximum number of packets held in each pipe's send queue
+	void setFecGroupSize(unsigned int newFecGroupSize); // Sets the number of data packets protected by each forward error correction parity packet on the master; 0 disables forward error correction; must be called before any pipes are opened
+	unsigned int getFecGroupSize(void) const // Returns the number of data packets protected by each parity packet
+		{
+		return fecGroupSize;
+		}
+	void setBulkWindowSize(unsigned int newBulkWindowSize); // Sets the maximum number of unacknowledged packets the master sends ahead during bulk transfers
+	unsigned int getBarrierTreeDegree(void) const // Returns the maximum number of children of each node in the barrier tree
+		{
+		return barrierTreeDegree;
+		}
+	size_t getMaxPacketDataSize(void) const // Returns the maximum amount of data pipes can send in a single packet
+		{
+		return fecGroupSize>0?Packet::maxPacketSize-fecHeaderSize:Packet::maxPacketSize;
+		}
 	void waitForConnection(void); // Waits until all slaves have connected to the master
+	TrafficStatistics getTrafficStatistics(void) const; // Returns the amount of stream traffic handled so far
+	PipeStatistics getPipeStatistics(unsigned int pipeId) const; // Returns the statistics of the pipe of the given ID
+	void getPipeStatistics(std::vector<PipeStatistics>& pipeStatistics) const; // Returns the statistics of all currently open pipes, in order of pipe IDs
+	SlaveStatistics getSlaveStatistics(unsigned int slaveIndex) const; // Returns the health statistics of the slave of the given node index (1 to number of slaves); must only be called on the master
 	
 	/* Pipe management interface: */
 	unsigned int openPipe(void); // Creates a new multicast pipe and returns its pipe ID
@@ -264,7 +463,13 @@ class Multiplexer
 	
 	/* Pipe communication interface: */
 	void sendPacket(unsigned int pipeId,Packet* packet); // Sends a packet from the master to the slaves
+	void sendPackets(unsigned int pipeId,Packet* const packets[],unsigned int numPackets); // Sends a sequence of packets from the master to the slaves in as few system calls as possible
+	void setAsyncSend(unsigned int pipeId,unsigned int newAsyncQueueSize,AsyncQueuePolicy newAsyncQueuePolicy); // Sets the maximum number of packets waiting in the given pipe's asynchronous send queue on the master, and the policy applied when a message does not fit; 0 disables asynchronous sending after the queue has drained
+	unsigned int sendAsync(unsigned int pipeId,Packet* packets,unsigned int numPackets,AsyncSendCallback* callback); // Queues a message consisting of the given list of packets, linked via their succ pointers, for sending without waiting for slave acknowledgments; multiplexer adopts packets and callback object; returns the message's sequence number
+	void flushAsync(unsigned int pipeId); // Blocks until all packets in the given pipe's asynchronous send queue have been sent
 	Packet* receivePacket(unsigned int pipeId); // Receives a packet from the master
+	void sendBulk(unsigned int pipeId,const void* data,size_t dataSize); // Sends a block of data from the master to the slaves directly from the caller's buffer; blocks until all slaves have received the data
+	void receiveBulk(unsigned int pipeId,void* data,size_t dataSize); // Receives a block of data sent by sendBulk directly into the caller's buffer; all previously sent stream data must have been read
 	void barrier(unsigned int pipeId); // Waits until all nodes (master + slaves) have reached the same point in the program
 	unsigned int gather(unsigned int pipeId,unsigned int value,GatherOperation::OpCode op); // Exchanges a single value between all nodes (master + slaves); implies a barrier
 	};
@@ -0,0 +1,352 @@
+/***********************************************************************
+NetworkEmulator - Class to relay the UDP traffic between a cluster
+multiplexer's master and slave nodes running on the same host, emulating
+a multicast network with configurable packet loss, packet reordering,
+latency, and bandwidth limits.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <Cluster/NetworkEmulator.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <Misc/ThrowStdErr.h>
+
+namespace Cluster {
+
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+const size_t maxDatagramSize=65536; // Maximum size of a UDP datagram
+const int socketBufferSize=4*1024*1024; // Requested size of the relay sockets' send and receive buffers
+
+/****************
+Helper functions:
+****************/
+
+double getTime(void) // Returns the current monotonic time in seconds
+	{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return double(now.tv_sec)+double(now.tv_nsec)*1.0e-9;
+	}
+
+int createRelaySocket(int portNumber) // Creates a UDP socket bound to the given port, or an arbitrary port if 0, on the loopback interface
+	{
+	int socketFd=socket(PF_INET,SOCK_DGRAM,0);
+	if(socketFd<0)
+		Misc::throwStdErr("Cluster::NetworkEmulator: Unable to create socket");
+	
+	/* Bind the socket to the given port: */
+	struct sockaddr_in socketAddress;
+	memset(&socketAddress,0,sizeof(struct sockaddr_in));
+	socketAddress.sin_family=AF_INET;
+	socketAddress.sin_port=htons(portNumber);
+	socketAddress.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+	if(bind(socketFd,(struct sockaddr*)&socketAddress,sizeof(struct sockaddr_in))==-1)
+		{
+		int myerrno=errno;
+		close(socketFd);
+		Misc::throwStdErr("Cluster::NetworkEmulator: Unable to bind socket to port number %d due to error %s",portNumber,strerror(myerrno));
+		}
+	
+	/* Enlarge the socket's buffers so that the relay itself does not drop datagrams during bursts: */
+	setsockopt(socketFd,SOL_SOCKET,SO_RCVBUF,&socketBufferSize,sizeof(int));
+	setsockopt(socketFd,SOL_SOCKET,SO_SNDBUF,&socketBufferSize,sizeof(int));
+	
+	return socketFd;
+	}
+
+int getPortNumber(int socketFd) // Returns the port number to which the given socket is bound
+	{
+	struct sockaddr_in socketAddress;
+	socklen_t socketAddressLen=sizeof(struct sockaddr_in);
+	getsockname(socketFd,(struct sockaddr*)&socketAddress,&socketAddressLen);
+	return ntohs(socketAddress.sin_port);
+	}
+
+}
+
+/********************************
+Methods of class NetworkEmulator:
+********************************/
+
+double NetworkEmulator::random(void)
+	{
+	return double(rand_r(&randomSeed))/(double(RAND_MAX)+1.0);
+	}
+
+void NetworkEmulator::scheduleDelivery(NetworkEmulator::Datagram* datagram,NetworkEmulator::Link& link,int socketFd,const NetworkEmulator::LinkParameters& parameters,NetworkEmulator::LinkStatistics& statistics,double now)
+	{
+	/* Drop the datagram to emulate packet loss: */
+	if(parameters.lossRate>0.0&&random()<parameters.lossRate)
+		{
+		++statistics.numLostDatagrams;
+		return;
+		}
+	
+	/* Queue the datagram for transmission across the link: */
+	double start=link.busyUntil>now?link.busyUntil:now;
+	if(parameters.bandwidth>0.0)
+		{
+		/* Drop the datagram if the link's queue is full: */
+		if(start-now>parameters.maxQueueDelay)
+			{
+			++statistics.numQueueDrops;
+			return;
+			}
+		
+		/* Occupy the link for the datagram's transmission time: */
+		link.busyUntil=start+double(datagram->size)/parameters.bandwidth;
+		}
+	else
+		link.busyUntil=start;
+	
+	/* Schedule the datagram's arrival at the end of the link: */
+	Delivery delivery;
+	delivery.time=link.busyUntil+parameters.latency;
+	if(parameters.reorderRate>0.0&&random()<parameters.reorderRate)
+		{
+		/* Delay the datagram behind the datagrams following it: */
+		delivery.time+=parameters.reorderDelay;
+		++statistics.numReorderedDatagrams;
+		}
+	delivery.sequenceNumber=nextSequenceNumber;
+	++nextSequenceNumber;
+	delivery.datagram=datagram;
+	++datagram->refCount;
+	delivery.portNumber=link.portNumber;
+	delivery.socketFd=socketFd;
+	deliveryQueue.insert(delivery);
+	
+	++statistics.numForwardedDatagrams;
+	statistics.numForwardedBytes+=datagram->size;
+	}
+
+void NetworkEmulator::receiveDatagrams(int socketFd,bool downstream,double now)
+	{
+	while(true)
+		{
+		/* Receive the next waiting datagram: */
+		ssize_t datagramSize=recv(socketFd,receiveBuffer,maxDatagramSize,MSG_DONTWAIT);
+		if(datagramSize<0)
+			break;
+		
+		/* Copy the datagram: */
+		Datagram* datagram=new Datagram;
+		datagram->refCount=0;
+		datagram->size=size_t(datagramSize);
+		datagram->data=new char[datagram->size];
+		memcpy(datagram->data,receiveBuffer,datagram->size);
+		
+		/* Schedule the datagram's delivery to all its receivers: */
+		{
+		Threads::Spinlock::Lock parameterLock(parameterMutex);
+		if(downstream)
+			{
+			/* Forward the datagram to all slave nodes across independent links: */
+			++downstreamStatistics.numReceivedDatagrams;
+			for(unsigned int i=0;i<numSlaves;++i)
+				scheduleDelivery(datagram,downstreamLinks[i],downstreamSocketFd,downstreamParameters,downstreamStatistics,now);
+			}
+		else
+			{
+			/* Forward the datagram to the master node across the shared upstream link: */
+			++upstreamStatistics.numReceivedDatagrams;
+			scheduleDelivery(datagram,upstreamLink,upstreamSocketFd,upstreamParameters,upstreamStatistics,now);
+			}
+		}
+		
+		/* Delete the datagram if it was dropped on all links: */
+		if(datagram->refCount==0)
+			{
+			delete[] datagram->data;
+			delete datagram;
+			}
+		}
+	}
+
+void* NetworkEmulator::relayThreadMethod(void)
+	{
+	/* Enable immediate cancellation of this thread: */
+	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
+	
+	/* Prepare the receivers' address on the local host: */
+	struct sockaddr_in receiverAddress;
+	memset(&receiverAddress,0,sizeof(struct sockaddr_in));
+	receiverAddress.sin_family=AF_INET;
+	receiverAddress.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+	
+	while(true)
+		{
+		/* Deliver all datagrams that are due: */
+		double now=getTime();
+		while(!deliveryQueue.isEmpty()&&deliveryQueue.getSmallest().time<=now)
+			{
+			/* Send the datagram to its receiver: */
+			Delivery& delivery=deliveryQueue.getSmallest();
+			receiverAddress.sin_port=htons(delivery.portNumber);
+			sendto(delivery.socketFd,delivery.datagram->data,delivery.datagram->size,0,(const struct sockaddr*)&receiverAddress,sizeof(struct sockaddr_in));
+			
+			/* Delete the datagram if this was its last delivery: */
+			if(--delivery.datagram->refCount==0)
+				{
+				delete[] delivery.datagram->data;
+				delete delivery.datagram;
+				}
+			deliveryQueue.removeSmallest();
+			}
+		
+		/* Wait for incoming datagrams until the next delivery is due: */
+		fd_set readFdSet;
+		FD_ZERO(&readFdSet);
+		FD_SET(downstreamSocketFd,&readFdSet);
+		FD_SET(upstreamSocketFd,&readFdSet);
+		int maxFd=downstreamSocketFd>upstreamSocketFd?downstreamSocketFd:upstreamSocketFd;
+		struct timeval timeout;
+		struct timeval* timeoutPtr=0;
+		if(!deliveryQueue.isEmpty())
+			{
+			double wait=deliveryQueue.getSmallest().time-now;
+			timeout.tv_sec=long(wait);
+			timeout.tv_usec=long((wait-double(timeout.tv_sec))*1.0e6);
+			timeoutPtr=&timeout;
+			}
+		if(select(maxFd+1,&readFdSet,0,0,timeoutPtr)>0)
+			{
+			/* Receive all waiting datagrams: */
+			now=getTime();
+			if(FD_ISSET(downstreamSocketFd,&readFdSet))
+				receiveDatagrams(downstreamSocketFd,true,now);
+			if(FD_ISSET(upstreamSocketFd,&readFdSet))
+				receiveDatagrams(upstreamSocketFd,false,now);
+			}
+		}
+	
+	return 0;
+	}
+
+NetworkEmulator::NetworkEmulator(int sMasterPortNumber,unsigned int sNumSlaves,const int slavePortNumbers[],int downstreamPortNumber,int upstreamPortNumber)
+	:masterPortNumber(sMasterPortNumber),numSlaves(sNumSlaves),
+	 downstreamLinks(new Link[numSlaves]),
+	 downstreamSocketFd(-1),upstreamSocketFd(-1),
+	 randomSeed(1U),
+	 nextSequenceNumber(0),
+	 receiveBuffer(0)
+	{
+	/* Initialize the links: */
+	upstreamLink.portNumber=masterPortNumber;
+	upstreamLink.busyUntil=0.0;
+	for(unsigned int i=0;i<numSlaves;++i)
+		{
+		downstreamLinks[i].portNumber=slavePortNumbers[i];
+		downstreamLinks[i].busyUntil=0.0;
+		}
+	
+	try
+		{
+		/* Create the relay sockets: */
+		downstreamSocketFd=createRelaySocket(downstreamPortNumber);
+		upstreamSocketFd=createRelaySocket(upstreamPortNumber);
+		}
+	catch(...)
+		{
+		/* Clean up and re-throw the exception: */
+		if(downstreamSocketFd>=0)
+			close(downstreamSocketFd);
+		delete[] downstreamLinks;
+		throw;
+		}
+	
+	/* Start the relay thread: */
+	receiveBuffer=new char[maxDatagramSize];
+	relayThread.start(this,&NetworkEmulator::relayThreadMethod);
+	}
+
+NetworkEmulator::~NetworkEmulator(void)
+	{
+	/* Stop the relay thread: */
+	relayThread.cancel();
+	relayThread.join();
+	
+	/* Delete all undelivered datagrams: */
+	while(!deliveryQueue.isEmpty())
+		{
+		Datagram* datagram=deliveryQueue.getSmallest().datagram;
+		if(--datagram->refCount==0)
+			{
+			delete[] datagram->data;
+			delete datagram;
+			}
+		deliveryQueue.removeSmallest();
+		}
+	
+	/* Release all resources: */
+	delete[] receiveBuffer;
+	close(downstreamSocketFd);
+	close(upstreamSocketFd);
+	delete[] downstreamLinks;
+	}
+
+int NetworkEmulator::getDownstreamPortNumber(void) const
+	{
+	return getPortNumber(downstreamSocketFd);
+	}
+
+int NetworkEmulator::getUpstreamPortNumber(void) const
+	{
+	return getPortNumber(upstreamSocketFd);
+	}
+
+void NetworkEmulator::setDownstreamParameters(const NetworkEmulator::LinkParameters& newDownstreamParameters)
+	{
+	Threads::Spinlock::Lock parameterLock(parameterMutex);
+	downstreamParameters=newDownstreamParameters;
+	}
+
+void NetworkEmulator::setUpstreamParameters(const NetworkEmulator::LinkParameters& newUpstreamParameters)
+	{
+	Threads::Spinlock::Lock parameterLock(parameterMutex);
+	upstreamParameters=newUpstreamParameters;
+	}
+
+NetworkEmulator::LinkStatistics NetworkEmulator::getDownstreamStatistics(void) const
+	{
+	Threads::Spinlock::Lock parameterLock(parameterMutex);
+	return downstreamStatistics;
+	}
+
+NetworkEmulator::LinkStatistics NetworkEmulator::getUpstreamStatistics(void) const
+	{
+	Threads::Spinlock::Lock parameterLock(parameterMutex);
+	return upstreamStatistics;
+	}
+
+}
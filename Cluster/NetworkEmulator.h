@@ -0,0 +1,156 @@
+/***********************************************************************
+NetworkEmulator - Class to relay the UDP traffic between a cluster
+multiplexer's master and slave nodes running on the same host, emulating
+a multicast network with configurable packet loss, packet reordering,
+latency, and bandwidth limits.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Cluster Abstraction Library (Cluster).
+
+The Cluster Abstraction Library is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Cluster Abstraction Library is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Cluster Abstraction Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef CLUSTER_NETWORKEMULATOR_INCLUDED
+#define CLUSTER_NETWORKEMULATOR_INCLUDED
+
+#include <stddef.h>
+#include <Misc/PriorityHeap.h>
+#include <Threads/Thread.h>
+#include <Threads/Spinlock.h>
+
+namespace Cluster {
+
+class NetworkEmulator
+	{
+	/* Embedded classes: */
+	public:
+	struct LinkParameters // Structure describing the behavior of an emulated network link
+		{
+		/* Elements: */
+		public:
+		double lossRate; // Probability of dropping a datagram
+		double reorderRate; // Probability of delaying a datagram behind the datagrams following it
+		double reorderDelay; // Additional delay of reordered datagrams in seconds
+		double latency; // One-way latency of the link in seconds
+		double bandwidth; // Bandwidth of the link in bytes per second; 0 means unlimited
+		double maxQueueDelay; // Maximum time a datagram can wait for the link to become available before it is dropped, in seconds
+		
+		/* Constructors and destructors: */
+		LinkParameters(void) // Creates a perfect link
+			:lossRate(0.0),reorderRate(0.0),reorderDelay(0.001),
+			 latency(0.0),bandwidth(0.0),maxQueueDelay(0.01)
+			{
+			}
+		};
+	
+	struct LinkStatistics // Structure reporting the traffic relayed in one direction
+		{
+		/* Elements: */
+		public:
+		size_t numReceivedDatagrams; // Number of datagrams received from senders
+		size_t numForwardedDatagrams; // Number of datagrams forwarded to receivers
+		size_t numForwardedBytes; // Number of bytes forwarded to receivers
+		size_t numLostDatagrams; // Number of datagrams dropped due to emulated packet loss
+		size_t numQueueDrops; // Number of datagrams dropped because a link's queue was full
+		size_t numReorderedDatagrams; // Number of datagrams delayed behind following datagrams
+		
+		/* Constructors and destructors: */
+		LinkStatistics(void)
+			:numReceivedDatagrams(0),numForwardedDatagrams(0),numForwardedBytes(0),
+			 numLostDatagrams(0),numQueueDrops(0),numReorderedDatagrams(0)
+			{
+			}
+		};
+	
+	private:
+	struct Datagram // Structure holding a received datagram shared by all its forwarded copies
+		{
+		/* Elements: */
+		public:
+		unsigned int refCount; // Number of forwarded copies still in the delivery queue
+		size_t size; // Size of the datagram in bytes
+		char* data; // The datagram's contents
+		};
+	
+	struct Delivery // Structure for scheduled datagram deliveries
+		{
+		/* Elements: */
+		public:
+		double time; // Time at which to deliver the datagram
+		size_t sequenceNumber; // Sequence number to deliver datagrams scheduled for the same time in order
+		Datagram* datagram; // The datagram to deliver
+		int portNumber; // Port number of the receiver on the local host
+		int socketFd; // Socket through which to send the datagram
+		
+		/* Methods: */
+		friend bool operator<=(const Delivery& d1,const Delivery& d2)
+			{
+			return d1.time<d2.time||(d1.time==d2.time&&d1.sequenceNumber<=d2.sequenceNumber);
+			}
+		};
+	
+	struct Link // Structure holding the dynamic state of an emulated link
+		{
+		/* Elements: */
+		public:
+		int portNumber; // Port number of the receiver at the end of the link
+		double busyUntil; // Time at which the link will have finished transmitting all queued datagrams
+		};
+	
+	/* Elements: */
+	int masterPortNumber; // Port number to which the master node's socket is bound
+	unsigned int numSlaves; // Number of slave nodes
+	Link upstreamLink; // Link from all slave nodes to the master node
+	Link* downstreamLinks; // Array of links from the master node to each slave node
+	int downstreamSocketFd; // Socket receiving datagrams from the master node and sending them to the slave nodes
+	int upstreamSocketFd; // Socket receiving datagrams from the slave nodes and sending them to the master node
+	mutable Threads::Spinlock parameterMutex; // Mutex protecting the link parameters and statistics
+	LinkParameters downstreamParameters; // Parameters of the links from the master node to the slave nodes
+	LinkParameters upstreamParameters; // Parameters of the link from the slave nodes to the master node
+	LinkStatistics downstreamStatistics; // Traffic relayed from the master node to the slave nodes
+	LinkStatistics upstreamStatistics; // Traffic relayed from the slave nodes to the master node
+	unsigned int randomSeed; // State of the random number generator
+	Misc::PriorityHeap<Delivery> deliveryQueue; // Queue of scheduled datagram deliveries, ordered by delivery time
+	size_t nextSequenceNumber; // Sequence number for the next scheduled delivery
+	char* receiveBuffer; // Buffer to receive datagrams
+	Threads::Thread relayThread; // Thread relaying datagrams
+	
+	/* Private methods: */
+	double random(void); // Returns a random number in [0, 1)
+	void scheduleDelivery(Datagram* datagram,Link& link,int socketFd,const LinkParameters& parameters,LinkStatistics& statistics,double now); // Schedules delivery of the given datagram across the given link
+	void receiveDatagrams(int socketFd,bool downstream,double now); // Receives all datagrams waiting on the given socket and schedules their deliveries
+	void* relayThreadMethod(void); // Thread method relaying datagrams
+	
+	/* Constructors and destructors: */
+	public:
+	NetworkEmulator(int sMasterPortNumber,unsigned int sNumSlaves,const int slavePortNumbers[],int downstreamPortNumber =0,int upstreamPortNumber =0); // Creates a network emulator relaying between a master node bound to the given port number and the given number of slave nodes bound to the given port numbers on the local host; emulator binds to the given downstream and upstream port numbers, or to arbitrary free ports if 0
+	private:
+	NetworkEmulator(const NetworkEmulator& source); // Prohibit copy constructor
+	NetworkEmulator& operator=(const NetworkEmulator& source); // Prohibit assignment operator
+	public:
+	~NetworkEmulator(void);
+	
+	/* Methods: */
+	int getDownstreamPortNumber(void) const; // Returns the port number to which the master node must send its datagrams, i.e., the master's slave port number
+	int getUpstreamPortNumber(void) const; // Returns the port number to which the slave nodes must send their datagrams, i.e., the slaves' master port number
+	void setDownstreamParameters(const LinkParameters& newDownstreamParameters); // Sets the parameters of the links from the master node to the slave nodes
+	void setUpstreamParameters(const LinkParameters& newUpstreamParameters); // Sets the parameters of the link from the slave nodes to the master node
+	LinkStatistics getDownstreamStatistics(void) const; // Returns the traffic relayed from the master node to the slave nodes so far
+	LinkStatistics getUpstreamStatistics(void) const; // Returns the traffic relayed from the slave nodes to the master node so far
+	};
+
+}
+
+#endif
@@ -1,7 +1,7 @@
 /***********************************************************************
 Opener - Class derived from Comm::Opener to forward files from a
 cluster's master to all slaves via multicast pipes.
-Copyright (c) 2018-2019 Oliver Kreylos
+Copyright (c) 2018-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -49,7 +49,7 @@ Methods of class Opener:
 
 Opener::Opener(bool install)
 	:Comm::Opener(false),
-	 multiplexer(0)
+	 multiplexer(0),localReplicaReads(false)
 	{
 	if(install)
 		{
@@ -110,7 +110,7 @@ IO::FilePtr Opener::openFile(const char* fileName,IO::File::AccessMode accessMod
 		else if(multiplexer->isMaster())
 			{
 			/* Open a master-side shared standard file: */
-			result=new StandardFileMaster(multiplexer,fileName,accessMode);
+			result=new StandardFileMaster(multiplexer,fileName,accessMode,localReplicaReads);
 			}
 		else
 			{
@@ -308,6 +308,11 @@ void Opener::setMultiplexer(Multiplexer* newMultiplexer)
 		}
 	}
 
+void Opener::setLocalReplicaReads(bool newLocalReplicaReads)
+	{
+	localReplicaReads=newLocalReplicaReads;
+	}
+
 IO::FilePtr Opener::openFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode)
 	{
 	IO::FilePtr result;
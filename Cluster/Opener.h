@@ -1,7 +1,7 @@
 /***********************************************************************
 Opener - Class derived from Comm::Opener to forward files from a
 cluster's master to all slaves via multicast pipes.
-Copyright (c) 2018-2019 Oliver Kreylos
+Copyright (c) 2018-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -39,6 +39,7 @@ class Opener:public Comm::Opener
 	private:
 	static Opener theOpener; // Static opener object created and activated when the Cluster library is loaded
 	Multiplexer* multiplexer; // Pointer to a multiplexer connecting a cluster
+	bool localReplicaReads; // Flag whether slaves read files opened read-only from their own local replicas if all of them have one
 	IO::DirectoryPtr previousCurrentDirectory; // Pointer to previous current directory when a multiplexer is set
 	
 	/* Constructors and destructors: */
@@ -67,6 +68,11 @@ class Opener:public Comm::Opener
 		return result;
 		}
 	void setMultiplexer(Multiplexer* newMultiplexer); // Sets the cluster multiplexer to be used to forward files
+	bool getLocalReplicaReads(void) const // Returns true if slaves read files from their local replicas
+		{
+		return localReplicaReads;
+		}
+	void setLocalReplicaReads(bool newLocalReplicaReads); // Enables or disables reading files from local replicas on the slaves; only has an effect on the master node
 	static IO::FilePtr openFile(Multiplexer* multiplexer,const char* fileName,IO::File::AccessMode accessMode); // Method to open a file shared via the given cluster multiplexer
 	};
 
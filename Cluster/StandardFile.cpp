@@ -1,7 +1,7 @@
 /***********************************************************************
 StandardFile - Pair of classes for high-performance cluster-transparent
 reading/writing from/to standard operating system files.
-Copyright (c) 2011-2019 Oliver Kreylos
+Copyright (c) 2011-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <fcntl.h>
 #include <errno.h>
 #include <unistd.h>
+#include <Misc/SizedTypes.h>
 #include <Misc/ThrowStdErr.h>
 #include <Cluster/Packet.h>
 #include <Cluster/Multiplexer.h>
@@ -40,6 +41,12 @@ namespace Cluster {
 
 namespace {
 
+/****************
+Helper constants:
+****************/
+
+const size_t localReplicaBufferSize=1024*1024; // Size of read buffers when reading from local replicas
+
 /****************
 String constants:
 ****************/
@@ -50,6 +57,49 @@ const char fileOpenErrorString[]="Cluster::StandardFile: Unable to open file %s
 const char fileGetFdErrorString[]="Cluster::StandardFile::getFd: Cannot query file descriptor";
 const char fileGetSizeErrorString[]="Cluster::StandardFile: Error %d (%s) while determining file size";
 
+/****************
+Helper functions:
+****************/
+
+inline Misc::UInt64 rotl(Misc::UInt64 value,int shift)
+	{
+	return (value<<shift)|(value>>(64-shift));
+	}
+
+Misc::UInt64 hashBlock(const unsigned char* data,size_t dataSize) // Returns a 64-bit hash of the given block of data to detect mismatching local replicas
+	{
+	const Misc::UInt64 p1=0x9e3779b185ebca87ULL;
+	const Misc::UInt64 p2=0xc2b2ae3d27d4eb4fULL;
+	const Misc::UInt64 p3=0x165667b19e3779f9ULL;
+	
+	/* Process the data in 32-byte stripes using four independent lanes: */
+	Misc::UInt64 lanes[4]={p1+p2,p2,0,0-p1};
+	const unsigned char* dPtr=data;
+	for(const unsigned char* dEnd=data+(dataSize&~size_t(31));dPtr!=dEnd;dPtr+=32)
+		{
+		Misc::UInt64 words[4];
+		memcpy(words,dPtr,sizeof(words));
+		for(int i=0;i<4;++i)
+			lanes[i]=rotl(lanes[i]+words[i]*p2,31)*p1;
+		}
+	
+	/* Combine the lanes and the data size: */
+	Misc::UInt64 result=rotl(lanes[0],1)+rotl(lanes[1],7)+rotl(lanes[2],12)+rotl(lanes[3],18)+Misc::UInt64(dataSize);
+	
+	/* Process the remaining bytes: */
+	for(const unsigned char* dEnd=data+dataSize;dPtr!=dEnd;++dPtr)
+		result=rotl(result^(Misc::UInt64(*dPtr)*p3),11)*p1;
+	
+	/* Mix the final hash value: */
+	result^=result>>33;
+	result*=p2;
+	result^=result>>29;
+	result*=p3;
+	result^=result>>32;
+	
+	return result;
+	}
+
 }
 
 /***********************************
@@ -98,11 +148,31 @@ size_t StandardFileMaster::readData(IO::File::Byte* buffer,size_t bufferSize)
 		{
 		if(isReadCoupled())
 			{
-			/* Forward the just-read data to the slaves: */
-			Packet* packet=multiplexer->newPacket();
-			packet->packetSize=readSize;
-			memcpy(packet->packet,buffer,readSize);
-			multiplexer->sendPacket(pipeId,packet);
+			if(localReplica)
+				{
+				/* Send the size and hash of the just-read data to the slaves: */
+				Packet* packet=multiplexer->newPacket();
+				{
+				Packet::Writer writer(packet);
+				writer.write<int>(errorType);
+				writer.write<int>(errorCode);
+				writer.write<Misc::UInt32>(Misc::UInt32(readSize));
+				writer.write<Misc::UInt64>(hashBlock(buffer,readSize));
+				}
+				multiplexer->sendPacket(pipeId,packet);
+				
+				/* Forward the just-read data to the slaves if any of them could not read it from their local replicas: */
+				if(gather(0U,GatherOperation::OR)!=0U)
+					multiplexer->sendBulk(pipeId,buffer,readSize);
+				}
+			else
+				{
+				/* Forward the just-read data to the slaves: */
+				Packet* packet=multiplexer->newPacket();
+				packet->packetSize=readSize;
+				memcpy(packet->packet,buffer,readSize);
+				multiplexer->sendPacket(pipeId,packet);
+				}
 			}
 		
 		/* Advance the read pointer: */
@@ -115,10 +185,14 @@ size_t StandardFileMaster::readData(IO::File::Byte* buffer,size_t bufferSize)
 		{
 		if(isReadCoupled())
 			{
-			/* Send an error indicator (empty packet followed by status packet) to the slaves: */
-			Packet* packet=multiplexer->newPacket();
-			packet->packetSize=0;
-			multiplexer->sendPacket(pipeId,packet);
+			/* Send an error indicator (empty packet followed by status packet, or only status packet for local replicas) to the slaves: */
+			Packet* packet;
+			if(!localReplica)
+				{
+				packet=multiplexer->newPacket();
+				packet->packetSize=0;
+				multiplexer->sendPacket(pipeId,packet);
+				}
 			packet=multiplexer->newPacket();
 			{
 			Packet::Writer writer(packet);
@@ -295,7 +369,7 @@ size_t StandardFileMaster::writeDataUpTo(const IO::File::Byte* buffer,size_t buf
 	return numBytesWritten;
 	}
 
-void StandardFileMaster::openFile(const char* fileName,IO::File::AccessMode accessMode,int flags,int mode)
+void StandardFileMaster::openFile(const char* fileName,IO::File::AccessMode accessMode,int flags,int mode,bool tryLocalReplica)
 	{
 	/* Adjust flags according to access mode: */
 	switch(accessMode)
@@ -325,11 +399,22 @@ void StandardFileMaster::openFile(const char* fileName,IO::File::AccessMode acce
 	fd=open(fileName,flags,mode);
 	int errorCode=fd<0?errno:0;
 	
+	/* Check if the slaves should read the file from their local replicas: */
+	struct stat statBuffer;
+	localReplica=errorCode==0&&tryLocalReplica&&accessMode==ReadOnly&&fstat(fd,&statBuffer)==0&&S_ISREG(statBuffer.st_mode);
+	
 	/* Send a status message to the slaves: */
 	Packet* statusPacket=multiplexer->newPacket();
 	{
 	Packet::Writer writer(statusPacket);
 	writer.write<int>(errorCode);
+	if(errorCode==0)
+		{
+		/* Send the file's size to the slaves to check their local replicas against: */
+		writer.write<char>(localReplica?1:0);
+		if(localReplica)
+			writer.write<Misc::UInt64>(Misc::UInt64(statBuffer.st_size));
+		}
 	}
 	multiplexer->sendPacket(pipeId,statusPacket);
 	
@@ -340,16 +425,20 @@ void StandardFileMaster::openFile(const char* fileName,IO::File::AccessMode acce
 		throw OpenError(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),fileOpenErrorString,fileName,getAccessModeName(accessMode),errorCode,strerror(errorCode)));
 		}
 	
-	/* Install a read buffer the size of a multicast packet: */
+	/* Only use local replicas if all slaves have one: */
+	if(localReplica)
+		localReplica=gather(1U,GatherOperation::AND)!=0U;
+	
+	/* Install a read buffer the size of a multicast packet, or a larger one when reading from local replicas: */
 	canReadThrough=false;
 	if(accessMode==ReadOnly||accessMode==ReadWrite)
-		IO::SeekableFile::resizeReadBuffer(Packet::maxPacketSize);
+		IO::SeekableFile::resizeReadBuffer(localReplica?localReplicaBufferSize:Packet::maxPacketSize);
 	}
 
-StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode)
+StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode,bool tryLocalReplica)
 	:IO::SeekableFile(disableRead(accessMode)),ClusterPipe(sMultiplexer),
 	 fd(-1),
-	 filePos(0)
+	 filePos(0),localReplica(false)
 	{
 	/* Create flags and mode to open the file: */
 	int flags=O_CREAT;
@@ -358,16 +447,16 @@ StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fil
 	mode_t mode=S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH;
 	
 	/* Open the file: */
-	openFile(fileName,accessMode,flags,mode);
+	openFile(fileName,accessMode,flags,mode,tryLocalReplica);
 	}
 
 StandardFileMaster::StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode,int flags,int mode)
 	:SeekableFile(disableRead(accessMode)),ClusterPipe(sMultiplexer),
 	 fd(-1),
-	 filePos(0)
+	 filePos(0),localReplica(false)
 	{
 	/* Open the file: */
-	openFile(fileName,accessMode,flags,mode);
+	openFile(fileName,accessMode,flags,mode,false);
 	}
 
 StandardFileMaster::~StandardFileMaster(void)
@@ -388,8 +477,8 @@ int StandardFileMaster::getFd(void) const
 
 size_t StandardFileMaster::resizeReadBuffer(size_t newReadBufferSize)
 	{
-	/* Ignore the change and return the size of a multicast packet: */
-	return Packet::maxPacketSize;
+	/* Ignore the change and return the size of a multicast packet, or the size of the local replica read buffer: */
+	return localReplica?localReplicaBufferSize:Packet::maxPacketSize;
 	}
 
 IO::SeekableFile::Offset StandardFileMaster::getSize(void) const
@@ -429,7 +518,63 @@ Methods of class StandardFileSlave:
 
 size_t StandardFileSlave::readData(IO::File::Byte* buffer,size_t bufferSize)
 	{
-	if(isReadCoupled())
+	if(isReadCoupled()&&localReplica)
+		{
+		/* Receive a status packet from the master: */
+		Packet* statusPacket=multiplexer->receivePacket(pipeId);
+		Packet::Reader reader(statusPacket);
+		int errorType=reader.read<int>();
+		int errorCode=reader.read<int>();
+		size_t readSize=0;
+		Misc::UInt64 hash=0;
+		if(errorType==0)
+			{
+			readSize=reader.read<Misc::UInt32>();
+			hash=reader.read<Misc::UInt64>();
+			}
+		multiplexer->deletePacket(statusPacket);
+		
+		/* Handle errors: */
+		if(errorType==1)
+			throw SeekError(readPos);
+		else if(errorType==3)
+			{
+			char buffer[512];
+			throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),fileReadErrorString,errorCode,strerror(errorCode)));
+			}
+		else if(errorType==2)
+			return 0;
+		
+		/* Read the same data from the local replica and check it against the master's: */
+		if(localFd>=0)
+			{
+			size_t localReadSize=0;
+			while(localReadSize<readSize)
+				{
+				ssize_t readResult=pread(localFd,buffer+localReadSize,readSize-localReadSize,readPos+localReadSize);
+				if(readResult>0)
+					localReadSize+=size_t(readResult);
+				else if(readResult==0||(errno!=EAGAIN&&errno!=EWOULDBLOCK&&errno!=EINTR))
+					break;
+				}
+			if(localReadSize!=readSize||hashBlock(buffer,readSize)!=hash)
+				{
+				/* Stop using the local replica for the rest of the file: */
+				close(localFd);
+				localFd=-1;
+				}
+			}
+		
+		/* Receive the data from the master if any slave could not read it from its local replica: */
+		if(gather(localFd<0?1U:0U,GatherOperation::OR)!=0U)
+			multiplexer->receiveBulk(pipeId,buffer,readSize);
+		
+		/* Advance the read pointer: */
+		readPos+=readSize;
+		
+		return readSize;
+		}
+	else if(isReadCoupled())
 		{
 		/* Receive a data packet from the master: */
 		Packet* newPacket=multiplexer->receivePacket(pipeId);
@@ -552,12 +697,19 @@ size_t StandardFileSlave::writeDataUpTo(const IO::File::Byte* buffer,size_t buff
 
 StandardFileSlave::StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,IO::File::AccessMode accessMode)
 	:IO::SeekableFile(disableRead(accessMode)),ClusterPipe(sMultiplexer),
-	 packet(0)
+	 packet(0),localReplica(false),localFd(-1)
 	{
 	/* Read the status packet from the master node: */
 	Packet* statusPacket=multiplexer->receivePacket(pipeId);
 	Packet::Reader reader(statusPacket);
 	int errorCode=reader.read<int>();
+	Misc::UInt64 fileSize=0;
+	if(errorCode==0)
+		{
+		localReplica=reader.read<char>()!=0;
+		if(localReplica)
+			fileSize=reader.read<Misc::UInt64>();
+		}
 	multiplexer->deletePacket(statusPacket);
 	
 	/* Check for errors: */
@@ -567,11 +719,40 @@ StandardFileSlave::StandardFileSlave(Multiplexer* sMultiplexer,const char* fileN
 		throw OpenError(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),fileOpenErrorString,fileName,getAccessModeName(accessMode),errorCode));
 		}
 	
+	if(localReplica)
+		{
+		/* Open the local replica and check that it is a regular file of the same size as the master's: */
+		localFd=open(fileName,O_RDONLY);
+		struct stat statBuffer;
+		if(localFd>=0&&(fstat(localFd,&statBuffer)!=0||!S_ISREG(statBuffer.st_mode)||Misc::UInt64(statBuffer.st_size)!=fileSize))
+			{
+			close(localFd);
+			localFd=-1;
+			}
+		
+		/* Only use local replicas if all slaves have one: */
+		localReplica=gather(localFd>=0?1U:0U,GatherOperation::AND)!=0U;
+		if(localReplica)
+			{
+			/* Install a read buffer of the same size as the master's: */
+			IO::SeekableFile::resizeReadBuffer(localReplicaBufferSize);
+			}
+		else if(localFd>=0)
+			{
+			close(localFd);
+			localFd=-1;
+			}
+		}
+	
 	canReadThrough=false;
 	}
 
 StandardFileSlave::~StandardFileSlave(void)
 	{
+	/* Close the local replica: */
+	if(localFd>=0)
+		close(localFd);
+	
 	/* Delete the current multicast packet: */
 	if(packet!=0)
 		{
@@ -590,14 +771,14 @@ int StandardFileSlave::getFd(void) const
 
 size_t StandardFileSlave::getReadBufferSize(void) const
 	{
-	/* Return the size of a multicast packet: */
-	return Packet::maxPacketSize;
+	/* Return the size of a multicast packet, or the size of the local replica read buffer: */
+	return localReplica?localReplicaBufferSize:Packet::maxPacketSize;
 	}
 
 size_t StandardFileSlave::resizeReadBuffer(size_t newReadBufferSize)
 	{
-	/* Ignore the change and return the size of a multicast packet: */
-	return Packet::maxPacketSize;
+	/* Ignore the change and return the size of a multicast packet, or the size of the local replica read buffer: */
+	return localReplica?localReplicaBufferSize:Packet::maxPacketSize;
 	}
 
 IO::SeekableFile::Offset StandardFileSlave::getSize(void) const
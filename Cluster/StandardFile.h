@@ -1,7 +1,7 @@
 /***********************************************************************
 StandardFile - Pair of classes for high-performance cluster-transparent
 reading/writing from/to standard operating system files.
-Copyright (c) 2011-2015 Oliver Kreylos
+Copyright (c) 2011-2020 Oliver Kreylos
 
 This file is part of the Cluster Abstraction Library (Cluster).
 
@@ -39,6 +39,7 @@ class StandardFileMaster:public IO::SeekableFile,public ClusterPipe // Class to
 	private:
 	int fd; // File descriptor of the underlying file
 	Offset filePos; // Current position of the underlying file's read/write pointer
+	bool localReplica; // Flag whether the slaves read the file from their own local replicas and only verify its contents against the master's
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -47,11 +48,11 @@ class StandardFileMaster:public IO::SeekableFile,public ClusterPipe // Class to
 	virtual size_t writeDataUpTo(const Byte* buffer,size_t bufferSize);
 	
 	/* Private methods: */
-	void openFile(const char* fileName,AccessMode accessMode,int flags,int mode); // Opens a file and handles errors
+	void openFile(const char* fileName,AccessMode accessMode,int flags,int mode,bool tryLocalReplica); // Opens a file and handles errors
 	
 	/* Constructors and destructors: */
 	public:
-	StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly); // Opens a standard file with "DontCare" endianness setting and default flags and permissions
+	StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly,bool tryLocalReplica =false); // Opens a standard file with "DontCare" endianness setting and default flags and permissions; if flag is true and file is opened read-only, slaves read from their local replicas if all of them have one
 	StandardFileMaster(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode,int flags,int mode =0); // Opens a standard file with "DontCare" endianness setting
 	virtual ~StandardFileMaster(void);
 	
@@ -68,6 +69,8 @@ class StandardFileSlave:public IO::SeekableFile,public ClusterPipe // Class to r
 	/* Elements: */
 	private:
 	Packet* packet; // Pointer to most recently received multicast packet; doubles as file's read buffer
+	bool localReplica; // Flag whether the file is read from the slave's local replica
+	int localFd; // File descriptor of the local replica, or -1 after the local replica failed verification
 	
 	/* Protected methods from IO::File: */
 	protected:
@@ -77,7 +80,7 @@ class StandardFileSlave:public IO::SeekableFile,public ClusterPipe // Class to r
 	
 	/* Constructors and destructors: */
 	public:
-	StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly); // Opens a standard file with "DontCare" endianness setting
+	StandardFileSlave(Multiplexer* sMultiplexer,const char* fileName,AccessMode accessMode =ReadOnly); // Opens a standard file with "DontCare" endianness setting; uses a local replica of the file if the master requests it
 	virtual ~StandardFileSlave(void);
 	
 	/* Methods from IO::File: */
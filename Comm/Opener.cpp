@@ -31,6 +31,7 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Comm/Config.h>
 #include <Comm/HttpFile.h>
 #include <Comm/HttpDirectory.h>
+#include <Comm/SeekableHttpFile.h>
 #include <Comm/TCPPipe.h>
 #if COMM_CONFIG_HAVE_OPENSSL
 #include <Comm/TLSPipe.h>
@@ -105,6 +106,30 @@ IO::FilePtr Opener::openFile(const char* fileName,IO::File::AccessMode accessMod
 		}
 	}
 
+IO::SeekableFilePtr Opener::openSeekableFile(const char* fileName,IO::File::AccessMode accessMode)
+	{
+	/* Check for uncompressed remote files: */
+	if(HttpFile::checkHttpPrefix(fileName)&&!Misc::hasCaseExtension(fileName,".gz"))
+		{
+		/* Check if the requested access mode is supported by HTTP files: */
+		if(accessMode==IO::File::WriteOnly||accessMode==IO::File::ReadWrite)
+			throw std::runtime_error("Comm::openSeekableFile: Write access to HTTP files not supported");
+		
+		try
+			{
+			/* Open a remote file that is read on demand via HTTP/1.1 byte range requests: */
+			return new SeekableHttpFile(fileName);
+			}
+		catch(const SeekableHttpFile::RangeError&)
+			{
+			/* The server does not support range requests; fall back to reading the entire file through a seekable filter: */
+			}
+		}
+	
+	/* Delegate to the base class: */
+	return IO::Opener::openSeekableFile(fileName,accessMode);
+	}
+
 IO::DirectoryPtr Opener::openDirectory(const char* directoryName)
 	{
 	/* Check for supported file system protocols: */
@@ -44,6 +44,7 @@ class Opener:public IO::Opener
 	
 	/* Methods from IO::Opener: */
 	virtual IO::FilePtr openFile(const char* fileName,IO::File::AccessMode accessMode);
+	virtual IO::SeekableFilePtr openSeekableFile(const char* fileName,IO::File::AccessMode accessMode);
 	virtual IO::DirectoryPtr openDirectory(const char* directoryName);
 	virtual IO::DirectoryPtr openDirectory(const char* directoryNameBegin,const char* directoryNameEnd);
 	virtual IO::DirectoryPtr openFileDirectory(const char* fileName);
@@ -0,0 +1,474 @@
+/***********************************************************************
+SeekableHttpFile - Class for random-access reading from remote files
+using HTTP/1.1 byte range requests over a persistent server connection,
+with a block cache and sequential read-ahead.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Portable Communications Library (Comm).
+
+The Portable Communications Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Portable Communications Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Communications Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Comm/SeekableHttpFile.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <stdexcept>
+#include <Misc/ThrowStdErr.h>
+#include <IO/ValueSource.h>
+#include <Comm/Config.h>
+#include <Comm/TCPPipe.h>
+#if COMM_CONFIG_HAVE_OPENSSL
+#include <Comm/TLSPipe.h>
+#endif
+
+namespace Comm {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+bool parseContentRange(const std::string& value,IO::SeekableFile::Offset& rangeBegin,IO::SeekableFile::Offset& rangeEnd,IO::SeekableFile::Offset& totalSize)
+	{
+	/* Parse a content range of the form "bytes <first>-<last>/<total>", where the range can be an asterisk if the server only reports the total size: */
+	const char* vPtr=value.c_str();
+	while(*vPtr==' '||*vPtr=='\t')
+		++vPtr;
+	if(strncmp(vPtr,"bytes",5)!=0)
+		return false;
+	vPtr+=5;
+	while(*vPtr==' '||*vPtr=='\t')
+		++vPtr;
+	char* endPtr;
+	if(*vPtr=='*')
+		{
+		/* There is no range, only a total size: */
+		rangeBegin=0;
+		rangeEnd=0;
+		++vPtr;
+		}
+	else
+		{
+		rangeBegin=strtoll(vPtr,&endPtr,10);
+		if(endPtr==vPtr||*endPtr!='-')
+			return false;
+		vPtr=endPtr+1;
+		rangeEnd=strtoll(vPtr,&endPtr,10)+1;
+		if(endPtr==vPtr)
+			return false;
+		vPtr=endPtr;
+		}
+	if(*vPtr!='/')
+		return false;
+	++vPtr;
+	totalSize=strtoll(vPtr,&endPtr,10);
+	return endPtr!=vPtr;
+	}
+
+}
+
+/*********************************
+Methods of class SeekableHttpFile:
+*********************************/
+
+size_t SeekableHttpFile::readData(IO::File::Byte* buffer,size_t bufferSize)
+	{
+	/* Check for end-of-file: */
+	if(readPos>=size)
+		return 0;
+	
+	/* Find the block containing the read position in the cache: */
+	Offset blockIndex=readPos/Offset(blockSize);
+	BlockHasher::Iterator bIt=blockMap.findEntry(blockIndex);
+	Block* block;
+	if(!bIt.isFinished())
+		{
+		/* Use the cached block: */
+		block=bIt->getDest();
+		touchBlock(block);
+		++cacheStatistics.numBlockHits;
+		}
+	else
+		{
+		/* Grow the read-ahead window during sequential reads, and drop it after a seek: */
+		if(blockIndex==lastBlockIndex+1)
+			readAhead=readAhead==0?1:(readAhead*2<maxReadAhead?readAhead*2:maxReadAhead);
+		else
+			readAhead=0;
+		
+		/* Fetch the missing block and the following blocks up to the first cached block or the end of the file: */
+		Offset numFileBlocks=(size+Offset(blockSize)-1)/Offset(blockSize);
+		unsigned int numFetchBlocks=1;
+		while(numFetchBlocks<=readAhead&&blockIndex+numFetchBlocks<numFileBlocks&&blockMap.findEntry(blockIndex+numFetchBlocks).isFinished())
+			++numFetchBlocks;
+		fetchBlocks(blockIndex,numFetchBlocks);
+		block=blockMap.getEntry(blockIndex).getDest();
+		++cacheStatistics.numBlockMisses;
+		}
+	lastBlockIndex=blockIndex;
+	
+	/* Check for end-of-file in case the file shrank on the server: */
+	size_t blockOffset=size_t(readPos-blockIndex*Offset(blockSize));
+	if(blockOffset>=block->size)
+		return 0;
+	
+	/* Install the remainder of the block as the read buffer: */
+	size_t readSize=block->size-blockOffset;
+	setReadBuffer(readSize,block->data+blockOffset,false);
+	readPos+=Offset(readSize);
+	
+	return readSize;
+	}
+
+void SeekableHttpFile::connect(void)
+	{
+	/* Drop the current connection: */
+	pipe=0;
+	
+	if(urlParts.https)
+		{
+		#if COMM_CONFIG_HAVE_OPENSSL
+		/* Open a TLS-secured TCP connection to the HTTP server: */
+		pipe=new Comm::TLSPipe(urlParts.serverName.c_str(),urlParts.portNumber);
+		#else
+		throw std::runtime_error("Comm::SeekableHttpFile: HTTPS connections not supported due to lack of OpenSSL library");
+		#endif
+		}
+	else
+		{
+		/* Open a standard TCP connection to the HTTP server: */
+		pipe=new Comm::TCPPipe(urlParts.serverName.c_str(),urlParts.portNumber);
+		}
+	}
+
+bool SeekableHttpFile::requestRange(IO::SeekableFile::Offset rangeBegin,IO::SeekableFile::Offset rangeEnd,IO::SeekableFile::Offset& replyBegin,IO::SeekableFile::Offset& replySize)
+	{
+	/* Assemble the GET request for the given byte range: */
+	char buffer[512];
+	std::string request;
+	request.append("GET ");
+	request.append(urlParts.resourcePath);
+	request.append(" HTTP/1.1\r\n");
+	snprintf(buffer,sizeof(buffer),"Host: %s:%d\r\n",urlParts.serverName.c_str(),urlParts.portNumber);
+	request.append(buffer);
+	snprintf(buffer,sizeof(buffer),"Range: bytes=%lld-%lld\r\n",(long long int)rangeBegin,(long long int)(rangeEnd-1));
+	request.append(buffer);
+	request.append("\r\n");
+	
+	/* Send the GET request: */
+	pipe->writeRaw(request.data(),request.size());
+	pipe->flush();
+	++cacheStatistics.numRequests;
+	
+	/* Attach a value source to the pipe to parse the server's reply: */
+	IO::ValueSource reply(pipe);
+	reply.setPunctuation("()<>@,;:\\/[]?={}\r");
+	reply.setQuotes("\"");
+	reply.skipWs();
+	
+	/* Read the status line: */
+	if(!reply.isLiteral("HTTP")||!reply.isLiteral('/'))
+		throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Malformed HTTP reply from server \"%s\" on port %d",urlParts.serverName.c_str(),urlParts.portNumber));
+	reply.skipString();
+	unsigned int statusCode=reply.readUnsignedInteger();
+	std::string error=reply.readLine();
+	if(!error.empty()&&error[error.size()-1]=='\r')
+		error.erase(error.size()-1);
+	reply.skipWs();
+	
+	/* Parse reply options until the first empty line: */
+	Offset contentLength=-1;
+	Offset totalSize=-1;
+	replyBegin=0;
+	keepAlive=true;
+	while(!reply.eof()&&reply.peekc()!='\r')
+		{
+		/* Read the option tag: */
+		std::string option=reply.readString();
+		if(reply.isLiteral(':'))
+			{
+			/* Handle the option value: */
+			if(option=="Content-Length")
+				contentLength=Offset(reply.readUnsignedInteger());
+			else if(option=="Content-Range")
+				{
+				/* Read and parse the rest of the line: */
+				std::string value=reply.readLine();
+				Offset replyEnd;
+				if(!parseContentRange(value,replyBegin,replyEnd,totalSize))
+					throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Malformed content range in reply from server \"%s\" on port %d",urlParts.serverName.c_str(),urlParts.portNumber));
+				reply.skipWs();
+				continue;
+				}
+			else if(option=="Transfer-Encoding")
+				throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Unsupported transfer encoding in reply from server \"%s\" on port %d",urlParts.serverName.c_str(),urlParts.portNumber));
+			else if(option=="Connection")
+				keepAlive=reply.readString()!="close";
+			}
+		
+		/* Skip the rest of the line: */
+		reply.skipLine();
+		reply.skipWs();
+		}
+	
+	/* Read the CR/LF pair: */
+	if(reply.getChar()!='\r'||reply.getChar()!='\n')
+		throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Malformed HTTP reply from server \"%s\" on port %d",urlParts.serverName.c_str(),urlParts.portNumber));
+	
+	/* Check the status code: */
+	if(statusCode==200)
+		{
+		/* The server ignored the range request and is sending the entire file; drop the connection: */
+		pipe=0;
+		return false;
+		}
+	else if(statusCode==416&&totalSize>=0&&rangeBegin>=totalSize)
+		{
+		/* The requested range is past the end of the file; skip the reply body: */
+		if(contentLength>0)
+			pipe->skip<char>(size_t(contentLength));
+		replyBegin=rangeBegin;
+		replySize=0;
+		}
+	else if(statusCode==206)
+		{
+		if(contentLength<0||totalSize<0||replyBegin!=rangeBegin)
+			throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Invalid partial content reply from server \"%s\" on port %d",urlParts.serverName.c_str(),urlParts.portNumber));
+		
+		/* Check that the reply covers the entire requested range, or the rest of the file, so that only the file's last block can be short: */
+		if(contentLength!=(rangeEnd<totalSize?rangeEnd:totalSize)-rangeBegin)
+			throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Short partial content reply from server \"%s\" on port %d",urlParts.serverName.c_str(),urlParts.portNumber));
+		replySize=contentLength;
+		}
+	else
+		throw HttpFile::HttpError(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: HTTP error %d (%s) while reading resource \"%s\" on server \"%s\" on port %d",statusCode,error.c_str(),urlParts.resourcePath.c_str(),urlParts.serverName.c_str(),urlParts.portNumber),statusCode,error);
+	
+	/* Update the file size; the resource might have changed on the server since the file was opened: */
+	size=totalSize;
+	
+	return true;
+	}
+
+void SeekableHttpFile::readBlocks(IO::SeekableFile::Offset firstBlockIndex,IO::SeekableFile::Offset replySize)
+	{
+	Offset blockIndex=firstBlockIndex;
+	while(replySize>0)
+		{
+		/* Read the next block, and only enter it into the cache once it is complete: */
+		Block* block=getBlock();
+		block->index=-1;
+		block->size=0;
+		size_t readSize=replySize<Offset(blockSize)?size_t(replySize):blockSize;
+		try
+			{
+			pipe->readRaw(block->data,readSize);
+			}
+		catch(const std::runtime_error&)
+			{
+			/* The connection is in an undefined state; drop it: */
+			pipe=0;
+			throw;
+			}
+		block->index=blockIndex;
+		block->size=readSize;
+		blockMap.setEntry(BlockHasher::Entry(blockIndex,block));
+		cacheStatistics.numReceivedBytes+=Offset(readSize);
+		replySize-=Offset(readSize);
+		++blockIndex;
+		}
+	
+	/* Drop the connection if the server is going to close it: */
+	if(!keepAlive)
+		pipe=0;
+	}
+
+void SeekableHttpFile::fetchBlocks(IO::SeekableFile::Offset firstBlockIndex,unsigned int numFetchBlocks)
+	{
+	/* Calculate the byte range covering the blocks: */
+	Offset rangeBegin=firstBlockIndex*Offset(blockSize);
+	Offset rangeEnd=rangeBegin+Offset(numFetchBlocks)*Offset(blockSize);
+	if(rangeEnd>size)
+		rangeEnd=size;
+	
+	/* Send a range request over the current connection, and retry once over a new connection if the server closed the old one: */
+	Offset replyBegin,replySize;
+	for(int attempt=0;;++attempt)
+		{
+		try
+			{
+			if(pipe==0)
+				{
+				connect();
+				++cacheStatistics.numReconnects;
+				}
+			if(!requestRange(rangeBegin,rangeEnd,replyBegin,replySize))
+				throw RangeError("Comm::SeekableHttpFile: Server stopped honoring byte range requests",200);
+			break;
+			}
+		catch(const HttpFile::HttpError&)
+			{
+			/* Protocol errors won't go away by re-connecting: */
+			throw;
+			}
+		catch(const std::runtime_error&)
+			{
+			/* Give up if a fresh connection failed as well: */
+			pipe=0;
+			if(attempt>0)
+				throw;
+			}
+		}
+	
+	/* Read the reply body into the cache: */
+	readBlocks(firstBlockIndex,replySize);
+	
+	/* Check that the server sent the requested block: */
+	if(blockMap.findEntry(firstBlockIndex).isFinished())
+		throw SeekError(firstBlockIndex*Offset(blockSize));
+	}
+
+SeekableHttpFile::Block* SeekableHttpFile::getBlock(void)
+	{
+	Block* result;
+	if(numBlocks<maxNumBlocks)
+		{
+		/* Create a new block: */
+		result=new Block;
+		result->data=new Byte[blockSize];
+		++numBlocks;
+		}
+	else
+		{
+		/* Evict the least recently used block: */
+		result=leastRecent;
+		blockMap.removeEntry(result->index);
+		leastRecent=result->pred;
+		if(leastRecent!=0)
+			leastRecent->succ=0;
+		else
+			mostRecent=0;
+		}
+	
+	/* Link the block to the head of the block list: */
+	result->pred=0;
+	result->succ=mostRecent;
+	if(mostRecent!=0)
+		mostRecent->pred=result;
+	else
+		leastRecent=result;
+	mostRecent=result;
+	
+	return result;
+	}
+
+void SeekableHttpFile::touchBlock(SeekableHttpFile::Block* block)
+	{
+	if(block!=mostRecent)
+		{
+		/* Unlink the block from the block list: */
+		block->pred->succ=block->succ;
+		if(block->succ!=0)
+			block->succ->pred=block->pred;
+		else
+			leastRecent=block->pred;
+		
+		/* Link the block to the head of the block list: */
+		block->pred=0;
+		block->succ=mostRecent;
+		mostRecent->pred=block;
+		mostRecent=block;
+		}
+	}
+
+SeekableHttpFile::SeekableHttpFile(const char* fileUrl,size_t sBlockSize,unsigned int sMaxNumBlocks,unsigned int sMaxReadAhead)
+	:IO::SeekableFile(),
+	 urlParts(HttpFile::splitUrl(fileUrl)),
+	 keepAlive(true),
+	 size(0),
+	 blockSize(sBlockSize),maxNumBlocks(sMaxNumBlocks),maxReadAhead(sMaxReadAhead),
+	 blockMap(17),numBlocks(0),mostRecent(0),leastRecent(0),
+	 lastBlockIndex(-2),readAhead(0)
+	{
+	/* The cache must be able to hold a missed block and its entire read-ahead: */
+	if(blockSize<1)
+		blockSize=1;
+	if(maxNumBlocks<maxReadAhead+1)
+		maxNumBlocks=maxReadAhead+1;
+	
+	/* Connect to the HTTP server: */
+	connect();
+	
+	/* Request the first block to check for range request support and determine the file's size: */
+	Offset replyBegin,replySize;
+	if(!requestRange(0,Offset(blockSize),replyBegin,replySize))
+		{
+		char buffer[512];
+		throw RangeError(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"Comm::SeekableHttpFile: Server \"%s\" on port %d does not support byte range requests for resource \"%s\"",urlParts.serverName.c_str(),urlParts.portNumber,urlParts.resourcePath.c_str()),200);
+		}
+	
+	/* Read the first block into the cache: */
+	readBlocks(0,replySize);
+	++cacheStatistics.numBlockMisses;
+	
+	/* Disable read-through, as all data is read from cached blocks: */
+	canReadThrough=false;
+	}
+
+SeekableHttpFile::~SeekableHttpFile(void)
+	{
+	/* Release the read buffer: */
+	setReadBuffer(0,0,false);
+	
+	/* Delete all cached blocks: */
+	while(mostRecent!=0)
+		{
+		Block* succ=mostRecent->succ;
+		delete[] mostRecent->data;
+		delete mostRecent;
+		mostRecent=succ;
+		}
+	}
+
+int SeekableHttpFile::getFd(void) const
+	{
+	/* Return pipe's file descriptor: */
+	if(pipe==0)
+		throw Error("Comm::SeekableHttpFile::getFd: File is not connected to server");
+	return pipe->getFd();
+	}
+
+size_t SeekableHttpFile::getReadBufferSize(void) const
+	{
+	/* Return the block size, since the read buffer always points into a cached block: */
+	return blockSize;
+	}
+
+size_t SeekableHttpFile::resizeReadBuffer(size_t newReadBufferSize)
+	{
+	/* Ignore the request and return the block size: */
+	return blockSize;
+	}
+
+IO::SeekableFile::Offset SeekableHttpFile::getSize(void) const
+	{
+	return size;
+	}
+
+}
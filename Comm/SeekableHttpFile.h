@@ -0,0 +1,136 @@
+/***********************************************************************
+SeekableHttpFile - Class for random-access reading from remote files
+using HTTP/1.1 byte range requests over a persistent server connection,
+with a block cache and sequential read-ahead.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Portable Communications Library (Comm).
+
+The Portable Communications Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Portable Communications Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Portable Communications Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef COMM_SEEKABLEHTTPFILE_INCLUDED
+#define COMM_SEEKABLEHTTPFILE_INCLUDED
+
+#include <stddef.h>
+#include <Misc/HashTable.h>
+#include <IO/SeekableFile.h>
+#include <Comm/Pipe.h>
+#include <Comm/HttpFile.h>
+
+namespace Comm {
+
+class SeekableHttpFile:public IO::SeekableFile
+	{
+	/* Embedded classes: */
+	public:
+	class RangeError:public HttpFile::HttpError // Exception class to signal that a server does not support byte range requests for a resource
+		{
+		/* Constructors and destructors: */
+		public:
+		RangeError(const char* message,unsigned int sStatusCode)
+			:HttpFile::HttpError(message,sStatusCode,"Byte range requests not supported")
+			{
+			}
+		};
+	
+	struct CacheStatistics // Structure reporting the effectiveness of the block cache
+		{
+		/* Elements: */
+		public:
+		size_t numRequests; // Number of range requests sent to the server
+		size_t numReconnects; // Number of times the server connection had to be re-established
+		size_t numBlockHits; // Number of block reads satisfied from the cache
+		size_t numBlockMisses; // Number of block reads that required a range request
+		Offset numReceivedBytes; // Total number of body bytes received from the server
+		
+		/* Constructors and destructors: */
+		CacheStatistics(void)
+			:numRequests(0),numReconnects(0),numBlockHits(0),numBlockMisses(0),numReceivedBytes(0)
+			{
+			}
+		};
+	
+	private:
+	struct Block // Structure for cached blocks of file data
+		{
+		/* Elements: */
+		public:
+		Offset index; // Index of the block in the file
+		size_t size; // Amount of data in the block; less than block size only for the last block of the file
+		Byte* data; // Block data
+		Block* pred; // Pointer to the next more recently used block
+		Block* succ; // Pointer to the next less recently used block
+		};
+	
+	typedef Misc::HashTable<Offset,Block*> BlockHasher; // Hash table to find cached blocks by block index
+	
+	/* Elements: */
+	HttpFile::URLParts urlParts; // Components of the file's URL
+	PipePtr pipe; // Pipe connected to the HTTP server, or null if the connection has to be re-established
+	bool keepAlive; // Flag whether the server keeps the connection open after the most recent reply
+	Offset size; // Total size of the remote file
+	size_t blockSize; // Size of cached blocks in bytes
+	unsigned int maxNumBlocks; // Maximum number of blocks held in the cache
+	unsigned int maxReadAhead; // Maximum number of blocks fetched ahead of the read position during sequential reads
+	BlockHasher blockMap; // Map from block indices to cached blocks
+	unsigned int numBlocks; // Number of blocks currently in the cache
+	Block* mostRecent; // Head of the block list, ordered from most to least recently used
+	Block* leastRecent; // Tail of the block list
+	Offset lastBlockIndex; // Index of the most recently read block, to detect sequential reads
+	unsigned int readAhead; // Number of blocks currently fetched ahead of a missed block
+	CacheStatistics cacheStatistics; // Statistics of the block cache
+	
+	/* Protected methods from IO::File: */
+	protected:
+	virtual size_t readData(Byte* buffer,size_t bufferSize);
+	
+	/* Private methods: */
+	private:
+	void connect(void); // Opens a new connection to the HTTP server
+	bool requestRange(Offset rangeBegin,Offset rangeEnd,Offset& replyBegin,Offset& replySize); // Requests the given half-open byte range from the server and parses the reply header; returns false if the server does not support range requests
+	void readBlocks(Offset firstBlockIndex,Offset replySize); // Reads the body of a range reply into consecutive cached blocks starting at the given block index
+	void fetchBlocks(Offset firstBlockIndex,unsigned int numFetchBlocks); // Requests a run of consecutive blocks from the server and reads them into the cache
+	Block* getBlock(void); // Returns an unused block, evicting the least recently used block if the cache is full
+	void touchBlock(Block* block); // Moves the given block to the head of the block list
+	
+	/* Constructors and destructors: */
+	public:
+	SeekableHttpFile(const char* fileUrl,size_t sBlockSize =65536,unsigned int sMaxNumBlocks =64,unsigned int sMaxReadAhead =16); // Opens the file of the given URL using the given block size, maximum number of cached blocks, and maximum read-ahead in blocks; throws RangeError if the server does not support range requests for the file
+	private:
+	SeekableHttpFile(const SeekableHttpFile& source); // Prohibit copy constructor
+	SeekableHttpFile& operator=(const SeekableHttpFile& source); // Prohibit assignment operator
+	public:
+	virtual ~SeekableHttpFile(void); // Closes the file and releases the block cache
+	
+	/* Methods from IO::File: */
+	virtual int getFd(void) const;
+	virtual size_t getReadBufferSize(void) const;
+	virtual size_t resizeReadBuffer(size_t newReadBufferSize);
+	
+	/* Methods from IO::SeekableFile: */
+	virtual Offset getSize(void) const;
+	
+	/* New methods: */
+	const CacheStatistics& getCacheStatistics(void) const // Returns the statistics of the block cache
+		{
+		return cacheStatistics;
+		}
+	};
+
+}
+
+#endif
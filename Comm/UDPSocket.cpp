@@ -43,7 +43,7 @@ namespace Comm {
 Methods of class UPDSocket:
 **************************/
 
-UDPSocket::UDPSocket(int localPortId,int)
+UDPSocket::UDPSocket(int localPortId,int,bool shareLocalPort)
 	{
 	/* Create the socket file descriptor: */
 	socketFd=socket(PF_INET,SOCK_DGRAM,0);
@@ -53,6 +53,13 @@ UDPSocket::UDPSocket(int localPortId,int)
 		Misc::throwStdErr("Comm::UDPSocket: Unable to create socket due to error %d (%s)",myerrno,strerror(myerrno));
 		}
 	
+	if(shareLocalPort)
+		{
+		/* Allow other sockets to bind to the same local port: */
+		int flag=1;
+		setsockopt(socketFd,SOL_SOCKET,SO_REUSEADDR,&flag,sizeof(flag));
+		}
+	
 	/* Bind the socket file descriptor to the local port ID: */
 	IPv4SocketAddress socketAddress(localPortId>=0?(unsigned int)(localPortId):0U);
 	if(bind(socketFd,(struct sockaddr*)&socketAddress,sizeof(struct IPv4SocketAddress))==-1)
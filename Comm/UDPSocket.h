@@ -67,7 +67,7 @@ class UDPSocket
 		{
 		}
 	public:
-	UDPSocket(int localPortId,int backlog); // Creates an unconnected socket on the local host; if portId is negative, random free port is assigned
+	UDPSocket(int localPortId,int backlog,bool shareLocalPort =false); // Creates an unconnected socket on the local host; if portId is negative, random free port is assigned; if flag is true, other sockets can bind to the same port, e.g., to receive the same multicast datagrams
 	UDPSocket(int localPortId,const std::string& hostname,int hostPortId); // Creates a socket connected to a remote host; if localPortId is negative, random free port is assigned
 	UDPSocket(int localPortId,const IPv4SocketAddress& hostAddress); // Ditto, using an IP v4 socket address
 	UDPSocket(const UDPSocket& source); // Copy constructor
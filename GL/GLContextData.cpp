@@ -80,6 +80,16 @@ void GLContextData::shutdownThingManager(void)
 	GLThingManager::theThingManager.shutdown();
 	}
 
+void GLContextData::setThingUpdateBudget(double newThingUpdateBudget)
+	{
+	GLThingManager::theThingManager.setUpdateBudget(newThingUpdateBudget);
+	}
+
+double GLContextData::getThingUpdateBudget(void)
+	{
+	return GLThingManager::theThingManager.getUpdateBudget();
+	}
+
 void GLContextData::updateThings(void)
 	{
 	GLThingManager::theThingManager.updateThings(*this);
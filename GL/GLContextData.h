@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef GLCONTEXTDATA_INCLUDED
 #define GLCONTEXTDATA_INCLUDED
 
+#include <vector>
 #include <Misc/HashTable.h>
 #include <Misc/CallbackData.h>
 #include <Misc/CallbackList.h>
@@ -35,6 +36,8 @@ class GLClipPlaneTracker;
 
 class GLContextData
 	{
+	friend class GLThingManager;
+	
 	/* Embedded classes: */
 	public:
 	struct CurrentContextDataChangedCallbackData:public Misc::CallbackData
@@ -58,6 +61,7 @@ class GLContextData
 	static Misc::CallbackList currentContextDataChangedCallbacks; // List of callbacks called whenever the current context data object changes
 	static GL_THREAD_LOCAL(GLContextData*) currentContextData; // Pointer to the current context data object (associated with the current OpenGL context)
 	ItemHash context; // A hash table for the context
+	std::vector<const GLObject*> deferredThings; // List of things whose initialization in this context was postponed to stay within the thing manager's time budget
 	GLLightTracker* lightTracker; // An object to track the OpenGL context's lighting state
 	GLClipPlaneTracker* clipPlaneTracker; // An object to track the OpenGL context's clipping plane state
 	
@@ -72,7 +76,13 @@ class GLContextData
 	static void orderThings(const GLObject* thing1,const GLObject* thing2); // Asks thing manager to always initialize thing1 before thing2
 	static void resetThingManager(void); // Resets the thing manager
 	static void shutdownThingManager(void); // Shuts down the thing manager
+	static void setThingUpdateBudget(double newThingUpdateBudget); // Limits the time spent on deferrable thing initializations per context and render cycle, in seconds; 0 disables the limit
+	static double getThingUpdateBudget(void); // Returns the current time budget for thing initializations
 	void updateThings(void); // Initializes or deletes all marked things
+	bool hasDeferredThings(void) const // Returns true if the initialization of some things in this context has been postponed to later render cycles
+		{
+		return !deferredThings.empty();
+		}
 	
 	/* Methods to manage the current context: */
 	static Misc::CallbackList& getCurrentContextDataChangedCallbacks(void) // Returns the list of callbacks called whenever the current context data object changes
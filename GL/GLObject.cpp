@@ -60,3 +60,9 @@ GLObject::~GLObject(void)
 	/* Mark the object's context data item for destruction: */
 	GLContextData::destroyThing(this);
 	}
+
+bool GLObject::isContextInitDeferrable(void) const
+	{
+	/* Objects must be initialized immediately by default: */
+	return false;
+	}
@@ -52,6 +52,7 @@ class GLObject
 	
 	/* Methods: */
 	virtual void initContext(GLContextData& contextData) const =0; // Method called before a GL object is rendered for the first time in the given OpenGL context
+	virtual bool isContextInitDeferrable(void) const; // Returns true if the object's context initialization may be postponed to a later render cycle when the thing manager's time budget is exhausted; such objects must check for a missing context data item during rendering
 	};
 
 #endif
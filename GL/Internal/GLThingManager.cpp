@@ -22,6 +22,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <GL/Internal/GLThingManager.h>
 
+#include <vector>
+#include <Misc/Timer.h>
 #include <GL/GLObject.h>
 #include <GL/GLContextData.h>
 
@@ -38,7 +40,8 @@ Methods of class GLThingManager:
 GLThingManager::GLThingManager(void)
 	:active(true),
 	 firstNewAction(0),lastNewAction(0),
-	 firstProcessAction(0)
+	 firstProcessAction(0),
+	 updateBudget(0.0)
 	{
 	}
 
@@ -183,6 +186,11 @@ void GLThingManager::orderThings(const GLObject* thing1,const GLObject* thing2)
 		}
 	}
 
+void GLThingManager::setUpdateBudget(double newUpdateBudget)
+	{
+	updateBudget=newUpdateBudget>0.0?newUpdateBudget:0.0;
+	}
+
 void GLThingManager::processActions(void)
 	{
 	/* Delete the old process list: */
@@ -204,18 +212,58 @@ void GLThingManager::processActions(void)
 
 void GLThingManager::updateThings(GLContextData& contextData) const
 	{
-	/* Perform all actions on the process list in order: */
+	/* Bail out early in the common case of no pending work: */
+	std::vector<const GLObject*>& deferredThings=contextData.deferredThings;
+	if(firstProcessAction==0&&deferredThings.empty())
+		return;
+	
+	/*********************************************************************
+	Perform all destructions first, and drop destroyed things from this
+	context's list of deferred initializations. A destruction of a thing
+	never follows its initialization in the same process list, but it can
+	precede the initialization of a new thing at the same address.
+	*********************************************************************/
+	
 	for(const ThingAction* taPtr=firstProcessAction;taPtr!=0;taPtr=taPtr->succ)
-		{
-		if(taPtr->action==ThingAction::INIT)
-			{
-			/* Call the thing's context initialization routine: */
-			taPtr->thing->initContext(contextData);
-			}
-		else
+		if(taPtr->action==ThingAction::DESTROY)
 			{
+			/* Remove the thing from the deferred list if it was never initialized in this context: */
+			for(std::vector<const GLObject*>::iterator dtIt=deferredThings.begin();dtIt!=deferredThings.end();++dtIt)
+				if(*dtIt==taPtr->thing)
+					{
+					deferredThings.erase(dtIt);
+					break;
+					}
+			
 			/* Delete the context data item associated with the thing: */
 			contextData.removeDataItem(taPtr->thing);
 			}
-		}
+	
+	/* Start timing deferrable initializations: */
+	Misc::Timer timer;
+	
+	/* Continue initializing things that were deferred during previous render cycles, in order: */
+	std::vector<const GLObject*>::iterator dtIt;
+	for(dtIt=deferredThings.begin();dtIt!=deferredThings.end()&&(updateBudget==0.0||timer.peekTime()<updateBudget);++dtIt)
+		(*dtIt)->initContext(contextData);
+	deferredThings.erase(deferredThings.begin(),dtIt);
+	
+	/* Perform all initializations on the process list in order: */
+	for(const ThingAction* taPtr=firstProcessAction;taPtr!=0;taPtr=taPtr->succ)
+		if(taPtr->action==ThingAction::INIT)
+			{
+			/* Check if the thing's initialization has to be postponed to preserve order or to stay within the time budget: */
+			if(updateBudget>0.0&&taPtr->thing->isContextInitDeferrable()&&(!deferredThings.empty()||timer.peekTime()>=updateBudget))
+				deferredThings.push_back(taPtr->thing);
+			else
+				{
+				/* Initialize all postponed things that precede this thing first, as it might depend on them: */
+				for(dtIt=deferredThings.begin();dtIt!=deferredThings.end();++dtIt)
+					(*dtIt)->initContext(contextData);
+				deferredThings.clear();
+				
+				/* Call the thing's context initialization routine: */
+				taPtr->thing->initContext(contextData);
+				}
+			}
 	}
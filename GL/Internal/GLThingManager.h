@@ -58,6 +58,7 @@ class GLThingManager
 	ThingAction* firstNewAction; // List of actions added to by users
 	ThingAction* lastNewAction; // Pointer to last element in new action list
 	ThingAction* firstProcessAction; // List of actions initialized in the current render cycle
+	double updateBudget; // Maximum time in seconds spent on deferrable context initializations per context and render cycle; 0 disables the budget
 	
 	/* Constructors and destructors: */
 	public:
@@ -69,6 +70,11 @@ class GLThingManager
 	void initThing(const GLObject* thing); // Marks the given thing for initialization
 	void destroyThing(const GLObject* thing); // Marks the given thing for destruction
 	void orderThings(const GLObject* thing1,const GLObject* thing2); // Orders process list such that thing1 is initialized before thing2; assumes both things exist and have not been initialized yet
+	void setUpdateBudget(double newUpdateBudget); // Sets the time budget for deferrable context initializations in seconds; 0 disables the budget
+	double getUpdateBudget(void) const // Returns the current time budget
+		{
+		return updateBudget;
+		}
 	void processActions(void); // Moves all new actions to the process list
 	void updateThings(GLContextData& contextData) const; // Performs all actions for the current render cycle
 	};
@@ -123,7 +123,7 @@ class EndiannessSwapper<Geometry::Matrix<ScalarParam,numRowsParam,numColumnsPara
 			for(int column=0;column<numColumnsParam;++column)
 				swapEndianness(m(row,column));
 		}
-	static void swap(Geometry::Matrix<ScalarParam,numRowsParam,numColumnsParam>& ms,size_t numMs)
+	static void swap(Geometry::Matrix<ScalarParam,numRowsParam,numColumnsParam>* ms,size_t numMs)
 		{
 		for(size_t i=0;i<numMs;++i)
 			for(int row=0;row<numRowsParam;++row)
@@ -1,7 +1,7 @@
 /***********************************************************************
 CSVSource - Class to read tabular data from input streams in generalized
 comma-separated value (CSV) format.
-Copyright (c) 2010-2011 Oliver Kreylos
+Copyright (c) 2010-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -23,9 +23,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <IO/CSVSource.h>
 
 #include <ctype.h>
-#include <math.h>
 #include <string>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include <Misc/ThrowStdErr.h>
+#include <IO/ParseNumber.h>
 
 namespace IO {
 
@@ -101,6 +104,60 @@ class TypeName<std::string>
 		}
 	};
 
+/****************
+Helper functions:
+****************/
+
+const char* findSeparator(const char* ptr,const char* end,char sep0,char sep1,char sep2) // Returns a pointer to the first occurrence of any of the given separators in the given character range, or the end of the range
+	{
+	#ifdef __SSE2__
+	/* Compare 16 characters at a time against all separators: */
+	__m128i s0=_mm_set1_epi8(sep0);
+	__m128i s1=_mm_set1_epi8(sep1);
+	__m128i s2=_mm_set1_epi8(sep2);
+	for(;end-ptr>=16;ptr+=16)
+		{
+		__m128i chars=_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+		__m128i matches=_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars,s0),_mm_cmpeq_epi8(chars,s1)),_mm_cmpeq_epi8(chars,s2));
+		int matchMask=_mm_movemask_epi8(matches);
+		if(matchMask!=0)
+			return ptr+__builtin_ctz(matchMask);
+		}
+	#endif
+	
+	/* Compare the remaining characters one at a time: */
+	while(ptr!=end&&*ptr!=sep0&&*ptr!=sep1&&*ptr!=sep2)
+		++ptr;
+	return ptr;
+	}
+
+/**************************************************************
+Helper functions to convert field contents to numeric values:
+**************************************************************/
+
+inline const char* parseFieldValue(const char* begin,const char* end,unsigned int& value)
+	{
+	return parseUnsignedInteger(begin,end,value);
+	}
+
+inline const char* parseFieldValue(const char* begin,const char* end,int& value)
+	{
+	return parseInteger(begin,end,value);
+	}
+
+inline const char* parseFieldValue(const char* begin,const char* end,double& value)
+	{
+	return parseNumber(begin,end,value);
+	}
+
+inline const char* parseFieldValue(const char* begin,const char* end,float& value)
+	{
+	double tempValue;
+	const char* result=parseNumber(begin,end,tempValue);
+	value=float(tempValue);
+	return result;
+	}
+
 }
 
 /***************************************
@@ -168,10 +225,18 @@ bool CSVSource::skipRestOfField(bool quoted,int nextChar)
 		**********************/
 		
 		/* Skip characters until the next field separator, record separator, eof, or quote: */
-		while(nextChar!=fieldSeparator&&nextChar!=recordSeparator&&nextChar>=0&&nextChar!=quote)
+		if(nextChar!=fieldSeparator&&nextChar!=recordSeparator&&nextChar>=0&&nextChar!=quote)
 			{
+			/* Skip characters directly inside the character source's read buffer: */
 			skippedAny=true;
+			const char* bufPtr=source->getUnreadData();
+			const char* sepPtr=findSeparator(bufPtr,bufPtr+source->getUnreadDataSize(),char(fieldSeparator),char(recordSeparator),char(quote));
+			source->skipUnreadData(sepPtr-bufPtr);
 			nextChar=source->getChar();
+			
+			/* Continue character by character if the field extended past the end of the read buffer: */
+			while(nextChar!=fieldSeparator&&nextChar!=recordSeparator&&nextChar>=0&&nextChar!=quote)
+				nextChar=source->getChar();
 			}
 		}
 	
@@ -196,6 +261,40 @@ bool CSVSource::skipRestOfField(bool quoted,int nextChar)
 	return skippedAny;
 	}
 
+bool CSVSource::getBufferedField(const char*& fieldBegin,const char*& fieldEnd)
+	{
+	/* Check if the current field is unquoted: */
+	const char* bufPtr=source->getUnreadData();
+	const char* bufEnd=bufPtr+source->getUnreadDataSize();
+	if(bufPtr==bufEnd||*bufPtr==char(quote))
+		return false;
+	
+	/* Find the end of the field, and check that it is terminated by a separator inside the read buffer: */
+	const char* sepPtr=findSeparator(bufPtr,bufEnd,char(fieldSeparator),char(recordSeparator),char(quote));
+	if(sepPtr==bufEnd||*sepPtr==char(quote))
+		return false;
+	
+	fieldBegin=bufPtr;
+	fieldEnd=sepPtr;
+	return true;
+	}
+
+void CSVSource::skipBufferedField(const char* fieldEnd)
+	{
+	/* Skip the field and its terminating separator: */
+	bool endOfRecord=*fieldEnd!=char(fieldSeparator);
+	source->skipUnreadData((fieldEnd+1)-source->getUnreadData());
+	
+	/* Update the field and record indices: */
+	if(endOfRecord)
+		{
+		fieldIndex=0;
+		++recordIndex;
+		}
+	else
+		++fieldIndex;
+	}
+
 template <>
 bool CSVSource::convertNumber(int& nextChar,unsigned int& value)
 	{
@@ -257,91 +356,74 @@ bool CSVSource::convertNumber(int& nextChar,int& value)
 template <>
 bool CSVSource::convertNumber(int& nextChar,double& value)
 	{
+	/* Collect the number's characters one at a time: */
+	std::string number;
+	
 	/* Check for optional sign: */
-	bool negated=false;
-	if(nextChar=='-')
+	if(nextChar=='-'||nextChar=='+')
 		{
-		negated=true;
+		number.push_back(char(nextChar));
 		nextChar=source->getChar();
 		}
-	else if(nextChar=='+')
-		nextChar=source->getChar();
 	
 	/* Keep track if any digits have been read: */
 	bool haveDigit=false;
 	
 	/* Read an integral number part: */
-	value=0.0;
 	while(nextChar>='0'&&nextChar<='9')
 		{
 		haveDigit=true;
-		value=value*10.0+double(nextChar-'0');
+		number.push_back(char(nextChar));
 		nextChar=source->getChar();
 		}
 	
 	/* Check for a period: */
 	if(nextChar=='.')
 		{
+		number.push_back(char(nextChar));
 		nextChar=source->getChar();
 		
 		/* Read a fractional number part: */
-		double fraction=0.0;
-		double fractionBase=1.0;
 		while(nextChar>='0'&&nextChar<='9')
 			{
 			haveDigit=true;
-			fraction=fraction*10.0+double(nextChar-'0');
-			fractionBase*=10.0;
+			number.push_back(char(nextChar));
 			nextChar=source->getChar();
 			}
-		
-		value+=fraction/fractionBase;
 		}
 	
 	/* Signal a conversion error if no digits were read in the integral or fractional part: */
 	if(!haveDigit)
 		return false;
 	
-	/* Negate the result if a minus sign was read: */
-	if(negated)
-		value=-value;
-	
 	/* Check for an exponent indicator: */
 	if(nextChar=='e'||nextChar=='E')
 		{
+		number.push_back(char(nextChar));
 		nextChar=source->getChar();
 		
 		/* Read a plus or minus sign: */
-		bool exponentNegated=false;
-		if(nextChar=='-')
+		if(nextChar=='-'||nextChar=='+')
 			{
-			exponentNegated=true;
+			number.push_back(char(nextChar));
 			nextChar=source->getChar();
 			}
-		else if(nextChar=='+')
-			nextChar=source->getChar();
 		
 		/* Signal a conversion error if the next character is not a digit: */
 		if(nextChar<'0'||nextChar>'9')
 			return false;
 		
-		/* Read the first exponent digit: */
-		double exponent=double(nextChar-'0');
-		nextChar=source->getChar();
-		
-		/* Read the rest of the exponent digits: */
+		/* Read the exponent digits: */
 		while(nextChar>='0'&&nextChar<='9')
 			{
-			exponent=exponent*10.0+double(nextChar-'0');
+			number.push_back(char(nextChar));
 			nextChar=source->getChar();
 			}
-		
-		/* Multiply the mantissa with the exponent: */
-		if(exponentNegated)
-			exponent=-exponent;
-		value*=pow(10.0,exponent);
 		}
 	
+	/* Convert the collected characters: */
+	parseNumber(number.data(),number.data()+number.size(),value);
+	
 	return true;
 	}
 
@@ -385,6 +467,30 @@ void CSVSource::setQuote(int newQuote)
 template <class ValueParam>
 ValueParam CSVSource::readField(void)
 	{
+	/* Check if the field is entirely contained in the character source's read buffer: */
+	const char* fieldBegin;
+	const char* fieldEnd;
+	if(getBufferedField(fieldBegin,fieldEnd))
+		{
+		/* Remove leading and trailing whitespace: */
+		const char* valueBegin=fieldBegin;
+		while(valueBegin!=fieldEnd&&isspace((unsigned char)(*valueBegin)))
+			++valueBegin;
+		const char* valueEnd=fieldEnd;
+		while(valueEnd!=valueBegin&&isspace((unsigned char)(valueEnd[-1])))
+			--valueEnd;
+		
+		/* Convert the field directly from the read buffer if it contains exactly one number: */
+		ValueParam result(0);
+		if(valueBegin!=valueEnd&&parseFieldValue(valueBegin,valueEnd,result)==valueEnd)
+			{
+			skipBufferedField(fieldEnd);
+			return result;
+			}
+		
+		/* Fall back to reading character by character to signal errors consistently: */
+		}
+	
 	/* Read the field's first character: */
 	int nextChar=source->getChar();
 	
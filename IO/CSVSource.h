@@ -1,7 +1,7 @@
 /***********************************************************************
 CSVSource - Class to read tabular data from input streams in generalized
 comma-separated value (CSV) format.
-Copyright (c) 2010-2011 Oliver Kreylos
+Copyright (c) 2010-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -57,6 +57,8 @@ class CSVSource
 	
 	/* Private methods: */
 	bool skipRestOfField(bool quoted,int nextChar); // Skips the rest of the current field starting with the given character; returns true if any characters were skipped; throws format error if the end of the field cannot be determined reliably
+	bool getBufferedField(const char*& fieldBegin,const char*& fieldEnd); // Returns true and the extent of the current field if the field is unquoted and entirely contained in the character source's read buffer
+	void skipBufferedField(const char* fieldEnd); // Skips the current field, whose end was returned by getBufferedField, and its terminating separator
 	template <class ValueParam>
 	bool convertNumber(int& nextChar,ValueParam& value); // Converts characters in a field into a numeric value of the given type; returns false on conversion error
 	
@@ -1,7 +1,7 @@
 /***********************************************************************
 File - Base class for high-performance buffered binary read/write access
 to file-like objects.
-Copyright (c) 2010-2019 Oliver Kreylos
+Copyright (c) 2010-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -195,6 +195,14 @@ class File:public Threads::RefCounted
 		{
 		return readDataEnd-readPtr;
 		}
+	const char* getUnreadData(void) const // Returns a pointer to the unread data in the read buffer without reading it; pointer stays valid until the next read
+		{
+		return reinterpret_cast<const char*>(readPtr);
+		}
+	void skipUnreadData(size_t numBytes) // Marks the given amount of unread data in the read buffer, which must not exceed getUnreadDataSize(), as read
+		{
+		readPtr+=numBytes;
+		}
 	bool canWriteImmediately(void) const // Returns true if there is room in the write buffer
 		{
 		return writePtr!=writeBufferEnd;
@@ -449,17 +457,25 @@ class File:public Threads::RefCounted
 		{
 		if(writeMustSwapEndianness)
 			{
-			for(size_t i=0;i<numItems;++i)
+			/* Swap and write the values in chunks to use bulk endianness swapping, using raw storage so that the values need not be default-constructible: */
+			const size_t chunkSize=sizeof(DataParam)<1024?1024/sizeof(DataParam):1;
+			long double tempBuffer[(chunkSize*sizeof(DataParam)+sizeof(long double)-1)/sizeof(long double)];
+			DataParam* temp=reinterpret_cast<DataParam*>(tempBuffer);
+			while(numItems>0)
 				{
-				DataParam temp=data[i];
-				Misc::swapEndianness(temp);
-				if(sizeof(DataParam)<=size_t(writeBufferEnd-writePtr))
+				size_t numChunkItems=numItems<chunkSize?numItems:chunkSize;
+				size_t chunkBytes=numChunkItems*sizeof(DataParam);
+				memcpy(temp,data,chunkBytes);
+				Misc::swapEndianness(temp,numChunkItems);
+				if(chunkBytes<=size_t(writeBufferEnd-writePtr))
 					{
-					memcpy(writePtr,&temp,sizeof(DataParam));
-					writePtr+=sizeof(DataParam);
+					memcpy(writePtr,temp,chunkBytes);
+					writePtr+=chunkBytes;
 					}
 				else
-					bufferedWrite(&temp,sizeof(DataParam));
+					bufferedWrite(temp,chunkBytes);
+				data+=numChunkItems;
+				numItems-=numChunkItems;
 				}
 			}
 		else
@@ -54,6 +54,12 @@ class GzipFilter:public IO::File
 	
 	/* Methods from File: */
 	virtual int getFd(void) const;
+	
+	/* New methods: */
+	FilePtr getGzippedFile(void) const // Returns the underlying gzip-compressed file
+		{
+		return gzippedFile;
+		}
 	};
 
 }
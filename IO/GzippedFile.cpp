@@ -1,7 +1,8 @@
 /***********************************************************************
 GzippedFile - Class for high-performance reading from gzip-compressed
-standard operating system files.
-Copyright (c) 2011-2019 Oliver Kreylos
+files, with random access based on an index of access points into the
+compressed data stream.
+Copyright (c) 2011-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -22,43 +23,393 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <IO/GzippedFile.h>
 
+#include <string.h>
+#include <Misc/SizedTypes.h>
 #include <Misc/ThrowStdErr.h>
+#include <IO/StandardFile.h>
 
 namespace IO {
 
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+const char indexFileHeader[8]={'G','z','I','n','d','e','x','1'}; // Identifier at the beginning of access point index files
+const unsigned int maxWindowSize=32768U; // Maximum size of a deflate decompression dictionary
+
+}
+
 /****************************
 Methods of class GzippedFile:
 ****************************/
 
 size_t GzippedFile::readData(File::Byte* buffer,size_t bufferSize)
 	{
-	/* Read at most one buffer's worth of data from the compressed input file: */
-	int readSize=gzread(inputFile,buffer,bufferSize);
+	/* Check if the decompressor needs to be repositioned: */
+	if(streamPos!=readPos)
+		skipTo(readPos);
+	
+	/* Decompress data into the given buffer: */
+	size_t readSize=decompress(buffer,bufferSize);
+	
+	/* Advance the read pointer: */
+	readPos+=Offset(readSize);
+	
+	return readSize;
+	}
+
+void GzippedFile::init(void)
+	{
+	/* Check the compressed file's gzip header identifier: */
+	compressedFile->setReadPosAbs(0);
+	if(compressedFile->getChar()!=0x1f||compressedFile->getChar()!=0x8b)
+		throw OpenError("IO::GzippedFile: File is not gzip-compressed");
+	
+	/* Initialize the zlib stream object: */
+	memset(&stream,0,sizeof(z_stream));
+	stream.next_in=Z_NULL;
+	stream.avail_in=0;
+	stream.zalloc=Z_NULL;
+	stream.zfree=Z_NULL;
+	stream.opaque=0;
+	if(inflateInit2(&stream,15+16)!=Z_OK) // Expect a gzip header
+		{
+		if(stream.msg!=0)
+			{
+			char buffer[512];
+			throw OpenError(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"IO::GzippedFile: Error \"%s\" during initialization",stream.msg));
+			}
+		else
+			throw OpenError("IO::GzippedFile: Internal zlib error during initialization");
+		}
+	
+	/* Start decompressing from the beginning of the file: */
+	restart(0);
+	}
+
+void GzippedFile::restart(const GzippedFile::AccessPoint* accessPoint)
+	{
+	if(accessPoint!=0)
+		{
+		/* Reset the decompressor to read a raw deflate stream: */
+		inflateReset2(&stream,-15);
+		rawStream=true;
+		
+		/* Position the compressed file at the access point: */
+		compressedFile->setReadPosAbs(accessPoint->compressedPos-(accessPoint->numBits>0?1:0));
+		stream.next_in=Z_NULL;
+		stream.avail_in=0;
+		
+		/* Feed the bits of the next deflate block that are contained in the preceding byte to the decompressor: */
+		if(accessPoint->numBits>0)
+			{
+			int byte=compressedFile->getChar();
+			if(byte<0)
+				throw SeekError(accessPoint->uncompressedPos);
+			inflatePrime(&stream,accessPoint->numBits,byte>>(8-accessPoint->numBits));
+			}
+		
+		/* Install the decompression dictionary: */
+		inflateSetDictionary(&stream,accessPoint->window,accessPoint->windowSize);
+		
+		streamPos=accessPoint->uncompressedPos;
+		}
+	else
+		{
+		/* Reset the decompressor to read the gzip header: */
+		inflateReset2(&stream,15+16);
+		rawStream=false;
+		
+		/* Position the compressed file at the beginning: */
+		compressedFile->setReadPosAbs(0);
+		stream.next_in=Z_NULL;
+		stream.avail_in=0;
+		
+		streamPos=0;
+		}
+	streamEof=false;
+	}
+
+size_t GzippedFile::decompress(Bytef* buffer,size_t bufferSize)
+	{
+	/* Decompress data into the given buffer: */
+	stream.next_out=buffer;
+	stream.avail_out=bufferSize;
 	
-	/* Check for fatal read errors: */
-	if(readSize<0)
-		throw Error("IO::GzippedFile: Fatal error while reading from file");
+	/* Try until at least some output is produced: */
+	while(stream.avail_out==bufferSize&&!streamEof)
+		{
+		/* Check if the decompressor needs more input: */
+		if(stream.avail_in==0)
+			{
+			/* Read the next glob of compressed data: */
+			void* compressedBuffer;
+			size_t compressedSize=compressedFile->readInBuffer(compressedBuffer);
+			if(compressedSize==0)
+				throw Error("IO::GzippedFile: Compressed file is truncated");
+			
+			/* Pass the compressed data to the decompressor: */
+			stream.next_in=static_cast<Bytef*>(compressedBuffer);
+			stream.avail_in=compressedSize;
+			}
+		
+		/* Decompress up to the end of the current deflate block: */
+		size_t outputSpace=stream.avail_out;
+		int result=inflate(&stream,Z_BLOCK);
+		streamPos+=Offset(outputSpace-stream.avail_out);
+		
+		if(result==Z_STREAM_END)
+			{
+			/* Skip the gzip trailer if the decompressor does not process it itself: */
+			if(rawStream)
+				{
+				size_t trailerSize=8;
+				while(trailerSize>0)
+					{
+					if(stream.avail_in==0)
+						{
+						void* compressedBuffer;
+						size_t compressedSize=compressedFile->readInBuffer(compressedBuffer);
+						if(compressedSize==0)
+							throw Error("IO::GzippedFile: Compressed file is truncated");
+						stream.next_in=static_cast<Bytef*>(compressedBuffer);
+						stream.avail_in=compressedSize;
+						}
+					size_t skipSize=stream.avail_in<trailerSize?stream.avail_in:trailerSize;
+					stream.next_in+=skipSize;
+					stream.avail_in-=skipSize;
+					trailerSize-=skipSize;
+					}
+				}
+			
+			/* Check if another gzip member follows the one that just ended: */
+			if(stream.avail_in==0)
+				{
+				void* compressedBuffer;
+				size_t compressedSize=compressedFile->readInBuffer(compressedBuffer);
+				stream.next_in=static_cast<Bytef*>(compressedBuffer);
+				stream.avail_in=compressedSize;
+				}
+			if(stream.avail_in>0&&stream.next_in[0]==0x1f)
+				{
+				/* Reset the decompressor to read the next member's gzip header: */
+				inflateReset2(&stream,15+16);
+				rawStream=false;
+				}
+			else
+				{
+				/* Ignore any trailing data and finish the index: */
+				streamEof=true;
+				if(!indexComplete)
+					{
+					indexComplete=true;
+					uncompressedSize=streamPos;
+					}
+				}
+			}
+		else if(result!=Z_OK&&result!=Z_BUF_ERROR)
+			{
+			if(stream.msg!=0)
+				{
+				char buffer[512];
+				throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"IO::GzippedFile: Error \"%s\" while decompressing",stream.msg));
+				}
+			else
+				throw Error("IO::GzippedFile: Internal zlib error while decompressing");
+			}
+		else if((stream.data_type&128)!=0&&(stream.data_type&64)==0)
+			{
+			/* Add an access point at the end of the current deflate block if it is far enough past the last one: */
+			Offset lastPos=index.empty()?Offset(0):index.back().uncompressedPos;
+			if(streamPos>=lastPos+spanSize)
+				{
+				AccessPoint ap;
+				ap.uncompressedPos=streamPos;
+				ap.compressedPos=compressedFile->getReadPos()-Offset(stream.avail_in);
+				ap.numBits=stream.data_type&7;
+				ap.window=new Bytef[maxWindowSize];
+				uInt windowSize=maxWindowSize;
+				inflateGetDictionary(&stream,ap.window,&windowSize);
+				ap.windowSize=windowSize;
+				index.push_back(ap);
+				}
+			}
+		}
 	
-	return size_t(readSize);
+	return bufferSize-stream.avail_out;
 	}
 
-GzippedFile::GzippedFile(const char* inputFileName)
-	:File(ReadOnly),
-	 inputFile(0)
+void GzippedFile::skipTo(SeekableFile::Offset newStreamPos)
 	{
-	/* Open the compressed input file: */
-	if((inputFile=gzopen(inputFileName,"r"))==0)
+	/* Find the last access point at or before the new position: */
+	const AccessPoint* accessPoint=0;
+	size_t l=0;
+	size_t r=index.size();
+	while(l<r)
+		{
+		size_t m=(l+r)>>1;
+		if(index[m].uncompressedPos<=newStreamPos)
+			l=m+1;
+		else
+			r=m;
+		}
+	if(l>0)
+		accessPoint=&index[l-1];
+	Offset accessPointPos=accessPoint!=0?accessPoint->uncompressedPos:Offset(0);
+	
+	/* Restart the decompressor unless it can reach the new position faster by skipping forward: */
+	if(newStreamPos<streamPos||accessPointPos>streamPos)
+		restart(accessPoint);
+	
+	/* Decompress and discard data up to the new position: */
+	Bytef discard[16384];
+	while(streamPos<newStreamPos&&!streamEof)
 		{
-		char buffer[1024];
-		throw OpenError(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"IO::GzippedFile: Error while opening gzipped input file %s",inputFileName));
+		size_t skipSize=sizeof(discard);
+		if(Offset(skipSize)>newStreamPos-streamPos)
+			skipSize=size_t(newStreamPos-streamPos);
+		decompress(discard,skipSize);
 		}
 	}
 
+void GzippedFile::clearIndex(void)
+	{
+	/* Release all access points' decompression dictionaries: */
+	for(std::vector<AccessPoint>::iterator apIt=index.begin();apIt!=index.end();++apIt)
+		delete[] apIt->window;
+	index.clear();
+	}
+
+GzippedFile::GzippedFile(const char* inputFileName,SeekableFile::Offset sSpanSize)
+	:SeekableFile(ReadOnly),
+	 compressedFile(new StandardFile(inputFileName,ReadOnly)),
+	 rawStream(false),streamPos(0),streamEof(false),
+	 spanSize(sSpanSize),
+	 indexComplete(false),uncompressedSize(0)
+	{
+	init();
+	}
+
+GzippedFile::GzippedFile(SeekableFilePtr sCompressedFile,SeekableFile::Offset sSpanSize)
+	:SeekableFile(ReadOnly),
+	 compressedFile(sCompressedFile),
+	 rawStream(false),streamPos(0),streamEof(false),
+	 spanSize(sSpanSize),
+	 indexComplete(false),uncompressedSize(0)
+	{
+	init();
+	}
+
 GzippedFile::~GzippedFile(void)
 	{
-	/* Close the compressed input file: */
-	if(inputFile!=0)
-		gzclose(inputFile);
+	/* Clean out the decompressor and the index: */
+	inflateEnd(&stream);
+	clearIndex();
+	}
+
+int GzippedFile::getFd(void) const
+	{
+	/* Return the compressed file's file descriptor: */
+	return compressedFile->getFd();
+	}
+
+SeekableFile::Offset GzippedFile::getSize(void) const
+	{
+	/* Decompress the entire file to determine its uncompressed size; this only changes the object's decompression state, not its logical state: */
+	if(!indexComplete)
+		const_cast<GzippedFile*>(this)->buildIndex();
+	
+	return uncompressedSize;
+	}
+
+void GzippedFile::buildIndex(void)
+	{
+	if(!indexComplete)
+		{
+		/* Continue decompressing from the last access point if the decompressor is positioned before it: */
+		if(!index.empty()&&index.back().uncompressedPos>streamPos)
+			restart(&index.back());
+		
+		/* Decompress and discard the rest of the file: */
+		Bytef discard[16384];
+		while(!streamEof)
+			decompress(discard,sizeof(discard));
+		}
+	}
+
+void GzippedFile::saveIndex(File& indexFile)
+	{
+	/* Complete the index: */
+	buildIndex();
+	
+	/* Write the index header: */
+	indexFile.setEndianness(Misc::LittleEndian);
+	indexFile.write(indexFileHeader,sizeof(indexFileHeader));
+	indexFile.write<Misc::SInt64>(compressedFile->getSize());
+	indexFile.write<Misc::SInt64>(uncompressedSize);
+	indexFile.write<Misc::SInt64>(spanSize);
+	indexFile.write<Misc::UInt32>(index.size());
+	
+	/* Write all access points: */
+	for(std::vector<AccessPoint>::iterator apIt=index.begin();apIt!=index.end();++apIt)
+		{
+		indexFile.write<Misc::SInt64>(apIt->uncompressedPos);
+		indexFile.write<Misc::SInt64>(apIt->compressedPos);
+		indexFile.write<Misc::UInt8>(apIt->numBits);
+		indexFile.write<Misc::UInt32>(apIt->windowSize);
+		indexFile.write(apIt->window,apIt->windowSize);
+		}
+	}
+
+void GzippedFile::loadIndex(File& indexFile)
+	{
+	/* Read and check the index header: */
+	indexFile.setEndianness(Misc::LittleEndian);
+	char header[sizeof(indexFileHeader)];
+	indexFile.read(header,sizeof(header));
+	if(memcmp(header,indexFileHeader,sizeof(indexFileHeader))!=0)
+		throw Error("IO::GzippedFile::loadIndex: File is not a gzip index file");
+	if(indexFile.read<Misc::SInt64>()!=compressedFile->getSize())
+		throw Error("IO::GzippedFile::loadIndex: Index does not match compressed file");
+	Offset newUncompressedSize=indexFile.read<Misc::SInt64>();
+	Offset newSpanSize=indexFile.read<Misc::SInt64>();
+	unsigned int numAccessPoints=indexFile.read<Misc::UInt32>();
+	
+	/* Read all access points into a new index: */
+	std::vector<AccessPoint> newIndex;
+	newIndex.reserve(numAccessPoints);
+	try
+		{
+		for(unsigned int i=0;i<numAccessPoints;++i)
+			{
+			AccessPoint ap;
+			ap.uncompressedPos=indexFile.read<Misc::SInt64>();
+			ap.compressedPos=indexFile.read<Misc::SInt64>();
+			ap.numBits=indexFile.read<Misc::UInt8>();
+			ap.windowSize=indexFile.read<Misc::UInt32>();
+			if(ap.numBits>7||ap.windowSize>maxWindowSize||ap.uncompressedPos>newUncompressedSize||(!newIndex.empty()&&ap.uncompressedPos<=newIndex.back().uncompressedPos))
+				throw Error("IO::GzippedFile::loadIndex: Corrupted index file");
+			ap.window=new Bytef[maxWindowSize];
+			newIndex.push_back(ap);
+			indexFile.read(ap.window,ap.windowSize);
+			}
+		}
+	catch(...)
+		{
+		/* Release the partially read index and bail out: */
+		for(std::vector<AccessPoint>::iterator apIt=newIndex.begin();apIt!=newIndex.end();++apIt)
+			delete[] apIt->window;
+		throw;
+		}
+	
+	/* Replace the current index: */
+	clearIndex();
+	index.swap(newIndex);
+	spanSize=newSpanSize;
+	indexComplete=true;
+	uncompressedSize=newUncompressedSize;
 	}
 
 }
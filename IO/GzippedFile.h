@@ -1,7 +1,8 @@
 /***********************************************************************
 GzippedFile - Class for high-performance reading from gzip-compressed
-standard operating system files.
-Copyright (c) 2011-2012 Oliver Kreylos
+files, with random access based on an index of access points into the
+compressed data stream.
+Copyright (c) 2011-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -23,25 +24,78 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef IO_GZIPPEDFILE_INCLUDED
 #define IO_GZIPPEDFILE_INCLUDED
 
+#include <vector>
 #include <zlib.h>
-#include <IO/File.h>
+#include <IO/SeekableFile.h>
 
 namespace IO {
 
-class GzippedFile:public File
+class GzippedFile:public SeekableFile
 	{
-	/* Elements: */
+	/* Embedded classes: */
 	private:
-	gzFile inputFile; // File descriptor of gzipped input file
+	struct AccessPoint // Structure for points in the compressed data stream at which decompression can be restarted
+		{
+		/* Elements: */
+		public:
+		Offset uncompressedPos; // Position in the uncompressed data
+		Offset compressedPos; // Position of the first complete byte of the next deflate block in the compressed file
+		int numBits; // Number of bits of the next deflate block contained in the byte preceding the compressed position
+		unsigned int windowSize; // Amount of uncompressed data preceding the access point
+		Bytef* window; // Uncompressed data preceding the access point, used as decompression dictionary
+		};
+	
+	/* Elements: */
+	SeekableFilePtr compressedFile; // The underlying gzip-compressed file
+	z_stream stream; // Zlib decompression object
+	bool rawStream; // Flag if the decompressor was restarted at an access point and therefore reads a raw deflate stream without gzip header and trailer
+	Offset streamPos; // Uncompressed position of the next data produced by the decompressor
+	bool streamEof; // Flag if the decompressor reached the end of the compressed file
+	Offset spanSize; // Minimum amount of uncompressed data between adjacent access points
+	std::vector<AccessPoint> index; // List of access points in increasing position order
+	bool indexComplete; // Flag if the entire compressed file has been decompressed, i.e., the index and the uncompressed file size are final
+	Offset uncompressedSize; // Total size of the uncompressed data if the index is complete
 	
 	/* Protected methods from File: */
 	protected:
 	virtual size_t readData(Byte* buffer,size_t bufferSize);
 	
+	/* Private methods: */
+	private:
+	void init(void); // Checks the compressed file's header and initializes the decompressor
+	void restart(const AccessPoint* accessPoint); // Restarts decompression at the given access point, or at the beginning of the compressed file if the pointer is null
+	size_t decompress(Bytef* buffer,size_t bufferSize); // Decompresses data into the given buffer, adding access points to the index along the way; returns amount of data decompressed, or zero at end of file
+	void skipTo(Offset newStreamPos); // Positions the decompressor at the given uncompressed position, using the nearest preceding access point
+	void clearIndex(void); // Releases all access points
+	
 	/* Constructors and destructors: */
 	public:
-	GzippedFile(const char* inputFileName); // Opens the given compressed input file
+	GzippedFile(const char* inputFileName,Offset sSpanSize =Offset(1048576)); // Opens the given compressed input file and places access points at the given minimum distance in uncompressed data
+	GzippedFile(SeekableFilePtr sCompressedFile,Offset sSpanSize =Offset(1048576)); // Reads from the given already-opened compressed file
+	private:
+	GzippedFile(const GzippedFile& source); // Prohibit copy constructor
+	GzippedFile& operator=(const GzippedFile& source); // Prohibit assignment operator
+	public:
 	virtual ~GzippedFile(void); // Closes the file
+	
+	/* Methods from File: */
+	virtual int getFd(void) const;
+	
+	/* Methods from SeekableFile: */
+	virtual Offset getSize(void) const; // Returns the size of the uncompressed data; decompresses the entire file on first call unless a complete index was loaded
+	
+	/* New methods: */
+	bool isIndexComplete(void) const // Returns true if the access point index covers the entire file
+		{
+		return indexComplete;
+		}
+	size_t getNumAccessPoints(void) const // Returns the current number of access points in the index
+		{
+		return index.size();
+		}
+	void buildIndex(void); // Decompresses the remainder of the file to complete the access point index
+	void saveIndex(File& indexFile); // Completes the access point index and writes it to the given file
+	void loadIndex(File& indexFile); // Replaces the access point index with one previously written to the given file by saveIndex; throws exception if the index does not match the compressed file
 	};
 
 }
@@ -1,7 +1,7 @@
 /***********************************************************************
 MemMappedFile - Class for read/write access to memory-mapped files using
 the File abstraction; mostly for simplified resource management.
-Copyright (c) 2011-2019 Oliver Kreylos
+Copyright (c) 2011-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -177,4 +177,69 @@ SeekableFile::Offset MemMappedFile::getSize(void) const
 	return memSize;
 	}
 
+bool MemMappedFile::advise(MemMappedFile::AccessHint hint,SeekableFile::Offset offset,size_t size)
+	{
+	/* Clip the range against the file's memory space: */
+	if(offset<0||size_t(offset)>=memSize)
+		return false;
+	if(size>memSize-size_t(offset))
+		size=memSize-size_t(offset);
+	
+	/* Extend the range to page boundaries, as madvise requires a page-aligned start address: */
+	size_t pageSize=size_t(sysconf(_SC_PAGESIZE));
+	size_t pageOffset=size_t(offset)%pageSize;
+	char* start=static_cast<char*>(memBase)+(size_t(offset)-pageOffset);
+	size+=pageOffset;
+	
+	/* Translate the hint: */
+	int advice;
+	switch(hint)
+		{
+		case NormalAccess:
+			advice=MADV_NORMAL;
+			break;
+		
+		case SequentialAccess:
+			advice=MADV_SEQUENTIAL;
+			break;
+		
+		case RandomAccess:
+			advice=MADV_RANDOM;
+			break;
+		
+		case WillNeed:
+			advice=MADV_WILLNEED;
+			break;
+		
+		case DontNeed:
+			advice=MADV_DONTNEED;
+			break;
+		
+		case HugePages:
+			#ifdef MADV_HUGEPAGE
+			advice=MADV_HUGEPAGE;
+			break;
+			#else
+			return false;
+			#endif
+		
+		default:
+			return false;
+		}
+	
+	/* Pass the hint to the operating system: */
+	return madvise(start,size,advice)==0;
+	}
+
+const void* MemMappedFile::getSpan(SeekableFile::Offset offset,size_t spanSize) const
+	{
+	/* Check the range against the file's memory space: */
+	if(offset<0||size_t(offset)>memSize)
+		throw SeekError(offset);
+	if(spanSize>memSize-size_t(offset))
+		throw ReadError(spanSize-(memSize-size_t(offset)));
+	
+	return static_cast<const char*>(memBase)+offset;
+	}
+
 }
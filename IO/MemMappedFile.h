@@ -1,7 +1,7 @@
 /***********************************************************************
 MemMappedFile - Class for read/write access to memory-mapped files using
 the File abstraction; mostly for simplified resource management.
-Copyright (c) 2011 Oliver Kreylos
+Copyright (c) 2011-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -30,6 +30,18 @@ namespace IO {
 
 class MemMappedFile:public SeekableFile
 	{
+	/* Embedded classes: */
+	public:
+	enum AccessHint // Enumerated type for hints about how a mapped file will be accessed
+		{
+		NormalAccess, // No special treatment
+		SequentialAccess, // Data will be accessed in sequential order; read ahead aggressively and release data soon after access
+		RandomAccess, // Data will be accessed in random order; do not read ahead
+		WillNeed, // Data will be accessed soon; start reading it into memory now
+		DontNeed, // Data will not be accessed soon; release it from memory
+		HugePages // Back the mapping with huge pages if possible
+		};
+	
 	/* Elements: */
 	private:
 	void* memBase; // Base address of file's memory space
@@ -60,6 +72,27 @@ class MemMappedFile:public SeekableFile
 		{
 		return memBase;
 		}
+	bool advise(AccessHint hint,Offset offset =0,size_t size =~size_t(0)); // Advises the operating system how the given range of the file, extending to the end of the file by default, will be accessed; returns false if the hint was rejected
+	const void* getSpan(Offset offset,size_t spanSize) const; // Returns a pointer to the given range of the file's memory map without changing the read position; throws exception if the range extends past the end of the file
+	const void* readSpan(size_t spanSize) // Returns a pointer to the given amount of data at the current read position in the file's memory map and advances the read position; throws exception if not enough data remains
+		{
+		/* Check if there is enough unread data: */
+		size_t unreadSize=getUnreadDataSize();
+		if(spanSize>unreadSize)
+			throw ReadError(spanSize-unreadSize);
+		
+		/* Return a pointer to the unread data and skip it: */
+		const void* result=static_cast<const Byte*>(memBase)+getReadPos();
+		skip<Byte>(spanSize);
+		return result;
+		}
+	template <class DataParam>
+	const DataParam* readSpan(size_t numItems) // Ditto for an array of values; throws exception if values would require endianness conversion. Returned pointer is only aligned if the file's layout aligns the values
+		{
+		if(readMustSwapEndianness&&sizeof(DataParam)>1)
+			throw Error("IO::MemMappedFile::readSpan: Cannot read values requiring endianness conversion in-place");
+		return static_cast<const DataParam*>(readSpan(numItems*sizeof(DataParam)));
+		}
 	};
 
 }
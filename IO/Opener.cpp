@@ -23,9 +23,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <IO/Opener.h>
 
+#include <unistd.h>
 #include <Misc/FileNameExtensions.h>
 #include <IO/StandardFile.h>
 #include <IO/GzipFilter.h>
+#include <IO/GzippedFile.h>
+#include <IO/ParallelGzipFilter.h>
 #include <IO/SeekableFilter.h>
 #include <IO/StandardDirectory.h>
 #include <IO/StandardFile.h>
@@ -100,8 +103,20 @@ FilePtr Opener::openFile(const char* fileName,File::AccessMode accessMode)
 	/* Check if the file name has the .gz extension: */
 	if(Misc::hasCaseExtension(fileName,".gz"))
 		{
-		/* Wrap a gzip filter around the standard file: */
-		result=new GzipFilter(result);
+		if(accessMode==File::WriteOnly)
+			{
+			/* Use one compression thread per CPU, but at most four, as many files can be open for writing at the same time: */
+			long numCpus=sysconf(_SC_NPROCESSORS_ONLN);
+			unsigned int numCompressionThreads=numCpus>4?4U:(numCpus>0?(unsigned int)(numCpus):1U);
+			
+			/* Wrap a parallel gzip filter around the standard file to compress on background threads: */
+			result=new ParallelGzipFilter(result,numCompressionThreads);
+			}
+		else
+			{
+			/* Wrap a gzip filter around the standard file: */
+			result=new GzipFilter(result);
+			}
 		}
 	
 	/* Return the open file: */
@@ -117,8 +132,19 @@ SeekableFilePtr Opener::openSeekableFile(const char* fileName,File::AccessMode a
 	SeekableFilePtr result=file;
 	if(result==0)
 		{
-		/* Wrap a seekable filter around the file: */
-		result=new SeekableFilter(file);
+		/* Check if the file is a gzip filter around a seekable compressed file: */
+		GzipFilter* gzipFilter=dynamic_cast<GzipFilter*>(file.getPointer());
+		SeekableFilePtr compressedFile=gzipFilter!=0?gzipFilter->getGzippedFile():0;
+		if(compressedFile!=0&&compressedFile->getReadBufferSize()!=0)
+			{
+			/* Read the compressed file through an indexed gzipped file that decompresses on demand: */
+			result=new GzippedFile(compressedFile);
+			}
+		else
+			{
+			/* Wrap a seekable filter around the file: */
+			result=new SeekableFilter(file);
+			}
 		}
 	
 	return result;
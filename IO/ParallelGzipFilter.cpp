@@ -0,0 +1,308 @@
+/***********************************************************************
+ParallelGzipFilter - Class to write gzip-compressed files by compressing
+blocks of uncompressed data on a set of background threads.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the I/O Support Library (IO).
+
+The I/O Support Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The I/O Support Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the I/O Support Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <IO/ParallelGzipFilter.h>
+
+#include <string.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <Misc/ThrowStdErr.h>
+#include <Misc/MessageLogger.h>
+
+namespace IO {
+
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+const size_t maxWindowSize=32768; // Maximum size of a deflate compression dictionary
+
+}
+
+/***********************************
+Methods of class ParallelGzipFilter:
+***********************************/
+
+void ParallelGzipFilter::writeData(const File::Byte* buffer,size_t bufferSize)
+	{
+	/* Copy the given data into blocks: */
+	while(bufferSize>0)
+		{
+		/* Copy as much data as fits into the current block: */
+		Block& block=blocks[fillIndex];
+		size_t copySize=blockSize-block.inputSize;
+		if(copySize>bufferSize)
+			copySize=bufferSize;
+		memcpy(block.input+block.inputSize,buffer,copySize);
+		block.inputSize+=copySize;
+		buffer+=copySize;
+		bufferSize-=copySize;
+		
+		/* Hand the block to the compression threads if it is full: */
+		if(block.inputSize==blockSize)
+			queueBlock(false);
+		}
+	}
+
+size_t ParallelGzipFilter::writeDataUpTo(const File::Byte* buffer,size_t bufferSize)
+	{
+	/* Copying into blocks never blocks, so write all data: */
+	writeData(buffer,bufferSize);
+	
+	return bufferSize;
+	}
+
+void* ParallelGzipFilter::compressionThreadMethod(void)
+	{
+	/* Create a raw deflate compressor: */
+	z_stream stream;
+	memset(&stream,0,sizeof(z_stream));
+	stream.zalloc=Z_NULL;
+	stream.zfree=Z_NULL;
+	stream.opaque=0;
+	bool streamOk=deflateInit2(&stream,compressionLevel,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)==Z_OK;
+	
+	while(true)
+		{
+		/* Wait for the next block to compress: */
+		Block* block;
+		{
+		Threads::MutexCond::Lock blockLock(blockCond);
+		while(numQueuedBlocks==0&&!shutdown)
+			blockCond.wait(blockLock);
+		if(numQueuedBlocks==0)
+			break;
+		block=&blocks[compressIndex];
+		compressIndex=(compressIndex+1)%numBlocks;
+		--numQueuedBlocks;
+		}
+		
+		/* Compress the block such that its compressed data can be appended to that of the previous block: */
+		bool ok=streamOk&&deflateReset(&stream)==Z_OK;
+		if(ok&&block->dictionarySize>0)
+			ok=deflateSetDictionary(&stream,block->dictionary,block->dictionarySize)==Z_OK;
+		if(ok)
+			{
+			stream.next_in=block->input;
+			stream.avail_in=block->inputSize;
+			stream.next_out=block->output;
+			stream.avail_out=outputBufferSize;
+			int result=deflate(&stream,block->last?Z_FINISH:Z_SYNC_FLUSH);
+			if(block->last)
+				ok=result==Z_STREAM_END;
+			else
+				ok=result==Z_OK&&stream.avail_in==0&&stream.avail_out>0;
+			block->outputSize=outputBufferSize-stream.avail_out;
+			}
+		
+		/* Calculate the block's checksum: */
+		block->crc=crc32(crc32(0L,Z_NULL,0),block->input,block->inputSize);
+		
+		/* Signal completion of the block: */
+		{
+		Threads::MutexCond::Lock blockLock(blockCond);
+		if(!ok&&compressionError.empty())
+			compressionError=stream.msg!=0?stream.msg:"Internal zlib error";
+		block->compressed=true;
+		blockCond.broadcast();
+		}
+		}
+	
+	/* Clean up: */
+	if(streamOk)
+		deflateEnd(&stream);
+	
+	return 0;
+	}
+
+void ParallelGzipFilter::queueBlock(bool last)
+	{
+	Block& block=blocks[fillIndex];
+	
+	/* Use the preceding uncompressed data as the block's compression dictionary: */
+	memcpy(block.dictionary,window,windowSize);
+	block.dictionarySize=windowSize;
+	
+	/* Update the window with the block's uncompressed data: */
+	if(block.inputSize>=maxWindowSize)
+		{
+		memcpy(window,block.input+(block.inputSize-maxWindowSize),maxWindowSize);
+		windowSize=maxWindowSize;
+		}
+	else if(block.inputSize>0)
+		{
+		size_t keepSize=windowSize+block.inputSize>maxWindowSize?maxWindowSize-block.inputSize:windowSize;
+		memmove(window,window+(windowSize-keepSize),keepSize);
+		memcpy(window+keepSize,block.input,block.inputSize);
+		windowSize=keepSize+block.inputSize;
+		}
+	totalSize+=uLong(block.inputSize);
+	block.last=last;
+	
+	/* Hand the block to the compression threads: */
+	{
+	Threads::MutexCond::Lock blockLock(blockCond);
+	block.compressed=false;
+	++numPendingBlocks;
+	++numQueuedBlocks;
+	blockCond.broadcast();
+	}
+	
+	/* Write finished blocks, and wait until the next block in the ring buffer is free: */
+	fillIndex=(fillIndex+1)%numBlocks;
+	writeBlocks(numBlocks-1);
+	blocks[fillIndex].inputSize=0;
+	}
+
+void ParallelGzipFilter::writeBlocks(unsigned int maxNumPendingBlocks)
+	{
+	while(numPendingBlocks>0)
+		{
+		/* Check if the oldest pending block has been compressed: */
+		Block& block=blocks[writeIndex];
+		{
+		Threads::MutexCond::Lock blockLock(blockCond);
+		
+		/* Wait for the block if there are too many pending blocks: */
+		while(!block.compressed&&numPendingBlocks>maxNumPendingBlocks)
+			blockCond.wait(blockLock);
+		
+		if(!compressionError.empty())
+			{
+			char buffer[512];
+			throw Error(Misc::printStdErrMsgReentrant(buffer,sizeof(buffer),"IO::ParallelGzipFilter: Error \"%s\" while compressing",compressionError.c_str()));
+			}
+		if(!block.compressed)
+			break;
+		}
+		
+		/* Write the block's compressed data to the gzipped file and update the checksum: */
+		gzippedFile->write(block.output,block.outputSize);
+		crc=crc32_combine(crc,block.crc,block.inputSize);
+		
+		/* Release the block: */
+		writeIndex=(writeIndex+1)%numBlocks;
+		--numPendingBlocks;
+		}
+	}
+
+ParallelGzipFilter::ParallelGzipFilter(FilePtr sGzippedFile,unsigned int sNumCompressionThreads,int sCompressionLevel,size_t sBlockSize)
+	:File(WriteOnly),
+	 gzippedFile(sGzippedFile),
+	 compressionLevel(sCompressionLevel),
+	 blockSize(sBlockSize>=maxWindowSize?sBlockSize:maxWindowSize),
+	 outputBufferSize(compressBound(blockSize)+64),
+	 numBlocks(0),blocks(0),
+	 fillIndex(0),writeIndex(0),numPendingBlocks(0),
+	 compressIndex(0),numQueuedBlocks(0),shutdown(false),
+	 numCompressionThreads(sNumCompressionThreads),compressionThreads(0),
+	 window(new Bytef[maxWindowSize]),windowSize(0),
+	 crc(crc32(0L,Z_NULL,0)),totalSize(0)
+	{
+	/* Determine the number of compression threads: */
+	if(numCompressionThreads==0)
+		{
+		long numCpus=sysconf(_SC_NPROCESSORS_ONLN);
+		numCompressionThreads=numCpus>0?(unsigned int)(numCpus):1U;
+		}
+	
+	/* Create the block ring buffer with enough blocks to keep all compression threads busy: */
+	numBlocks=numCompressionThreads*2+1;
+	blocks=new Block[numBlocks];
+	for(unsigned int i=0;i<numBlocks;++i)
+		{
+		blocks[i].input=new Bytef[blockSize];
+		blocks[i].inputSize=0;
+		blocks[i].dictionary=new Bytef[maxWindowSize];
+		blocks[i].dictionarySize=0;
+		blocks[i].last=false;
+		blocks[i].output=new Bytef[outputBufferSize];
+		blocks[i].outputSize=0;
+		blocks[i].compressed=false;
+		}
+	
+	/* Write a minimal gzip header: */
+	static const Byte header[10]={0x1fU,0x8bU,0x08U,0x00U,0x00U,0x00U,0x00U,0x00U,0x00U,0x03U};
+	gzippedFile->write(header,sizeof(header));
+	
+	/* Start the compression threads: */
+	compressionThreads=new Threads::Thread[numCompressionThreads];
+	for(unsigned int i=0;i<numCompressionThreads;++i)
+		compressionThreads[i].start(this,&ParallelGzipFilter::compressionThreadMethod);
+	}
+
+ParallelGzipFilter::~ParallelGzipFilter(void)
+	{
+	try
+		{
+		/* Flush the write buffer: */
+		flush();
+		
+		/* Compress the final block and write all remaining blocks: */
+		queueBlock(true);
+		writeBlocks(0);
+		
+		/* Write the gzip trailer: */
+		Byte trailer[8];
+		for(int i=0;i<4;++i)
+			{
+			trailer[i]=Byte((crc>>(i*8))&0xffU);
+			trailer[4+i]=Byte((totalSize>>(i*8))&0xffU);
+			}
+		gzippedFile->write(trailer,sizeof(trailer));
+		}
+	catch(const std::runtime_error& err)
+		{
+		/* Print an error message and bail out: */
+		Misc::formattedUserError("IO::ParallelGzipFilter: Error \"%s\" while finishing compressed file",err.what());
+		}
+	
+	/* Shut down the compression threads: */
+	{
+	Threads::MutexCond::Lock blockLock(blockCond);
+	shutdown=true;
+	blockCond.broadcast();
+	}
+	for(unsigned int i=0;i<numCompressionThreads;++i)
+		compressionThreads[i].join();
+	delete[] compressionThreads;
+	
+	/* Release all buffers: */
+	for(unsigned int i=0;i<numBlocks;++i)
+		{
+		delete[] blocks[i].input;
+		delete[] blocks[i].dictionary;
+		delete[] blocks[i].output;
+		}
+	delete[] blocks;
+	delete[] window;
+	}
+
+int ParallelGzipFilter::getFd(void) const
+	{
+	/* Return the gzipped file's file descriptor: */
+	return gzippedFile->getFd();
+	}
+
+}
@@ -0,0 +1,101 @@
+/***********************************************************************
+ParallelGzipFilter - Class to write gzip-compressed files by compressing
+blocks of uncompressed data on a set of background threads.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the I/O Support Library (IO).
+
+The I/O Support Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The I/O Support Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the I/O Support Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef IO_PARALLELGZIPFILTER_INCLUDED
+#define IO_PARALLELGZIPFILTER_INCLUDED
+
+#include <string>
+#include <zlib.h>
+#include <Threads/MutexCond.h>
+#include <Threads/Thread.h>
+#include <IO/File.h>
+
+namespace IO {
+
+class ParallelGzipFilter:public File
+	{
+	/* Embedded classes: */
+	private:
+	struct Block // Structure for blocks of uncompressed data that are compressed independently
+		{
+		/* Elements: */
+		public:
+		Bytef* input; // Buffer of uncompressed data
+		size_t inputSize; // Amount of uncompressed data in the block
+		Bytef* dictionary; // Uncompressed data preceding the block, used as compression dictionary
+		size_t dictionarySize; // Amount of data in the compression dictionary
+		bool last; // Flag if this is the final block of the compressed stream
+		Bytef* output; // Buffer of compressed data
+		size_t outputSize; // Amount of compressed data in the block
+		uLong crc; // CRC-32 checksum of the block's uncompressed data
+		bool compressed; // Flag if the block has been compressed and can be written to the gzipped file
+		};
+	
+	/* Elements: */
+	FilePtr gzippedFile; // Underlying gzip-compressed file
+	int compressionLevel; // Zlib compression level
+	size_t blockSize; // Amount of uncompressed data per block
+	size_t outputBufferSize; // Size of compressed data buffer per block
+	unsigned int numBlocks; // Number of blocks in the block ring buffer
+	Block* blocks; // Ring buffer of blocks
+	unsigned int fillIndex; // Index of the block currently being filled with uncompressed data
+	unsigned int writeIndex; // Index of the oldest block that has not yet been written to the gzipped file
+	unsigned int numPendingBlocks; // Number of filled blocks that have not yet been written to the gzipped file
+	Threads::MutexCond blockCond; // Condition variable protecting the compression queue and signaling completed blocks
+	unsigned int compressIndex; // Index of the next block to be compressed by a compression thread
+	unsigned int numQueuedBlocks; // Number of filled blocks that have not yet been claimed by a compression thread
+	bool shutdown; // Flag to tell the compression threads to shut down
+	std::string compressionError; // Error message from a failed block compression, or empty
+	unsigned int numCompressionThreads; // Number of background compression threads
+	Threads::Thread* compressionThreads; // Array of background compression threads
+	Bytef* window; // Most recently filled uncompressed data, used as compression dictionary for the next block
+	size_t windowSize; // Amount of data in the window
+	uLong crc; // CRC-32 checksum of all uncompressed data written to the gzipped file so far
+	uLong totalSize; // Total amount of uncompressed data modulo 2^32, for the gzip trailer
+	
+	/* Protected methods from File: */
+	protected:
+	virtual void writeData(const Byte* buffer,size_t bufferSize);
+	virtual size_t writeDataUpTo(const Byte* buffer,size_t bufferSize);
+	
+	/* Private methods: */
+	private:
+	void* compressionThreadMethod(void); // Method run by the background compression threads
+	void queueBlock(bool last); // Hands the block currently being filled to the compression threads and starts filling the next block
+	void writeBlocks(unsigned int maxNumPendingBlocks); // Writes compressed blocks to the gzipped file, waiting for blocks to finish compressing until at most the given number are pending
+	
+	/* Constructors and destructors: */
+	public:
+	ParallelGzipFilter(FilePtr sGzippedFile,unsigned int sNumCompressionThreads =0,int sCompressionLevel =Z_DEFAULT_COMPRESSION,size_t sBlockSize =131072); // Creates a filter writing to the given underlying file using the given number of compression threads (one per CPU if zero), compression level, and block size
+	private:
+	ParallelGzipFilter(const ParallelGzipFilter& source); // Prohibit copy constructor
+	ParallelGzipFilter& operator=(const ParallelGzipFilter& source); // Prohibit assignment operator
+	public:
+	virtual ~ParallelGzipFilter(void); // Compresses all remaining data, finishes the gzip stream, and destroys the filter
+	
+	/* Methods from File: */
+	virtual int getFd(void) const;
+	};
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+/***********************************************************************
+ParseNumber - Helper functions to parse decimal numbers from character
+ranges in memory without per-character function calls, with exact
+conversion of floating-point numbers.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the I/O Support Library (IO).
+
+The I/O Support Library is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as published
+by the Free Software Foundation; either version 2 of the License, or (at
+your option) any later version.
+
+The I/O Support Library is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the I/O Support Library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef IO_PARSENUMBER_INCLUDED
+#define IO_PARSENUMBER_INCLUDED
+
+namespace IO {
+
+/***********************************************************************
+All functions parse a number starting at the beginning of the given
+character range, and return a pointer to the first character following
+the number, or a null pointer if the range does not start with a valid
+number. Numbers follow the same syntax as in IO::ValueSource, i.e.,
+integers consist of an optional sign followed by decimal digits, and
+floating-point numbers of an optional sign, decimal digits with an
+optional period, and an optional exponent.
+***********************************************************************/
+
+const char* parseUnsignedInteger(const char* begin,const char* end,unsigned int& value); // Parses an unsigned integer without sign
+const char* parseInteger(const char* begin,const char* end,int& value); // Parses a signed integer
+const char* parseNumber(const char* begin,const char* end,double& value); // Parses a floating-point number and returns the closest double-precision value
+
+}
+
+#endif
@@ -1,6 +1,6 @@
 /***********************************************************************
 ValueSource - Class to read strings or numbers from files.
-Copyright (c) 2009-2019 Oliver Kreylos
+Copyright (c) 2009-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -21,8 +21,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <IO/ValueSource.h>
 
+#include <string.h>
 #include <ctype.h>
-#include <math.h>
+#include <IO/ParseNumber.h>
 
 namespace IO {
 
@@ -121,6 +122,30 @@ char ValueSource::processEscape(void)
 	return result;
 	}
 
+unsigned int ValueSource::readDigits(void)
+	{
+	/* Accumulate the last read character: */
+	unsigned int result=(unsigned int)(lastChar-'0');
+	
+	/* Accumulate digits directly from the character source's read buffer: */
+	const char* bufPtr=source->getUnreadData();
+	const char* bufEnd=bufPtr+source->getUnreadDataSize();
+	const char* digitPtr;
+	for(digitPtr=bufPtr;digitPtr!=bufEnd&&cc[(unsigned char)(*digitPtr)]&DIGIT;++digitPtr)
+		result=result*10U+(unsigned int)(*digitPtr-'0');
+	source->skipUnreadData(digitPtr-bufPtr);
+	lastChar=source->getChar();
+	
+	/* Continue character by character if the number extended past the end of the read buffer: */
+	while(cc[lastChar]&DIGIT)
+		{
+		result=result*10U+(unsigned int)(lastChar-'0');
+		lastChar=source->getChar();
+		}
+	
+	return result;
+	}
+
 ValueSource::ValueSource(FilePtr sSource)
 	:source(sSource),
 	 cc(characterClasses+1),
@@ -601,12 +626,8 @@ int ValueSource::readInteger(void)
 		throw NumberError();
 	
 	/* Read an integral number part: */
-	int result=0;
-	while(cc[lastChar]&DIGIT)
-		{
-		result=result*10+int(lastChar-'0');
-		lastChar=source->getChar();
-		}
+	unsigned int absResult=readDigits();
+	int result=int(absResult);
 	
 	/* Negate the result if a minus sign was read: */
 	if(negate)
@@ -626,12 +647,7 @@ unsigned int ValueSource::readUnsignedInteger(void)
 		throw NumberError();
 	
 	/* Read an integral number part: */
-	unsigned int result=0;
-	while(cc[lastChar]&DIGIT)
-		{
-		result=result*10+(unsigned int)(lastChar-'0');
-		lastChar=source->getChar();
-		}
+	unsigned int result=readDigits();
 	
 	/* Skip whitespace: */
 	while(cc[lastChar]&WHITESPACE)
@@ -642,74 +658,102 @@ unsigned int ValueSource::readUnsignedInteger(void)
 
 double ValueSource::readNumber(void)
 	{
+	/* Check if the number is entirely contained in the character source's read buffer: */
+	const char* bufPtr=source->getUnreadData();
+	size_t bufSize=source->getUnreadDataSize();
+	size_t numberSize=0;
+	while(numberSize<bufSize&&isNumberChar(bufPtr[numberSize]))
+		++numberSize;
+	if(numberSize<bufSize&&numberSize<sizeof(numberBuffer)-1&&(cc[lastChar]&DIGIT||lastChar=='-'||lastChar=='+'||lastChar=='.'))
+		{
+		/* Assemble the number from the last read character and the buffer contents, and parse it: */
+		numberBuffer[0]=char(lastChar);
+		memcpy(numberBuffer+1,bufPtr,numberSize);
+		double result;
+		const char* numberEnd=parseNumber(numberBuffer,numberBuffer+1+numberSize,result);
+		if(numberEnd!=0)
+			{
+			/* Skip the parsed characters and read the character following the number: */
+			source->skipUnreadData((numberEnd-numberBuffer)-1);
+			lastChar=source->getChar();
+			
+			/* Skip whitespace: */
+			while(cc[lastChar]&WHITESPACE)
+				lastChar=source->getChar();
+			
+			return result;
+			}
+		
+		/* Fall back to reading character by character to signal the error at the same position: */
+		}
+	
+	/* Collect the number's characters one at a time: */
+	std::string number;
+	
 	/* Read a plus or minus sign: */
-	bool negate=lastChar=='-';
 	if(lastChar=='-'||lastChar=='+')
+		{
+		number.push_back(char(lastChar));
 		lastChar=source->getChar();
+		}
 	
 	/* Read an integral number part: */
 	bool haveDigit=false;
-	double result=0.0;
 	while(cc[lastChar]&DIGIT)
 		{
 		haveDigit=true;
-		result=result*10.0+double(lastChar-'0');
+		number.push_back(char(lastChar));
 		lastChar=source->getChar();
 		}
 	
 	/* Check for a period: */
 	if(lastChar=='.')
 		{
+		number.push_back(char(lastChar));
 		lastChar=source->getChar();
 		
 		/* Read a fractional number part: */
-		double fraction=0.0;
-		double fractionBase=1.0;
 		while(cc[lastChar]&DIGIT)
 			{
 			haveDigit=true;
-			fraction=fraction*10.0+double(lastChar-'0');
-			fractionBase*=10.0;
+			number.push_back(char(lastChar));
 			lastChar=source->getChar();
 			}
-		
-		result+=fraction/fractionBase;
 		}
 	
 	/* Signal an error if no digits were read in the integral or fractional part: */
 	if(!haveDigit)
 		throw NumberError();
 	
-	/* Negate the result if a minus sign was read: */
-	if(negate)
-		result=-result;
-	
 	/* Check for an exponent indicator: */
 	if(lastChar=='e'||lastChar=='E')
 		{
+		number.push_back(char(lastChar));
 		lastChar=source->getChar();
 		
 		/* Read a plus or minus sign: */
-		bool negateExponent=lastChar=='-';
 		if(lastChar=='-'||lastChar=='+')
+			{
+			number.push_back(char(lastChar));
 			lastChar=source->getChar();
+			}
 		
 		/* Check if there are any digits in the exponent: */
 		if(!(cc[lastChar]&DIGIT))
 			throw NumberError();
 		
 		/* Read the exponent: */
-		double exponent=0.0;
 		while(cc[lastChar]&DIGIT)
 			{
-			exponent=exponent*10.0+double(lastChar-'0');
+			number.push_back(char(lastChar));
 			lastChar=source->getChar();
 			}
-		
-		/* Multiply the mantissa with the exponent: */
-		result*=pow(10.0,negateExponent?-exponent:exponent);
 		}
 	
+	/* Convert the collected characters: */
+	double result;
+	parseNumber(number.data(),number.data()+number.size(),result);
+	
 	/* Skip whitespace: */
 	while(cc[lastChar]&WHITESPACE)
 		lastChar=source->getChar();
@@ -1,6 +1,6 @@
 /***********************************************************************
 ValueSource - Class to read strings or numbers from files.
-Copyright (c) 2009-2019 Oliver Kreylos
+Copyright (c) 2009-2020 Oliver Kreylos
 
 This file is part of the I/O Support Library (IO).
 
@@ -60,9 +60,15 @@ class ValueSource
 	unsigned char* cc; // Pointer into character classes array to account for EOF==-1
 	int escapeChar; // Escape character for quoted and non-quoted strings; -1 if escape sequences should be ignored
 	int lastChar; // Last character read from character source
+	char numberBuffer[64]; // Buffer to assemble numbers read from the character source's read buffer
 	
 	/* Private methods: */
 	char processEscape(void); // Processes an escape sequence from the character source
+	static bool isNumberChar(char c) // Returns true if the given character can be part of a floating-point number
+		{
+		return (c>='0'&&c<='9')||c=='.'||c=='-'||c=='+'||c=='e'||c=='E';
+		}
+	unsigned int readDigits(void); // Reads a sequence of decimal digits starting with the last read character, which must be a digit
 	
 	/* Constructors and destructors: */
 	public:
@@ -24,13 +24,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <IO/ZipArchive.h>
 
 #include <string.h>
+#include <unistd.h>
+#include <errno.h>
 #include <zlib.h>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <Misc/SizedTypes.h>
 #include <Misc/ThrowStdErr.h>
+#include <Threads/Thread.h>
 #include <IO/StandardFile.h>
+#include <IO/MemMappedFile.h>
 #include <IO/FixedMemoryFile.h>
 
 namespace IO {
@@ -53,7 +57,7 @@ class ZipArchiveStreamingFile:public File
 	
 	/* Elements: */
 	private:
-	SeekableFilePtr archive; // Reference to the ZIP archive containing the file
+	ZipArchive::ArchiveReaderPtr archive; // Reader for the ZIP archive containing the file
 	Offset nextReadPos; // Position of next data block to read from archive
 	size_t compressedSize; // Amount of data remaining to be read from archive
 	size_t compressedBufferSize; // Size of allocated buffer for compressed data read from the archive
@@ -69,7 +73,7 @@ class ZipArchiveStreamingFile:public File
 	
 	/* Constructors and destructors: */
 	public:
-	ZipArchiveStreamingFile(SeekableFilePtr sArchive,unsigned int sCompressionMethod,Offset sNextReadPos,size_t sCompressedSize);
+	ZipArchiveStreamingFile(ZipArchive::ArchiveReaderPtr sArchive,unsigned int sCompressionMethod,Offset sNextReadPos,size_t sCompressedSize);
 	virtual ~ZipArchiveStreamingFile(void);
 	};
 
@@ -98,8 +102,7 @@ size_t ZipArchiveStreamingFile::readData(File::Byte* buffer,size_t bufferSize)
 				size_t compressedReadSize=compressedBufferSize;
 				if(compressedReadSize>compressedSize)
 					compressedReadSize=compressedSize;
-				archive->setReadPosAbs(nextReadPos);
-				compressedReadSize=archive->readUpTo(compressedBuffer,compressedReadSize);
+				compressedReadSize=archive->readUpTo(nextReadPos,compressedBuffer,compressedReadSize);
 				nextReadPos+=compressedReadSize;
 				compressedSize-=compressedReadSize;
 				
@@ -131,8 +134,7 @@ size_t ZipArchiveStreamingFile::readData(File::Byte* buffer,size_t bufferSize)
 		size_t readSize=bufferSize;
 		if(readSize>compressedSize)
 			readSize=compressedSize;
-		archive->setReadPosAbs(nextReadPos);
-		readSize=archive->readUpTo(buffer,readSize);
+		readSize=archive->readUpTo(nextReadPos,buffer,readSize);
 		nextReadPos+=readSize;
 		compressedSize-=readSize;
 		eof=compressedSize==0;
@@ -153,7 +155,7 @@ size_t ZipArchiveStreamingFile::writeDataUpTo(const File::Byte* buffer,size_t bu
 	throw Error("IO::ZipArchiveStreamingFile: Writing to ZIP archives not supported");
 	}
 
-ZipArchiveStreamingFile::ZipArchiveStreamingFile(SeekableFilePtr sArchive,unsigned int sCompressionMethod,SeekableFile::Offset sNextReadPos,size_t sCompressedSize)
+ZipArchiveStreamingFile::ZipArchiveStreamingFile(ZipArchive::ArchiveReaderPtr sArchive,unsigned int sCompressionMethod,SeekableFile::Offset sNextReadPos,size_t sCompressedSize)
 	:File(ReadOnly),
 	 archive(sArchive),
 	 nextReadPos(sNextReadPos),compressedSize(sCompressedSize),
@@ -166,8 +168,7 @@ ZipArchiveStreamingFile::ZipArchiveStreamingFile(SeekableFilePtr sArchive,unsign
 		size_t compressedReadSize=compressedBufferSize;
 		if(compressedReadSize>compressedSize)
 			compressedReadSize=compressedSize;
-		archive->setReadPosAbs(nextReadPos);
-		compressedReadSize=archive->readUpTo(compressedBuffer,compressedReadSize);
+		compressedReadSize=archive->readUpTo(nextReadPos,compressedBuffer,compressedReadSize);
 		nextReadPos+=compressedReadSize;
 		compressedSize-=compressedReadSize;
 		
@@ -194,6 +195,73 @@ ZipArchiveStreamingFile::~ZipArchiveStreamingFile(void)
 	delete stream;
 	}
 
+/*****************************************************************
+Class to decompress multiple ZIP archive entries in parallel using
+a set of worker threads:
+*****************************************************************/
+
+class ZipArchiveBulkExtractor
+	{
+	/* Elements: */
+	private:
+	ZipArchive& archive; // The ZIP archive from which to extract files
+	const std::vector<ZipArchive::FileID>& fileIds; // IDs of the files to extract
+	std::vector<SeekableFilePtr>& files; // Extracted files
+	Threads::Mutex indexMutex; // Mutex protecting the index of the next file to extract and the error message
+	size_t nextIndex; // Index of the next file to be extracted by any worker thread
+	std::string errorMessage; // Error message of the first failed extraction, or empty
+	
+	/* Constructors and destructors: */
+	public:
+	ZipArchiveBulkExtractor(ZipArchive& sArchive,const std::vector<ZipArchive::FileID>& sFileIds,std::vector<SeekableFilePtr>& sFiles)
+		:archive(sArchive),fileIds(sFileIds),files(sFiles),
+		 nextIndex(0)
+		{
+		}
+	
+	/* Methods: */
+	void* workerThreadMethod(void); // Extracts files until all files have been claimed or an extraction failed
+	const std::string& getErrorMessage(void) const // Returns the error message of the first failed extraction
+		{
+		return errorMessage;
+		}
+	};
+
+/****************************************
+Methods of class ZipArchiveBulkExtractor:
+****************************************/
+
+void* ZipArchiveBulkExtractor::workerThreadMethod(void)
+	{
+	while(true)
+		{
+		/* Claim the next file to extract: */
+		size_t index;
+		{
+		Threads::Mutex::Lock indexLock(indexMutex);
+		if(nextIndex>=fileIds.size()||!errorMessage.empty())
+			break;
+		index=nextIndex;
+		++nextIndex;
+		}
+		
+		try
+			{
+			/* Decompress the file into memory: */
+			files[index]=archive.openSeekableFile(fileIds[index]);
+			}
+		catch(const std::runtime_error& err)
+			{
+			/* Remember the first error and stop all worker threads: */
+			Threads::Mutex::Lock indexLock(indexMutex);
+			if(errorMessage.empty())
+				errorMessage=err.what();
+			}
+		}
+	
+	return 0;
+	}
+
 }
 
 /**************************************************************************************
@@ -773,6 +841,84 @@ ZipArchive::FileNotFoundError::~FileNotFoundError(void) throw()
 	delete[] fileName;
 	}
 
+/******************************************
+Methods of class ZipArchive::ArchiveReader:
+******************************************/
+
+ZipArchive::ArchiveReader::ArchiveReader(SeekableFilePtr sFile)
+	:file(sFile),
+	 memory(0),memorySize(0),fd(-1)
+	{
+	/* Check if the file is memory-mapped: */
+	MemMappedFile* mmFile=dynamic_cast<MemMappedFile*>(file.getPointer());
+	if(mmFile!=0)
+		{
+		/* Read directly from the file's memory image: */
+		memory=static_cast<const unsigned char*>(mmFile->getMemory());
+		memorySize=mmFile->getSize();
+		}
+	else if(dynamic_cast<StandardFile*>(file.getPointer())!=0)
+		{
+		/* Read from the file's descriptor using positioned reads, which do not affect the file's read position: */
+		fd=file->getFd();
+		}
+	}
+
+size_t ZipArchive::ArchiveReader::readUpTo(ZipArchive::Offset pos,void* buffer,size_t size)
+	{
+	if(memory!=0)
+		{
+		/* Copy data from the memory image: */
+		if(pos>=memorySize)
+			return 0;
+		if(Offset(size)>memorySize-pos)
+			size=size_t(memorySize-pos);
+		memcpy(buffer,memory+pos,size);
+		
+		return size;
+		}
+	else if(fd>=0)
+		{
+		/* Read data using positioned reads until the buffer is full or the end of the file is reached: */
+		unsigned char* bufPtr=static_cast<unsigned char*>(buffer);
+		size_t readSize=0;
+		while(readSize<size)
+			{
+			ssize_t result=pread(fd,bufPtr+readSize,size-readSize,pos+Offset(readSize));
+			if(result>0)
+				readSize+=size_t(result);
+			else if(result==0)
+				break;
+			else if(errno!=EINTR)
+				{
+				int error=errno;
+				Misc::throwStdErr("IO::ZipArchive::ArchiveReader: Fatal error %d (%s) while reading from archive",error,strerror(error));
+				}
+			}
+		
+		return readSize;
+		}
+	else
+		{
+		/* Serialize access to the shared file object: */
+		Threads::Mutex::Lock fileLock(fileMutex);
+		file->setReadPosAbs(pos);
+		
+		/* Read data until the buffer is full or the end of the file is reached: */
+		unsigned char* bufPtr=static_cast<unsigned char*>(buffer);
+		size_t readSize=0;
+		while(readSize<size)
+			{
+			size_t result=file->readUpTo(bufPtr+readSize,size-readSize);
+			if(result==0)
+				break;
+			readSize+=result;
+			}
+		
+		return readSize;
+		}
+	}
+
 /***************************
 Methods of class ZipArchive:
 ***************************/
@@ -958,6 +1104,9 @@ ZipArchive::ZipArchive(const char* archiveFileName)
 			Misc::throwStdErr("IO::ZipArchive: Invalid central directory in ZIP archive %s",archiveFileName);
 			break;
 		}
+	
+	/* Create a reader to access the archive from multiple threads: */
+	reader=new ArchiveReader(archive);
 	}
 
 ZipArchive::ZipArchive(SeekableFilePtr sArchive)
@@ -979,6 +1128,9 @@ ZipArchive::ZipArchive(SeekableFilePtr sArchive)
 			throw std::runtime_error("IO::ZipArchive: Invalid central directory in ZIP archive");
 			break;
 		}
+	
+	/* Create a reader to access the archive from multiple threads: */
+	reader=new ArchiveReader(archive);
 	}
 
 ZipArchive::~ZipArchive(void)
@@ -1004,64 +1156,79 @@ ZipArchive::FileID ZipArchive::findFile(const char* fileName) const
 		throw FileNotFoundError(fileName);
 	}
 
-FilePtr ZipArchive::openFile(const ZipArchive::FileID& fileId)
+void ZipArchive::readFileHeader(const ZipArchive::FileID& fileId,unsigned int& compressionMethod,ZipArchive::Offset& dataPos,size_t& compressedSize,size_t& uncompressedSize)
 	{
-	/* Read the file's header: */
-	archive->setReadPosAbs(fileId.filePos);
-	if(archive->read<Misc::UInt32>()!=0x04034b50U)
-		throw File::OpenError("IO::ZipArchive::openFile: Invalid file header signature");
+	if(!fileId.isValid())
+		throw File::OpenError("IO::ZipArchive: Invalid file ID");
 	
-	/* Read file header information: */
-	archive->skip<Misc::UInt16>(2);
-	unsigned short compressionMethod=archive->read<Misc::UInt16>();
-	archive->skip<Misc::UInt16>(2);
-	archive->skip<Misc::UInt32>(1);
-	unsigned int compressedSize=archive->read<Misc::UInt32>();
-	archive->skip<Misc::UInt32>(1);
-	unsigned short fileNameLength=archive->read<Misc::UInt16>();
-	unsigned short extraFieldLength=archive->read<Misc::UInt16>();
+	/* Read the file's local header in one go to be independent of the archive file's read position: */
+	unsigned char header[30];
+	reader->read(fileId.filePos,header,sizeof(header));
+	
+	/* Check the header signature: */
+	if(header[0]!=0x50U||header[1]!=0x4bU||header[2]!=0x03U||header[3]!=0x04U)
+		throw File::OpenError("IO::ZipArchive: Invalid file header signature");
+	
+	/* Extract file header information from little-endian fields: */
+	compressionMethod=(unsigned int)(header[8])|((unsigned int)(header[9])<<8);
+	compressedSize=size_t(header[18])|(size_t(header[19])<<8)|(size_t(header[20])<<16)|(size_t(header[21])<<24);
+	uncompressedSize=size_t(header[22])|(size_t(header[23])<<8)|(size_t(header[24])<<16)|(size_t(header[25])<<24);
+	unsigned int fileNameLength=(unsigned int)(header[26])|((unsigned int)(header[27])<<8);
+	unsigned int extraFieldLength=(unsigned int)(header[28])|((unsigned int)(header[29])<<8);
 	
 	/* Skip file name and extra field: */
-	archive->skip<char>(fileNameLength);
-	archive->skip<char>(extraFieldLength);
+	dataPos=fileId.filePos+Offset(sizeof(header))+Offset(fileNameLength)+Offset(extraFieldLength);
+	}
+
+FilePtr ZipArchive::openFile(const ZipArchive::FileID& fileId)
+	{
+	/* Read the file's header: */
+	unsigned int compressionMethod;
+	Offset dataPos;
+	size_t compressedSize,uncompressedSize;
+	readFileHeader(fileId,compressionMethod,dataPos,compressedSize,uncompressedSize);
 	
 	/* Create and return the result file: */
-	return new ZipArchiveStreamingFile(archive,compressionMethod,archive->getReadPos(),compressedSize);
+	return new ZipArchiveStreamingFile(reader,compressionMethod,dataPos,compressedSize);
 	}
 
 SeekableFilePtr ZipArchive::openSeekableFile(const ZipArchive::FileID& fileId)
 	{
 	/* Read the file's header: */
-	archive->setReadPosAbs(fileId.filePos);
-	if(archive->read<Misc::UInt32>()!=0x04034b50U)
-		throw File::OpenError("IO::ZipArchive::openSeekableFile: Invalid file header signature");
-	
-	/* Read file header information: */
-	archive->skip<Misc::UInt16>(2);
-	unsigned short compressionMethod=archive->read<Misc::UInt16>();
-	archive->skip<Misc::UInt16>(2);
-	archive->skip<Misc::UInt32>(1);
-	unsigned int compressedSize=archive->read<Misc::UInt32>();
-	unsigned int uncompressedSize=archive->read<Misc::UInt32>();
-	unsigned short fileNameLength=archive->read<Misc::UInt16>();
-	unsigned short extraFieldLength=archive->read<Misc::UInt16>();
-	
-	/* Skip file name and extra field: */
-	archive->skip<char>(fileNameLength);
-	archive->skip<char>(extraFieldLength);
+	unsigned int compressionMethod;
+	Offset dataPos;
+	size_t compressedSize,uncompressedSize;
+	readFileHeader(fileId,compressionMethod,dataPos,compressedSize,uncompressedSize);
 	
 	/* Create the result file: */
 	FixedMemoryFile* result=new FixedMemoryFile(uncompressedSize);
 	if(compressionMethod==0)
 		{
 		/* Directly read the uncompressed data: */
-		archive->read<char>(static_cast<char*>(result->getMemory()),compressedSize);
+		try
+			{
+			reader->read(dataPos,result->getMemory(),compressedSize);
+			}
+		catch(...)
+			{
+			delete result;
+			throw;
+			}
 		}
 	else
 		{
 		/* Read the compressed data: */
 		Bytef* compressed=new Bytef[compressedSize];
-		archive->read<Bytef>(compressed,compressedSize);
+		try
+			{
+			reader->read(dataPos,compressed,compressedSize);
+			}
+		catch(...)
+			{
+			delete[] compressed;
+			delete result;
+			throw;
+			}
 		
 		/* Uncompress the data: */
 		z_stream stream;
@@ -1095,6 +1262,43 @@ SeekableFilePtr ZipArchive::openSeekableFile(const ZipArchive::FileID& fileId)
 	return result;
 	}
 
+void ZipArchive::extractFiles(const std::vector<ZipArchive::FileID>& fileIds,std::vector<SeekableFilePtr>& files,unsigned int numThreads)
+	{
+	/* Prepare the result array: */
+	files.clear();
+	files.resize(fileIds.size());
+	
+	/* Determine the number of worker threads: */
+	if(numThreads==0)
+		{
+		long numCpus=sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads=numCpus>0?(unsigned int)(numCpus):1U;
+		}
+	if(numThreads>fileIds.size())
+		numThreads=(unsigned int)(fileIds.size());
+	
+	/* Extract files on a set of worker threads: */
+	ZipArchiveBulkExtractor extractor(*this,fileIds,files);
+	if(numThreads>1)
+		{
+		Threads::Thread* workers=new Threads::Thread[numThreads];
+		for(unsigned int i=0;i<numThreads;++i)
+			workers[i].start(&extractor,&ZipArchiveBulkExtractor::workerThreadMethod);
+		for(unsigned int i=0;i<numThreads;++i)
+			workers[i].join();
+		delete[] workers;
+		}
+	else
+		extractor.workerThreadMethod();
+	
+	/* Check for errors: */
+	if(!extractor.getErrorMessage().empty())
+		{
+		files.clear();
+		Misc::throwStdErr("IO::ZipArchive::extractFiles: %s",extractor.getErrorMessage().c_str());
+		}
+	}
+
 DirectoryPtr ZipArchive::openRootDirectory(void)
 	{
 	/* Return a new directory object: */
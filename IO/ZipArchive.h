@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <vector>
 #include <stdexcept>
 #include <Misc/Autopointer.h>
+#include <Threads/Mutex.h>
 #include <Threads/RefCounted.h>
 #include <IO/File.h>
 #include <IO/SeekableFile.h>
@@ -61,6 +62,32 @@ class ZipArchive:public Threads::RefCounted
 	
 	class FileID;
 	
+	class ArchiveReader:public Threads::RefCounted // Class for thread-safe positioned reads from a ZIP archive's underlying file
+		{
+		/* Elements: */
+		private:
+		SeekableFilePtr file; // File object to access the ZIP archive
+		const unsigned char* memory; // Pointer to the archive's memory image if the file is memory-mapped; null otherwise
+		Offset memorySize; // Size of the archive's memory image
+		int fd; // Descriptor for positioned reads if the file is a standard file; -1 otherwise
+		Threads::Mutex fileMutex; // Mutex serializing reads from files that are neither memory-mapped nor standard files
+		
+		/* Constructors and destructors: */
+		public:
+		ArchiveReader(SeekableFilePtr sFile); // Creates a reader for the given archive file
+		
+		/* Methods: */
+		size_t readUpTo(Offset pos,void* buffer,size_t size); // Reads up to the given number of bytes starting at the given archive position; returns number of bytes read; can be called concurrently from multiple threads
+		void read(Offset pos,void* buffer,size_t size) // Reads exactly the given number of bytes starting at the given archive position; throws exception if the archive ends prematurely
+			{
+			size_t readSize=readUpTo(pos,buffer,size);
+			if(readSize!=size)
+				throw File::ReadError(size-readSize);
+			}
+		};
+	
+	typedef Misc::Autopointer<ArchiveReader> ArchiveReaderPtr; // Type for reference-counted pointers to archive readers
+	
 	private:
 	struct Directory // Structure to represent interior nodes in the ZIP archive's directory tree
 		{
@@ -195,10 +222,12 @@ class ZipArchive:public Threads::RefCounted
 	/* Elements: */
 	private:
 	SeekableFilePtr archive; // File object to access the ZIP archive
+	ArchiveReaderPtr reader; // Reader for positioned reads from the ZIP archive after initialization, shared with all files opened from the archive
 	Directory root; // The ZIP archive's root directory
 	
 	/* Private methods: */
 	int initArchive(void); // Initializes the ZIP archive file structures; returns error code
+	void readFileHeader(const FileID& fileId,unsigned int& compressionMethod,Offset& dataPos,size_t& compressedSize,size_t& uncompressedSize); // Reads the local header of the given file; returns the file's compression method, the position of its data in the archive, and its compressed and uncompressed sizes
 	
 	/* Constructors and destructors: */
 	public:
@@ -208,8 +237,9 @@ class ZipArchive:public Threads::RefCounted
 	
 	/* Methods: */
 	FileID findFile(const char* fileName) const; // Returns a file identifier for a file of the given name; throws exception if file does not exist
-	FilePtr openFile(const FileID& fileId); // Returns a file for streaming reading
-	SeekableFilePtr openSeekableFile(const FileID& fileId); // Returns a file for seekable reading
+	FilePtr openFile(const FileID& fileId); // Returns a file for streaming reading; can be called concurrently from multiple threads
+	SeekableFilePtr openSeekableFile(const FileID& fileId); // Returns a file for seekable reading; can be called concurrently from multiple threads
+	void extractFiles(const std::vector<FileID>& fileIds,std::vector<SeekableFilePtr>& files,unsigned int numThreads =0); // Decompresses the given files into memory in parallel using the given number of threads, or one thread per CPU if zero; returns files in the same order as the given file IDs
 	DirectoryPtr openRootDirectory(void); // Returns a directory object representing the root directory
 	DirectoryPtr openDirectory(const char* directoryName); // Returns a directory object representing the given directory name
 	};
@@ -0,0 +1,116 @@
+/***********************************************************************
+Endianness - Helper functions to deal with endianness conversion of
+basic data types (extensible via template specialization mechanism).
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Miscellaneous Support Library (Misc).
+
+The Miscellaneous Support Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Miscellaneous Support Library is distributed in the hope that it
+will be useful, but WITHOUT ANY WARRANTY; without even the implied
+warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Miscellaneous Support Library; if not, write to the Free
+Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Misc/Endianness.h>
+
+#include <string.h>
+#include <stdint.h>
+
+/***********************************************************************
+The bulk swapping loops below are written such that the compiler can
+vectorize them. On x86-64 with GCC, additional clones of the functions
+are compiled for SSSE3 and AVX2, which can shuffle entire vectors of
+bytes in one instruction, and the best clone for the executing CPU is
+selected at load time.
+***********************************************************************/
+
+#if defined(__GNUC__)&&!defined(__clang__)&&__GNUC__>=6&&defined(__x86_64__)&&defined(__linux__)
+#define MISC_ENDIANNESS_VECTORCLONES __attribute__((target_clones("default","ssse3","avx2")))
+#else
+#define MISC_ENDIANNESS_VECTORCLONES
+#endif
+
+namespace Misc {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+inline uint16_t swapBytes(uint16_t value)
+	{
+	#ifdef __GNUC__
+	return __builtin_bswap16(value);
+	#else
+	return uint16_t((value>>8)|(value<<8));
+	#endif
+	}
+
+inline uint32_t swapBytes(uint32_t value)
+	{
+	#ifdef __GNUC__
+	return __builtin_bswap32(value);
+	#else
+	return (value>>24)|((value>>8)&0x0000ff00U)|((value<<8)&0x00ff0000U)|(value<<24);
+	#endif
+	}
+
+inline uint64_t swapBytes(uint64_t value)
+	{
+	#ifdef __GNUC__
+	return __builtin_bswap64(value);
+	#else
+	return (uint64_t(swapBytes(uint32_t(value)))<<32)|uint64_t(swapBytes(uint32_t(value>>32)));
+	#endif
+	}
+
+template <class WordParam>
+inline void swapWords(void* values,size_t numValues)
+	{
+	/* Access the values as bytes, as they are not necessarily aligned: */
+	unsigned char* vPtr=static_cast<unsigned char*>(values);
+	for(size_t i=0;i<numValues;++i,vPtr+=sizeof(WordParam))
+		{
+		WordParam word;
+		memcpy(&word,vPtr,sizeof(WordParam));
+		word=swapBytes(word);
+		memcpy(vPtr,&word,sizeof(WordParam));
+		}
+	}
+
+}
+
+/****************************************
+Bulk endianness swapping functions:
+****************************************/
+
+MISC_ENDIANNESS_VECTORCLONES
+void swapEndianness2(void* values,size_t numValues)
+	{
+	swapWords<uint16_t>(values,numValues);
+	}
+
+MISC_ENDIANNESS_VECTORCLONES
+void swapEndianness4(void* values,size_t numValues)
+	{
+	swapWords<uint32_t>(values,numValues);
+	}
+
+MISC_ENDIANNESS_VECTORCLONES
+void swapEndianness8(void* values,size_t numValues)
+	{
+	swapWords<uint64_t>(values,numValues);
+	}
+
+}
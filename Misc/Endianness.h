@@ -1,7 +1,7 @@
 /***********************************************************************
 Endianness - Helper functions to deal with endianness conversion of
 basic data types (extensible via template specialization mechanism).
-Copyright (c) 2001-2005 Oliver Kreylos
+Copyright (c) 2001-2020 Oliver Kreylos
 
 This file is part of the Miscellaneous Support Library (Misc).
 
@@ -44,6 +44,15 @@ enum Endianness // Enumerated type to select endianness types
 	BigEndian // Data has big endianness
 	};
 
+/**************************************************************
+Functions to swap endianness of arrays of 2-, 4-, or 8-byte
+values in-place, using vector instructions where available:
+**************************************************************/
+
+void swapEndianness2(void* values,size_t numValues);
+void swapEndianness4(void* values,size_t numValues);
+void swapEndianness8(void* values,size_t numValues);
+
 /****************************************************************
 Helper class to allow partial specialization of endianness
 swapper:
@@ -70,6 +79,23 @@ class EndiannessSwapper
 		}
 	static void swap(ValueParam* values,size_t numValues)
 		{
+		/* Use the bulk swapping functions for common value sizes: */
+		if(sizeof(ValueParam)==2)
+			{
+			swapEndianness2(values,numValues);
+			return;
+			}
+		if(sizeof(ValueParam)==4)
+			{
+			swapEndianness4(values,numValues);
+			return;
+			}
+		if(sizeof(ValueParam)==8)
+			{
+			swapEndianness8(values,numValues);
+			return;
+			}
+		
 		for(size_t i=0;i<numValues;++i)
 			{
 			/* Treat value as array of bytes: */
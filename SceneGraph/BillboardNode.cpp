@@ -91,6 +91,9 @@ void BillboardNode::update(void)
 		orthoZAxis.normalize();
 		rotationNormal=axisOfRotation.getValue()^orthoZAxis;
 		}
+	
+	/* Update the group state: */
+	GroupNode::update();
 	}
 
 void BillboardNode::glRenderAction(GLRenderState& renderState) const
@@ -139,4 +142,14 @@ void BillboardNode::glRenderAction(GLRenderState& renderState) const
 	renderState.popTransform(previousTransform);
 	}
 
+void BillboardNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Billboards depend on the viewer's position and are therefore not pickable */
+	}
+
+void BillboardNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Billboards depend on the viewer's position and are therefore not pickable */
+	}
+
 }
@@ -58,6 +58,8 @@ class BillboardNode:public GroupNode
 	
 	/* Methods from GraphNode: */
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 typedef Misc::Autopointer<BillboardNode> BillboardNodePointer;
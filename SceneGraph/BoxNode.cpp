@@ -22,12 +22,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/BoxNode.h>
 
 #include <string.h>
+#include <algorithm>
 #include <Math/Math.h>
+#include <Math/Constants.h>
 #include <GL/gl.h>
 #include <GL/GLVertexTemplates.h>
 #include <SceneGraph/EventTypes.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -173,6 +177,9 @@ void BoxNode::update(void)
 	
 	/* Invalidate the display list: */
 	DisplayList::update();
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box BoxNode::calcBoundingBox(void) const
@@ -191,4 +198,100 @@ void BoxNode::glRenderAction(GLRenderState& renderState) const
 	DisplayList::glRenderAction(renderState.contextData);
 	}
 
+void BoxNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Intersect the ray with the box's slabs: */
+	const Point& origin=rayCastState.getRay().getOrigin();
+	const Vector& direction=rayCastState.getRay().getDirection();
+	Scalar l0=-Math::Constants<Scalar>::max;
+	Scalar l1=Math::Constants<Scalar>::max;
+	int axis0=-1;
+	int axis1=-1;
+	for(int i=0;i<3;++i)
+		{
+		if(direction[i]!=Scalar(0))
+			{
+			Scalar t0=(box.min[i]-origin[i])/direction[i];
+			Scalar t1=(box.max[i]-origin[i])/direction[i];
+			if(t0>t1)
+				std::swap(t0,t1);
+			if(l0<t0)
+				{
+				l0=t0;
+				axis0=i;
+				}
+			if(l1>t1)
+				{
+				l1=t1;
+				axis1=i;
+				}
+			}
+		else if(origin[i]<box.min[i]||origin[i]>box.max[i])
+			return;
+		}
+	if(l0>l1)
+		return;
+	
+	/* Use the entry point if the ray starts outside the box, and the exit point otherwise: */
+	if(l0>=Scalar(0)&&axis0>=0)
+		{
+		Vector normal=Vector::zero;
+		normal[axis0]=direction[axis0]<Scalar(0)?Scalar(1):Scalar(-1);
+		rayCastState.updateHit(l0,normal);
+		}
+	else if(l1>=Scalar(0)&&axis1>=0)
+		{
+		Vector normal=Vector::zero;
+		normal[axis1]=direction[axis1]<Scalar(0)?Scalar(-1):Scalar(1);
+		rayCastState.updateHit(l1,normal);
+		}
+	}
+
+void BoxNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Clamp the query center to the box: */
+	const Point& center=sphereProximityState.getCenter();
+	Point closest=center;
+	bool inside=true;
+	for(int i=0;i<3;++i)
+		{
+		if(closest[i]<box.min[i])
+			{
+			closest[i]=box.min[i];
+			inside=false;
+			}
+		else if(closest[i]>box.max[i])
+			{
+			closest[i]=box.max[i];
+			inside=false;
+			}
+		}
+	
+	/* Project query centers inside the box onto the closest face: */
+	if(inside)
+		{
+		int bestAxis=0;
+		Scalar bestFace=box.min[0];
+		Scalar bestDist=center[0]-box.min[0];
+		for(int i=0;i<3;++i)
+			{
+			if(bestDist>center[i]-box.min[i])
+				{
+				bestAxis=i;
+				bestFace=box.min[i];
+				bestDist=center[i]-box.min[i];
+				}
+			if(bestDist>box.max[i]-center[i])
+				{
+				bestAxis=i;
+				bestFace=box.max[i];
+				bestDist=box.max[i]-center[i];
+				}
+			}
+		closest[bestAxis]=bestFace;
+		}
+	
+	sphereProximityState.updateClosestPoint(closest,Geometry::sqrDist(center,closest));
+	}
+
 }
@@ -62,6 +62,8 @@ class BoxNode:public GeometryNode,public DisplayList
 	/* Methods from GeometryNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	
 	/* New methods: */
 	const Box& getBox(void) const // Returns the current derived box
@@ -30,6 +30,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/EventTypes.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
+#include <SceneGraph/Internal/RevolutionProfile.h>
 
 namespace SceneGraph {
 
@@ -178,6 +181,9 @@ void ConeNode::update(void)
 	{
 	/* Invalidate the display list: */
 	DisplayList::update();
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box ConeNode::calcBoundingBox(void) const
@@ -198,4 +204,70 @@ void ConeNode::glRenderAction(GLRenderState& renderState) const
 	DisplayList::glRenderAction(renderState.contextData);
 	}
 
+void ConeNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	const Ray& ray=rayCastState.getRay();
+	const Point& o=ray.getOrigin();
+	const Vector& d=ray.getDirection();
+	Scalar br=bottomRadius.getValue();
+	Scalar h=height.getValue();
+	Scalar h2=Math::div2(h);
+	
+	if(side.getValue()&&h>Scalar(0))
+		{
+		/* Intersect the ray with the infinite double cone x^2+z^2=(k*(h/2-y))^2: */
+		Scalar k2=Math::sqr(br/h);
+		Scalar oy=h2-o[1];
+		Scalar a=d[0]*d[0]+d[2]*d[2]-k2*d[1]*d[1];
+		Scalar bh=o[0]*d[0]+o[2]*d[2]+k2*oy*d[1];
+		Scalar c=o[0]*o[0]+o[2]*o[2]-k2*oy*oy;
+		if(a!=Scalar(0))
+			{
+			Scalar det=bh*bh-a*c;
+			if(det>=Scalar(0))
+				{
+				det=Math::sqrt(det);
+				for(int i=0;i<2;++i)
+					{
+					Scalar lambda=(-bh+(i==0?-det:det))/a;
+					Point p=ray(lambda);
+					if(lambda>=Scalar(0)&&p[1]>=-h2&&p[1]<=h2)
+						rayCastState.updateHit(lambda,Vector(p[0],k2*(h2-p[1]),p[2]));
+					}
+				}
+			}
+		else if(bh!=Scalar(0))
+			{
+			/* The ray is parallel to the cone's surface and intersects it once: */
+			Scalar lambda=-c/(Scalar(2)*bh);
+			Point p=ray(lambda);
+			if(lambda>=Scalar(0)&&p[1]>=-h2&&p[1]<=h2)
+				rayCastState.updateHit(lambda,Vector(p[0],k2*(h2-p[1]),p[2]));
+			}
+		}
+	
+	/* Intersect the ray with the bottom cap: */
+	if(bottom.getValue()&&d[1]!=Scalar(0))
+		{
+		Scalar lambda=(-h2-o[1])/d[1];
+		Point p=ray(lambda);
+		if(lambda>=Scalar(0)&&p[0]*p[0]+p[2]*p[2]<=br*br)
+			rayCastState.updateHit(lambda,Vector(0,-1,0));
+		}
+	}
+
+void ConeNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Find the closest point on the cone's profile: */
+	RevolutionProfile profile(sphereProximityState.getCenter());
+	Scalar br=bottomRadius.getValue();
+	Scalar h2=Math::div2(height.getValue());
+	if(bottom.getValue())
+		profile.addSegment(0,-h2,br,-h2);
+	if(side.getValue())
+		profile.addSegment(br,-h2,0,h2);
+	
+	sphereProximityState.updateClosestPoint(profile.getClosestPoint(),profile.getDist2());
+	}
+
 }
@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef SCENEGRAPH_CONFIG_INCLUDED
 #define SCENEGRAPH_CONFIG_INCLUDED
 
-#define SCENEGRAPH_CONFIG_HAVE_FANCYTEXT 1
+#define SCENEGRAPH_CONFIG_HAVE_FANCYTEXT 0
 
 #define SCENEGRAPH_CONFIG_FONTDIR "/usr/share/fonts/gnu-free/"
 
@@ -153,6 +153,9 @@ void CurveSetNode::update(void)
 	
 	/* Bump up the indexed line set's version number: */
 	++version;
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box CurveSetNode::calcBoundingBox(void) const
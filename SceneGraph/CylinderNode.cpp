@@ -30,6 +30,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <GL/GLVertexTemplates.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
+#include <SceneGraph/Internal/RevolutionProfile.h>
 
 namespace SceneGraph {
 
@@ -172,6 +175,9 @@ void CylinderNode::update(void)
 	{
 	/* Invalidate the display list: */
 	DisplayList::update();
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box CylinderNode::calcBoundingBox(void) const
@@ -192,4 +198,63 @@ void CylinderNode::glRenderAction(GLRenderState& renderState) const
 	DisplayList::glRenderAction(renderState.contextData);
 	}
 
+void CylinderNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	const Ray& ray=rayCastState.getRay();
+	const Point& o=ray.getOrigin();
+	const Vector& d=ray.getDirection();
+	Scalar r=radius.getValue();
+	Scalar h2=Math::div2(height.getValue());
+	
+	if(side.getValue())
+		{
+		/* Intersect the ray with the infinite cylinder around the y axis: */
+		Scalar a=d[0]*d[0]+d[2]*d[2];
+		Scalar bh=o[0]*d[0]+o[2]*d[2];
+		Scalar c=o[0]*o[0]+o[2]*o[2]-r*r;
+		Scalar det=bh*bh-a*c;
+		if(a!=Scalar(0)&&det>=Scalar(0))
+			{
+			det=Math::sqrt(det);
+			for(int i=0;i<2;++i)
+				{
+				Scalar lambda=(-bh+(i==0?-det:det))/a;
+				Point p=ray(lambda);
+				if(lambda>=Scalar(0)&&p[1]>=-h2&&p[1]<=h2)
+					rayCastState.updateHit(lambda,Vector(p[0],0,p[2]));
+				}
+			}
+		}
+	
+	/* Intersect the ray with the caps: */
+	if(d[1]!=Scalar(0))
+		{
+		for(int i=0;i<2;++i)
+			if(i==0?bottom.getValue():top.getValue())
+				{
+				Scalar y=i==0?-h2:h2;
+				Scalar lambda=(y-o[1])/d[1];
+				Point p=ray(lambda);
+				if(lambda>=Scalar(0)&&p[0]*p[0]+p[2]*p[2]<=r*r)
+					rayCastState.updateHit(lambda,Vector(0,i==0?-1:1,0));
+				}
+		}
+	}
+
+void CylinderNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Find the closest point on the cylinder's profile: */
+	RevolutionProfile profile(sphereProximityState.getCenter());
+	Scalar r=radius.getValue();
+	Scalar h2=Math::div2(height.getValue());
+	if(bottom.getValue())
+		profile.addSegment(0,-h2,r,-h2);
+	if(side.getValue())
+		profile.addSegment(r,-h2,r,h2);
+	if(top.getValue())
+		profile.addSegment(r,h2,0,h2);
+	
+	sphereProximityState.updateClosestPoint(profile.getClosestPoint(),profile.getDist2());
+	}
+
 }
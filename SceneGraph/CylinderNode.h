@@ -59,6 +59,8 @@ class CylinderNode:public GeometryNode,public DisplayList
 	/* Methods from GeometryNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 }
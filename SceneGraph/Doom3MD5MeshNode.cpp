@@ -73,6 +73,9 @@ void Doom3MD5MeshNode::update(void)
 	delete mesh;
 	mesh=0;
 	
+	/* Invalidate the cached bounding boxes of all groups containing this node: */
+	invalidateBoundingBox();
+	
 	try
 		{
 		/* Load an MD5 mesh of the given name: */
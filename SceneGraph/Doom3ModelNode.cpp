@@ -77,6 +77,9 @@ void Doom3ModelNode::update(void)
 	delete mesh;
 	mesh=0;
 	
+	/* Invalidate the cached bounding boxes of all groups containing this node: */
+	invalidateBoundingBox();
+	
 	/* Determine the model's format: */
 	const char* fileExt=Misc::getExtension(model.getValue().c_str());
 	
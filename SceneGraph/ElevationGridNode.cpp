@@ -36,6 +36,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <GL/GLGeometryVertex.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
+#include <SceneGraph/Internal/TriangleBVH.h>
 
 #include <SceneGraph/Internal/LoadElevationGrid.h>
 
@@ -1241,6 +1244,87 @@ void ElevationGridNode::uploadHoleyQuadTriangleSet(GLuint& numQuads,GLuint& numT
 	delete[] vertices;
 	}
 
+const TriangleBVH& ElevationGridNode::getBVH(void) const
+	{
+	Threads::Mutex::Lock bvhLock(bvhMutex);
+	
+	/* Check if the BVH needs to be (re-)built: */
+	if(bvh==0||bvhVersion!=version)
+		{
+		if(bvh==0)
+			bvh=new TriangleBVH;
+		else
+			bvh->clear();
+		
+		if(valid)
+			{
+			/* Calculate all vertex positions and apply the point transformation: */
+			int xDim=xDimension.getValue();
+			int zDim=zDimension.getValue();
+			Point* vertices=calcVertices();
+			if(pointTransform.getValue()!=0)
+				{
+				for(int i=0;i<zDim*xDim;++i)
+					vertices[i]=Point(pointTransform.getValue()->transformPoint(PointTransformNode::TPoint(vertices[i])));
+				}
+			
+			/* Add two triangles for each grid cell, or one for cells with a single invalid corner: */
+			bvh->reserve(size_t(zDim-1)*size_t(xDim-1)*2);
+			for(int z=0;z<zDim-1;++z)
+				for(int x=0;x<xDim-1;++x)
+					{
+					const Point* v=vertices+(z*xDim+x);
+					int c=0xf;
+					if(haveInvalids)
+						{
+						/* Compare the grid cell's four corner elevations against the invalid value: */
+						const Scalar* h=&(height.getValue(z*xDim+x));
+						c=0x0;
+						if(h[0]!=invalidHeight.getValue())
+							c+=0x1;
+						if(h[1]!=invalidHeight.getValue())
+							c+=0x2;
+						if(h[xDim]!=invalidHeight.getValue())
+							c+=0x4;
+						if(h[xDim+1]!=invalidHeight.getValue())
+							c+=0x8;
+						}
+					
+					switch(c)
+						{
+						case 0x7:
+							bvh->addTriangle(v[0],v[xDim],v[1]);
+							break;
+						
+						case 0xb:
+							bvh->addTriangle(v[0],v[xDim+1],v[1]);
+							break;
+						
+						case 0xd:
+							bvh->addTriangle(v[0],v[xDim],v[xDim+1]);
+							break;
+						
+						case 0xe:
+							bvh->addTriangle(v[1],v[xDim],v[xDim+1]);
+							break;
+						
+						case 0xf:
+							bvh->addTriangle(v[0],v[xDim],v[1]);
+							bvh->addTriangle(v[1],v[xDim],v[xDim+1]);
+							break;
+						}
+					}
+			
+			delete[] vertices;
+			}
+		
+		bvh->build();
+		bvhVersion=version;
+		}
+	
+	return *bvh;
+	}
+
 ElevationGridNode::ElevationGridNode(void)
 	:colorPerVertex(true),normalPerVertex(true),
 	 creaseAngle(0),
@@ -1252,10 +1336,16 @@ ElevationGridNode::ElevationGridNode(void)
 	 removeInvalids(false),invalidHeight(0),
 	 ccw(true),solid(true),
 	 propMask(0U),
-	 valid(false),indexed(false),version(0)
+	 valid(false),indexed(false),version(0),
+	 bvh(0),bvhVersion(0)
 	{
 	}
 
+ElevationGridNode::~ElevationGridNode(void)
+	{
+	delete bvh;
+	}
+
 const char* ElevationGridNode::getStaticClassName(void)
 	{
 	return "ElevationGrid";
@@ -1367,6 +1457,9 @@ void ElevationGridNode::update(void)
 	
 	/* Bump up the elevation grid's version number: */
 	++version;
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box ElevationGridNode::calcBoundingBox(void) const
@@ -1589,6 +1682,33 @@ void ElevationGridNode::glRenderAction(GLRenderState& renderState) const
 		}
 	}
 
+void ElevationGridNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Intersect the ray with the elevation grid's triangles: */
+	const TriangleBVH& triangles=getBVH();
+	Scalar lambda=rayCastState.getScalarLambda();
+	unsigned int triangleIndex;
+	if(triangles.intersectRay(rayCastState.getRay(),lambda,triangleIndex))
+		{
+		/* Triangles are oriented counter-clockwise; flip the normal vector for clockwise elevation grids: */
+		Vector normal=triangles.calcTriangleNormal(triangleIndex);
+		if(!ccw.getValue())
+			normal=-normal;
+		rayCastState.updateHit(lambda,normal);
+		}
+	}
+
+void ElevationGridNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Find the closest point on the elevation grid's triangles: */
+	const TriangleBVH& triangles=getBVH();
+	Scalar dist2=sphereProximityState.getMaxDist2();
+	Point closestPoint;
+	unsigned int triangleIndex;
+	if(triangles.findClosestPoint(sphereProximityState.getCenter(),dist2,closestPoint,triangleIndex))
+		sphereProximityState.updateClosestPoint(closestPoint,dist2);
+	}
+
 void ElevationGridNode::initContext(GLContextData& contextData) const
 	{
 	/* Create a data item and store it in the context: */
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef SCENEGRAPH_ELEVATIONGRIDNODE_INCLUDED
 #define SCENEGRAPH_ELEVATIONGRIDNODE_INCLUDED
 
+#include <Threads/Mutex.h>
 #include <IO/Directory.h>
 #include <GL/gl.h>
 #include <GL/GLObject.h>
@@ -34,6 +35,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/ColorMapNode.h>
 #include <SceneGraph/ImageProjectionNode.h>
 
+/* Forward declarations: */
+namespace SceneGraph {
+class TriangleBVH;
+}
+
 namespace SceneGraph {
 
 class ElevationGridNode:public GeometryNode,public GLObject
@@ -99,6 +105,9 @@ class ElevationGridNode:public GeometryNode,public GLObject
 	bool indexed; // Flag whether the elevation grid is represented as a set of indexed quad strips or a set of quads
 	bool haveInvalids; // Flag whether there are some invalid elevation samples that need to be removed
 	unsigned int version; // Version number of elevation grid
+	mutable Threads::Mutex bvhMutex; // Mutex protecting the triangle BVH
+	mutable TriangleBVH* bvh; // Bounding volume hierarchy over the elevation grid's triangles for ray casting and proximity queries, built on demand
+	mutable unsigned int bvhVersion; // Version of elevation grid represented by the triangle BVH
 	
 	/* Private methods: */
 	Point* calcVertices(void) const; // Returns a new-allocated array of vertex positions, untransformed by the point transformation
@@ -108,10 +117,12 @@ class ElevationGridNode:public GeometryNode,public GLObject
 	void uploadIndexedQuadStripSet(bool havePrimitiveRestart) const; // Uploads the elevation grid as a set of indexed quad strips
 	void uploadQuadSet(void) const; // Uploads the elevation grid as a set of quads
 	void uploadHoleyQuadTriangleSet(GLuint& numQuads,GLuint& numTriangles) const; // Uploads the elevation grid as a set of quads and triangles with removal of invalid samples; updates passed number of quads and triangles
+	const TriangleBVH& getBVH(void) const; // Returns a triangle BVH for the current version of the elevation grid
 	
 	/* Constructors and destructors: */
 	public:
 	ElevationGridNode(void); // Creates a default elevation grid
+	virtual ~ElevationGridNode(void);
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -122,6 +133,8 @@ class ElevationGridNode:public GeometryNode,public GLObject
 	/* Methods from GeometryNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	
 	/* Methods from GLObject: */
 	virtual void initContext(GLContextData& contextData) const;
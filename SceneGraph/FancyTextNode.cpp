@@ -117,6 +117,9 @@ void FancyTextNode::update(void)
 	
 	/* Invalidate OpenGL state: */
 	++version;
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box FancyTextNode::calcBoundingBox(void) const
@@ -50,13 +50,14 @@ GLRenderState::GLRenderState(GLContextData& sContextData,const GLRenderState::DO
 	 baseViewerPos(sBaseViewerPos),baseUpVector(sBaseUpVector),
 	 currentTransform(initialTransform)
 	{
-	/* Install the initial model transformations: */
+	/* Initialize the view frustum in initial model coordinates from the current OpenGL context: */
 	glMatrixMode(GL_MODELVIEW);
-	glLoadMatrix(currentTransform);
-	
-	/* Initialize the view frustum from the current OpenGL context: */
+	glLoadIdentity();
 	baseFrustum.setFromGL();
 	
+	/* Install the initial model transformations: */
+	glLoadMatrix(currentTransform);
+	
 	/* Initialize OpenGL state tracking elements: */
 	GLint tempFrontFace;
 	glGetIntegerv(GL_FRONT_FACE,&tempFrontFace);
@@ -258,16 +259,17 @@ bool GLRenderState::doesBoxIntersectFrustum(const Box& box) const
 	/* Check the box against each frustum plane: */
 	for(int planeIndex=0;planeIndex<6;++planeIndex)
 		{
-		/* Get the frustum plane's normal vector: */
-		const Vector& normal=baseFrustum.getFrustumPlane(planeIndex).getNormal();
+		/* Get the frustum plane's normal vector (it points to the inside of the frustum): */
+		const Frustum::Plane& plane=baseFrustum.getFrustumPlane(planeIndex);
+		const Vector& normal=plane.getNormal();
 		
-		/* Find the point on the bounding box which is closest to the frustum plane: */
+		/* Find the point on the bounding box which is furthest inside the frustum plane: */
 		Point p;
 		for(int i=0;i<3;++i)
 			p[i]=normal*axis[i]>Scalar(0)?box.max[i]:box.min[i];
 		
-		/* Check if the point is inside the view frustum: */
-		if(!baseFrustum.getFrustumPlane(planeIndex).contains(currentTransform.transform(p)))
+		/* The box is outside the frustum if that point is outside the frustum plane: */
+		if(normal*Point(currentTransform.transform(p))<plane.getOffset())
 			return false;
 		}
 	
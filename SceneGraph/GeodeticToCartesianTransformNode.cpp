@@ -28,6 +28,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <Math/Constants.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -118,13 +120,20 @@ void GeodeticToCartesianTransformNode::update(void)
 		ReferenceEllipsoidNode::Geoid::Frame frame=referenceEllipsoid.getValue()->getRE().geodeticToCartesianFrame(g);
 		transform=OGTransform(frame.getTranslation(),frame.getRotation(),referenceEllipsoid.getValue()->scale.getValue());
 		}
+	
+	/* Update the group state and invalidate the cached bounding boxes: */
+	GroupNode::update();
 	}
 
-Box GeodeticToCartesianTransformNode::calcBoundingBox(void) const
+Box GeodeticToCartesianTransformNode::calcUncachedBoundingBox(void) const
 	{
-	/* Return the explicit bounding box if there is one: */
 	if(haveExplicitBoundingBox)
-		return explicitBoundingBox;
+		{
+		/* Return the transformed explicit bounding box: */
+		Box result=explicitBoundingBox;
+		result.transform(transform);
+		return result;
+		}
 	else
 		{
 		/* Calculate the group's bounding box as the union of the transformed children's boxes: */
@@ -141,6 +150,10 @@ Box GeodeticToCartesianTransformNode::calcBoundingBox(void) const
 
 void GeodeticToCartesianTransformNode::glRenderAction(GLRenderState& renderState) const
 	{
+	/* Skip the group if it is entirely outside the view frustum: */
+	if(isOutsideFrustum(renderState))
+		return;
+	
 	/* Push the transformation onto the matrix stack: */
 	GLRenderState::DOGTransform previousTransform=renderState.pushTransform(transform);
 	
@@ -152,4 +165,38 @@ void GeodeticToCartesianTransformNode::glRenderAction(GLRenderState& renderState
 	renderState.popTransform(previousTransform);
 	}
 
+void GeodeticToCartesianTransformNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Skip the group if the ray misses its bounding box: */
+	if(!rayCastState.doesRayIntersectBox(calcBoundingBox()))
+		return;
+	
+	/* Push the transformation onto the transformation stack: */
+	RayCastState::DOGTransform previousTransform=rayCastState.pushTransform(transform);
+	
+	/* Call the ray casting actions of all children in order: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		(*chIt)->rayCastAction(rayCastState);
+	
+	/* Pop the transformation off the transformation stack: */
+	rayCastState.popTransform(previousTransform);
+	}
+
+void GeodeticToCartesianTransformNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Skip the group if its bounding box is farther away than the closest point found so far: */
+	if(!sphereProximityState.doesSphereIntersectBox(calcBoundingBox()))
+		return;
+	
+	/* Push the transformation onto the transformation stack: */
+	SphereProximityState::DOGTransform previousTransform=sphereProximityState.pushTransform(transform);
+	
+	/* Call the sphere proximity actions of all children in order: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		(*chIt)->sphereProximityAction(sphereProximityState);
+	
+	/* Pop the transformation off the transformation stack: */
+	sphereProximityState.popTransform(previousTransform);
+	}
+
 }
@@ -53,6 +53,9 @@ class GeodeticToCartesianTransformNode:public GroupNode
 	protected:
 	OGTransform transform; // The current transformation
 	
+	/* Protected methods from GroupNode: */
+	virtual Box calcUncachedBoundingBox(void) const;
+	
 	/* Constructors and destructors: */
 	public:
 	GeodeticToCartesianTransformNode(void); // Creates a default node
@@ -64,8 +67,9 @@ class GeodeticToCartesianTransformNode:public GroupNode
 	virtual void update(void);
 	
 	/* Methods from GraphNode: */
-	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	
 	/* New methods: */
 	const OGTransform& getTransform(void) const // Returns the current derived transformation
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <string.h>
 #include <SceneGraph/VRMLFile.h>
+#include <SceneGraph/GraphNode.h>
 
 namespace SceneGraph {
 
@@ -30,11 +31,25 @@ namespace SceneGraph {
 Methods of class GeometryNode:
 *****************************/
 
+void GeometryNode::invalidateBoundingBox(void)
+	{
+	/* Notify all shape nodes using this node: */
+	for(std::vector<GraphNode*>::iterator sIt=shapes.begin();sIt!=shapes.end();++sIt)
+		(*sIt)->invalidateBoundingBox();
+	}
+
 GeometryNode::GeometryNode(void)
 	:needTexCoords(false),needColors(false),needNormals(false)
 	{
 	}
 
+GeometryNode::GeometryNode(const GeometryNode& source)
+	:Node(source),
+	 pointTransform(source.pointTransform),
+	 needTexCoords(source.needTexCoords),needColors(source.needColors),needNormals(source.needNormals)
+	{
+	}
+
 void GeometryNode::parseField(const char* fieldName,VRMLFile& vrmlFile)
 	{
 	if(strcmp(fieldName,"pointTransform")==0)
@@ -64,4 +79,30 @@ void GeometryNode::mustProvideNormals(void)
 	needNormals=true;
 	}
 
+void GeometryNode::addShape(GraphNode& shape)
+	{
+	shapes.push_back(&shape);
+	}
+
+void GeometryNode::removeShape(GraphNode& shape)
+	{
+	/* Remove the first registration of the given shape node: */
+	for(std::vector<GraphNode*>::iterator sIt=shapes.begin();sIt!=shapes.end();++sIt)
+		if(*sIt==&shape)
+			{
+			shapes.erase(sIt);
+			break;
+			}
+	}
+
+void GeometryNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Geometry is not pickable by default */
+	}
+
+void GeometryNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Geometry is not pickable by default */
+	}
+
 }
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef SCENEGRAPH_GEOMETRYNODE_INCLUDED
 #define SCENEGRAPH_GEOMETRYNODE_INCLUDED
 
+#include <vector>
 #include <Misc/Autopointer.h>
 #include <SceneGraph/FieldTypes.h>
 #include <SceneGraph/Node.h>
@@ -29,7 +30,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 /* Forward declarations: */
 namespace SceneGraph {
+class GraphNode;
 class GLRenderState;
+class RayCastState;
+class SphereProximityState;
 }
 
 namespace SceneGraph {
@@ -51,10 +55,17 @@ class GeometryNode:public Node
 	bool needTexCoords; // Flag whether the geometry node needs to provide per-vertex texture coordinates for rendering
 	bool needColors; // Flag whether the geometry node needs to provide per-vertex colors for rendering
 	bool needNormals; // Flag whether the geometry node needs to provide per-vertex normal vectors for rendering
+	private:
+	std::vector<GraphNode*> shapes; // List of shape nodes using this node as their geometry; one entry per use
+	
+	/* Protected methods: */
+	protected:
+	void invalidateBoundingBox(void); // Notifies all shape nodes using this node that its bounding box changed; must be called from update() of derived classes
 	
 	/* Constructors and destructors: */
 	public:
 	GeometryNode(void); // Creates an empty geometry node
+	GeometryNode(const GeometryNode& source); // Copy constructor; does not copy the source's shape nodes
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -66,8 +77,12 @@ class GeometryNode:public Node
 	void mustProvideTexCoords(void); // Flags the geometry node as requiring per-vertex texture coordinates
 	void mustProvideColors(void); // Flags the geometry node as requiring per-vertex colors
 	void mustProvideNormals(void); // Flags the geometry node as requiring per-vertex normal vectors
+	void addShape(GraphNode& shape); // Registers the given shape node as using this node as its geometry
+	void removeShape(GraphNode& shape); // Unregisters one use of this node by the given shape node
 	virtual Box calcBoundingBox(void) const =0; // Returns the bounding box of the geometry defined by the node
 	virtual void glRenderAction(GLRenderState& renderState) const =0; // Renders the geometry defined by the node into the current OpenGL context
+	virtual void rayCastAction(RayCastState& rayCastState) const; // Intersects the given ray with the geometry defined by the node; does nothing by default
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const; // Finds the point on the geometry defined by the node closest to the given query sphere's center; does nothing by default
 	};
 
 typedef Misc::Autopointer<GeometryNode> GeometryNodePointer;
@@ -0,0 +1,88 @@
+/***********************************************************************
+GraphNode - Base class for nodes that can be parts of a scene graph.
+Copyright (c) 2009 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <SceneGraph/GraphNode.h>
+
+namespace SceneGraph {
+
+/**************************
+Methods of class GraphNode:
+**************************/
+
+void GraphNode::linkChildren(GraphNode::GraphNodeList& linkedChildren,const GraphNode::GraphNodeList& newChildren)
+	{
+	/* Unregister from the previous children: */
+	for(GraphNodeList::iterator lcIt=linkedChildren.begin();lcIt!=linkedChildren.end();++lcIt)
+		(*lcIt)->removeParent(*this);
+	
+	/* Register with the new children: */
+	linkedChildren=newChildren;
+	for(GraphNodeList::iterator lcIt=linkedChildren.begin();lcIt!=linkedChildren.end();++lcIt)
+		(*lcIt)->addParent(*this);
+	}
+
+void GraphNode::unlinkChildren(GraphNode::GraphNodeList& linkedChildren)
+	{
+	for(GraphNodeList::iterator lcIt=linkedChildren.begin();lcIt!=linkedChildren.end();++lcIt)
+		(*lcIt)->removeParent(*this);
+	linkedChildren.clear();
+	}
+
+void GraphNode::addParent(GraphNode& parent)
+	{
+	parents.push_back(&parent);
+	}
+
+void GraphNode::removeParent(GraphNode& parent)
+	{
+	/* Remove the first registration of the given parent: */
+	for(std::vector<GraphNode*>::iterator pIt=parents.begin();pIt!=parents.end();++pIt)
+		if(*pIt==&parent)
+			{
+			parents.erase(pIt);
+			break;
+			}
+	}
+
+void GraphNode::invalidateBoundingBox(void)
+	{
+	/* Notify all parents: */
+	for(std::vector<GraphNode*>::iterator pIt=parents.begin();pIt!=parents.end();++pIt)
+		(*pIt)->invalidateBoundingBox();
+	}
+
+bool GraphNode::isBoundingBoxCacheable(void) const
+	{
+	/* Nodes call invalidateBoundingBox when they change by default: */
+	return true;
+	}
+
+void GraphNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Nodes are not pickable by default */
+	}
+
+void GraphNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Nodes are not pickable by default */
+	}
+
+}
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef SCENEGRAPH_GRAPHNODE_INCLUDED
 #define SCENEGRAPH_GRAPHNODE_INCLUDED
 
+#include <vector>
 #include <Misc/Autopointer.h>
 #include <SceneGraph/Geometry.h>
 #include <SceneGraph/Node.h>
@@ -29,16 +30,46 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 /* Forward declarations: */
 namespace SceneGraph {
 class GLRenderState;
+class RayCastState;
+class SphereProximityState;
 }
 
 namespace SceneGraph {
 
 class GraphNode:public Node
 	{
-	/* New methods: */
+	/* Embedded classes: */
+	protected:
+	typedef std::vector<Misc::Autopointer<GraphNode> > GraphNodeList; // Type for lists of child nodes
+	
+	/* Elements: */
+	private:
+	std::vector<GraphNode*> parents; // List of nodes containing this node as a child; one entry per containment
+	
+	/* Protected methods: */
+	protected:
+	void linkChildren(GraphNodeList& linkedChildren,const GraphNodeList& newChildren); // Unregisters this node from the given previously linked children, registers it with the given new children, and replaces the linked list
+	void unlinkChildren(GraphNodeList& linkedChildren); // Unregisters this node from the given linked children and clears the list
+	
+	/* Constructors and destructors: */
 	public:
+	GraphNode(void) // Creates a node without parents
+		{
+		}
+	GraphNode(const GraphNode& source) // Copy constructor; does not copy the source's parents
+		:Node(source)
+		{
+		}
+	
+	/* New methods: */
+	void addParent(GraphNode& parent); // Registers the given node as containing this node as a child
+	void removeParent(GraphNode& parent); // Unregisters one containment of this node in the given node
+	virtual void invalidateBoundingBox(void); // Notifies the node that its bounding box or that of one of its descendants changed; propagates the notification to all parents
+	virtual bool isBoundingBoxCacheable(void) const; // Returns true if the node's bounding box can only change when invalidateBoundingBox is called; true by default
 	virtual Box calcBoundingBox(void) const =0; // Returns the bounding box of the node
 	virtual void glRenderAction(GLRenderState& renderState) const =0; // Renders the node into the current OpenGL context
+	virtual void rayCastAction(RayCastState& rayCastState) const; // Intersects the given ray with the node; does nothing by default
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const; // Finds the point on the node closest to the given query sphere's center; does nothing by default
 	};
 
 typedef Misc::Autopointer<GraphNode> GraphNodePointer;
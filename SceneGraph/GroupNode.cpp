@@ -23,7 +23,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <string.h>
 #include <SceneGraph/EventTypes.h>
+#include <SceneGraph/GLRenderState.h>
 #include <SceneGraph/VRMLFile.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -34,10 +37,17 @@ Methods of class GroupNode:
 GroupNode::GroupNode(void)
 	:bboxCenter(Point::origin),
 	 bboxSize(Size(-1,-1,-1)),
-	 haveExplicitBoundingBox(false)
+	 haveExplicitBoundingBox(false),
+	 boundingBoxValid(false)
 	{
 	}
 
+GroupNode::~GroupNode(void)
+	{
+	/* Unregister this node from its children: */
+	unlinkChildren(linkedChildren);
+	}
+
 const char* GroupNode::getStaticClassName(void)
 	{
 	return "Group";
@@ -142,9 +152,15 @@ void GroupNode::update(void)
 			}
 		explicitBoundingBox=Box(pmin,pmax);
 		}
+	
+	/* Register this node as the parent of its current children: */
+	linkChildren(linkedChildren,children.getValues());
+	
+	/* Invalidate the cached bounding boxes of this node and its ancestors: */
+	invalidateBoundingBox();
 	}
 
-Box GroupNode::calcBoundingBox(void) const
+Box GroupNode::calcUncachedBoundingBox(void) const
 	{
 	/* Return the explicit bounding box if there is one: */
 	if(haveExplicitBoundingBox)
@@ -159,11 +175,97 @@ Box GroupNode::calcBoundingBox(void) const
 		}
 	}
 
+bool GroupNode::isOutsideFrustum(GLRenderState& renderState) const
+	{
+	/* Groups without a bounding box, e.g., those containing only non-geometric nodes, are never culled: */
+	Box box=calcBoundingBox();
+	return !box.isNull()&&!renderState.doesBoxIntersectFrustum(box);
+	}
+
+void GroupNode::invalidateBoundingBox(void)
+	{
+	/* Invalidate the cached bounding box: */
+	{
+	Threads::Spinlock::Lock boundingBoxLock(boundingBoxMutex);
+	boundingBoxValid=false;
+	}
+	
+	/* Call the base class method: */
+	GraphNode::invalidateBoundingBox();
+	}
+
+bool GroupNode::isBoundingBoxCacheable(void) const
+	{
+	/* A cached or explicit bounding box is always cacheable: */
+	{
+	Threads::Spinlock::Lock boundingBoxLock(boundingBoxMutex);
+	if(boundingBoxValid)
+		return true;
+	}
+	if(haveExplicitBoundingBox)
+		return true;
+	
+	/* The union of the children's bounding boxes is only cacheable if all children's boxes are: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		if(!(*chIt)->isBoundingBoxCacheable())
+			return false;
+	return true;
+	}
+
+Box GroupNode::calcBoundingBox(void) const
+	{
+	/* Return the cached bounding box if it is up-to-date: */
+	{
+	Threads::Spinlock::Lock boundingBoxLock(boundingBoxMutex);
+	if(boundingBoxValid)
+		return boundingBox;
+	}
+	
+	/* Calculate the bounding box: */
+	Box result=calcUncachedBoundingBox();
+	
+	/* Cache the bounding box unless it depends on descendants that might change without invalidating it: */
+	if(isBoundingBoxCacheable())
+		{
+		Threads::Spinlock::Lock boundingBoxLock(boundingBoxMutex);
+		boundingBox=result;
+		boundingBoxValid=true;
+		}
+	
+	return result;
+	}
+
 void GroupNode::glRenderAction(GLRenderState& renderState) const
 	{
+	/* Skip the group if it is entirely outside the view frustum: */
+	if(isOutsideFrustum(renderState))
+		return;
+	
 	/* Call the render actions of all children in order: */
 	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
 		(*chIt)->glRenderAction(renderState);
 	}
 
+void GroupNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Skip the group if the ray misses its bounding box: */
+	if(!rayCastState.doesRayIntersectBox(calcBoundingBox()))
+		return;
+	
+	/* Call the ray casting actions of all children in order: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		(*chIt)->rayCastAction(rayCastState);
+	}
+
+void GroupNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Skip the group if its bounding box is farther away than the closest point found so far: */
+	if(!sphereProximityState.doesSphereIntersectBox(calcBoundingBox()))
+		return;
+	
+	/* Call the sphere proximity actions of all children in order: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		(*chIt)->sphereProximityAction(sphereProximityState);
+	}
+
 }
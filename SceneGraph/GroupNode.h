@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include <vector>
 #include <Misc/Autopointer.h>
+#include <Threads/Spinlock.h>
 #include <Geometry/ComponentArray.h>
 #include <Geometry/Point.h>
 #include <Geometry/Box.h>
@@ -53,10 +54,21 @@ class GroupNode:public GraphNode
 	protected:
 	bool haveExplicitBoundingBox; // Flag whether the node has an explicit bounding box
 	Box explicitBoundingBox; // The explicit bounding box, if it exists
+	private:
+	GraphNodeList linkedChildren; // List of children that have this node registered as their parent
+	mutable Threads::Spinlock boundingBoxMutex; // Mutex protecting the cached bounding box
+	mutable bool boundingBoxValid; // Flag whether the cached bounding box is up-to-date
+	mutable Box boundingBox; // Cached bounding box
+	
+	/* Protected methods: */
+	protected:
+	virtual Box calcUncachedBoundingBox(void) const; // Returns the node's bounding box from its explicit bounding box or its children's bounding boxes
+	bool isOutsideFrustum(GLRenderState& renderState) const; // Returns true if the node's bounding box is guaranteed not to intersect the render state's view frustum
 	
 	/* Constructors and destructors: */
 	public:
 	GroupNode(void); // Creates an empty group node
+	virtual ~GroupNode(void); // Unregisters the node from its children
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -67,8 +79,12 @@ class GroupNode:public GraphNode
 	virtual void update(void);
 	
 	/* Methods from GraphNode: */
+	virtual void invalidateBoundingBox(void);
+	virtual bool isBoundingBoxCacheable(void) const;
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 typedef Misc::Autopointer<GroupNode> GroupNodePointer;
@@ -107,48 +107,57 @@ void ImageTextureNode::update(void)
 	++version;
 	}
 
+void ImageTextureNode::uploadTexture(DataItem* dataItem) const
+	{
+	/* Load the texture image: */
+	Images::BaseImage texture=Images::readGenericImageFile(*baseDirectory,url.getValue(0).c_str());
+	
+	/* Upload the texture image: */
+	int mml=mipmapLevel.getValue();
+	texture.glTexImage2D(GL_TEXTURE_2D,0,false);
+	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_BASE_LEVEL,0);
+	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,mml);
+	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,filter.getValue()?(mml>0?GL_LINEAR_MIPMAP_LINEAR:GL_LINEAR):GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,filter.getValue()?GL_LINEAR:GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,repeatS.getValue()?GL_REPEAT:GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,repeatT.getValue()?GL_REPEAT:GL_CLAMP);
+	
+	/* Check if mipmapping was requested and mipmap generation is supported: */
+	if(mml>0&&GLEXTFramebufferObject::isSupported())
+		{
+		/* Initialize the framebuffer extension: */
+		GLEXTFramebufferObject::initExtension();
+		
+		/* Auto-generate all requested mipmap levels: */
+		glGenerateMipmapEXT(GL_TEXTURE_2D);
+		}
+	
+	/* Mark the texture object as up-to-date: */
+	dataItem->version=version;
+	}
+
 void ImageTextureNode::setGLState(GLRenderState& renderState) const
 	{
 	if(url.getNumValues()>0)
 		{
-		/* Enable 2D textures: */
-		renderState.enableTexture2D();
-		
 		/* Get the data item: */
 		DataItem* dataItem=renderState.contextData.retrieveDataItem<DataItem>(this);
+		if(dataItem==0)
+			{
+			/* Texture is not initialized in this context yet; render untextured: */
+			renderState.disableTextures();
+			return;
+			}
+		
+		/* Enable 2D textures: */
+		renderState.enableTexture2D();
 		
 		/* Bind the texture object: */
 		renderState.bindTexture2D(dataItem->textureObjectId);
 		
 		/* Check if the texture object needs to be updated: */
 		if(dataItem->version!=version)
-			{
-			/* Load the texture image: */
-			Images::BaseImage texture=Images::readGenericImageFile(*baseDirectory,url.getValue(0).c_str());
-			
-			/* Upload the texture image: */
-			int mml=mipmapLevel.getValue();
-			texture.glTexImage2D(GL_TEXTURE_2D,0,false);
-			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_BASE_LEVEL,0);
-			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,mml);
-			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,filter.getValue()?(mml>0?GL_LINEAR_MIPMAP_LINEAR:GL_LINEAR):GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,filter.getValue()?GL_LINEAR:GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,repeatS.getValue()?GL_REPEAT:GL_CLAMP);
-			glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,repeatT.getValue()?GL_REPEAT:GL_CLAMP);
-			
-			/* Check if mipmapping was requested and mipmap generation is supported: */
-			if(mml>0&&GLEXTFramebufferObject::isSupported())
-				{
-				/* Initialize the framebuffer extension: */
-				GLEXTFramebufferObject::initExtension();
-				
-				/* Auto-generate all requested mipmap levels: */
-				glGenerateMipmapEXT(GL_TEXTURE_2D);
-				}
-			
-			/* Mark the texture object as up-to-date: */
-			dataItem->version=version;
-			}
+			uploadTexture(dataItem);
 		
 		#if 0
 		
@@ -182,6 +191,20 @@ void ImageTextureNode::initContext(GLContextData& contextData) const
 	/* Create a data item and store it in the GL context: */
 	DataItem* dataItem=new DataItem;
 	contextData.addDataItem(this,dataItem);
+	
+	if(url.getNumValues()>0&&dataItem->version!=version)
+		{
+		/* Upload the texture image right away, to keep the expensive part out of rendering: */
+		glBindTexture(GL_TEXTURE_2D,dataItem->textureObjectId);
+		uploadTexture(dataItem);
+		glBindTexture(GL_TEXTURE_2D,0);
+		}
+	}
+
+bool ImageTextureNode::isContextInitDeferrable(void) const
+	{
+	/* Image textures render untextured until initialized: */
+	return true;
 	}
 
 void ImageTextureNode::setUrl(const std::string& newUrl,IO::Directory& newBaseDirectory)
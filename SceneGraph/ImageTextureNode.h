@@ -61,6 +61,9 @@ class ImageTextureNode:public TextureNode,public GLObject
 	IO::DirectoryPtr baseDirectory; // Base directory for image URLs
 	unsigned int version; // Version number of texture
 	
+	/* Protected methods: */
+	void uploadTexture(DataItem* dataItem) const; // Uploads the current texture image into the data item's texture object, which must be bound
+	
 	/* Constructors and destructors: */
 	public:
 	ImageTextureNode(void); // Creates a default image texture node with no texture image
@@ -77,6 +80,7 @@ class ImageTextureNode:public TextureNode,public GLObject
 	
 	/* Methods from GLObject: */
 	virtual void initContext(GLContextData& contextData) const;
+	virtual bool isContextInitDeferrable(void) const;
 	
 	/* New methods: */
 	void setUrl(const std::string& newUrl,IO::Directory& newBaseDirectory); // Sets an image URL and its base directory
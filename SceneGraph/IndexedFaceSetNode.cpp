@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/IndexedFaceSetNode.h>
 
 #include <string.h>
+#include <vector>
 #include <GL/gl.h>
 #include <GL/GLVertexArrayParts.h>
 #include <GL/GLContextData.h>
@@ -30,6 +31,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <GL/Extensions/GLARBVertexBufferObject.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
+#include <SceneGraph/Internal/TriangleBVH.h>
 
 namespace SceneGraph {
 
@@ -1152,12 +1156,68 @@ void IndexedFaceSetNode::uploadFaceSet(DataItem* dataItem) const
 
 #endif
 
+const TriangleBVH& IndexedFaceSetNode::getBVH(void) const
+	{
+	Threads::Mutex::Lock bvhLock(bvhMutex);
+	
+	/* Check if the BVH needs to be (re-)built: */
+	if(bvh==0||bvhVersion!=version)
+		{
+		if(bvh==0)
+			bvh=new TriangleBVH;
+		else
+			bvh->clear();
+		
+		if(coord.getValue()!=0&&!coord.getValue()->point.getValues().empty())
+			{
+			/* Access the face set's vertex coordinates and face vertex indices: */
+			const MFPoint::ValueList& coords=coord.getValue()->point.getValues();
+			const MFInt::ValueList& coordIndices=coordIndex.getValues();
+			
+			/* Transform all vertices if there is a point transformation: */
+			std::vector<Point> transformedCoords;
+			if(pointTransform.getValue()!=0)
+				{
+				transformedCoords.reserve(coords.size());
+				for(MFPoint::ValueList::const_iterator cIt=coords.begin();cIt!=coords.end();++cIt)
+					transformedCoords.push_back(Point(pointTransform.getValue()->transformPoint(PointTransformNode::TPoint(*cIt))));
+				}
+			const Point* vertices=pointTransform.getValue()!=0?&transformedCoords[0]:&coords[0];
+			
+			/* Add all faces to the BVH, using the same trivial triangulation as for rendering: */
+			bvh->reserve(numTriangles);
+			for(MFInt::ValueList::const_iterator ciIt=coordIndices.begin();ciIt!=coordIndices.end();)
+				{
+				MFInt::ValueList::const_iterator faceBegin=ciIt;
+				for(;ciIt!=coordIndices.end()&&*ciIt>=0;++ciIt)
+					if(ciIt-faceBegin>=2)
+						bvh->addTriangle(vertices[faceBegin[0]],vertices[ciIt[-1]],vertices[ciIt[0]]);
+				
+				/* Skip the face terminator: */
+				if(ciIt!=coordIndices.end())
+					++ciIt;
+				}
+			}
+		
+		bvh->build();
+		bvhVersion=version;
+		}
+	
+	return *bvh;
+	}
+
 IndexedFaceSetNode::IndexedFaceSetNode(void)
 	:colorPerVertex(true),normalPerVertex(true),
 	 ccw(true),convex(true),solid(true),
 	 haveColors(false),numTriangles(0),
-	 version(0)
+	 version(0),
+	 bvh(0),bvhVersion(0)
+	{
+	}
+
+IndexedFaceSetNode::~IndexedFaceSetNode(void)
 	{
+	delete bvh;
 	}
 
 const char* IndexedFaceSetNode::getStaticClassName(void)
@@ -1260,6 +1320,9 @@ void IndexedFaceSetNode::update(void)
 	
 	/* Bump up the indexed face set's version number: */
 	++version;
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box IndexedFaceSetNode::calcBoundingBox(void) const
@@ -1317,7 +1380,11 @@ void IndexedFaceSetNode::glRenderAction(GLRenderState& renderState) const
 	/* Get the context data item: */
 	DataItem* dataItem=renderState.contextData.retrieveDataItem<DataItem>(this);
 	
-	if(dataItem->vertexBufferObjectId!=0&&dataItem->indexBufferObjectId!=0)
+	if(dataItem==0)
+		{
+		/* Face set is not initialized in this context yet; skip it: */
+		}
+	else if(dataItem->vertexBufferObjectId!=0&&dataItem->indexBufferObjectId!=0)
 		{
 		/*******************************************************************
 		Render the indexed face set from the vertex and index buffers:
@@ -1359,11 +1426,54 @@ void IndexedFaceSetNode::glRenderAction(GLRenderState& renderState) const
 		}
 	}
 
+void IndexedFaceSetNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Intersect the ray with the face set's triangles: */
+	const TriangleBVH& triangles=getBVH();
+	Scalar lambda=rayCastState.getScalarLambda();
+	unsigned int triangleIndex;
+	if(triangles.intersectRay(rayCastState.getRay(),lambda,triangleIndex))
+		{
+		Vector normal=triangles.calcTriangleNormal(triangleIndex);
+		if(!ccw.getValue())
+			normal=-normal;
+		rayCastState.updateHit(lambda,normal);
+		}
+	}
+
+void IndexedFaceSetNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Find the closest point on the face set's triangles: */
+	const TriangleBVH& triangles=getBVH();
+	Scalar dist2=sphereProximityState.getMaxDist2();
+	Point closestPoint;
+	unsigned int triangleIndex;
+	if(triangles.findClosestPoint(sphereProximityState.getCenter(),dist2,closestPoint,triangleIndex))
+		sphereProximityState.updateClosestPoint(closestPoint,dist2);
+	}
+
 void IndexedFaceSetNode::initContext(GLContextData& contextData) const
 	{
 	/* Create a data item and store it in the context: */
 	DataItem* dataItem=new DataItem;
 	contextData.addDataItem(this,dataItem);
+	
+	if(dataItem->vertexBufferObjectId!=0&&dataItem->indexBufferObjectId!=0&&dataItem->version!=version)
+		{
+		/* Upload the face set right away, to keep the expensive part out of rendering: */
+		glBindBufferARB(GL_ARRAY_BUFFER_ARB,dataItem->vertexBufferObjectId);
+		glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB,dataItem->indexBufferObjectId);
+		uploadFaceSet(dataItem);
+		dataItem->version=version;
+		glBindBufferARB(GL_ARRAY_BUFFER_ARB,0);
+		glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER_ARB,0);
+		}
+	}
+
+bool IndexedFaceSetNode::isContextInitDeferrable(void) const
+	{
+	/* Face sets are skipped during rendering until initialized: */
+	return true;
 	}
 
 }
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef SCENEGRAPH_INDEXEDFACESETNODE_INCLUDED
 #define SCENEGRAPH_INDEXEDFACESETNODE_INCLUDED
 
+#include <Threads/Mutex.h>
 #include <GL/gl.h>
 #include <GL/GLObject.h>
 #include <SceneGraph/FieldTypes.h>
@@ -32,6 +33,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/NormalNode.h>
 #include <SceneGraph/TextureCoordinateNode.h>
 
+/* Forward declarations: */
+namespace SceneGraph {
+class TriangleBVH;
+}
+
 namespace SceneGraph {
 
 class IndexedFaceSetNode:public GeometryNode,public GLObject
@@ -88,6 +94,10 @@ class IndexedFaceSetNode:public GeometryNode,public GLObject
 	bool haveColors; // Flag if the face set's vertices have per-vertex color values
 	size_t numTriangles; // Total number of triangles defined by the indexed face set
 	unsigned int version; // Version number of face set
+	private:
+	mutable Threads::Mutex bvhMutex; // Mutex protecting the triangle BVH
+	mutable TriangleBVH* bvh; // Bounding volume hierarchy over the face set's triangles for ray casting and proximity queries, built on demand
+	mutable unsigned int bvhVersion; // Version of face set represented by the triangle BVH
 	
 	#if 0
 	/* Private methods: */
@@ -97,10 +107,12 @@ class IndexedFaceSetNode:public GeometryNode,public GLObject
 	/* Protected methods: */
 	protected:
 	void uploadFaceSet(DataItem* dataItem) const; // Uploads new face set into OpenGL buffers
+	const TriangleBVH& getBVH(void) const; // Returns a triangle BVH for the current version of the face set
 	
 	/* Constructors and destructors: */
 	public:
 	IndexedFaceSetNode(void); // Creates a default face set
+	virtual ~IndexedFaceSetNode(void);
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -111,9 +123,12 @@ class IndexedFaceSetNode:public GeometryNode,public GLObject
 	/* Methods from GeometryNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	
 	/* Methods from GLObject: */
 	virtual void initContext(GLContextData& contextData) const;
+	virtual bool isContextInitDeferrable(void) const;
 	};
 
 }
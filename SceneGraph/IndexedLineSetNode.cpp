@@ -261,6 +261,9 @@ void IndexedLineSetNode::update(void)
 	
 	/* Bump up the indexed line set's version number: */
 	++version;
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box IndexedLineSetNode::calcBoundingBox(void) const
@@ -72,6 +72,8 @@ void InlineNode::parseField(const char* fieldName,VRMLFile& vrmlFile)
 
 void InlineNode::update(void)
 	{
+	/* Update the group state: */
+	GroupNode::update();
 	}
 
 }
@@ -0,0 +1,322 @@
+/***********************************************************************
+MeshFileCache - Helper functions to store the representations of mesh
+files in scene cache files, and to restore them without parsing the
+mesh files.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <SceneGraph/Internal/MeshFileCache.h>
+
+#include <Misc/SizedTypes.h>
+#include <Misc/SelfDestructPointer.h>
+#include <Misc/FileNameExtensions.h>
+#include <IO/Directory.h>
+#include <SceneGraph/TextureCoordinateNode.h>
+#include <SceneGraph/ColorNode.h>
+#include <SceneGraph/NormalNode.h>
+#include <SceneGraph/CoordinateNode.h>
+#include <SceneGraph/IndexedFaceSetNode.h>
+#include <SceneGraph/PointSetNode.h>
+#include <SceneGraph/MaterialLibraryNode.h>
+#include <SceneGraph/MeshFileNode.h>
+#include <SceneGraph/SceneCache.h>
+#include <SceneGraph/Internal/ReadMtlFile.h>
+
+namespace SceneGraph {
+
+namespace {
+
+/**************************************************************
+Helper class to assign indices to property nodes shared between
+multiple geometry nodes:
+**************************************************************/
+
+template <class NodeParam>
+class PropertyNodeList
+	{
+	/* Elements: */
+	public:
+	std::vector<const NodeParam*> nodes; // List of distinct property nodes
+	
+	/* Methods: */
+	Misc::SInt32 getIndex(const NodeParam* node) // Returns the index of the given property node, or -1 for a null pointer
+		{
+		if(node==0)
+			return -1;
+		
+		/* Find the node in the list and add it if it is not there yet: */
+		Misc::SInt32 result=0;
+		while(result<Misc::SInt32(nodes.size())&&nodes[result]!=node)
+			++result;
+		if(result==Misc::SInt32(nodes.size()))
+			nodes.push_back(node);
+		
+		return result;
+		}
+	};
+
+/***********************************************************
+Helper function to retrieve property nodes by cached index:
+***********************************************************/
+
+template <class NodeParam>
+inline
+Misc::Autopointer<NodeParam>
+getPropertyNode(
+	std::vector<Misc::Autopointer<NodeParam> >& nodes,
+	SceneCache::Reader& reader)
+	{
+	Misc::SInt32 index=reader.read<Misc::SInt32>();
+	if(index<0)
+		return 0;
+	if(index>=Misc::SInt32(nodes.size()))
+		throw SceneCache::FormatError("SceneGraph::readMeshFileCache: Invalid property node index");
+	return nodes[index];
+	}
+
+enum GeometryType // Enumerated type for geometry node types stored in cache files
+	{
+	INDEXEDFACESET=0,POINTSET
+	};
+
+}
+
+bool readMeshFileCache(const IO::Directory& directory,const std::string& fileName,MeshFileNode& node)
+	{
+	if(!SceneCache::isEnabled())
+		return false;
+	
+	/* Open an up-to-date cache file for the mesh file: */
+	Misc::SelfDestructPointer<SceneCache::Reader> reader(SceneCache::Reader::open(SceneCache::SourceKey(directory,fileName),SceneCache::MeshFile));
+	if(reader.getTarget()==0)
+		return false;
+	
+	std::vector<ShapeNodePointer> shapes;
+	try
+		{
+		/* Read the property nodes: */
+		std::vector<TextureCoordinateNodePointer> texCoords(reader->read<Misc::UInt32>());
+		for(std::vector<TextureCoordinateNodePointer>::iterator nIt=texCoords.begin();nIt!=texCoords.end();++nIt)
+			{
+			*nIt=new TextureCoordinateNode;
+			reader->readArray((*nIt)->point.getValues());
+			}
+		std::vector<ColorNodePointer> colors(reader->read<Misc::UInt32>());
+		for(std::vector<ColorNodePointer>::iterator nIt=colors.begin();nIt!=colors.end();++nIt)
+			{
+			*nIt=new ColorNode;
+			reader->readArray((*nIt)->color.getValues());
+			}
+		std::vector<NormalNodePointer> normals(reader->read<Misc::UInt32>());
+		for(std::vector<NormalNodePointer>::iterator nIt=normals.begin();nIt!=normals.end();++nIt)
+			{
+			*nIt=new NormalNode;
+			reader->readArray((*nIt)->vector.getValues());
+			}
+		std::vector<CoordinateNodePointer> coords(reader->read<Misc::UInt32>());
+		for(std::vector<CoordinateNodePointer>::iterator nIt=coords.begin();nIt!=coords.end();++nIt)
+			{
+			*nIt=new CoordinateNode;
+			reader->readArray((*nIt)->point.getValues());
+			}
+		
+		/* Read the material library file names: */
+		std::vector<std::string> libraryFileNames(reader->read<Misc::UInt32>());
+		for(std::vector<std::string>::iterator lIt=libraryFileNames.begin();lIt!=libraryFileNames.end();++lIt)
+			*lIt=reader->readString();
+		
+		/* Read the shapes: */
+		MaterialLibraryNodePointer materialLibrary=node.materialLibrary.getValue();
+		Misc::UInt32 numShapes=reader->read<Misc::UInt32>();
+		for(Misc::UInt32 shapeIndex=0;shapeIndex<numShapes;++shapeIndex)
+			{
+			ShapeNodePointer shape=new ShapeNode;
+			
+			/* Assign the shape's appearance: */
+			std::string materialName=reader->readString();
+			if(materialName.empty())
+				shape->appearance.setValue(node.appearance.getValue());
+			else
+				{
+				if(materialLibrary==0)
+					{
+					/* Read the mesh file's material library files into a temporary material library node: */
+					materialLibrary=new MaterialLibraryNode;
+					IO::DirectoryPtr meshDirectory=directory.openFileDirectory(fileName.c_str());
+					for(std::vector<std::string>::iterator lIt=libraryFileNames.begin();lIt!=libraryFileNames.end();++lIt)
+						readMtlFile(*meshDirectory,*lIt,*materialLibrary,node.disableTextures.getValue());
+					}
+				shape->appearance.setValue(materialLibrary->getMaterial(materialName));
+				}
+			
+			/* Read the shape's geometry: */
+			Misc::UInt8 geometryType=reader->read<Misc::UInt8>();
+			if(geometryType==INDEXEDFACESET)
+				{
+				Misc::Autopointer<IndexedFaceSetNode> faceSet=new IndexedFaceSetNode;
+				faceSet->texCoord.setValue(getPropertyNode(texCoords,*reader));
+				faceSet->color.setValue(getPropertyNode(colors,*reader));
+				faceSet->normal.setValue(getPropertyNode(normals,*reader));
+				faceSet->coord.setValue(getPropertyNode(coords,*reader));
+				reader->readArray(faceSet->texCoordIndex.getValues());
+				reader->readArray(faceSet->colorIndex.getValues());
+				reader->readArray(faceSet->normalIndex.getValues());
+				reader->readArray(faceSet->coordIndex.getValues());
+				faceSet->colorPerVertex.setValue(reader->read<Misc::UInt8>()!=0);
+				faceSet->normalPerVertex.setValue(reader->read<Misc::UInt8>()!=0);
+				faceSet->convex.setValue(reader->read<Misc::UInt8>()!=0);
+				
+				/* Copy face set parameters from the mesh file node: */
+				faceSet->ccw.setValue(node.ccw.getValue());
+				faceSet->solid.setValue(node.solid.getValue());
+				faceSet->creaseAngle.setValue(node.creaseAngle.getValue());
+				
+				faceSet->update();
+				shape->geometry.setValue(faceSet);
+				}
+			else if(geometryType==POINTSET)
+				{
+				Misc::Autopointer<PointSetNode> pointSet=new PointSetNode;
+				pointSet->color.setValue(getPropertyNode(colors,*reader));
+				pointSet->coord.setValue(getPropertyNode(coords,*reader));
+				
+				/* Copy point set parameters from the mesh file node: */
+				pointSet->pointSize.setValue(node.pointSize.getValue());
+				
+				pointSet->update();
+				shape->geometry.setValue(pointSet);
+				}
+			else
+				throw SceneCache::FormatError("SceneGraph::readMeshFileCache: Invalid geometry type");
+			
+			shape->update();
+			shapes.push_back(shape);
+			}
+		}
+	catch(const SceneCache::FormatError&)
+		{
+		/* Ignore the malformed cache file; the mesh file will be read again: */
+		return false;
+		}
+	
+	/* Add the restored shapes to the mesh file node's representation: */
+	for(std::vector<ShapeNodePointer>::iterator sIt=shapes.begin();sIt!=shapes.end();++sIt)
+		node.addShape(*sIt);
+	
+	return true;
+	}
+
+void writeMeshFileCache(const IO::Directory& directory,const std::string& fileName,const MeshFileNode& node,const std::vector<ShapeNodePointer>& shapes,const MeshFileMaterials& materials)
+	{
+	if(!SceneCache::isEnabled())
+		return;
+	SceneCache::SourceKey key(directory,fileName);
+	if(!key.isValid())
+		return;
+	
+	/* Collect the distinct property nodes used by all cacheable shapes: */
+	PropertyNodeList<TextureCoordinateNode> texCoords;
+	PropertyNodeList<ColorNode> colors;
+	PropertyNodeList<NormalNode> normals;
+	PropertyNodeList<CoordinateNode> coords;
+	for(std::vector<ShapeNodePointer>::const_iterator sIt=shapes.begin();sIt!=shapes.end();++sIt)
+		{
+		const GeometryNode* geometry=(*sIt)->geometry.getValue().getPointer();
+		if(const IndexedFaceSetNode* faceSet=dynamic_cast<const IndexedFaceSetNode*>(geometry))
+			{
+			texCoords.getIndex(faceSet->texCoord.getValue().getPointer());
+			colors.getIndex(faceSet->color.getValue().getPointer());
+			normals.getIndex(faceSet->normal.getValue().getPointer());
+			coords.getIndex(faceSet->coord.getValue().getPointer());
+			}
+		else if(const PointSetNode* pointSet=dynamic_cast<const PointSetNode*>(geometry))
+			{
+			colors.getIndex(pointSet->color.getValue().getPointer());
+			coords.getIndex(pointSet->coord.getValue().getPointer());
+			}
+		else
+			{
+			/* Don't cache mesh files producing unknown geometry types: */
+			return;
+			}
+		}
+	
+	try
+		{
+		SceneCache::Writer writer(key,SceneCache::MeshFile);
+		
+		/* Write the property nodes: */
+		writer.write(Misc::UInt32(texCoords.nodes.size()));
+		for(std::vector<const TextureCoordinateNode*>::iterator nIt=texCoords.nodes.begin();nIt!=texCoords.nodes.end();++nIt)
+			writer.writeArray((*nIt)->point.getValues());
+		writer.write(Misc::UInt32(colors.nodes.size()));
+		for(std::vector<const ColorNode*>::iterator nIt=colors.nodes.begin();nIt!=colors.nodes.end();++nIt)
+			writer.writeArray((*nIt)->color.getValues());
+		writer.write(Misc::UInt32(normals.nodes.size()));
+		for(std::vector<const NormalNode*>::iterator nIt=normals.nodes.begin();nIt!=normals.nodes.end();++nIt)
+			writer.writeArray((*nIt)->vector.getValues());
+		writer.write(Misc::UInt32(coords.nodes.size()));
+		for(std::vector<const CoordinateNode*>::iterator nIt=coords.nodes.begin();nIt!=coords.nodes.end();++nIt)
+			writer.writeArray((*nIt)->point.getValues());
+		
+		/* Write the material library file names: */
+		writer.write(Misc::UInt32(materials.libraryFileNames.size()));
+		for(std::vector<std::string>::const_iterator lIt=materials.libraryFileNames.begin();lIt!=materials.libraryFileNames.end();++lIt)
+			writer.writeString(*lIt);
+		
+		/* Write the shapes: */
+		writer.write(Misc::UInt32(shapes.size()));
+		for(size_t shapeIndex=0;shapeIndex<shapes.size();++shapeIndex)
+			{
+			writer.writeString(shapeIndex<materials.shapeMaterialNames.size()?materials.shapeMaterialNames[shapeIndex]:std::string());
+			
+			const GeometryNode* geometry=shapes[shapeIndex]->geometry.getValue().getPointer();
+			if(const IndexedFaceSetNode* faceSet=dynamic_cast<const IndexedFaceSetNode*>(geometry))
+				{
+				writer.write(Misc::UInt8(INDEXEDFACESET));
+				writer.write(texCoords.getIndex(faceSet->texCoord.getValue().getPointer()));
+				writer.write(colors.getIndex(faceSet->color.getValue().getPointer()));
+				writer.write(normals.getIndex(faceSet->normal.getValue().getPointer()));
+				writer.write(coords.getIndex(faceSet->coord.getValue().getPointer()));
+				writer.writeArray(faceSet->texCoordIndex.getValues());
+				writer.writeArray(faceSet->colorIndex.getValues());
+				writer.writeArray(faceSet->normalIndex.getValues());
+				writer.writeArray(faceSet->coordIndex.getValues());
+				writer.write(Misc::UInt8(faceSet->colorPerVertex.getValue()?1:0));
+				writer.write(Misc::UInt8(faceSet->normalPerVertex.getValue()?1:0));
+				writer.write(Misc::UInt8(faceSet->convex.getValue()?1:0));
+				}
+			else
+				{
+				const PointSetNode* pointSet=static_cast<const PointSetNode*>(geometry);
+				writer.write(Misc::UInt8(POINTSET));
+				writer.write(colors.getIndex(pointSet->color.getValue().getPointer()));
+				writer.write(coords.getIndex(pointSet->coord.getValue().getPointer()));
+				}
+			}
+		
+		writer.commit();
+		}
+	catch(const std::runtime_error&)
+		{
+		/* Ignore the error; the mesh file will be read again next time */
+		}
+	}
+
+}
@@ -0,0 +1,54 @@
+/***********************************************************************
+MeshFileCache - Helper functions to store the representations of mesh
+files in scene cache files, and to restore them without parsing the
+mesh files.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef SCENEGRAPH_INTERNAL_MESHFILECACHE_INCLUDED
+#define SCENEGRAPH_INTERNAL_MESHFILECACHE_INCLUDED
+
+#include <string>
+#include <vector>
+#include <SceneGraph/ShapeNode.h>
+
+/* Forward declarations: */
+namespace IO {
+class Directory;
+}
+namespace SceneGraph {
+class MeshFileNode;
+}
+
+namespace SceneGraph {
+
+struct MeshFileMaterials // Structure recording how the shapes read from a mesh file received their appearances
+	{
+	/* Elements: */
+	public:
+	std::vector<std::string> libraryFileNames; // Names of material library files read by the mesh file, relative to the mesh file's directory
+	std::vector<std::string> shapeMaterialNames; // Names of the materials used by the read shapes in order; empty names select the mesh file node's appearance
+	};
+
+bool readMeshFileCache(const IO::Directory& directory,const std::string& fileName,MeshFileNode& node); // Appends shape nodes restored from an up-to-date scene cache file for the mesh file of the given name to the given mesh file node's representation; returns false if there is no such cache file
+void writeMeshFileCache(const IO::Directory& directory,const std::string& fileName,const MeshFileNode& node,const std::vector<ShapeNodePointer>& shapes,const MeshFileMaterials& materials); // Stores the given shapes read from the mesh file of the given name into a scene cache file; ignores errors
+
+}
+
+#endif
@@ -44,6 +44,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/MeshFileNode.h>
 #include <SceneGraph/Internal/OBJValueSource.h>
 #include <SceneGraph/Internal/ReadMtlFile.h>
+#include <SceneGraph/Internal/MeshFileCache.h>
 
 namespace SceneGraph {
 
@@ -78,6 +79,7 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 	
 	/* Appearance node representing the current material properties: */
 	AppearanceNodePointer currentAppearance;
+	std::string currentMaterialName; // Name of the current material, or empty if the mesh file node's appearance is current
 	
 	/* Geometry nodes collecting geometric primitives: */
 	FaceSetMap faceSetMap; // Map of indexed face sets by appearances
@@ -90,6 +92,7 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 	
 	/* Output state: */
 	MeshFileNode& node; // Mesh file node in which to collect created shapes
+	MeshFileMaterials* materials; // Optional record of material library files and shape materials
 	
 	/* Private methods: */
 	void storeFaceSet(void) // Adds the current face set as a shape to the mesh file node
@@ -134,6 +137,8 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 			/* Finalize the shape node and add it to the mesh file node's representation: */
 			shape->update();
 			node.addShape(shape);
+			if(materials!=0)
+				materials->shapeMaterialNames.push_back(currentMaterialName);
 			
 			/* If there is a current appearance node, add a mapping from it to the face set to the face set map: */
 			if(currentAppearance!=0)
@@ -146,7 +151,7 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 	
 	/* Constructors and destructors: */
 	public:
-	OBJFileReader(IO::Directory& sDirectory,const std::string& fileName,MeshFileNode& sNode)
+	OBJFileReader(IO::Directory& sDirectory,const std::string& fileName,MeshFileNode& sNode,MeshFileMaterials* sMaterials)
 		:directory(sDirectory),
 		 objFile(sDirectory,fileName),
 		 texCoord(new TextureCoordinateNode),texCoords(texCoord->point.getValues()),numTexCoords(0),
@@ -156,7 +161,7 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 		 materialLibrary(sNode.materialLibrary.getValue()==0?new MaterialLibraryNode:0),
 		 currentAppearance(sNode.appearance.getValue()),
 		 faceSetMap(17),currentFaceSet(0),
-		 node(sNode)
+		 node(sNode),materials(sMaterials)
 		{
 		}
 	
@@ -345,6 +350,8 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 					{
 					/* Read the material library file name: */
 					std::string materialLibraryFileName=objFile.readLine();
+					if(materials!=0)
+						materials->libraryFileNames.push_back(materialLibraryFileName);
 					
 					/* Check if the mesh file node does not have a defined material library node: */
 					if(node.materialLibrary.getValue()==0)
@@ -367,6 +374,7 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 					
 					/* Read the name of the new material and get its appearance node from the active material library: */
 					std::string materialName=objFile.readLine();
+					currentMaterialName=materialName;
 					if(node.materialLibrary.getValue()!=0)
 						currentAppearance=node.materialLibrary.getValue()->getMaterial(materialName);
 					else
@@ -385,7 +393,7 @@ class OBJFileReader // Helper class to maintain state while parsing an OBJ file
 
 }
 
-void readObjFile(const IO::Directory& directory,const std::string& fileName,MeshFileNode& node)
+void readObjFile(const IO::Directory& directory,const std::string& fileName,MeshFileNode& node,MeshFileMaterials* materials)
 	{
 	/* Open the directory containing the OBJ file: */
 	IO::DirectoryPtr objDirectory=directory.openFileDirectory(fileName.c_str());
@@ -394,7 +402,7 @@ void readObjFile(const IO::Directory& directory,const std::string& fileName,Mesh
 	std::string objFileName=Misc::getFileName(fileName.c_str());
 	
 	/* Create a reader for the OBJ file: */
-	OBJFileReader objFileReader(*objDirectory,objFileName,node);
+	OBJFileReader objFileReader(*objDirectory,objFileName,node,materials);
 	
 	/* Parse the OBJ file: */
 	objFileReader.parse();
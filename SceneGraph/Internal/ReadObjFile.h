@@ -31,11 +31,12 @@ class Directory;
 }
 namespace SceneGraph {
 class MeshFileNode;
+struct MeshFileMaterials;
 }
 
 namespace SceneGraph {
 
-void readObjFile(const IO::Directory& directory,const std::string& fileName,MeshFileNode& node); // Reads the Wavefront OBJ file of the given name from the given directory and appends read shape nodes to the given mesh file node's representation
+void readObjFile(const IO::Directory& directory,const std::string& fileName,MeshFileNode& node,MeshFileMaterials* materials =0); // Reads the Wavefront OBJ file of the given name from the given directory and appends read shape nodes to the given mesh file node's representation; records the names of used materials if materials is not null
 
 }
 
@@ -0,0 +1,88 @@
+/***********************************************************************
+RevolutionProfile - Helper class to find the closest point to a query
+point on a surface of revolution around the y axis defined by a
+polyline profile in the (radius, y) half-plane.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef SCENEGRAPH_INTERNAL_REVOLUTIONPROFILE_INCLUDED
+#define SCENEGRAPH_INTERNAL_REVOLUTIONPROFILE_INCLUDED
+
+#include <Math/Math.h>
+#include <Math/Constants.h>
+#include <Geometry/Point.h>
+#include <SceneGraph/Geometry.h>
+
+namespace SceneGraph {
+
+class RevolutionProfile
+	{
+	/* Elements: */
+	private:
+	Point query; // The query point
+	Scalar queryR; // Distance from the query point to the y axis
+	Scalar bestDist2; // Squared distance to the closest profile point found so far
+	Scalar bestR,bestY; // Closest profile point found so far
+	
+	/* Constructors and destructors: */
+	public:
+	RevolutionProfile(const Point& sQuery) // Starts a closest point query for the given query point
+		:query(sQuery),queryR(Math::sqrt(Math::sqr(sQuery[0])+Math::sqr(sQuery[2]))),
+		 bestDist2(Math::Constants<Scalar>::max),bestR(0),bestY(0)
+		{
+		}
+	
+	/* Methods: */
+	void addSegment(Scalar r0,Scalar y0,Scalar r1,Scalar y1) // Adds a profile segment
+		{
+		/* Find the closest point on the segment in the profile half-plane: */
+		Scalar dr=r1-r0;
+		Scalar dy=y1-y0;
+		Scalar len2=dr*dr+dy*dy;
+		Scalar t=len2>Scalar(0)?((queryR-r0)*dr+(query[1]-y0)*dy)/len2:Scalar(0);
+		if(t<Scalar(0))
+			t=Scalar(0);
+		else if(t>Scalar(1))
+			t=Scalar(1);
+		Scalar r=r0+dr*t;
+		Scalar y=y0+dy*t;
+		Scalar dist2=Math::sqr(queryR-r)+Math::sqr(query[1]-y);
+		if(bestDist2>dist2)
+			{
+			bestDist2=dist2;
+			bestR=r;
+			bestY=y;
+			}
+		}
+	Scalar getDist2(void) const // Returns the squared distance from the query point to the closest point
+		{
+		return bestDist2;
+		}
+	Point getClosestPoint(void) const // Returns the closest point by rotating the closest profile point into the query point's half-plane
+		{
+		if(queryR>Scalar(0))
+			return Point(query[0]*bestR/queryR,bestY,query[2]*bestR/queryR);
+		else
+			return Point(bestR,bestY,Scalar(0));
+		}
+	};
+
+}
+
+#endif
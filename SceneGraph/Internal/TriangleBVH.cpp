@@ -0,0 +1,465 @@
+/***********************************************************************
+TriangleBVH - Class for bounding volume hierarchies over sets of
+triangles, built with the surface area heuristic, to accelerate ray
+casting and proximity queries against triangle meshes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <SceneGraph/Internal/TriangleBVH.h>
+
+#include <algorithm>
+#include <Math/Math.h>
+#include <Math/Constants.h>
+
+namespace SceneGraph {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+const unsigned int maxLeafSize=4; // Number of triangles below which nodes are never split
+const unsigned int maxForcedLeafSize=16; // Number of triangles above which nodes are always split
+const int numBins=16; // Number of bins per axis for binned SAH evaluation
+
+inline Scalar calcHalfArea(const Box& box) // Returns half the surface area of a non-empty box
+	{
+	Scalar dx=box.max[0]-box.min[0];
+	Scalar dy=box.max[1]-box.min[1];
+	Scalar dz=box.max[2]-box.min[2];
+	return dx*dy+dy*dz+dz*dx;
+	}
+
+struct BuildTask // Structure for pending node construction tasks
+	{
+	/* Elements: */
+	public:
+	unsigned int nodeIndex; // Index of the node to construct
+	unsigned int begin,end; // Range of triangles in the order array
+	};
+
+struct Bin // Structure for SAH bins
+	{
+	/* Elements: */
+	public:
+	Box box; // Bounding box of all triangles in the bin
+	unsigned int numTriangles; // Number of triangles in the bin
+	};
+
+class BinPredicate // Functor class to partition triangles by bin index
+	{
+	/* Elements: */
+	private:
+	const Point* centroids;
+	int axis;
+	Scalar binMin,binScale;
+	int splitBin;
+	
+	/* Constructors and destructors: */
+	public:
+	BinPredicate(const Point* sCentroids,int sAxis,Scalar sBinMin,Scalar sBinScale,int sSplitBin)
+		:centroids(sCentroids),axis(sAxis),binMin(sBinMin),binScale(sBinScale),splitBin(sSplitBin)
+		{
+		}
+	
+	/* Methods: */
+	bool operator()(unsigned int triangleIndex) const
+		{
+		int bin=int((centroids[triangleIndex][axis]-binMin)*binScale);
+		if(bin>=numBins)
+			bin=numBins-1;
+		return bin<splitBin;
+		}
+	};
+
+inline bool intersectRayBox(const Point& origin,const Scalar invDir[3],const Box& box,Scalar lambdaMax,Scalar& lambdaEnter) // Slab test of a ray against a box over the parameter interval [0, lambdaMax)
+	{
+	Scalar l0=Scalar(0);
+	Scalar l1=lambdaMax;
+	for(int i=0;i<3;++i)
+		{
+		Scalar t0=(box.min[i]-origin[i])*invDir[i];
+		Scalar t1=(box.max[i]-origin[i])*invDir[i];
+		if(t0>t1)
+			std::swap(t0,t1);
+		if(l0<t0)
+			l0=t0;
+		if(l1>t1)
+			l1=t1;
+		if(l0>l1)
+			return false;
+		}
+	lambdaEnter=l0;
+	return true;
+	}
+
+inline Point calcClosestPointOnTriangle(const Point& p,const Point& a,const Point& b,const Point& c) // Returns the point on triangle (a, b, c) closest to p, by Voronoi region classification
+	{
+	Vector ab=b-a;
+	Vector ac=c-a;
+	Vector ap=p-a;
+	Scalar d1=ab*ap;
+	Scalar d2=ac*ap;
+	if(d1<=Scalar(0)&&d2<=Scalar(0))
+		return a;
+	
+	Vector bp=p-b;
+	Scalar d3=ab*bp;
+	Scalar d4=ac*bp;
+	if(d3>=Scalar(0)&&d4<=d3)
+		return b;
+	
+	Scalar vc=d1*d4-d3*d2;
+	if(vc<=Scalar(0)&&d1>=Scalar(0)&&d3<=Scalar(0))
+		return a+ab*(d1/(d1-d3));
+	
+	Vector cp=p-c;
+	Scalar d5=ab*cp;
+	Scalar d6=ac*cp;
+	if(d6>=Scalar(0)&&d5<=d6)
+		return c;
+	
+	Scalar vb=d5*d2-d1*d6;
+	if(vb<=Scalar(0)&&d2>=Scalar(0)&&d6<=Scalar(0))
+		return a+ac*(d2/(d2-d6));
+	
+	Scalar va=d3*d6-d5*d4;
+	if(va<=Scalar(0)&&(d4-d3)>=Scalar(0)&&(d5-d6)>=Scalar(0))
+		return b+(c-b)*((d4-d3)/((d4-d3)+(d5-d6)));
+	
+	Scalar denom=Scalar(1)/(va+vb+vc);
+	return a+ab*(vb*denom)+ac*(vc*denom);
+	}
+
+}
+
+/****************************
+Methods of class TriangleBVH:
+****************************/
+
+void TriangleBVH::clear(void)
+	{
+	std::vector<Point>().swap(vertices);
+	std::vector<Node>().swap(nodes);
+	}
+
+void TriangleBVH::build(void)
+	{
+	nodes.clear();
+	unsigned int numTriangles=(unsigned int)(vertices.size()/3);
+	if(numTriangles==0)
+		return;
+	
+	/* Calculate all triangles' bounding boxes and centroids: */
+	std::vector<Box> boxes;
+	boxes.reserve(numTriangles);
+	std::vector<Point> centroids;
+	centroids.reserve(numTriangles);
+	for(unsigned int i=0;i<numTriangles;++i)
+		{
+		const Point* t=&vertices[i*3];
+		Box b(t[0],t[0]);
+		b.addPoint(t[1]);
+		b.addPoint(t[2]);
+		boxes.push_back(b);
+		centroids.push_back(Geometry::mid(b.min,b.max));
+		}
+	
+	/* Initialize the triangle order: */
+	std::vector<unsigned int> order;
+	order.reserve(numTriangles);
+	for(unsigned int i=0;i<numTriangles;++i)
+		order.push_back(i);
+	
+	/* Create the root node and build the hierarchy top-down: */
+	nodes.reserve(2*(numTriangles/maxLeafSize)+1);
+	nodes.push_back(Node());
+	std::vector<BuildTask> tasks;
+	BuildTask rootTask;
+	rootTask.nodeIndex=0;
+	rootTask.begin=0;
+	rootTask.end=numTriangles;
+	tasks.push_back(rootTask);
+	while(!tasks.empty())
+		{
+		BuildTask task=tasks.back();
+		tasks.pop_back();
+		unsigned int count=task.end-task.begin;
+		
+		/* Calculate the node's bounding box and the bounding box of its triangles' centroids: */
+		Box box=Box::empty;
+		Box centroidBox=Box::empty;
+		for(unsigned int i=task.begin;i<task.end;++i)
+			{
+			box.addBox(boxes[order[i]]);
+			centroidBox.addPoint(centroids[order[i]]);
+			}
+		nodes[task.nodeIndex].box=box;
+		
+		/* Find the best split by evaluating the surface area heuristic over binned centroids along all three axes: */
+		int bestAxis=-1;
+		int bestSplit=0;
+		Scalar bestCost=calcHalfArea(box)*Scalar(count);
+		if(count>maxLeafSize)
+			{
+			for(int axis=0;axis<3;++axis)
+				{
+				Scalar extent=centroidBox.max[axis]-centroidBox.min[axis];
+				if(extent<=Scalar(0))
+					continue;
+				Scalar binScale=Scalar(numBins)/extent;
+				
+				/* Sort the triangles into bins: */
+				Bin bins[numBins];
+				for(int b=0;b<numBins;++b)
+					{
+					bins[b].box=Box::empty;
+					bins[b].numTriangles=0;
+					}
+				for(unsigned int i=task.begin;i<task.end;++i)
+					{
+					int bin=int((centroids[order[i]][axis]-centroidBox.min[axis])*binScale);
+					if(bin>=numBins)
+						bin=numBins-1;
+					bins[bin].box.addBox(boxes[order[i]]);
+					++bins[bin].numTriangles;
+					}
+				
+				/* Sweep from the right to accumulate right-side areas: */
+				Scalar rightAreas[numBins];
+				unsigned int rightCounts[numBins];
+				Box rightBox=Box::empty;
+				unsigned int rightCount=0;
+				for(int b=numBins-1;b>0;--b)
+					{
+					rightBox.addBox(bins[b].box);
+					rightCount+=bins[b].numTriangles;
+					rightAreas[b]=rightCount>0?calcHalfArea(rightBox):Scalar(0);
+					rightCounts[b]=rightCount;
+					}
+				
+				/* Sweep from the left and evaluate all split positions: */
+				Box leftBox=Box::empty;
+				unsigned int leftCount=0;
+				for(int b=1;b<numBins;++b)
+					{
+					leftBox.addBox(bins[b-1].box);
+					leftCount+=bins[b-1].numTriangles;
+					if(leftCount==0||rightCounts[b]==0)
+						continue;
+					Scalar cost=calcHalfArea(leftBox)*Scalar(leftCount)+rightAreas[b]*Scalar(rightCounts[b]);
+					if(bestCost>cost)
+						{
+						bestCost=cost;
+						bestAxis=axis;
+						bestSplit=b;
+						}
+					}
+				}
+			}
+		
+		/* Partition the triangles according to the best split: */
+		unsigned int mid;
+		if(bestAxis>=0)
+			{
+			Scalar binScale=Scalar(numBins)/(centroidBox.max[bestAxis]-centroidBox.min[bestAxis]);
+			BinPredicate pred(&centroids[0],bestAxis,centroidBox.min[bestAxis],binScale,bestSplit);
+			mid=(unsigned int)(std::partition(order.begin()+task.begin,order.begin()+task.end,pred)-order.begin());
+			}
+		else if(count>maxForcedLeafSize)
+			{
+			/* Splitting is not worth it or not possible by centroid, but the leaf would be too large; split in the middle: */
+			mid=task.begin+count/2;
+			}
+		else
+			{
+			/* Make the node a leaf: */
+			nodes[task.nodeIndex].first=task.begin;
+			nodes[task.nodeIndex].numTriangles=count;
+			continue;
+			}
+		
+		/* Create the node's two children: */
+		unsigned int childIndex=(unsigned int)nodes.size();
+		nodes[task.nodeIndex].first=childIndex;
+		nodes[task.nodeIndex].numTriangles=0;
+		nodes.push_back(Node());
+		nodes.push_back(Node());
+		BuildTask leftTask;
+		leftTask.nodeIndex=childIndex;
+		leftTask.begin=task.begin;
+		leftTask.end=mid;
+		tasks.push_back(leftTask);
+		BuildTask rightTask;
+		rightTask.nodeIndex=childIndex+1;
+		rightTask.begin=mid;
+		rightTask.end=task.end;
+		tasks.push_back(rightTask);
+		}
+	
+	/* Sort the triangle soup by leaf order: */
+	std::vector<Point> sortedVertices;
+	sortedVertices.reserve(vertices.size());
+	for(std::vector<unsigned int>::iterator oIt=order.begin();oIt!=order.end();++oIt)
+		for(int i=0;i<3;++i)
+			sortedVertices.push_back(vertices[(*oIt)*3+i]);
+	vertices.swap(sortedVertices);
+	}
+
+bool TriangleBVH::intersectRay(const Ray& ray,Scalar& lambda,unsigned int& triangleIndex) const
+	{
+	if(nodes.empty())
+		return false;
+	
+	/* Precompute the ray's inverse direction for slab tests: */
+	const Point& origin=ray.getOrigin();
+	const Vector& dir=ray.getDirection();
+	Scalar invDir[3];
+	for(int i=0;i<3;++i)
+		invDir[i]=dir[i]!=Scalar(0)?Scalar(1)/dir[i]:Math::Constants<Scalar>::max;
+	
+	/* Traverse the hierarchy front-to-back: */
+	bool result=false;
+	Scalar lambdaEnter;
+	if(!intersectRayBox(origin,invDir,nodes[0].box,lambda,lambdaEnter))
+		return false;
+	std::vector<unsigned int> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+	while(!stack.empty())
+		{
+		const Node& node=nodes[stack.back()];
+		stack.pop_back();
+		
+		if(node.numTriangles>0)
+			{
+			/* Intersect the ray with all triangles in the leaf: */
+			for(unsigned int ti=node.first;ti<node.first+node.numTriangles;++ti)
+				{
+				const Point* t=&vertices[ti*3];
+				Vector e1=t[1]-t[0];
+				Vector e2=t[2]-t[0];
+				Vector p=dir^e2;
+				Scalar det=e1*p;
+				if(det==Scalar(0))
+					continue;
+				Scalar invDet=Scalar(1)/det;
+				Vector s=origin-t[0];
+				Scalar u=(s*p)*invDet;
+				if(u<Scalar(0)||u>Scalar(1))
+					continue;
+				Vector q=s^e1;
+				Scalar v=(dir*q)*invDet;
+				if(v<Scalar(0)||u+v>Scalar(1))
+					continue;
+				Scalar l=(e2*q)*invDet;
+				if(l>=Scalar(0)&&l<lambda)
+					{
+					lambda=l;
+					triangleIndex=ti;
+					result=true;
+					}
+				}
+			}
+		else
+			{
+			/* Push the intersected children such that the nearer one is processed first: */
+			Scalar l0,l1;
+			bool hit0=intersectRayBox(origin,invDir,nodes[node.first].box,lambda,l0);
+			bool hit1=intersectRayBox(origin,invDir,nodes[node.first+1].box,lambda,l1);
+			if(hit0&&hit1)
+				{
+				if(l0<=l1)
+					{
+					stack.push_back(node.first+1);
+					stack.push_back(node.first);
+					}
+				else
+					{
+					stack.push_back(node.first);
+					stack.push_back(node.first+1);
+					}
+				}
+			else if(hit0)
+				stack.push_back(node.first);
+			else if(hit1)
+				stack.push_back(node.first+1);
+			}
+		}
+	
+	return result;
+	}
+
+bool TriangleBVH::findClosestPoint(const Point& center,Scalar& dist2,Point& closestPoint,unsigned int& triangleIndex) const
+	{
+	if(nodes.empty()||nodes[0].box.sqrDist(center)>=dist2)
+		return false;
+	
+	/* Traverse the hierarchy nearest-child-first: */
+	bool result=false;
+	std::vector<unsigned int> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+	while(!stack.empty())
+		{
+		const Node& node=nodes[stack.back()];
+		stack.pop_back();
+		if(node.box.sqrDist(center)>=dist2)
+			continue;
+		
+		if(node.numTriangles>0)
+			{
+			/* Check all triangles in the leaf: */
+			for(unsigned int ti=node.first;ti<node.first+node.numTriangles;++ti)
+				{
+				const Point* t=&vertices[ti*3];
+				Point cp=calcClosestPointOnTriangle(center,t[0],t[1],t[2]);
+				Scalar d2=Geometry::sqrDist(center,cp);
+				if(d2<dist2)
+					{
+					dist2=d2;
+					closestPoint=cp;
+					triangleIndex=ti;
+					result=true;
+					}
+				}
+			}
+		else
+			{
+			/* Push the children such that the nearer one is processed first: */
+			Scalar d0=nodes[node.first].box.sqrDist(center);
+			Scalar d1=nodes[node.first+1].box.sqrDist(center);
+			if(d0<=d1)
+				{
+				stack.push_back(node.first+1);
+				stack.push_back(node.first);
+				}
+			else
+				{
+				stack.push_back(node.first);
+				stack.push_back(node.first+1);
+				}
+			}
+		}
+	
+	return result;
+	}
+
+}
@@ -0,0 +1,91 @@
+/***********************************************************************
+TriangleBVH - Class for bounding volume hierarchies over sets of
+triangles, built with the surface area heuristic, to accelerate ray
+casting and proximity queries against triangle meshes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef SCENEGRAPH_INTERNAL_TRIANGLEBVH_INCLUDED
+#define SCENEGRAPH_INTERNAL_TRIANGLEBVH_INCLUDED
+
+#include <vector>
+#include <Geometry/Point.h>
+#include <Geometry/Vector.h>
+#include <Geometry/Box.h>
+#include <Geometry/Ray.h>
+#include <SceneGraph/Geometry.h>
+
+namespace SceneGraph {
+
+class TriangleBVH
+	{
+	/* Embedded classes: */
+	private:
+	struct Node // Structure for BVH nodes
+		{
+		/* Elements: */
+		public:
+		Box box; // Bounding box of all triangles below the node
+		unsigned int first; // Index of the node's first triangle for leaf nodes, or index of the node's first child for interior nodes
+		unsigned int numTriangles; // Number of triangles in a leaf node, or 0 for interior nodes
+		};
+	
+	/* Elements: */
+	std::vector<Point> vertices; // Triangle soup, three vertices per triangle, sorted by leaf after build
+	std::vector<Node> nodes; // Array of BVH nodes; root node is at index 0, children of interior nodes are adjacent
+	
+	/* Constructors and destructors: */
+	public:
+	TriangleBVH(void) // Creates an empty BVH
+		{
+		}
+	
+	/* Methods: */
+	void clear(void); // Removes all triangles
+	void reserve(size_t numTriangles) // Prepares the BVH to receive the given number of triangles
+		{
+		vertices.reserve(numTriangles*3);
+		}
+	void addTriangle(const Point& p0,const Point& p1,const Point& p2) // Adds a triangle; BVH must be rebuilt afterwards
+		{
+		vertices.push_back(p0);
+		vertices.push_back(p1);
+		vertices.push_back(p2);
+		}
+	void build(void); // Builds the BVH over all added triangles; reorders triangles
+	size_t getNumTriangles(void) const // Returns the number of triangles
+		{
+		return vertices.size()/3;
+		}
+	const Point* getTriangle(unsigned int triangleIndex) const // Returns the three vertices of the given triangle, using post-build indices
+		{
+		return &vertices[triangleIndex*3];
+		}
+	Vector calcTriangleNormal(unsigned int triangleIndex) const // Returns the non-normalized normal vector of the given triangle
+		{
+		const Point* t=&vertices[triangleIndex*3];
+		return (t[1]-t[0])^(t[2]-t[0]);
+		}
+	bool intersectRay(const Ray& ray,Scalar& lambda,unsigned int& triangleIndex) const; // Intersects the given ray with all triangles in the ray parameter interval [0, lambda); updates lambda and the index of the hit triangle and returns true if a closer intersection was found
+	bool findClosestPoint(const Point& center,Scalar& dist2,Point& closestPoint,unsigned int& triangleIndex) const; // Finds the closest point to the given center on all triangles closer than sqrt(dist2); updates the squared distance, closest point, and index of the closest triangle and returns true if a closer point was found
+	};
+
+}
+
+#endif
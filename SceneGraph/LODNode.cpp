@@ -26,6 +26,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/EventTypes.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -38,6 +40,12 @@ LODNode::LODNode(void)
 	{
 	}
 
+LODNode::~LODNode(void)
+	{
+	/* Unregister this node from its levels: */
+	unlinkChildren(linkedLevels);
+	}
+
 const char* LODNode::getStaticClassName(void)
 	{
 	return "LOD";
@@ -90,6 +98,15 @@ void LODNode::parseField(const char* fieldName,VRMLFile& vrmlFile)
 		GraphNode::parseField(fieldName,vrmlFile);
 	}
 
+void LODNode::update(void)
+	{
+	/* Register this node as the parent of its current levels: */
+	linkChildren(linkedLevels,level.getValues());
+	
+	/* Invalidate the cached bounding boxes of all groups containing this node: */
+	invalidateBoundingBox();
+	}
+
 Box LODNode::calcBoundingBox(void) const
 	{
 	/* Calculate the group's bounding box as the union of the children's boxes: */
@@ -126,4 +143,18 @@ void LODNode::glRenderAction(GLRenderState& renderState) const
 	level.getValue(l)->glRenderAction(renderState);
 	}
 
+void LODNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Call the ray casting action of the most detailed level, which does not depend on the viewer's position: */
+	if(!level.getValues().empty())
+		level.getValue(0)->rayCastAction(rayCastState);
+	}
+
+void LODNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Call the sphere proximity action of the most detailed level, which does not depend on the viewer's position: */
+	if(!level.getValues().empty())
+		level.getValue(0)->sphereProximityAction(sphereProximityState);
+	}
+
 }
@@ -45,9 +45,14 @@ class LODNode:public GraphNode
 	SFPoint center;
 	MFFloat range;
 	
+	/* Derived state: */
+	private:
+	GraphNodeList linkedLevels; // List of levels that have this node registered as their parent
+	
 	/* Constructors and destructors: */
 	public:
 	LODNode(void); // Creates an empty LOD node
+	virtual ~LODNode(void); // Unregisters the node from its levels
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -55,10 +60,13 @@ class LODNode:public GraphNode
 	virtual EventOut* getEventOut(const char* fieldName) const;
 	virtual EventIn* getEventIn(const char* fieldName);
 	virtual void parseField(const char* fieldName,VRMLFile& vrmlFile);
+	virtual void update(void);
 	
 	/* Methods from GraphNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 typedef Misc::Autopointer<LODNode> LODNodePointer;
@@ -183,6 +183,9 @@ void LabelSetNode::update(void)
 		GLObject::init();
 		inited=true;
 		}
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box LabelSetNode::calcBoundingBox(void) const
@@ -27,6 +27,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/Internal/ReadPlyFile.h>
 #include <SceneGraph/Internal/ReadObjFile.h>
+#include <SceneGraph/Internal/MeshFileCache.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -83,6 +86,9 @@ void MeshFileNode::update(void)
 	/* Delete the current mesh file representation: */
 	shapes.clear();
 	
+	/* Invalidate the cached bounding boxes of all groups containing this node: */
+	invalidateBoundingBox();
+	
 	/* Do nothing if there is no mesh file name: */
 	if(url.getNumValues()==0)
 		return;
@@ -99,13 +105,21 @@ void MeshFileNode::update(void)
 	for(extIt=endIt;extIt>=url.getValue(0).begin()&&*extIt!='.';--extIt)
 		;
 	
+	/* Restore the mesh file's representation from a scene cache file if possible: */
+	if(readMeshFileCache(*baseDirectory,url.getValue(0),*this))
+		return;
+	
 	/* Read a mesh file: */
+	MeshFileMaterials materials;
 	if(extIt>url.getValue(0).begin()&&strncasecmp(&*extIt,".ply",endIt-extIt)==0)
 		readPlyFile(*baseDirectory,url.getValue(0),*this);
 	else if(extIt>url.getValue(0).begin()&&strncasecmp(&*extIt,".obj",endIt-extIt)==0)
-		readObjFile(*baseDirectory,url.getValue(0),*this);
+		readObjFile(*baseDirectory,url.getValue(0),*this,&materials);
 	else
 		Misc::throwStdErr("SceneGraph::MeshFileNode: Mesh file %s has unknown format",url.getValue(0).c_str());
+	
+	/* Store the mesh file's representation in a scene cache file: */
+	writeMeshFileCache(*baseDirectory,url.getValue(0),*this,shapes,materials);
 	}
 
 Box MeshFileNode::calcBoundingBox(void) const
@@ -132,4 +146,18 @@ void MeshFileNode::addShape(ShapeNodePointer newShape)
 	shapes.push_back(newShape);
 	}
 
+void MeshFileNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Call the ray casting actions of all represented shapes: */
+	for(std::vector<ShapeNodePointer>::const_iterator sIt=shapes.begin();sIt!=shapes.end();++sIt)
+		(*sIt)->rayCastAction(rayCastState);
+	}
+
+void MeshFileNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Call the sphere proximity actions of all represented shapes: */
+	for(std::vector<ShapeNodePointer>::const_iterator sIt=shapes.begin();sIt!=shapes.end();++sIt)
+		(*sIt)->sphereProximityAction(sphereProximityState);
+	}
+
 }
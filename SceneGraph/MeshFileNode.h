@@ -72,6 +72,8 @@ class MeshFileNode:public GraphNode
 	/* Methods from GraphNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	
 	/* New methods: */
 	void addShape(ShapeNodePointer newShape); // Adds a shape node to the representation
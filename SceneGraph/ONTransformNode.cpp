@@ -27,6 +27,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/EventTypes.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -66,7 +68,14 @@ void ONTransformNode::parseField(const char* fieldName,VRMLFile& vrmlFile)
 
 void ONTransformNode::update(void)
 	{
-	/* Do nothing */
+	/* Update the group state and invalidate the cached bounding boxes: */
+	GroupNode::update();
+	}
+
+bool ONTransformNode::isBoundingBoxCacheable(void) const
+	{
+	/* The transformation is commonly changed without calling update(), so only an explicit bounding box is cacheable: */
+	return haveExplicitBoundingBox;
 	}
 
 Box ONTransformNode::calcBoundingBox(void) const
@@ -101,4 +110,30 @@ void ONTransformNode::glRenderAction(GLRenderState& renderState) const
 	renderState.popTransform(previousTransform);
 	}
 
+void ONTransformNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Push the transformation onto the transformation stack: */
+	RayCastState::DOGTransform previousTransform=rayCastState.pushTransform(transform.getValue());
+	
+	/* Call the ray casting actions of all children in order: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		(*chIt)->rayCastAction(rayCastState);
+	
+	/* Pop the transformation off the transformation stack: */
+	rayCastState.popTransform(previousTransform);
+	}
+
+void ONTransformNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Push the transformation onto the transformation stack: */
+	SphereProximityState::DOGTransform previousTransform=sphereProximityState.pushTransform(transform.getValue());
+	
+	/* Call the sphere proximity actions of all children in order: */
+	for(MFGraphNode::ValueList::const_iterator chIt=children.getValues().begin();chIt!=children.getValues().end();++chIt)
+		(*chIt)->sphereProximityAction(sphereProximityState);
+	
+	/* Pop the transformation off the transformation stack: */
+	sphereProximityState.popTransform(previousTransform);
+	}
+
 }
@@ -59,8 +59,11 @@ class ONTransformNode:public GroupNode
 	virtual void update(void);
 	
 	/* Methods from GraphNode: */
+	virtual bool isBoundingBoxCacheable(void) const;
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 typedef Misc::Autopointer<ONTransformNode> ONTransformNodePointer;
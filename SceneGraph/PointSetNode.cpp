@@ -127,6 +127,9 @@ void PointSetNode::update(void)
 		sphereRenderer->setFixedRadius(pointSize.getValue());
 		sphereRenderer->setColorMaterial(color.getValue()!=0);
 		}
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box PointSetNode::calcBoundingBox(void) const
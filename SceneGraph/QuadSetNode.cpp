@@ -265,6 +265,9 @@ void QuadSetNode::update(void)
 	
 	/* Update the quad set version number: */
 	++version;
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box QuadSetNode::calcBoundingBox(void) const
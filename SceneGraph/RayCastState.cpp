@@ -0,0 +1,133 @@
+/***********************************************************************
+RayCastState - Class to encapsulate the traversal state of a scene graph
+during ray casting, and to collect the closest intersection of the ray
+with scene graph geometry.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <SceneGraph/RayCastState.h>
+
+#include <algorithm>
+
+namespace SceneGraph {
+
+/*****************************
+Methods of class RayCastState:
+*****************************/
+
+void RayCastState::updateCurrentRay(void)
+	{
+	/* Transform the base ray to current model coordinates without normalizing its direction, to keep ray parameters consistent: */
+	currentRay=Ray(Point(currentTransform.inverseTransform(baseRay.getOrigin())),Vector(currentTransform.inverseTransform(baseRay.getDirection())));
+	}
+
+RayCastState::RayCastState(const RayCastState::DRay& sRay,double sMaxLambda)
+	:baseRay(sRay),
+	 currentTransform(DOGTransform::identity),
+	 currentRay(sRay),
+	 lambda(sMaxLambda),
+	 hit(false),hitNormal(DVector::zero),
+	 currentShape(0),hitShape(0)
+	{
+	}
+
+RayCastState::DOGTransform RayCastState::pushTransform(const OGTransform& deltaTransform)
+	{
+	DOGTransform result=currentTransform;
+	currentTransform*=DOGTransform(deltaTransform);
+	currentTransform.renormalize();
+	updateCurrentRay();
+	return result;
+	}
+
+RayCastState::DOGTransform RayCastState::pushTransform(const RayCastState::DOGTransform& deltaTransform)
+	{
+	DOGTransform result=currentTransform;
+	currentTransform*=deltaTransform;
+	currentTransform.renormalize();
+	updateCurrentRay();
+	return result;
+	}
+
+RayCastState::DOGTransform RayCastState::pushTransform(const ONTransform& deltaTransform)
+	{
+	DOGTransform result=currentTransform;
+	currentTransform*=DOGTransform(deltaTransform);
+	currentTransform.renormalize();
+	updateCurrentRay();
+	return result;
+	}
+
+void RayCastState::popTransform(const RayCastState::DOGTransform& previousTransform)
+	{
+	currentTransform=previousTransform;
+	updateCurrentRay();
+	}
+
+bool RayCastState::doesRayIntersectBox(const Box& box) const
+	{
+	/* Boxes without points are never hit: */
+	if(box.isNull())
+		return false;
+	
+	/* Intersect the ray with the box's slabs over the parameter interval [0, lambda): */
+	double l0=0.0;
+	double l1=lambda;
+	const Point& origin=currentRay.getOrigin();
+	const Vector& direction=currentRay.getDirection();
+	for(int i=0;i<3;++i)
+		{
+		if(direction[i]!=Scalar(0))
+			{
+			double t0=double(box.min[i]-origin[i])/double(direction[i]);
+			double t1=double(box.max[i]-origin[i])/double(direction[i]);
+			if(t0>t1)
+				std::swap(t0,t1);
+			if(l0<t0)
+				l0=t0;
+			if(l1>t1)
+				l1=t1;
+			if(l0>l1)
+				return false;
+			}
+		else if(origin[i]<box.min[i]||origin[i]>box.max[i])
+			return false;
+		}
+	
+	return true;
+	}
+
+bool RayCastState::updateHit(double newLambda,const Vector& normal)
+	{
+	if(newLambda<0.0||newLambda>=lambda)
+		return false;
+	
+	/* Record the intersection: */
+	lambda=newLambda;
+	hit=true;
+	hitNormal=currentTransform.transform(DVector(normal));
+	double normalMag=Geometry::mag(hitNormal);
+	if(normalMag>0.0)
+		hitNormal/=normalMag;
+	hitShape=currentShape;
+	
+	return true;
+	}
+
+}
@@ -0,0 +1,125 @@
+/***********************************************************************
+RayCastState - Class to encapsulate the traversal state of a scene graph
+during ray casting, and to collect the closest intersection of the ray
+with scene graph geometry.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef SCENEGRAPH_RAYCASTSTATE_INCLUDED
+#define SCENEGRAPH_RAYCASTSTATE_INCLUDED
+
+#include <Math/Constants.h>
+#include <Geometry/Point.h>
+#include <Geometry/Vector.h>
+#include <Geometry/Box.h>
+#include <Geometry/Ray.h>
+#include <Geometry/OrthonormalTransformation.h>
+#include <Geometry/OrthogonalTransformation.h>
+#include <SceneGraph/Geometry.h>
+
+/* Forward declarations: */
+namespace SceneGraph {
+class ShapeNode;
+}
+
+namespace SceneGraph {
+
+class RayCastState
+	{
+	/* Embedded classes: */
+	public:
+	typedef Geometry::Point<double,3> DPoint; // Double-precision point in initial model coordinates
+	typedef Geometry::Vector<double,3> DVector; // Double-precision vector in initial model coordinates
+	typedef Geometry::Ray<double,3> DRay; // Double-precision ray in initial model coordinates
+	typedef Geometry::OrthogonalTransformation<double,3> DOGTransform; // Double-precision orthogonal transformations as internal representations
+	
+	/* Elements: */
+	private:
+	DRay baseRay; // The cast ray in initial model coordinates
+	DOGTransform currentTransform; // Transformation from current model coordinates to initial model coordinates
+	Ray currentRay; // The cast ray in current model coordinates; ray parameters are the same in all coordinate systems
+	double lambda; // Ray parameter of the closest intersection found so far, or the maximum ray parameter
+	bool hit; // Flag whether an intersection was found
+	DVector hitNormal; // Normalized surface normal at the closest intersection in initial model coordinates
+	const ShapeNode* currentShape; // The shape node currently being traversed
+	const ShapeNode* hitShape; // The shape node containing the closest intersection
+	
+	/* Private methods: */
+	void updateCurrentRay(void); // Recalculates the ray in current model coordinates
+	
+	/* Constructors and destructors: */
+	public:
+	RayCastState(const DRay& sRay,double sMaxLambda =Math::Constants<double>::max); // Creates a ray casting state for the given ray in initial model coordinates and maximum ray parameter
+	
+	/* Methods for scene graph traversal: */
+	const Ray& getRay(void) const // Returns the ray in current model coordinates
+		{
+		return currentRay;
+		}
+	double getLambda(void) const // Returns the ray parameter of the closest intersection found so far, or the maximum ray parameter
+		{
+		return lambda;
+		}
+	Scalar getScalarLambda(void) const // Ditto, clamped to the range of the scalar type used for geometry
+		{
+		return lambda<double(Math::Constants<Scalar>::max)?Scalar(lambda):Math::Constants<Scalar>::max;
+		}
+	const DOGTransform& getTransform(void) const // Returns the transformation from current to initial model coordinates
+		{
+		return currentTransform;
+		}
+	DOGTransform pushTransform(const OGTransform& deltaTransform); // Pushes the given transformation onto the transformation stack and returns the previous transformation
+	DOGTransform pushTransform(const DOGTransform& deltaTransform); // Ditto, with a double-precision transformation
+	DOGTransform pushTransform(const ONTransform& deltaTransform); // Ditto, with an orthonormal transformation
+	void popTransform(const DOGTransform& previousTransform); // Resets the transformation stack to the given transformation; must be result from previous pushTransform call
+	const ShapeNode* setCurrentShape(const ShapeNode* newCurrentShape) // Sets the shape node currently being traversed and returns the previous one
+		{
+		const ShapeNode* result=currentShape;
+		currentShape=newCurrentShape;
+		return result;
+		}
+	bool doesRayIntersectBox(const Box& box) const; // Returns true if the ray intersects the given box in current model coordinates before the closest intersection found so far
+	bool updateHit(double newLambda,const Vector& normal); // Records an intersection at the given ray parameter with the given surface normal in current model coordinates if it is closer than the closest intersection found so far; returns true if the intersection was recorded
+	
+	/* Methods to query results: */
+	bool hasHit(void) const // Returns true if the ray intersected any geometry
+		{
+		return hit;
+		}
+	double getHitLambda(void) const // Returns the ray parameter of the closest intersection
+		{
+		return lambda;
+		}
+	DPoint getHitPoint(void) const // Returns the closest intersection point in initial model coordinates
+		{
+		return baseRay(lambda);
+		}
+	const DVector& getHitNormal(void) const // Returns the normalized surface normal at the closest intersection in initial model coordinates
+		{
+		return hitNormal;
+		}
+	const ShapeNode* getHitShape(void) const // Returns the shape node containing the closest intersection, or null
+		{
+		return hitShape;
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,238 @@
+/***********************************************************************
+SceneCache - Class to manage versioned binary cache files holding
+pre-parsed representations of scene graph source files, keyed on the
+source files' path names, modification times, and sizes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <SceneGraph/SceneCache.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <Misc/ThrowStdErr.h>
+#include <Misc/StringPrintf.h>
+#include <IO/StandardFile.h>
+#include <IO/StandardDirectory.h>
+#include <SceneGraph/Geometry.h>
+
+namespace SceneGraph {
+
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+const char cacheFileMagic[8]={'S','G','C','a','c','h','e','\n'}; // Identifier at the beginning of each cache file
+const Misc::UInt32 cacheFileVersion=1U; // Version number of the cache file format
+const Misc::UInt32 endiannessMarker=0x01020304U; // Marker to detect cache files written on hosts of different endianness
+
+}
+
+/**************************************
+Methods of class SceneCache::SourceKey:
+**************************************/
+
+SceneCache::SourceKey::SourceKey(const IO::Directory& directory,const std::string& url)
+	:modTime(0),size(0)
+	{
+	/* Only files in the local file system can be cached: */
+	if(dynamic_cast<const IO::StandardDirectory*>(&directory)==0)
+		return;
+	
+	try
+		{
+		/* Get the source file's absolute path and query its status: */
+		std::string sourcePath=directory.getPath(url.c_str());
+		struct stat statBuffer;
+		if(stat(sourcePath.c_str(),&statBuffer)==0&&S_ISREG(statBuffer.st_mode))
+			{
+			path=sourcePath;
+			modTime=Misc::SInt64(statBuffer.st_mtime);
+			size=Misc::UInt64(statBuffer.st_size);
+			}
+		}
+	catch(const std::runtime_error&)
+		{
+		/* Leave the key invalid */
+		}
+	}
+
+/***********************************
+Methods of class SceneCache::Writer:
+***********************************/
+
+SceneCache::Writer::Writer(const SceneCache::SourceKey& key,SceneCache::ContentType contentType)
+	:cacheFileName(getCacheFileName(key,contentType))
+	{
+	/* Create a uniquely-named temporary file next to the cache file; process IDs alone are not unique when several cluster nodes share a cache directory: */
+	tempFileName=cacheFileName;
+	tempFileName.append(".XXXXXX");
+	int tempFd=mkstemp(&tempFileName[0]);
+	if(tempFd<0)
+		{
+		int error=errno;
+		Misc::throwStdErr("SceneGraph::SceneCache::Writer: Unable to create temporary file for cache file %s due to error %d (%s)",cacheFileName.c_str(),error,strerror(error));
+		}
+	
+	/* Make the cache file readable by everyone, like the cache directory: */
+	fchmod(tempFd,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	file=new IO::StandardFile(tempFd,IO::File::WriteOnly);
+	
+	/* Write the cache file header: */
+	file->writeRaw(cacheFileMagic,sizeof(cacheFileMagic));
+	write(cacheFileVersion);
+	write(endiannessMarker);
+	write(Misc::UInt32(sizeof(Scalar)));
+	write(Misc::UInt32(contentType));
+	
+	/* Write the source key: */
+	writeString(key.path);
+	write(key.modTime);
+	write(key.size);
+	}
+
+SceneCache::Writer::~Writer(void)
+	{
+	if(file!=0)
+		{
+		/* Close and remove the incomplete temporary file: */
+		file=0;
+		unlink(tempFileName.c_str());
+		}
+	}
+
+void SceneCache::Writer::commit(void)
+	{
+	/* Close the temporary file: */
+	file=0;
+	
+	/* Replace any existing cache file: */
+	if(rename(tempFileName.c_str(),cacheFileName.c_str())!=0)
+		{
+		int error=errno;
+		unlink(tempFileName.c_str());
+		Misc::throwStdErr("SceneGraph::SceneCache::Writer: Unable to create cache file %s due to error %d (%s)",cacheFileName.c_str(),error,strerror(error));
+		}
+	}
+
+/***********************************
+Methods of class SceneCache::Reader:
+***********************************/
+
+SceneCache::Reader::Reader(const std::string& cacheFileName)
+	:file(cacheFileName.c_str(),IO::File::ReadOnly),
+	 bufferEnd(static_cast<const char*>(file.getMemory())+file.getSize()),
+	 readPtr(static_cast<const char*>(file.getMemory()))
+	{
+	}
+
+SceneCache::Reader* SceneCache::Reader::open(const SceneCache::SourceKey& key,SceneCache::ContentType contentType)
+	{
+	/* Check if the cache file exists: */
+	std::string cacheFileName=getCacheFileName(key,contentType);
+	struct stat statBuffer;
+	if(stat(cacheFileName.c_str(),&statBuffer)!=0||!S_ISREG(statBuffer.st_mode)||statBuffer.st_size==0)
+		return 0;
+	
+	Reader* result=0;
+	try
+		{
+		/* Map the cache file: */
+		result=new Reader(cacheFileName);
+		
+		/* Check the cache file header: */
+		char magic[sizeof(cacheFileMagic)];
+		result->read(magic,sizeof(magic));
+		bool valid=memcmp(magic,cacheFileMagic,sizeof(cacheFileMagic))==0;
+		valid=valid&&result->read<Misc::UInt32>()==cacheFileVersion;
+		valid=valid&&result->read<Misc::UInt32>()==endiannessMarker;
+		valid=valid&&result->read<Misc::UInt32>()==Misc::UInt32(sizeof(Scalar));
+		valid=valid&&result->read<Misc::UInt32>()==Misc::UInt32(contentType);
+		
+		/* Check the source key: */
+		valid=valid&&result->readString()==key.path;
+		valid=valid&&result->read<Misc::SInt64>()==key.modTime;
+		valid=valid&&result->read<Misc::UInt64>()==key.size;
+		
+		if(!valid)
+			{
+			delete result;
+			result=0;
+			}
+		}
+	catch(const std::runtime_error&)
+		{
+		/* Ignore unreadable or truncated cache files: */
+		delete result;
+		result=0;
+		}
+	
+	return result;
+	}
+
+/***********************************
+Static elements of class SceneCache:
+***********************************/
+
+std::string SceneCache::cacheDirectory;
+
+/***************************
+Methods of class SceneCache:
+***************************/
+
+std::string SceneCache::getCacheFileName(const SceneCache::SourceKey& key,SceneCache::ContentType contentType)
+	{
+	/* Hash the source file's path name using 64-bit FNV-1a; collisions are detected by the source key stored in the cache file: */
+	Misc::UInt64 hash=0xcbf29ce484222325ULL;
+	for(std::string::const_iterator pIt=key.path.begin();pIt!=key.path.end();++pIt)
+		{
+		hash^=Misc::UInt64((unsigned char)(*pIt));
+		hash*=0x100000001b3ULL;
+		}
+	
+	return Misc::stringPrintf("%s/%016llx.%s.cache",cacheDirectory.c_str(),(unsigned long long)hash,contentType==VRML?"wrl":"mesh");
+	}
+
+void SceneCache::setCacheDirectory(const std::string& newCacheDirectory)
+	{
+	if(!newCacheDirectory.empty())
+		{
+		/* Create the cache directory and all its parents if they do not exist: */
+		for(std::string::size_type slashPos=newCacheDirectory.find('/',1);true;slashPos=newCacheDirectory.find('/',slashPos+1))
+			{
+			std::string prefix(newCacheDirectory,0,slashPos);
+			if(mkdir(prefix.c_str(),0755)!=0&&errno!=EEXIST)
+				{
+				int error=errno;
+				Misc::throwStdErr("SceneGraph::SceneCache::setCacheDirectory: Unable to create cache directory %s due to error %d (%s)",prefix.c_str(),error,strerror(error));
+				}
+			if(slashPos==std::string::npos)
+				break;
+			}
+		}
+	
+	cacheDirectory=newCacheDirectory;
+	}
+
+}
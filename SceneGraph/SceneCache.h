@@ -0,0 +1,208 @@
+/***********************************************************************
+SceneCache - Class to manage versioned binary cache files holding
+pre-parsed representations of scene graph source files, keyed on the
+source files' path names, modification times, and sizes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef SCENEGRAPH_SCENECACHE_INCLUDED
+#define SCENEGRAPH_SCENECACHE_INCLUDED
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <Misc/SizedTypes.h>
+#include <IO/File.h>
+#include <IO/MemMappedFile.h>
+
+/* Forward declarations: */
+namespace IO {
+class Directory;
+}
+
+namespace SceneGraph {
+
+class SceneCache
+	{
+	/* Embedded classes: */
+	public:
+	enum ContentType // Enumerated type for types of cached content
+		{
+		VRML=0, // Token and field value stream of a VRML 2.0 file
+		MeshFile // Geometry arrays read from a PLY or OBJ mesh file
+		};
+	
+	class FormatError:public std::runtime_error // Exception class to signal malformed or mismatching cache files
+		{
+		/* Constructors and destructors: */
+		public:
+		FormatError(const char* error)
+			:std::runtime_error(error)
+			{
+			}
+		};
+	
+	struct SourceKey // Structure identifying a version of a source file
+		{
+		/* Elements: */
+		public:
+		std::string path; // Normalized absolute path name of the source file; empty if the source is not a local file
+		Misc::SInt64 modTime; // Source file's modification time in seconds since the epoch
+		Misc::UInt64 size; // Source file's size in bytes
+		
+		/* Constructors and destructors: */
+		SourceKey(const IO::Directory& directory,const std::string& url); // Creates a key for the source file of the given URL relative to the given directory
+		
+		/* Methods: */
+		bool isValid(void) const // Returns true if the source file can be cached
+			{
+			return !path.empty();
+			}
+		};
+	
+	class Writer // Class to write a cache file
+		{
+		/* Elements: */
+		private:
+		std::string cacheFileName; // Final name of the cache file
+		std::string tempFileName; // Name of the temporary file being written
+		IO::FilePtr file; // The temporary file
+		
+		/* Constructors and destructors: */
+		public:
+		Writer(const SourceKey& key,ContentType contentType); // Starts writing a cache file for the given source and content type; throws exception if the cache file can not be created
+		~Writer(void); // Removes the temporary file if the cache file was not committed
+		
+		/* Methods: */
+		template <class DataParam>
+		void write(const DataParam& data) // Writes a single value of a trivially copyable type in native byte order
+			{
+			file->writeRaw(&data,sizeof(DataParam));
+			}
+		template <class DataParam>
+		void write(const DataParam* data,size_t numItems) // Writes an array of values of a trivially copyable type in native byte order
+			{
+			file->writeRaw(data,numItems*sizeof(DataParam));
+			}
+		void writeString(const std::string& string) // Writes a string
+			{
+			write(Misc::UInt32(string.size()));
+			file->writeRaw(string.data(),string.size());
+			}
+		template <class DataParam>
+		void writeArray(const std::vector<DataParam>& array) // Writes a size-prefixed array of values of a trivially copyable type
+			{
+			write(Misc::UInt64(array.size()));
+			if(!array.empty())
+				write(&array[0],array.size());
+			}
+		void commit(void); // Finishes writing the cache file and atomically replaces any previous cache file for the same source
+		};
+	
+	class Reader // Class to read a memory-mapped cache file
+		{
+		/* Elements: */
+		private:
+		IO::MemMappedFile file; // The memory-mapped cache file
+		const char* bufferEnd; // Pointer to the end of the cache file's contents
+		const char* readPtr; // Current read position
+		
+		/* Private methods: */
+		void check(size_t numBytes) const // Throws an exception if the given number of bytes can not be read
+			{
+			if(size_t(bufferEnd-readPtr)<numBytes)
+				throw FormatError("SceneGraph::SceneCache::Reader: Truncated cache file");
+			}
+		
+		/* Constructors and destructors: */
+		Reader(const std::string& cacheFileName); // Maps the cache file of the given name
+		
+		public:
+		static Reader* open(const SourceKey& key,ContentType contentType); // Returns a reader for an up-to-date cache file for the given source and content type, or null if there is none
+		
+		/* Methods: */
+		bool eof(void) const // Returns true if the entire cache file has been read
+			{
+			return readPtr==bufferEnd;
+			}
+		template <class DataParam>
+		DataParam read(void) // Reads a single value of a trivially copyable type
+			{
+			check(sizeof(DataParam));
+			DataParam result;
+			memcpy(&result,readPtr,sizeof(DataParam));
+			readPtr+=sizeof(DataParam);
+			return result;
+			}
+		template <class DataParam>
+		void read(DataParam* data,size_t numItems) // Reads an array of values of a trivially copyable type
+			{
+			check(numItems*sizeof(DataParam));
+			memcpy(data,readPtr,numItems*sizeof(DataParam));
+			readPtr+=numItems*sizeof(DataParam);
+			}
+		const char* readString(size_t& stringSize) // Returns a pointer to a string of the returned size inside the cache file; string is not NUL-terminated
+			{
+			stringSize=read<Misc::UInt32>();
+			check(stringSize);
+			const char* result=readPtr;
+			readPtr+=stringSize;
+			return result;
+			}
+		std::string readString(void) // Reads a string
+			{
+			size_t stringSize;
+			const char* string=readString(stringSize);
+			return std::string(string,string+stringSize);
+			}
+		template <class DataParam>
+		void readArray(std::vector<DataParam>& array) // Reads a size-prefixed array of values of a trivially copyable type into the given vector
+			{
+			Misc::UInt64 numItems=read<Misc::UInt64>();
+			check(numItems*sizeof(DataParam));
+			array.resize(numItems);
+			if(numItems>0)
+				read(&array[0],numItems);
+			}
+		};
+	
+	/* Elements: */
+	private:
+	static std::string cacheDirectory; // Directory in which to store cache files; caching is disabled if empty
+	
+	/* Private methods: */
+	static std::string getCacheFileName(const SourceKey& key,ContentType contentType); // Returns the name of the cache file for the given source and content type
+	
+	/* Methods: */
+	public:
+	static bool isEnabled(void) // Returns true if scene caching is enabled
+		{
+		return !cacheDirectory.empty();
+		}
+	static const std::string& getCacheDirectory(void) // Returns the current cache directory
+		{
+		return cacheDirectory;
+		}
+	static void setCacheDirectory(const std::string& newCacheDirectory); // Sets the directory in which to store cache files, which will be created if it does not exist; empty name disables caching
+	};
+
+}
+
+#endif
@@ -25,6 +25,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <string.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -36,6 +38,13 @@ ShapeNode::ShapeNode(void)
 	{
 	}
 
+ShapeNode::~ShapeNode(void)
+	{
+	/* Unregister this node from its geometry node: */
+	if(linkedGeometry!=0)
+		linkedGeometry->removeShape(*this);
+	}
+
 const char* ShapeNode::getStaticClassName(void)
 	{
 	return "Shape";
@@ -73,6 +82,19 @@ void ShapeNode::update(void)
 		if(appearance.getValue()->requiresNormals())
 			geometry.getValue()->mustProvideNormals();
 		}
+	
+	/* Register this node with its current geometry node so that geometry changes invalidate cached bounding boxes: */
+	if(linkedGeometry!=geometry.getValue())
+		{
+		if(linkedGeometry!=0)
+			linkedGeometry->removeShape(*this);
+		linkedGeometry=geometry.getValue();
+		if(linkedGeometry!=0)
+			linkedGeometry->addShape(*this);
+		}
+	
+	/* Invalidate the cached bounding boxes of all groups containing this shape: */
+	invalidateBoundingBox();
 	}
 
 Box ShapeNode::calcBoundingBox(void) const
@@ -106,4 +128,26 @@ void ShapeNode::glRenderAction(GLRenderState& renderState) const
 		appearance.getValue()->resetGLState(renderState);
 	}
 
+void ShapeNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Call the ray casting action of the geometry node, with this node as the current shape: */
+	if(geometry.getValue()!=0)
+		{
+		const ShapeNode* previousShape=rayCastState.setCurrentShape(this);
+		geometry.getValue()->rayCastAction(rayCastState);
+		rayCastState.setCurrentShape(previousShape);
+		}
+	}
+
+void ShapeNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Call the sphere proximity action of the geometry node, with this node as the current shape: */
+	if(geometry.getValue()!=0)
+		{
+		const ShapeNode* previousShape=sphereProximityState.setCurrentShape(this);
+		geometry.getValue()->sphereProximityAction(sphereProximityState);
+		sphereProximityState.setCurrentShape(previousShape);
+		}
+	}
+
 }
@@ -44,9 +44,14 @@ class ShapeNode:public GraphNode
 	SFBaseAppearanceNode appearance; // The shape's appearance
 	SFGeometryNode geometry; // The shape's geometry
 	
+	/* Derived state: */
+	private:
+	GeometryNodePointer linkedGeometry; // Geometry node that has this node registered as a shape using it
+	
 	/* Constructors and destructors: */
 	public:
 	ShapeNode(void); // Creates a shape node with default appearance and no geometry
+	virtual ~ShapeNode(void); // Unregisters the node from its geometry node
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -57,6 +62,8 @@ class ShapeNode:public GraphNode
 	/* Methods from GraphNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 typedef Misc::Autopointer<ShapeNode> ShapeNodePointer;
@@ -28,6 +28,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/EventTypes.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -305,6 +307,9 @@ void SphereNode::update(void)
 	{
 	/* Invalidate the display list: */
 	DisplayList::update();
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box SphereNode::calcBoundingBox(void) const
@@ -330,4 +335,40 @@ void SphereNode::glRenderAction(GLRenderState& renderState) const
 	DisplayList::glRenderAction(renderState.contextData);
 	}
 
+void SphereNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Intersect the ray with the sphere: */
+	const Ray& ray=rayCastState.getRay();
+	Vector oc=ray.getOrigin()-center.getValue();
+	const Vector& direction=ray.getDirection();
+	Scalar a=direction.sqr();
+	Scalar bh=direction*oc;
+	Scalar c=oc.sqr()-Math::sqr(radius.getValue());
+	Scalar det=bh*bh-a*c;
+	if(a==Scalar(0)||det<Scalar(0))
+		return;
+	
+	/* Use the entry point if the ray starts outside the sphere, and the exit point otherwise: */
+	det=Math::sqrt(det);
+	Scalar lambda=(-bh-det)/a;
+	if(lambda<Scalar(0))
+		lambda=(-bh+det)/a;
+	if(lambda>=Scalar(0))
+		rayCastState.updateHit(lambda,ray(lambda)-center.getValue());
+	}
+
+void SphereNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Project the query center onto the sphere: */
+	const Point& query=sphereProximityState.getCenter();
+	Vector d=query-center.getValue();
+	Scalar dist=Geometry::mag(d);
+	Point closest=center.getValue();
+	if(dist>Scalar(0))
+		closest+=d*(radius.getValue()/dist);
+	else
+		closest[0]+=radius.getValue();
+	sphereProximityState.updateClosestPoint(closest,Math::sqr(dist-radius.getValue()));
+	}
+
 }
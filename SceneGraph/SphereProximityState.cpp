@@ -0,0 +1,99 @@
+/***********************************************************************
+SphereProximityState - Class to encapsulate the traversal state of a
+scene graph during proximity queries, and to collect the point on scene
+graph geometry closest to the center of a query sphere.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#include <SceneGraph/SphereProximityState.h>
+
+#include <Math/Math.h>
+
+namespace SceneGraph {
+
+/*************************************
+Methods of class SphereProximityState:
+*************************************/
+
+void SphereProximityState::updateCurrentQuery(void)
+	{
+	/* Transform the query center and the current search radius to current model coordinates: */
+	currentCenter=Point(currentTransform.inverseTransform(baseCenter));
+	currentMaxDist2=Scalar(Math::sqr(distance/currentTransform.getScaling()));
+	}
+
+SphereProximityState::SphereProximityState(const SphereProximityState::DPoint& sCenter,double sRadius)
+	:baseCenter(sCenter),
+	 currentTransform(DOGTransform::identity),
+	 currentCenter(sCenter),
+	 distance(sRadius),currentMaxDist2(Scalar(Math::sqr(sRadius))),
+	 found(false),closestPoint(sCenter),
+	 currentShape(0),closestShape(0)
+	{
+	}
+
+SphereProximityState::DOGTransform SphereProximityState::pushTransform(const OGTransform& deltaTransform)
+	{
+	DOGTransform result=currentTransform;
+	currentTransform*=DOGTransform(deltaTransform);
+	currentTransform.renormalize();
+	updateCurrentQuery();
+	return result;
+	}
+
+SphereProximityState::DOGTransform SphereProximityState::pushTransform(const SphereProximityState::DOGTransform& deltaTransform)
+	{
+	DOGTransform result=currentTransform;
+	currentTransform*=deltaTransform;
+	currentTransform.renormalize();
+	updateCurrentQuery();
+	return result;
+	}
+
+SphereProximityState::DOGTransform SphereProximityState::pushTransform(const ONTransform& deltaTransform)
+	{
+	DOGTransform result=currentTransform;
+	currentTransform*=DOGTransform(deltaTransform);
+	currentTransform.renormalize();
+	updateCurrentQuery();
+	return result;
+	}
+
+void SphereProximityState::popTransform(const SphereProximityState::DOGTransform& previousTransform)
+	{
+	currentTransform=previousTransform;
+	updateCurrentQuery();
+	}
+
+bool SphereProximityState::updateClosestPoint(const Point& point,Scalar dist2)
+	{
+	if(dist2>=currentMaxDist2)
+		return false;
+	
+	/* Record the point: */
+	found=true;
+	closestPoint=currentTransform.transform(DPoint(point));
+	distance=Math::sqrt(double(dist2))*currentTransform.getScaling();
+	currentMaxDist2=dist2;
+	closestShape=currentShape;
+	
+	return true;
+	}
+
+}
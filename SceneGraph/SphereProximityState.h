@@ -0,0 +1,117 @@
+/***********************************************************************
+SphereProximityState - Class to encapsulate the traversal state of a
+scene graph during proximity queries, and to collect the point on scene
+graph geometry closest to the center of a query sphere.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Simple Scene Graph Renderer (SceneGraph).
+
+The Simple Scene Graph Renderer is free software; you can redistribute
+it and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+The Simple Scene Graph Renderer is distributed in the hope that it will
+be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Simple Scene Graph Renderer; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+***********************************************************************/
+
+#ifndef SCENEGRAPH_SPHEREPROXIMITYSTATE_INCLUDED
+#define SCENEGRAPH_SPHEREPROXIMITYSTATE_INCLUDED
+
+#include <Geometry/Point.h>
+#include <Geometry/Vector.h>
+#include <Geometry/Box.h>
+#include <Geometry/OrthonormalTransformation.h>
+#include <Geometry/OrthogonalTransformation.h>
+#include <SceneGraph/Geometry.h>
+
+/* Forward declarations: */
+namespace SceneGraph {
+class ShapeNode;
+}
+
+namespace SceneGraph {
+
+class SphereProximityState
+	{
+	/* Embedded classes: */
+	public:
+	typedef Geometry::Point<double,3> DPoint; // Double-precision point in initial model coordinates
+	typedef Geometry::OrthogonalTransformation<double,3> DOGTransform; // Double-precision orthogonal transformations as internal representations
+	
+	/* Elements: */
+	private:
+	DPoint baseCenter; // Center of the query sphere in initial model coordinates
+	DOGTransform currentTransform; // Transformation from current model coordinates to initial model coordinates
+	Point currentCenter; // Center of the query sphere in current model coordinates
+	double distance; // Distance to the closest point found so far, or the query sphere's radius, in initial model coordinates
+	Scalar currentMaxDist2; // Squared distance to the closest point found so far in current model coordinates
+	bool found; // Flag whether a point inside the query sphere was found
+	DPoint closestPoint; // Closest point found so far in initial model coordinates
+	const ShapeNode* currentShape; // The shape node currently being traversed
+	const ShapeNode* closestShape; // The shape node containing the closest point
+	
+	/* Private methods: */
+	void updateCurrentQuery(void); // Recalculates the query sphere in current model coordinates
+	
+	/* Constructors and destructors: */
+	public:
+	SphereProximityState(const DPoint& sCenter,double sRadius); // Creates a proximity query state for the given sphere in initial model coordinates
+	
+	/* Methods for scene graph traversal: */
+	const Point& getCenter(void) const // Returns the query sphere's center in current model coordinates
+		{
+		return currentCenter;
+		}
+	Scalar getMaxDist2(void) const // Returns the squared distance to the closest point found so far, or the squared query radius, in current model coordinates
+		{
+		return currentMaxDist2;
+		}
+	const DOGTransform& getTransform(void) const // Returns the transformation from current to initial model coordinates
+		{
+		return currentTransform;
+		}
+	DOGTransform pushTransform(const OGTransform& deltaTransform); // Pushes the given transformation onto the transformation stack and returns the previous transformation
+	DOGTransform pushTransform(const DOGTransform& deltaTransform); // Ditto, with a double-precision transformation
+	DOGTransform pushTransform(const ONTransform& deltaTransform); // Ditto, with an orthonormal transformation
+	void popTransform(const DOGTransform& previousTransform); // Resets the transformation stack to the given transformation; must be result from previous pushTransform call
+	const ShapeNode* setCurrentShape(const ShapeNode* newCurrentShape) // Sets the shape node currently being traversed and returns the previous one
+		{
+		const ShapeNode* result=currentShape;
+		currentShape=newCurrentShape;
+		return result;
+		}
+	bool doesSphereIntersectBox(const Box& box) const // Returns true if the given box in current model coordinates is closer to the query sphere's center than the closest point found so far
+		{
+		return !box.isNull()&&box.sqrDist(currentCenter)<currentMaxDist2;
+		}
+	bool updateClosestPoint(const Point& point,Scalar dist2); // Records the given point in current model coordinates at the given squared distance from the query center if it is closer than the closest point found so far; returns true if the point was recorded
+	
+	/* Methods to query results: */
+	bool hasFound(void) const // Returns true if any geometry intersected the query sphere
+		{
+		return found;
+		}
+	double getDistance(void) const // Returns the distance from the query center to the closest point
+		{
+		return distance;
+		}
+	const DPoint& getClosestPoint(void) const // Returns the closest point in initial model coordinates
+		{
+		return closestPoint;
+		}
+	const ShapeNode* getClosestShape(void) const // Returns the shape node containing the closest point, or null
+		{
+		return closestShape;
+		}
+	};
+
+}
+
+#endif
@@ -26,6 +26,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/EventTypes.h>
 #include <SceneGraph/VRMLFile.h>
 #include <SceneGraph/GLRenderState.h>
+#include <SceneGraph/RayCastState.h>
+#include <SceneGraph/SphereProximityState.h>
 
 namespace SceneGraph {
 
@@ -38,6 +40,12 @@ SwitchNode::SwitchNode(void)
 	{
 	}
 
+SwitchNode::~SwitchNode(void)
+	{
+	/* Unregister this node from its choices: */
+	unlinkChildren(linkedChoices);
+	}
+
 const char* SwitchNode::getStaticClassName(void)
 	{
 	return "Switch";
@@ -82,6 +90,15 @@ void SwitchNode::parseField(const char* fieldName,VRMLFile& vrmlFile)
 		GraphNode::parseField(fieldName,vrmlFile);
 	}
 
+void SwitchNode::update(void)
+	{
+	/* Register this node as the parent of its current choices: */
+	linkChildren(linkedChoices,choice.getValues());
+	
+	/* Invalidate the cached bounding boxes of all groups containing this node: */
+	invalidateBoundingBox();
+	}
+
 Box SwitchNode::calcBoundingBox(void) const
 	{
 	/* Calculate the group's bounding box as the union of the children's boxes: */
@@ -101,4 +118,24 @@ void SwitchNode::glRenderAction(GLRenderState& renderState) const
 	choice.getValue(whichChoice.getValue())->glRenderAction(renderState);
 	}
 
+void SwitchNode::rayCastAction(RayCastState& rayCastState) const
+	{
+	/* Bail out if the children list is empty or the choice index is out of range: */
+	if(choice.getValues().empty()||whichChoice.getValue()<0||whichChoice.getValue()>=int(choice.getNumValues()))
+		return;
+	
+	/* Call the ray casting action of the selected choice: */
+	choice.getValue(whichChoice.getValue())->rayCastAction(rayCastState);
+	}
+
+void SwitchNode::sphereProximityAction(SphereProximityState& sphereProximityState) const
+	{
+	/* Bail out if the children list is empty or the choice index is out of range: */
+	if(choice.getValues().empty()||whichChoice.getValue()<0||whichChoice.getValue()>=int(choice.getNumValues()))
+		return;
+	
+	/* Call the sphere proximity action of the selected choice: */
+	choice.getValue(whichChoice.getValue())->sphereProximityAction(sphereProximityState);
+	}
+
 }
@@ -44,9 +44,14 @@ class SwitchNode:public GraphNode
 	MFGraphNode choice;
 	SFInt whichChoice;
 	
+	/* Derived state: */
+	private:
+	GraphNodeList linkedChoices; // List of choices that have this node registered as their parent
+	
 	/* Constructors and destructors: */
 	public:
 	SwitchNode(void); // Creates an empty switch node
+	virtual ~SwitchNode(void); // Unregisters the node from its choices
 	
 	/* Methods from Node: */
 	static const char* getStaticClassName(void);
@@ -54,10 +59,13 @@ class SwitchNode:public GraphNode
 	virtual EventOut* getEventOut(const char* fieldName) const;
 	virtual EventIn* getEventIn(const char* fieldName);
 	virtual void parseField(const char* fieldName,VRMLFile& vrmlFile);
+	virtual void update(void);
 	
 	/* Methods from GraphNode: */
 	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	};
 
 typedef Misc::Autopointer<SwitchNode> SwitchNodePointer;
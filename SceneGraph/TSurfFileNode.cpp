@@ -103,6 +103,9 @@ void TSurfFileNode::update(void)
 	vertices.clear();
 	indices.clear();
 	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
+	
 	/* Do nothing if there is no export file name: */
 	if(url.getNumValues()==0)
 		return;
@@ -210,6 +210,9 @@ void TextNode::update(void)
 		GLObject::init();
 		inited=true;
 		}
+	
+	/* Invalidate the cached bounding boxes of all shapes using this geometry: */
+	invalidateBoundingBox();
 	}
 
 Box TextNode::calcBoundingBox(void) const
@@ -49,6 +49,9 @@ class TransformNode:public GroupNode
 	protected:
 	OGTransform transform; // The current transformation
 	
+	/* Protected methods from GroupNode: */
+	virtual Box calcUncachedBoundingBox(void) const;
+	
 	/* Constructors and destructors: */
 	public:
 	TransformNode(void); // Creates an empty transform node with an identity transformation
@@ -62,8 +65,9 @@ class TransformNode:public GroupNode
 	virtual void update(void);
 	
 	/* Methods from GraphNode: */
-	virtual Box calcBoundingBox(void) const;
 	virtual void glRenderAction(GLRenderState& renderState) const;
+	virtual void rayCastAction(RayCastState& rayCastState) const;
+	virtual void sphereProximityAction(SphereProximityState& sphereProximityState) const;
 	
 	/* New methods: */
 	const OGTransform& getTransform(void) const // Returns the current derived transformation
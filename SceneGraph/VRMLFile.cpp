@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/VRMLFile.h>
 
 #include <stdlib.h>
+#include <vector>
 #include <Misc/FileNameExtensions.h>
 #include <Misc/StringPrintf.h>
 #include <Misc/ThrowStdErr.h>
@@ -512,6 +513,179 @@ class FieldParser<MF<ValueParam> >
 		}
 	};
 
+/*****************************************************************
+Templatized helper class to write values to and read values from
+scene cache files:
+*****************************************************************/
+
+template <class ValueParam>
+class ValueCoder // Generic version for trivially copyable values
+	{
+	/* Methods: */
+	public:
+	static void write(const ValueParam& value,SceneCache::Writer& writer)
+		{
+		writer.write(value);
+		}
+	static ValueParam read(SceneCache::Reader& reader)
+		{
+		return reader.read<ValueParam>();
+		}
+	static void writeList(const std::vector<ValueParam>& values,SceneCache::Writer& writer)
+		{
+		writer.writeArray(values);
+		}
+	static void readList(std::vector<ValueParam>& values,SceneCache::Reader& reader)
+		{
+		reader.readArray(values);
+		}
+	};
+
+template <>
+class ValueCoder<bool>
+	{
+	/* Methods: */
+	public:
+	static void write(bool value,SceneCache::Writer& writer)
+		{
+		writer.write(Misc::UInt8(value?1:0));
+		}
+	static bool read(SceneCache::Reader& reader)
+		{
+		return reader.read<Misc::UInt8>()!=0;
+		}
+	static void writeList(const std::vector<bool>& values,SceneCache::Writer& writer)
+		{
+		writer.write(Misc::UInt64(values.size()));
+		for(std::vector<bool>::const_iterator vIt=values.begin();vIt!=values.end();++vIt)
+			write(*vIt,writer);
+		}
+	static void readList(std::vector<bool>& values,SceneCache::Reader& reader)
+		{
+		Misc::UInt64 numValues=reader.read<Misc::UInt64>();
+		values.clear();
+		for(Misc::UInt64 i=0;i<numValues;++i)
+			values.push_back(read(reader));
+		}
+	};
+
+template <>
+class ValueCoder<std::string>
+	{
+	/* Methods: */
+	public:
+	static void write(const std::string& value,SceneCache::Writer& writer)
+		{
+		writer.writeString(value);
+		}
+	static std::string read(SceneCache::Reader& reader)
+		{
+		return reader.readString();
+		}
+	static void writeList(const std::vector<std::string>& values,SceneCache::Writer& writer)
+		{
+		writer.write(Misc::UInt64(values.size()));
+		for(std::vector<std::string>::const_iterator vIt=values.begin();vIt!=values.end();++vIt)
+			writer.writeString(*vIt);
+		}
+	static void readList(std::vector<std::string>& values,SceneCache::Reader& reader)
+		{
+		Misc::UInt64 numValues=reader.read<Misc::UInt64>();
+		values.clear();
+		for(Misc::UInt64 i=0;i<numValues;++i)
+			values.push_back(reader.readString());
+		}
+	};
+
+/***********************************************************
+Templatized helper class to cache fields in scene cache files:
+***********************************************************/
+
+template <class FieldParam>
+class FieldCoder
+	{
+	};
+
+template <class ValueParam>
+class FieldCoder<SF<ValueParam> >
+	{
+	/* Elements: */
+	public:
+	static const bool cached=true; // Flag whether fields of this type are cached as binary values
+	
+	/* Methods: */
+	static void write(const SF<ValueParam>& field,SceneCache::Writer& writer)
+		{
+		writer.write(Misc::UInt8('S'));
+		writer.write(Misc::UInt32(sizeof(ValueParam)));
+		ValueCoder<ValueParam>::write(field.getValue(),writer);
+		}
+	static void read(SF<ValueParam>& field,SceneCache::Reader& reader)
+		{
+		if(reader.read<Misc::UInt8>()!=Misc::UInt8('S')||reader.read<Misc::UInt32>()!=Misc::UInt32(sizeof(ValueParam)))
+			throw SceneCache::FormatError("SceneGraph::VRMLFile: Mismatching field type in cache file");
+		field.setValue(ValueCoder<ValueParam>::read(reader));
+		}
+	};
+
+template <class ValueParam>
+class FieldCoder<MF<ValueParam> >
+	{
+	/* Elements: */
+	public:
+	static const bool cached=true; // Flag whether fields of this type are cached as binary values
+	
+	/* Methods: */
+	static void write(const MF<ValueParam>& field,SceneCache::Writer& writer)
+		{
+		writer.write(Misc::UInt8('M'));
+		writer.write(Misc::UInt32(sizeof(ValueParam)));
+		ValueCoder<ValueParam>::writeList(field.getValues(),writer);
+		}
+	static void read(MF<ValueParam>& field,SceneCache::Reader& reader)
+		{
+		if(reader.read<Misc::UInt8>()!=Misc::UInt8('M')||reader.read<Misc::UInt32>()!=Misc::UInt32(sizeof(ValueParam)))
+			throw SceneCache::FormatError("SceneGraph::VRMLFile: Mismatching field type in cache file");
+		ValueCoder<ValueParam>::readList(field.getValues(),reader);
+		}
+	};
+
+/**************************************************************
+Specializations for node fields, whose tokens are cached instead:
+**************************************************************/
+
+template <>
+class FieldCoder<SFNode>
+	{
+	/* Elements: */
+	public:
+	static const bool cached=false; // Flag whether fields of this type are cached as binary values
+	
+	/* Methods: */
+	static void write(const SFNode& field,SceneCache::Writer& writer)
+		{
+		}
+	static void read(SFNode& field,SceneCache::Reader& reader)
+		{
+		}
+	};
+
+template <>
+class FieldCoder<MFNode>
+	{
+	/* Elements: */
+	public:
+	static const bool cached=false; // Flag whether fields of this type are cached as binary values
+	
+	/* Methods: */
+	static void write(const MFNode& field,SceneCache::Writer& writer)
+		{
+		}
+	static void read(MFNode& field,SceneCache::Reader& reader)
+		{
+		}
+	};
+
 }
 
 /*************************************
@@ -551,13 +725,96 @@ void VRMLFile::init(void)
 	/* Skip the rest of the header line, which is a comment after all: */
 	skipLine();
 	skipWs();
+	
+	/* Check if the VRML file can be replayed from or recorded into a scene cache file: */
+	if(SceneCache::isEnabled())
+		{
+		SceneCache::SourceKey key(*baseDirectory,sourceUrl);
+		if(key.isValid())
+			{
+			cacheReader=SceneCache::Reader::open(key,SceneCache::VRML);
+			if(cacheReader!=0)
+				{
+				/* Read the first record header: */
+				try
+					{
+					readReplayHeader();
+					}
+				catch(const std::runtime_error&)
+					{
+					/* Ignore the malformed cache file: */
+					delete cacheReader;
+					cacheReader=0;
+					}
+				}
+			if(cacheReader==0)
+				{
+				try
+					{
+					cacheWriter=new SceneCache::Writer(key,SceneCache::VRML);
+					}
+				catch(const std::runtime_error&)
+					{
+					/* Parse the VRML file without recording it */
+					}
+				}
+			}
+		}
+	}
+
+void VRMLFile::readReplayHeader(void)
+	{
+	replayTag=cacheReader->read<Misc::UInt8>();
+	replayPeek=cacheReader->read<Misc::SInt32>();
+	}
+
+void VRMLFile::recordHeader(int tag,int peek)
+	{
+	cacheWriter->write(Misc::UInt8(tag));
+	cacheWriter->write(Misc::SInt32(peek));
+	}
+
+void VRMLFile::discardCacheWriter(void)
+	{
+	/* Delete the cache writer, which removes the incomplete cache file: */
+	delete cacheWriter;
+	cacheWriter=0;
+	}
+
+const char* VRMLFile::replayNextToken(void)
+	{
+	/* Check that the next record is a token: */
+	if(replayTag!='T')
+		throw SceneCache::FormatError("SceneGraph::VRMLFile: Mismatching token in cache file");
+	
+	/* Read the token and the next record header: */
+	size_t tokenSize;
+	const char* token=cacheReader->readString(tokenSize);
+	replayToken.assign(token,token+tokenSize);
+	readReplayHeader();
+	
+	return replayToken.c_str();
+	}
+
+void VRMLFile::recordToken(int peek)
+	{
+	try
+		{
+		recordHeader('T',peek);
+		cacheWriter->writeString(std::string(IO::TokenSource::getToken(),IO::TokenSource::getTokenSize()));
+		}
+	catch(const std::runtime_error&)
+		{
+		discardCacheWriter();
+		}
 	}
 
 VRMLFile::VRMLFile(IO::Directory& sBaseDirectory,const std::string& sSourceUrl,NodeCreator& sNodeCreator)
 	:IO::TokenSource(sBaseDirectory.openFile(sSourceUrl.c_str())),
 	 baseDirectory(sBaseDirectory.openFileDirectory(sSourceUrl.c_str())),sourceUrl(Misc::getFileName(sSourceUrl.c_str())),
 	 nodeCreator(sNodeCreator),nodeMap(17),
-	 currentLine(1)
+	 currentLine(1),
+	 cacheReader(0),cacheWriter(0),recordingSuppressed(0),replayTag(0),replayPeek(-1)
 	{
 	init();
 	}
@@ -566,13 +823,57 @@ VRMLFile::VRMLFile(const std::string& sSourceUrl,NodeCreator& sNodeCreator)
 	:IO::TokenSource(IO::openFile(sSourceUrl.c_str())),
 	 baseDirectory(IO::openFileDirectory(sSourceUrl.c_str())),sourceUrl(Misc::getFileName(sSourceUrl.c_str())),
 	 nodeCreator(sNodeCreator),nodeMap(17),
-	 currentLine(1)
+	 currentLine(1),
+	 cacheReader(0),cacheWriter(0),recordingSuppressed(0),replayTag(0),replayPeek(-1)
 	{
 	init();
 	}
 
+VRMLFile::~VRMLFile(void)
+	{
+	delete cacheReader;
+	delete cacheWriter;
+	}
+
 void VRMLFile::parse(GroupNodePointer root)
 	{
+	if(cacheReader!=0)
+		{
+		try
+			{
+			/* Replay nodes from the cache file into a temporary list until the end record: */
+			std::vector<GraphNodePointer> nodes;
+			while(!eof())
+				{
+				SF<GraphNodePointer> node;
+				parseSFNode(node);
+				if(node.getValue()!=0)
+					nodes.push_back(node.getValue());
+				}
+			
+			/* Add the replayed nodes to the root node: */
+			for(std::vector<GraphNodePointer>::iterator nIt=nodes.begin();nIt!=nodes.end();++nIt)
+				root->children.appendValue(*nIt);
+			
+			return;
+			}
+		catch(const SceneCache::FormatError&)
+			{
+			/* Discard the stale cache file and parse the VRML file, which has not been touched yet, from the beginning: */
+			delete cacheReader;
+			cacheReader=0;
+			nodeMap.clear();
+			try
+				{
+				cacheWriter=new SceneCache::Writer(SceneCache::SourceKey(*baseDirectory,sourceUrl),SceneCache::VRML);
+				}
+			catch(const std::runtime_error&)
+				{
+				/* Parse the VRML file without recording it */
+				}
+			}
+		}
+	
 	/* Read nodes until end of file: */
 	while(!eof())
 		{
@@ -581,6 +882,21 @@ void VRMLFile::parse(GroupNodePointer root)
 		if(node.getValue()!=0)
 			root->children.appendValue(node.getValue());
 		}
+	
+	if(cacheWriter!=0)
+		{
+		/* Finish the cache file: */
+		try
+			{
+			recordHeader('E',-1);
+			cacheWriter->commit();
+			}
+		catch(const std::runtime_error&)
+			{
+			/* Ignore the error; the VRML file will be parsed again next time */
+			}
+		discardCacheWriter();
+		}
 	}
 
 NodePointer VRMLFile::getNode(const std::string& nodeName)
@@ -607,6 +923,40 @@ void
 VRMLFile::parseField(
 	FieldParam& field)
 	{
+	if(FieldCoder<FieldParam>::cached)
+		{
+		if(cacheReader!=0)
+			{
+			/* Read the field's value from the cache file: */
+			if(replayTag!='F')
+				throw SceneCache::FormatError("SceneGraph::VRMLFile: Mismatching field in cache file");
+			FieldCoder<FieldParam>::read(field,*cacheReader);
+			readReplayHeader();
+			return;
+			}
+		
+		if(cacheWriter!=0&&recordingSuppressed==0)
+			{
+			/* Parse the field without recording its tokens: */
+			int peek=peekc();
+			++recordingSuppressed;
+			FieldParser<FieldParam>::parseField(field,*this);
+			--recordingSuppressed;
+			
+			/* Record the field's parsed value: */
+			try
+				{
+				recordHeader('F',peek);
+				FieldCoder<FieldParam>::write(field,*cacheWriter);
+				}
+			catch(const std::runtime_error&)
+				{
+				discardCacheWriter();
+				}
+			return;
+			}
+		}
+	
 	/* Call on the templatized field parser helper class: */
 	FieldParser<FieldParam>::parseField(field,*this);
 	}
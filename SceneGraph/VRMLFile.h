@@ -33,6 +33,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <SceneGraph/FieldTypes.h>
 #include <SceneGraph/Node.h>
 #include <SceneGraph/GroupNode.h>
+#include <SceneGraph/SceneCache.h>
 
 /* Forward declarations: */
 namespace SceneGraph {
@@ -64,6 +65,12 @@ class VRMLFile:public IO::TokenSource
 	NodeCreator& nodeCreator; // Reference to the node creator
 	NodeMap nodeMap; // Map of named nodes
 	size_t currentLine; // Number of currently processed line
+	SceneCache::Reader* cacheReader; // Cache file from which tokens and field values are replayed instead of parsing the VRML file, or null
+	SceneCache::Writer* cacheWriter; // Cache file into which tokens and field values are recorded while parsing the VRML file, or null
+	unsigned int recordingSuppressed; // Nesting level of field parsers whose tokens are recorded as binary field values instead
+	int replayTag; // Tag of the next record in the cache file
+	int replayPeek; // Character that peekc would return before the next record in the cache file
+	std::string replayToken; // Most recently replayed token
 	
 	/* Private methods: */
 	void skipExtendedWhitespace(void) // Skips over "extended" whitespace, i.e., line comments and newlines
@@ -94,28 +101,66 @@ class VRMLFile:public IO::TokenSource
 			}
 		}
 	void init(void); // Initializes a VRML file
+	void readReplayHeader(void); // Reads the header of the next record from the cache file
+	void recordHeader(int tag,int peek); // Writes a record header into the cache file
+	void discardCacheWriter(void); // Stops recording into the cache file after an error
+	const char* replayNextToken(void); // Replays the next token from the cache file
+	void recordToken(int peek); // Records the most recently read token into the cache file
 	
 	/* Constructors and destructors: */
 	public:
 	VRMLFile(IO::Directory& sBaseDirectory,const std::string& sSourceUrl,NodeCreator& sNodeCreator); // Creates a VRML parser for the given URL relative to the given base directory
 	VRMLFile(const std::string& sSourceUrl,NodeCreator& sNodeCreator); // Creates a VRML parser for the given URL relative to the current directory
+	~VRMLFile(void);
 	
 	/* Overloaded methods from IO::TokenSource: */
 	bool eof(void)
 		{
+		if(cacheReader!=0)
+			return replayTag=='E';
 		skipExtendedWhitespace();
 		return IO::TokenSource::eof();
 		}
 	int peekc(void)
 		{
+		if(cacheReader!=0)
+			return replayPeek;
 		skipExtendedWhitespace();
 		return IO::TokenSource::peekc();
 		}
 	const char* readNextToken(void) // Reads the next token while skipping line comments
 		{
+		if(cacheReader!=0)
+			return replayNextToken();
 		skipExtendedWhitespace();
+		if(cacheWriter!=0&&recordingSuppressed==0)
+			{
+			/* Read the next token and record it into the cache file: */
+			int peek=IO::TokenSource::peekc();
+			IO::TokenSource::readNextToken();
+			recordToken(peek);
+			return IO::TokenSource::getToken();
+			}
 		return IO::TokenSource::readNextToken();
 		}
+	size_t getTokenSize(void) const // Returns the length of the most recently read token
+		{
+		if(cacheReader!=0)
+			return replayToken.size();
+		return IO::TokenSource::getTokenSize();
+		}
+	const char* getToken(void) // Returns the most recently read token
+		{
+		if(cacheReader!=0)
+			return replayToken.c_str();
+		return IO::TokenSource::getToken();
+		}
+	bool isToken(const char* token) const // Returns true if the most recently read token matches the given string
+		{
+		if(cacheReader!=0)
+			return replayToken==token;
+		return IO::TokenSource::isToken(token);
+		}
 	
 	/* Main method: */
 	void parse(GroupNodePointer root); // Adds top-level nodes from the VRML file to the given group node
@@ -29,6 +29,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <unistd.h>
 #include <fcntl.h>
 #include <signal.h>
+#if THREADS_CONFIG_HAVE_EPOLL
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
+#include <algorithm>
 #include <stdexcept>
 #include <Misc/ThrowStdErr.h>
 #include <Misc/MessageLogger.h>
@@ -50,6 +57,14 @@ void stopSignalHandler(int signum)
 		stopDispatcher->stop();
 	}
 
+#if THREADS_CONFIG_HAVE_EPOLL
+
+const uint64_t doorbellEventKey=~uint64_t(0); // Epoll event key for the message queue's doorbell; cannot collide with 32-bit listener keys
+const uint64_t timerEventKey=~uint64_t(0)-1U; // Epoll event key for the timer file descriptor
+const int maxEpollEvents=64; // Maximum number of events returned by a single epoll_wait call
+
+#endif
+
 }
 
 /*****************************************
@@ -62,13 +77,20 @@ struct EventDispatcher::IOEventListener
 	public:
 	ListenerKey key; // Unique key identifying this event
 	int fd; // File descriptor belonging to the event
+	#if THREADS_CONFIG_HAVE_EPOLL
+	int pollFd; // File descriptor registered with the epoll instance; a duplicate of fd if another listener already watches the same descriptor
+	#endif
 	int typeMask; // Mask of event types (read, write, exception) in which the listener is interested
 	IOEventCallback callback; // Function called when an event occurs
 	void* callbackUserData; // Opaque pointer to be passed to callback function
 	
 	/* Constructors and destructors: */
 	IOEventListener(ListenerKey sKey,int sFd,int sTypeMask,IOEventCallback sCallback,void* sCallbackUserData)
-		:key(sKey),fd(sFd),typeMask(sTypeMask),callback(sCallback),callbackUserData(sCallbackUserData)
+		:key(sKey),fd(sFd),
+		 #if THREADS_CONFIG_HAVE_EPOLL
+		 pollFd(sFd),
+		 #endif
+		 typeMask(sTypeMask),callback(sCallback),callbackUserData(sCallbackUserData)
 		{
 		}
 	};
@@ -245,6 +267,114 @@ EventDispatcher::ListenerKey EventDispatcher::getNextKey(void)
 	return nextKey;
 	}
 
+#if THREADS_CONFIG_HAVE_EPOLL
+
+size_t EventDispatcher::readPipeMessages(void)
+	{
+	/* Reset the doorbell: */
+	uint64_t numRings;
+	if(read(eventFd,&numRings,sizeof(uint64_t))<0&&errno!=EAGAIN&&errno!=EWOULDBLOCK&&errno!=EINTR)
+		Misc::throwStdErr("Threads::EventDispatcher::readPipeMessages: Fatal error %d (%s) while reading doorbell",errno,strerror(errno));
+	
+	/* Lock the message queue: */
+	Threads::Spinlock::Lock pipeLock(pipeMutex);
+	
+	/* Swap the message queue and the message buffer to take ownership of all queued messages: */
+	std::swap(queuedMessages,messages);
+	std::swap(queueSize,numMessages);
+	size_t result=numQueuedMessages;
+	numQueuedMessages=0;
+	
+	return result;
+	}
+
+void EventDispatcher::writePipeMessage(const EventDispatcher::PipeMessage& pm,const char* methodName)
+	{
+	{
+	/* Lock the message queue: */
+	Threads::Spinlock::Lock pipeLock(pipeMutex);
+	
+	/* Grow the message queue if it is full: */
+	if(numQueuedMessages==queueSize)
+		{
+		size_t newQueueSize=queueSize*2;
+		PipeMessage* newQueuedMessages=new PipeMessage[newQueueSize];
+		memcpy(newQueuedMessages,queuedMessages,numQueuedMessages*sizeof(PipeMessage));
+		delete[] queuedMessages;
+		queueSize=newQueueSize;
+		queuedMessages=newQueuedMessages;
+		}
+	
+	/* Append the message to the queue: */
+	queuedMessages[numQueuedMessages]=pm;
+	++numQueuedMessages;
+	}
+	
+	/* Wake up the dispatching thread: */
+	ringDoorbell();
+	}
+
+void EventDispatcher::ringDoorbell(void)
+	{
+	/* Preserve errno in case this is called from a signal handler: */
+	int savedErrno=errno;
+	
+	/* Increment the event file descriptor's counter; EAGAIN means the counter is saturated, and the doorbell is already ringing: */
+	uint64_t ring=1;
+	while(write(eventFd,&ring,sizeof(uint64_t))<0&&errno==EINTR)
+		;
+	
+	errno=savedErrno;
+	}
+
+void EventDispatcher::updateEpollSet(EventDispatcher::IOEventListener& listener,int oldEventMask,int newEventMask)
+	{
+	if(newEventMask!=0x0)
+		{
+		/* Create an epoll event structure for the new event mask, using level-triggered semantics to match select(): */
+		struct epoll_event event;
+		memset(&event,0,sizeof(struct epoll_event));
+		if(newEventMask&Read)
+			event.events|=EPOLLIN;
+		if(newEventMask&Write)
+			event.events|=EPOLLOUT;
+		if(newEventMask&Exception)
+			event.events|=EPOLLPRI;
+		event.data.u64=listener.key;
+		
+		if(oldEventMask!=0x0)
+			{
+			/* Change the event mask of the already-registered file descriptor: */
+			if(epoll_ctl(epollFd,EPOLL_CTL_MOD,listener.pollFd,&event)<0)
+				Misc::formattedLogWarning("Threads::EventDispatcher: Error %d (%s) while changing event mask of file descriptor %d",errno,strerror(errno),listener.fd);
+			}
+		else
+			{
+			/* Register the listener's file descriptor with the epoll instance: */
+			listener.pollFd=listener.fd;
+			int result=epoll_ctl(epollFd,EPOLL_CTL_ADD,listener.pollFd,&event);
+			if(result<0&&errno==EEXIST)
+				{
+				/* Another listener is already watching the same file descriptor; register a duplicate instead: */
+				listener.pollFd=dup(listener.fd);
+				result=listener.pollFd>=0?epoll_ctl(epollFd,EPOLL_CTL_ADD,listener.pollFd,&event):-1;
+				}
+			if(result<0)
+				Misc::formattedLogWarning("Threads::EventDispatcher: Error %d (%s) while watching file descriptor %d",errno,strerror(errno),listener.fd);
+			}
+		}
+	else if(oldEventMask!=0x0)
+		{
+		/* Unregister the listener's file descriptor; ignore errors as the descriptor might already have been closed: */
+		epoll_ctl(epollFd,EPOLL_CTL_DEL,listener.pollFd,0);
+		if(listener.pollFd>=0&&listener.pollFd!=listener.fd)
+			close(listener.pollFd);
+		listener.pollFd=listener.fd;
+		}
+	}
+
+#else
+
 size_t EventDispatcher::readPipeMessages(void)
 	{
 	/* Check if there was a partial message during the previous call: */
@@ -375,6 +505,436 @@ void EventDispatcher::updateFdSets(int fd,int oldEventMask,int newEventMask)
 		}
 	}
 
+#endif
+
+void EventDispatcher::dispatchTimerEvents(void)
+	{
+	/* Handle elapsed timer events: */
+	while(!timerEventListeners.isEmpty())
+		{
+		/* Calculate the interval to the next timer event: */
+		TimerEventListener* tel=timerEventListeners.getSmallest();
+		Time interval=tel->time;
+		interval-=dispatchTime;
+		
+		/* Bail out if the event is still in the future: */
+		if(interval.tv_sec>=0)
+			break;
+		
+		/* Call the event callback: */
+		if(tel->callback(tel->key,tel->callbackUserData))
+			{
+			/* Remove the event listener from the heap: */
+			delete tel;
+			timerEventListeners.removeSmallest();
+			}
+		else
+			{
+			/* Move the event time to the next iteration that is still in the future and count the number of missed events: */
+			tel->time+=tel->interval;
+			// unsigned int numMissedEvents=0; // Need to figure out how to communicate this to timer event handlers in a meaningful way
+			while(!(dispatchTime<=tel->time))
+				{
+				// ++numMissedEvents;
+				tel->time+=tel->interval;
+				}
+			
+			/* Re-schedule the event at the next time: */
+			timerEventListeners.reinsertSmallest();
+			}
+		}
+	}
+
+bool EventDispatcher::handlePipeMessage(const EventDispatcher::PipeMessage& pm)
+	{
+	switch(pm.messageType)
+		{
+		case PipeMessage::INTERRUPT: // Interrupt wait
+		
+			/* Do nothing */
+			
+			break;
+		
+		case PipeMessage::STOP: // Stop dispatching events
+			return false;
+			break;
+		
+		case PipeMessage::ADD_IO_LISTENER: // Add input/output event listener
+			{
+			#if THREADS_CONFIG_HAVE_EPOLL
+			/* Add the new input/output event listener to the map: */
+			ioEventListeners.setEntry(IOEventListenerMap::Entry(pm.addIOListener.key,IOEventListener(pm.addIOListener.key,pm.addIOListener.fd,pm.addIOListener.typeMask,pm.addIOListener.callback,pm.addIOListener.callbackUserData)));
+			
+			/* Register the listener's file descriptor with the epoll instance: */
+			updateEpollSet(ioEventListeners.getEntry(pm.addIOListener.key).getDest(),0x0,pm.addIOListener.typeMask);
+			#else
+			/* Add the new input/output event listener to the list: */
+			ioEventListeners.push_back(IOEventListener(pm.addIOListener.key,pm.addIOListener.fd,pm.addIOListener.typeMask,pm.addIOListener.callback,pm.addIOListener.callbackUserData));
+			
+			/* Update the file descriptor sets: */
+			updateFdSets(pm.addIOListener.fd,0x0,pm.addIOListener.typeMask);
+			#endif
+			
+			break;
+			}
+		
+		case PipeMessage::SET_IO_LISTENER_TYPEMASK: // Change the event type mask of an input/output event listener
+			{
+			#if THREADS_CONFIG_HAVE_EPOLL
+			/* Find the input/output event listener with the given key: */
+			IOEventListenerMap::Iterator elIt=ioEventListeners.findEntry(pm.setIOListenerEventTypeMask.key);
+			if(!elIt.isFinished())
+				{
+				/* Update the input/output event listener and the epoll instance: */
+				IOEventListener& el=elIt->getDest();
+				updateEpollSet(el,el.typeMask,pm.setIOListenerEventTypeMask.newTypeMask);
+				el.typeMask=pm.setIOListenerEventTypeMask.newTypeMask;
+				}
+			#else
+			/* Find the input/output event listener with the given key: */
+			for(std::vector<IOEventListener>::iterator elIt=ioEventListeners.begin();elIt!=ioEventListeners.end();++elIt)
+				if(elIt->key==pm.setIOListenerEventTypeMask.key)
+					{
+					/* Update the input/output event listener: */
+					int typeMask=elIt->typeMask;
+					elIt->typeMask=pm.setIOListenerEventTypeMask.newTypeMask;
+					
+					/* Update the file descriptor sets: */
+					updateFdSets(elIt->fd,typeMask,elIt->typeMask);
+					
+					/* Stop looking: */
+					break;
+					}
+			#endif
+			
+			break;
+			}
+		
+		case PipeMessage::REMOVE_IO_LISTENER: // Remove input/output event listener
+			{
+			#if THREADS_CONFIG_HAVE_EPOLL
+			/* Find the input/output event listener with the given key: */
+			IOEventListenerMap::Iterator elIt=ioEventListeners.findEntry(pm.removeIOListener);
+			if(!elIt.isFinished())
+				{
+				/* Unregister the listener's file descriptor and remove the listener from the map: */
+				updateEpollSet(elIt->getDest(),elIt->getDest().typeMask,0x0);
+				ioEventListeners.removeEntry(elIt);
+				}
+			#else
+			/* Find the input/output event listener with the given key: */
+			for(std::vector<IOEventListener>::iterator elIt=ioEventListeners.begin();elIt!=ioEventListeners.end();++elIt)
+				if(elIt->key==pm.removeIOListener)
+					{
+					/* Remove the input/output event listener from the list: */
+					int fd=elIt->fd;
+					int typeMask=elIt->typeMask;
+					*elIt=ioEventListeners.back();
+					ioEventListeners.pop_back();
+					
+					/* Update the file descriptor sets: */
+					updateFdSets(fd,typeMask,0x0);
+					
+					/* Stop looking: */
+					break;
+					}
+			#endif
+			
+			break;
+			}
+		
+		case PipeMessage::ADD_TIMER_LISTENER: // Add timer event listener
+		
+			/* Add the new timer event listener to the heap: */
+			timerEventListeners.insert(new TimerEventListener(pm.addTimerListener.key,pm.addTimerListener.time,pm.addTimerListener.interval,pm.addTimerListener.callback,pm.addTimerListener.callbackUserData));
+			
+			break;
+		
+		case PipeMessage::REMOVE_TIMER_LISTENER: // Remove timer event listener
+		
+			/* Find the timer event listener with the given key: */
+			for(TimerEventListenerHeap::Iterator elIt=timerEventListeners.begin();elIt!=timerEventListeners.end();++elIt)
+				if((*elIt)->key==pm.removeTimerListener)
+					{
+					/* Remove the timer event listener from the heap: */
+					delete *elIt;
+					timerEventListeners.remove(elIt);
+					
+					/* Stop looking: */
+					break;
+					}
+			
+			break;
+		
+		case PipeMessage::ADD_PROCESS_LISTENER:
+		
+			/* Add the new process listener to the list: */
+			processListeners.push_back(ProcessListener(pm.addProcessListener.key,pm.addProcessListener.callback,pm.addProcessListener.callbackUserData));
+			
+			break;
+		
+		case PipeMessage::REMOVE_PROCESS_LISTENER:
+		
+			/* Find the process listener with the given key: */
+			for(std::vector<ProcessListener>::iterator plIt=processListeners.begin();plIt!=processListeners.end();++plIt)
+				if(plIt->key==pm.removeProcessListener)
+					{
+					/* Remove the process listener from the list: */
+					*plIt=processListeners.back();
+					processListeners.pop_back();
+					
+					/* Stop looking: */
+					break;
+					}
+			
+			break;
+		
+		case PipeMessage::ADD_SIGNAL_LISTENER:
+		
+			/* Add the new signal listener to the map: */
+			signalListeners.setEntry(SignalListenerMap::Entry(pm.addSignalListener.key,SignalListener(pm.addSignalListener.key,pm.addSignalListener.callback,pm.addSignalListener.callbackUserData)));
+			
+			break;
+		
+		case PipeMessage::REMOVE_SIGNAL_LISTENER:
+		
+			/* Remove the signal listener with the given key from the map: */
+			signalListeners.removeEntry(pm.removeSignalListener);
+			
+			break;
+		
+		case PipeMessage::SIGNAL:
+			{
+			/* Find the signal listener with the given key in the map: */
+			SignalListener& sl=signalListeners.getEntry(pm.signal.key).getDest();
+			
+			/* Call the callback: */
+			sl.callback(sl.key,pm.signal.signalData,sl.callbackUserData);
+			
+			break;
+			}
+		
+		default:
+			/* Do nothing: */
+			
+			// DEBUGGING
+			Misc::formattedLogWarning("Threads::EventDispatcher::dispatchNextEvent: Unknown pipe message %d",pm.messageType);
+		}
+	
+	return true;
+	}
+
+#if THREADS_CONFIG_HAVE_EPOLL
+
+EventDispatcher::EventDispatcher(void)
+	:eventFd(-1),stopRequested(0),
+	 numQueuedMessages(0),queueSize(4096/sizeof(PipeMessage)),queuedMessages(new PipeMessage[queueSize]),
+	 numMessages(queueSize),messages(new PipeMessage[numMessages]),
+	 epollFd(-1),timerFd(-1),timerFdArmed(false),
+	 nextKey(0),
+	 ioEventListeners(17),
+	 signalListeners(17)
+	{
+	try
+		{
+		/* Create the epoll instance: */
+		epollFd=epoll_create1(EPOLL_CLOEXEC);
+		if(epollFd<0)
+			Misc::throwStdErr("Misc::EventDispatcher: Cannot create epoll instance due to error %d (%s)",errno,strerror(errno));
+		
+		/* Create the message queue's doorbell: */
+		eventFd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+		if(eventFd<0)
+			Misc::throwStdErr("Misc::EventDispatcher: Cannot create event file descriptor due to error %d (%s)",errno,strerror(errno));
+		
+		/* Create the timer file descriptor using the same wall-clock time base as the Time class: */
+		timerFd=timerfd_create(CLOCK_REALTIME,TFD_NONBLOCK|TFD_CLOEXEC);
+		if(timerFd<0)
+			Misc::throwStdErr("Misc::EventDispatcher: Cannot create timer file descriptor due to error %d (%s)",errno,strerror(errno));
+		
+		/* Watch the doorbell and the timer file descriptor: */
+		struct epoll_event event;
+		memset(&event,0,sizeof(struct epoll_event));
+		event.events=EPOLLIN;
+		event.data.u64=doorbellEventKey;
+		if(epoll_ctl(epollFd,EPOLL_CTL_ADD,eventFd,&event)<0)
+			Misc::throwStdErr("Misc::EventDispatcher: Cannot watch event file descriptor due to error %d (%s)",errno,strerror(errno));
+		event.data.u64=timerEventKey;
+		if(epoll_ctl(epollFd,EPOLL_CTL_ADD,timerFd,&event)<0)
+			Misc::throwStdErr("Misc::EventDispatcher: Cannot watch timer file descriptor due to error %d (%s)",errno,strerror(errno));
+		
+		}
+	catch(...)
+		{
+		/* Release all resources acquired so far and re-throw the exception: */
+		if(timerFd>=0)
+			close(timerFd);
+		if(eventFd>=0)
+			close(eventFd);
+		if(epollFd>=0)
+			close(epollFd);
+		delete[] queuedMessages;
+		delete[] messages;
+		throw;
+		}
+	}
+
+EventDispatcher::~EventDispatcher(void)
+	{
+	/* Close duplicated file descriptors of all input/output event listeners: */
+	for(IOEventListenerMap::Iterator elIt=ioEventListeners.begin();!elIt.isFinished();++elIt)
+		if(elIt->getDest().pollFd>=0&&elIt->getDest().pollFd!=elIt->getDest().fd)
+			close(elIt->getDest().pollFd);
+	
+	/* Close the epoll instance, the doorbell, and the timer file descriptor: */
+	close(timerFd);
+	close(eventFd);
+	close(epollFd);
+	delete[] queuedMessages;
+	delete[] messages;
+	
+	/* Delete all timer event listeners: */
+	for(TimerEventListenerHeap::Iterator telIt=timerEventListeners.begin();telIt!=timerEventListeners.end();++telIt)
+		delete *telIt;
+	}
+
+bool EventDispatcher::dispatchNextEvent(void)
+	{
+	/* Update the dispatch time point: */
+	dispatchTime=Time::now();
+	
+	/* Handle elapsed timer events: */
+	dispatchTimerEvents();
+	
+	/* Arm the timer file descriptor for the next unelapsed timer event, or disarm it if there are none: */
+	if(!timerEventListeners.isEmpty())
+		{
+		const Time& nextTime=timerEventListeners.getSmallest()->time;
+		if(!timerFdArmed||timerFdTime!=nextTime)
+			{
+			struct itimerspec timerSpec;
+			memset(&timerSpec,0,sizeof(struct itimerspec));
+			timerSpec.it_value.tv_sec=nextTime.tv_sec;
+			timerSpec.it_value.tv_nsec=nextTime.tv_usec*1000L;
+			if(timerfd_settime(timerFd,TFD_TIMER_ABSTIME,&timerSpec,0)<0)
+				{
+				int error=errno;
+				Misc::throwStdErr("Threads::EventDispatcher::dispatchNextEvent: Error %d (%s) while arming timer",error,strerror(error));
+				}
+			timerFdArmed=true;
+			timerFdTime=nextTime;
+			}
+		}
+	else if(timerFdArmed)
+		{
+		struct itimerspec timerSpec;
+		memset(&timerSpec,0,sizeof(struct itimerspec));
+		timerfd_settime(timerFd,0,&timerSpec,0);
+		timerFdArmed=false;
+		}
+	
+	/* Wait for the next event on any watched file descriptor: */
+	struct epoll_event events[maxEpollEvents];
+	int numEvents=epoll_wait(epollFd,events,maxEpollEvents,-1);
+	
+	/* Update the dispatch time point: */
+	dispatchTime=Time::now();
+	
+	/* Handle messages and timer expirations first, so that listeners removed by queued messages are not called for events in the same batch: */
+	bool keepDispatching=true;
+	for(int eventIndex=0;eventIndex<numEvents;++eventIndex)
+		{
+		const struct epoll_event& event=events[eventIndex];
+		if(event.data.u64==doorbellEventKey)
+			{
+			/* Read and handle all queued messages: */
+			size_t numMessages=readPipeMessages();
+			for(size_t i=0;i<numMessages;++i)
+				if(!handlePipeMessage(messages[i]))
+					keepDispatching=false;
+			
+			/* Check if the dispatcher was asked to stop: */
+			if(stopRequested)
+				{
+				stopRequested=0;
+				keepDispatching=false;
+				}
+			}
+		else if(event.data.u64==timerEventKey)
+			{
+			/* Acknowledge the timer expiration; the elapsed timer event will be handled during the next call, and the timer needs to be re-armed: */
+			uint64_t numExpirations;
+			if(read(timerFd,&numExpirations,sizeof(uint64_t))<0&&errno!=EAGAIN&&errno!=EWOULDBLOCK&&errno!=EINTR)
+				Misc::formattedLogWarning("Threads::EventDispatcher::dispatchNextEvent: Error %d (%s) while reading timer",errno,strerror(errno));
+			timerFdArmed=false;
+			}
+		}
+	if(!keepDispatching)
+		return false;
+	
+	/* Handle all input/output events: */
+	for(int eventIndex=0;eventIndex<numEvents;++eventIndex)
+		{
+		const struct epoll_event& event=events[eventIndex];
+		if(event.data.u64!=doorbellEventKey&&event.data.u64!=timerEventKey)
+			{
+			/* Find the input/output event listener; ignore the event if the listener was removed by a queued message or while handling a previous event: */
+			IOEventListenerMap::Iterator elIt=ioEventListeners.findEntry(ListenerKey(event.data.u64));
+			if(elIt.isFinished())
+				continue;
+			IOEventListener& el=elIt->getDest();
+			
+			/* Determine all event types on the listener's file descriptor; errors and hang-ups wake up all interested parties, as with select(): */
+			int eventTypeMask=0x0;
+			if(event.events&(EPOLLERR|EPOLLHUP))
+				eventTypeMask=el.typeMask;
+			if(event.events&EPOLLIN)
+				eventTypeMask|=Read;
+			if(event.events&EPOLLOUT)
+				eventTypeMask|=Write;
+			if(event.events&EPOLLPRI)
+				eventTypeMask|=Exception;
+			
+			/* Limit to events in which the listener is interested: */
+			int interestEventTypeMask=eventTypeMask&el.typeMask;
+			
+			/* Check for spurious events: */
+			if(interestEventTypeMask!=eventTypeMask)
+				Misc::logWarning("Threads::EventDispatcher::dispatchNextEvent: Spurious event");
+			
+			/* Call the listener's event callback and check whether the listener wants to be removed: */
+			if(interestEventTypeMask!=0x0&&el.callback(el.key,interestEventTypeMask,el.callbackUserData))
+				{
+				/* Unregister the listener's file descriptor and remove the listener from the map: */
+				updateEpollSet(el,el.typeMask,0x0);
+				ioEventListeners.removeEntry(elIt);
+				}
+			}
+		}
+	if(numEvents<0&&errno!=EINTR)
+		{
+		int error=errno;
+		Misc::throwStdErr("Threads::EventDispatcher::dispatchNextEvent: Error %d (%s) during epoll_wait",error,strerror(error));
+		}
+	
+	/* Call all process listeners: */
+	for(std::vector<ProcessListener>::iterator plIt=processListeners.begin();plIt!=processListeners.end();++plIt)
+		{
+		/* Call the listener and check if it wants to be removed: */
+		if(plIt->callback(plIt->key,plIt->callbackUserData))
+			{
+			/* Remove the event listener from the list: */
+			*plIt=processListeners.back();
+			processListeners.pop_back();
+			--plIt;
+			}
+		}
+	
+	return true;
+	}
+
+#else
+
 EventDispatcher::EventDispatcher(void)
 	:numMessages(4096/sizeof(PipeMessage)),messages(new PipeMessage[numMessages]),messageReadSize(0),
 	 nextKey(0),
@@ -416,39 +976,12 @@ bool EventDispatcher::dispatchNextEvent(void)
 	dispatchTime=Time::now();
 	
 	/* Handle elapsed timer events and find the time interval to the next unelapsed event: */
+	dispatchTimerEvents();
 	Time interval;
-	while(!timerEventListeners.isEmpty())
+	if(!timerEventListeners.isEmpty())
 		{
-		/* Calculate the interval to the next timer event and dispatch elapsed events on-the-fly: */
-		TimerEventListener* tel=timerEventListeners.getSmallest();
-		interval=tel->time;
+		interval=timerEventListeners.getSmallest()->time;
 		interval-=dispatchTime;
-		
-		/* Bail out if the event is still in the future: */
-		if(interval.tv_sec>=0)
-			break;
-		
-		/* Call the event callback: */
-		if(tel->callback(tel->key,tel->callbackUserData))
-			{
-			/* Remove the event listener from the heap: */
-			delete tel;
-			timerEventListeners.removeSmallest();
-			}
-		else
-			{
-			/* Move the event time to the next iteration that is still in the future and count the number of missed events: */
-			tel->time+=tel->interval;
-			// unsigned int numMissedEvents=0; // Need to figure out how to communicate this to timer event handlers in a meaningful way
-			while(!(dispatchTime<=tel->time))
-				{
-				// ++numMissedEvents;
-				tel->time+=tel->interval;
-				}
-			
-			/* Re-schedule the event at the next time: */
-			timerEventListeners.reinsertSmallest();
-			}
 		}
 	
 	/* Create lists of watched file descriptors: */
@@ -506,147 +1039,8 @@ bool EventDispatcher::dispatchNextEvent(void)
 			size_t numMessages=readPipeMessages();
 			PipeMessage* pmPtr=messages;
 			for(size_t i=0;i<numMessages;++i,++pmPtr)
-				{
-				switch(pmPtr->messageType)
-					{
-					case PipeMessage::INTERRUPT: // Interrupt wait
-						
-						/* Do nothing */
-						
-						break;
-					
-					case PipeMessage::STOP: // Stop dispatching events
-						return false;
-						break;
-					
-					case PipeMessage::ADD_IO_LISTENER: // Add input/output event listener
-						
-						/* Add the new input/output event listener to the list: */
-						ioEventListeners.push_back(IOEventListener(pmPtr->addIOListener.key,pmPtr->addIOListener.fd,pmPtr->addIOListener.typeMask,pmPtr->addIOListener.callback,pmPtr->addIOListener.callbackUserData));
-						
-						/* Update the file descriptor sets: */
-						updateFdSets(pmPtr->addIOListener.fd,0x0,pmPtr->addIOListener.typeMask);
-						
-						break;
-					
-					case PipeMessage::SET_IO_LISTENER_TYPEMASK: // Change the event type mask of an input/output event listener
-						
-						/* Find the input/output event listener with the given key: */
-						for(std::vector<IOEventListener>::iterator elIt=ioEventListeners.begin();elIt!=ioEventListeners.end();++elIt)
-							if(elIt->key==pmPtr->setIOListenerEventTypeMask.key)
-								{
-								/* Update the input/output event listener: */
-								int typeMask=elIt->typeMask;
-								elIt->typeMask=pmPtr->setIOListenerEventTypeMask.newTypeMask;
-								
-								/* Update the file descriptor sets: */
-								updateFdSets(elIt->fd,typeMask,elIt->typeMask);
-								
-								/* Stop looking: */
-								break;
-								}
-						
-						break;
-					
-					case PipeMessage::REMOVE_IO_LISTENER: // Remove input/output event listener
-						
-						/* Find the input/output event listener with the given key: */
-						for(std::vector<IOEventListener>::iterator elIt=ioEventListeners.begin();elIt!=ioEventListeners.end();++elIt)
-							if(elIt->key==pmPtr->removeIOListener)
-								{
-								/* Remove the input/output event listener from the list: */
-								int fd=elIt->fd;
-								int typeMask=elIt->typeMask;
-								*elIt=ioEventListeners.back();
-								ioEventListeners.pop_back();
-								
-								/* Update the file descriptor sets: */
-								updateFdSets(fd,typeMask,0x0);
-								
-								/* Stop looking: */
-								break;
-								}
-						
-						break;
-					
-					case PipeMessage::ADD_TIMER_LISTENER: // Add timer event listener
-						
-						/* Add the new timer event listener to the heap: */
-						timerEventListeners.insert(new TimerEventListener(pmPtr->addTimerListener.key,pmPtr->addTimerListener.time,pmPtr->addTimerListener.interval,pmPtr->addTimerListener.callback,pmPtr->addTimerListener.callbackUserData));
-						
-						break;
-					
-					case PipeMessage::REMOVE_TIMER_LISTENER: // Remove timer event listener
-						
-						/* Find the timer event listener with the given key: */
-						for(TimerEventListenerHeap::Iterator elIt=timerEventListeners.begin();elIt!=timerEventListeners.end();++elIt)
-							if((*elIt)->key==pmPtr->removeTimerListener)
-								{
-								/* Remove the timer event listener from the heap: */
-								delete *elIt;
-								timerEventListeners.remove(elIt);
-								
-								/* Stop looking: */
-								break;
-								}
-						
-						break;
-					
-					case PipeMessage::ADD_PROCESS_LISTENER:
-						
-						/* Add the new process listener to the list: */
-						processListeners.push_back(ProcessListener(pmPtr->addProcessListener.key,pmPtr->addProcessListener.callback,pmPtr->addProcessListener.callbackUserData));
-						
-						break;
-					
-					case PipeMessage::REMOVE_PROCESS_LISTENER:
-						
-						/* Find the process listener with the given key: */
-						for(std::vector<ProcessListener>::iterator plIt=processListeners.begin();plIt!=processListeners.end();++plIt)
-							if(plIt->key==pmPtr->removeProcessListener)
-								{
-								/* Remove the process listener from the list: */
-								*plIt=processListeners.back();
-								processListeners.pop_back();
-								
-								/* Stop looking: */
-								break;
-								}
-						
-						break;
-					
-					case PipeMessage::ADD_SIGNAL_LISTENER:
-						
-						/* Add the new signal listener to the map: */
-						signalListeners.setEntry(SignalListenerMap::Entry(pmPtr->addSignalListener.key,SignalListener(pmPtr->addSignalListener.key,pmPtr->addSignalListener.callback,pmPtr->addSignalListener.callbackUserData)));
-						
-						break;
-					
-					case PipeMessage::REMOVE_SIGNAL_LISTENER:
-						
-						/* Remove the signal listener with the given key from the map: */
-						signalListeners.removeEntry(pmPtr->removeSignalListener);
-						
-						break;
-					
-					case PipeMessage::SIGNAL:
-						{
-						/* Find the signal listener with the given key in the map: */
-						SignalListener& sl=signalListeners.getEntry(pmPtr->signal.key).getDest();
-						
-						/* Call the callback: */
-						sl.callback(sl.key,pmPtr->signal.signalData,sl.callbackUserData);
-						
-						break;
-						}
-						
-					default:
-						/* Do nothing: */
-						
-						// DEBUGGING
-						Misc::formattedLogWarning("Threads::EventDispatcher::dispatchNextEvent: Unknown pipe message %d",pmPtr->messageType);
-					}
-				}
+				if(!handlePipeMessage(*pmPtr))
+					return false;
 			
 			--numSetFds;
 			}
@@ -728,6 +1122,8 @@ bool EventDispatcher::dispatchNextEvent(void)
 	return true;
 	}
 
+#endif
+
 void EventDispatcher::dispatchEvents(void)
 	{
 	/* Dispatch events until the stop() method is called: */
@@ -737,20 +1133,31 @@ void EventDispatcher::dispatchEvents(void)
 
 void EventDispatcher::interrupt(void)
 	{
+	#if THREADS_CONFIG_HAVE_EPOLL
+	/* Wake up the dispatching thread: */
+	ringDoorbell();
+	#else
 	/* Write a pipe message to the self pipe: */
 	PipeMessage pm;
 	memset(&pm,0,sizeof(PipeMessage));
 	pm.messageType=PipeMessage::INTERRUPT;
 	writePipeMessage(pm,"interrupt");
+	#endif
 	}
 
 void EventDispatcher::stop(void)
 	{
+	#if THREADS_CONFIG_HAVE_EPOLL
+	/* Set the stop flag and wake up the dispatching thread: */
+	stopRequested=1;
+	ringDoorbell();
+	#else
 	/* Write a pipe message to the self pipe: */
 	PipeMessage pm;
 	memset(&pm,0,sizeof(PipeMessage));
 	pm.messageType=PipeMessage::STOP;
 	writePipeMessage(pm,"stop");
+	#endif
 	}
 
 void EventDispatcher::stopOnSignals(void)
@@ -804,6 +1211,19 @@ void EventDispatcher::setIOEventListenerEventTypeMask(EventDispatcher::ListenerK
 
 void EventDispatcher::setIOEventListenerEventTypeMaskFromCallback(EventDispatcher::ListenerKey listenerKey,int newEventTypeMask)
 	{
+	#if THREADS_CONFIG_HAVE_EPOLL
+	/* Find the input/output event listener with the given key: */
+	IOEventListenerMap::Iterator elIt=ioEventListeners.findEntry(listenerKey);
+	if(!elIt.isFinished())
+		{
+		/* Update the epoll instance: */
+		IOEventListener& el=elIt->getDest();
+		updateEpollSet(el,el.typeMask,newEventTypeMask);
+		
+		/* Update the input/output event listener: */
+		el.typeMask=newEventTypeMask;
+		}
+	#else
 	/* Find the input/output event listener with the given key: */
 	for(std::vector<IOEventListener>::iterator elIt=ioEventListeners.begin();elIt!=ioEventListeners.end();++elIt)
 		if(elIt->key==listenerKey)
@@ -817,6 +1237,7 @@ void EventDispatcher::setIOEventListenerEventTypeMaskFromCallback(EventDispatche
 			/* Stop looking: */
 			break;
 			}
+	#endif
 	}
 
 void EventDispatcher::removeIOEventListener(EventDispatcher::ListenerKey listenerKey)
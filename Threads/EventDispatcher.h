@@ -23,11 +23,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef THREADS_EVENTDISPATCHER_INCLUDED
 #define THREADS_EVENTDISPATCHER_INCLUDED
 
+#include <Threads/Config.h>
+
 #include <sys/types.h>
 #include <sys/time.h>
 #ifdef __APPLE__
 #include <unistd.h>
 #endif
+#if THREADS_CONFIG_HAVE_EPOLL
+#include <signal.h>
+#endif
 #include <vector>
 #include <Misc/PriorityHeap.h>
 #include <Misc/StandardHashFunction.h>
@@ -136,6 +141,9 @@ class EventDispatcher
 	struct IOEventListener; // Structure representing listeners that have registered interest in some input/output event(s)
 	struct TimerEventListener; // Structure representing listeners that have registered interest in timer events
 	class TimerEventListenerComp; // Helper class to compare timer event listener structures by next event time
+	#if THREADS_CONFIG_HAVE_EPOLL
+	typedef Misc::HashTable<ListenerKey,IOEventListener> IOEventListenerMap; // Hash table mapping listener keys to input/output event listeners
+	#endif
 	typedef Misc::PriorityHeap<TimerEventListener*,TimerEventListenerComp> TimerEventListenerHeap; // Type for heap of timer event listeners, ordered by next event time
 	struct ProcessListener; // Structure representing listeners that are called after any event has been handled
 	struct SignalListener; // Structure representing listeners that react to user-defined signals
@@ -144,27 +152,55 @@ class EventDispatcher
 	
 	/* Elements: */
 	private:
+	#if THREADS_CONFIG_HAVE_EPOLL
+	Spinlock pipeMutex; // Mutex protecting the message queue used to change the dispatcher's internal state or raise signals
+	int eventFd; // Event file descriptor acting as a doorbell for the message queue
+	volatile sig_atomic_t stopRequested; // Flag set by the stop() method; a flag instead of a queued message to keep stop() safe to call from signal handlers
+	size_t numQueuedMessages; // Number of messages currently in the message queue
+	size_t queueSize; // Allocated size of the message queue
+	PipeMessage* queuedMessages; // Queue of messages posted to the dispatcher from any thread
+	size_t numMessages; // Allocated size of the message buffer handed to the dispatching thread
+	PipeMessage* messages; // Buffer of messages being handled by the dispatching thread; swapped with the message queue on each read
+	int epollFd; // File descriptor of the epoll instance watching all input/output event listeners' file descriptors
+	int timerFd; // Timer file descriptor tracking the time point of the next timer event
+	bool timerFdArmed; // Flag whether the timer file descriptor is currently armed
+	Time timerFdTime; // Time point to which the timer file descriptor is currently armed
+	#else
 	Spinlock pipeMutex; // Mutex protecting the self-pipe used to change the dispatcher's internal state or raise signals
 	int pipeFds[2]; // A uni-directional unnamed pipe to trigger events internal to the dispatcher
 	size_t numMessages; // Number of messages in the self-pipe read buffer
 	PipeMessage* messages; // A buffer to read pipe messages from the self-pipe
 	size_t messageReadSize; // Number of bytes read during previous call to readPipeMessages
+	#endif
 	ListenerKey nextKey; // Next key to be assigned to an event listener
+	#if THREADS_CONFIG_HAVE_EPOLL
+	IOEventListenerMap ioEventListeners; // Map of currently registered input/output event listeners
+	#else
 	std::vector<IOEventListener> ioEventListeners; // List of currently registered input/output event listeners
+	#endif
 	TimerEventListenerHeap timerEventListeners; // Heap of currently registered timer event listeners, sorted by next event time
 	std::vector<ProcessListener> processListeners; // List of currently registered process event listeners
 	SignalListenerMap signalListeners; // Map of currently registered signal event listeners
+	#if !THREADS_CONFIG_HAVE_EPOLL
 	fd_set readFds,writeFds,exceptionFds; // Three sets of file descriptors waiting for reads, writes, and exceptions, respectively
 	int numReadFds,numWriteFds,numExceptionFds; // Number of file descriptors in the three descriptor sets
 	int maxFd; // Largest file descriptor set in any of the three descriptor sets
 	bool hadBadFd; // Flag if the last invocation of dispatchNextEvent() tripped on a bad file descriptor
+	#endif
 	Time dispatchTime; // Time point of current iteration of dispatchNextEvent() method
 	
 	/* Private methods: */
 	ListenerKey getNextKey(void); // Returns a new listener key
-	size_t readPipeMessages(void); // Reads messages from the self-pipe; returns number of complete messages read
-	void writePipeMessage(const PipeMessage& pm,const char* methodName); // Writes a message to the self-pipe
+	size_t readPipeMessages(void); // Reads messages from the self-pipe or message queue; returns number of complete messages read
+	void writePipeMessage(const PipeMessage& pm,const char* methodName); // Writes a message to the self-pipe or message queue; the message queue can grow, so this is not safe to call from signal handlers
+	#if THREADS_CONFIG_HAVE_EPOLL
+	void ringDoorbell(void); // Wakes up the dispatching thread; safe to call from signal handlers
+	void updateEpollSet(IOEventListener& listener,int oldEventMask,int newEventMask); // Updates the epoll instance based on the given listener changing its interest mask
+	#else
 	void updateFdSets(int fd,int oldEventMask,int newEventMask); // Updates the three descriptor sets based on the given file descriptor changing its interest mask
+	#endif
+	void dispatchTimerEvents(void); // Dispatches all elapsed timer events
+	bool handlePipeMessage(const PipeMessage& pm); // Handles a single message received from the self-pipe or message queue; returns false if the dispatcher was stopped
 	
 	/* Constructors and destructors: */
 	public:
@@ -178,8 +214,8 @@ class EventDispatcher
 	/* Methods: */
 	bool dispatchNextEvent(void); // Waits for the next event and dispatches it; returns false if the stop() method was called
 	void dispatchEvents(void); // Waits for and dispatches events until stopped
-	void interrupt(void); // Forces an invocation of dispatchNextEvent() to return with a true value
-	void stop(void); // Forces an invocation of dispatchNextEvent() to return with a false value, or an invocation of dispatchEvents() to return
+	void interrupt(void); // Forces an invocation of dispatchNextEvent() to return with a true value; safe to call from signal handlers
+	void stop(void); // Forces an invocation of dispatchNextEvent() to return with a false value, or an invocation of dispatchEvents() to return; safe to call from signal handlers
 	void stopOnSignals(void); // Installs a signal handler that stops the event dispatcher when a SIGINT or SIGTERM occur
 	const Time& getCurrentTime(void) const // Returns the time point of the current invocation of the dispatchNextEvent method, to be used to schedule timer events; can only be called from inside an event callback
 		{
@@ -195,7 +231,7 @@ class EventDispatcher
 	void removeProcessListener(ListenerKey listenerKey); // Removes the process listener with the given listener key
 	ListenerKey addSignalListener(SignalCallback eventCallback,void* eventCallbackUserData); // Adds a new signal listener; returns unique event listener key
 	void removeSignalListener(ListenerKey listenerKey); // Removes the signal listener with the given listener key
-	void signal(ListenerKey listenerKey,void* signalData); // Raises a signal with the given listener key and opaque data pointer
+	void signal(ListenerKey listenerKey,void* signalData); // Raises a signal with the given listener key and opaque data pointer; like all other listener methods, must not be called from signal handlers
 	};
 
 }
@@ -22,9 +22,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef USB_CONFIG_INCLUDED
 #define USB_CONFIG_INCLUDED
 
-#define USB_CONFIG_HAVE_LIBUSB1 1
-#define USB_CONFIG_HAVE_TOPOLOGY_CALLS 1
-#define USB_CONFIG_HAVE_STRERROR 1
+#define USB_CONFIG_HAVE_LIBUSB1 0
+#define USB_CONFIG_HAVE_TOPOLOGY_CALLS 0
+#define USB_CONFIG_HAVE_STRERROR 0
 #define USB_CONFIG_HAVE_SET_OPTION 0
 
 #endif
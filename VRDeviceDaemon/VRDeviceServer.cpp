@@ -23,14 +23,23 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <VRDeviceDaemon/VRDeviceServer.h>
 
+#include <errno.h>
+#include <string.h>
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/socket.h>
 #include <stdexcept>
 #include <Misc/SizedTypes.h>
 #include <Misc/PrintInteger.h>
+#include <Misc/StringMarshaller.h>
+#include <Misc/ThrowStdErr.h>
 #include <Misc/StandardValueCoders.h>
 #include <Misc/ConfigurationFile.h>
 #include <Vrui/Internal/VRDeviceDescriptor.h>
 #include <Vrui/Internal/HMDConfiguration.h>
+#include <Vrui/Internal/VRDeviceSharedState.h>
+#include <Comm/IPv4Address.h>
+#include <Comm/IPv4SocketAddress.h>
 
 #define VRDEVICEDAEMON_DEBUG_PROTOCOL 0
 
@@ -55,7 +64,8 @@ VRDeviceServer::ClientState::ClientState(VRDeviceServer* sServer,Comm::Listening
 	:server(sServer),
 	 pipe(listenSocket),
 	 state(START),protocolVersion(Vrui::VRDevicePipe::protocolVersionNumber),clientExpectsTimeStamps(true),
-	 active(false),streaming(false)
+	 active(false),streaming(false),streamTransport(Vrui::VRDevicePipe::STREAM_PIPE),datagramAddress(0),
+	 pendingOffset(0),stale(false)
 	{
 	#ifdef VERBOSE
 	/* Assemble the client name: */
@@ -66,6 +76,11 @@ VRDeviceServer::ClientState::ClientState(VRDeviceServer* sServer,Comm::Listening
 	#endif
 	}
 
+VRDeviceServer::ClientState::~ClientState(void)
+	{
+	delete datagramAddress;
+	}
+
 /*******************************
 Methods of class VRDeviceServer:
 *******************************/
@@ -120,7 +135,11 @@ void VRDeviceServer::disconnectClient(VRDeviceServer::ClientState* client,bool r
 	
 	/* Check if the client is still streaming or active: */
 	if(client->streaming)
+		{
 		--numStreamingClients;
+		if(client->streamTransport==Vrui::VRDevicePipe::STREAM_DATAGRAM)
+			--numDatagramClients;
+		}
 	if(client->active)
 		{
 		--numActiveClients;
@@ -156,6 +175,34 @@ bool VRDeviceServer::clientMessageCallback(Threads::EventDispatcher::ListenerKey
 	
 	try
 		{
+		/* Check if the client's socket can accept more data after a partially sent update batch: */
+		if(eventType&Threads::EventDispatcher::Write)
+			{
+			/* Continue sending the pending update batch: */
+			if(client->pendingUpdates!=0)
+				thisPtr->sendStateUpdates(client,client->pendingUpdates);
+			
+			/* Send the full current device state if the client missed update batches while it was blocked: */
+			if(client->pendingUpdates==0&&client->stale)
+				{
+				client->stale=false;
+				UpdateBufferPtr fullState;
+				{
+				Threads::Mutex::Lock stateLock(thisPtr->stateMutex);
+				fullState=thisPtr->encodeStateUpdates(true);
+				}
+				thisPtr->sendStateUpdates(client,fullState);
+				}
+			
+			/* Stop waiting for the client's socket once the client has caught up: */
+			if(client->pendingUpdates==0)
+				thisPtr->dispatcher.setIOEventListenerEventTypeMaskFromCallback(client->listenerKey,Threads::EventDispatcher::Read);
+			
+			/* Bail out if there is nothing to read: */
+			if(!(eventType&Threads::EventDispatcher::Read))
+				return false;
+			}
+		
 		/* Read some data from the socket into the socket's read buffer and check if client hung up: */
 		if(client->pipe.readSomeData()==0)
 			throw std::runtime_error("Client terminated connection");
@@ -275,6 +322,21 @@ bool VRDeviceServer::clientMessageCallback(Threads::EventDispatcher::ListenerKey
 						client->active=true;
 						client->state=ACTIVE;
 						}
+					else if(message==Vrui::VRDevicePipe::SHAREDSTATE_REQUEST)
+						{
+						/* Send the name of the shared memory segment, or an empty string if there is none: */
+						client->pipe.writeMessage(Vrui::VRDevicePipe::SHAREDSTATE_REPLY);
+						Misc::writeCString(thisPtr->sharedState!=0?thisPtr->sharedState->getName().c_str():"",client->pipe);
+						client->pipe.flush();
+						}
+					else if(message==Vrui::VRDevicePipe::DATAGRAM_REQUEST)
+						{
+						/* Send the datagram stream's multicast group address and port, or an empty string if datagrams are unicast: */
+						client->pipe.writeMessage(Vrui::VRDevicePipe::DATAGRAM_REPLY);
+						Misc::writeCppString(thisPtr->datagramMulticastGroup,client->pipe);
+						client->pipe.write<Misc::UInt16>(Misc::UInt16(thisPtr->datagramMulticastAddress!=0?thisPtr->datagramMulticastAddress->getPort():0U));
+						client->pipe.flush();
+						}
 					else if(message==Vrui::VRDevicePipe::DISCONNECT_REQUEST)
 						{
 						/* Cleanly disconnect this client: */
@@ -292,6 +354,23 @@ bool VRDeviceServer::clientMessageCallback(Threads::EventDispatcher::ListenerKey
 				case ACTIVE:
 					if(message==Vrui::VRDevicePipe::PACKET_REQUEST||message==Vrui::VRDevicePipe::STARTSTREAM_REQUEST)
 						{
+						/* Check over which transport the client wants to receive streamed device states: */
+						client->streamTransport=Vrui::VRDevicePipe::STREAM_PIPE;
+						if(message==Vrui::VRDevicePipe::STARTSTREAM_REQUEST&&client->protocolVersion>=10U)
+							{
+							int streamTransport=client->pipe.read<Misc::UInt8>();
+							if(streamTransport==Vrui::VRDevicePipe::STREAM_SHAREDMEMORY&&thisPtr->sharedState!=0)
+								client->streamTransport=streamTransport;
+							else if(streamTransport==Vrui::VRDevicePipe::STREAM_DATAGRAM)
+								{
+								/* Read the port on which the client receives unicast datagrams: */
+								unsigned int datagramPort=client->pipe.read<Misc::UInt16>();
+								delete client->datagramAddress;
+								client->datagramAddress=new Comm::IPv4SocketAddress(datagramPort,Comm::IPv4Address(client->pipe.getPeerAddress().c_str()));
+								client->streamTransport=streamTransport;
+								}
+							}
+						
 						#if VRDEVICEDAEMON_DEBUG_PROTOCOL
 						printf("Sending packet reply..."); fflush(stdout);
 						#endif
@@ -316,6 +395,8 @@ bool VRDeviceServer::clientMessageCallback(Threads::EventDispatcher::ListenerKey
 							{
 							/* Increase the number of streaming clients: */
 							++thisPtr->numStreamingClients;
+							if(client->streamTransport==Vrui::VRDevicePipe::STREAM_DATAGRAM)
+								++thisPtr->numDatagramClients;
 							
 							/* Go to streaming state: */
 							client->streaming=true;
@@ -347,6 +428,21 @@ bool VRDeviceServer::clientMessageCallback(Threads::EventDispatcher::ListenerKey
 						/* Request a haptic tick on the requested feature: */
 						thisPtr->deviceManager->hapticTick(hapticFeatureIndex,duration,frequency,amplitude);
 						}
+					else if(message==Vrui::VRDevicePipe::SHAREDSTATE_REQUEST)
+						{
+						/* Send the name of the shared memory segment, or an empty string if there is none: */
+						client->pipe.writeMessage(Vrui::VRDevicePipe::SHAREDSTATE_REPLY);
+						Misc::writeCString(thisPtr->sharedState!=0?thisPtr->sharedState->getName().c_str():"",client->pipe);
+						client->pipe.flush();
+						}
+					else if(message==Vrui::VRDevicePipe::DATAGRAM_REQUEST)
+						{
+						/* Send the datagram stream's multicast group address and port, or an empty string if datagrams are unicast: */
+						client->pipe.writeMessage(Vrui::VRDevicePipe::DATAGRAM_REPLY);
+						Misc::writeCppString(thisPtr->datagramMulticastGroup,client->pipe);
+						client->pipe.write<Misc::UInt16>(Misc::UInt16(thisPtr->datagramMulticastAddress!=0?thisPtr->datagramMulticastAddress->getPort():0U));
+						client->pipe.flush();
+						}
 					else if(message==Vrui::VRDevicePipe::DEACTIVATE_REQUEST)
 						{
 						/* Stop VR devices if this was the last active clients: */
@@ -390,15 +486,22 @@ bool VRDeviceServer::clientMessageCallback(Threads::EventDispatcher::ListenerKey
 						}
 					else if(message==Vrui::VRDevicePipe::STOPSTREAM_REQUEST)
 						{
+						/* Finish sending any pending update batch and drop any missed updates: */
+						thisPtr->finishPendingUpdates(client);
+						client->stale=false;
+						
 						/* Send stopstream reply message: */
 						client->pipe.writeMessage(Vrui::VRDevicePipe::STOPSTREAM_REPLY);
 						client->pipe.flush();
 						
 						/* Decrease the number of streaming clients: */
 						--thisPtr->numStreamingClients;
+						if(client->streamTransport==Vrui::VRDevicePipe::STREAM_DATAGRAM)
+							--thisPtr->numDatagramClients;
 						
 						/* Go to active state: */
 						client->streaming=false;
+						client->streamTransport=Vrui::VRDevicePipe::STREAM_PIPE;
 						client->state=ACTIVE;
 						}
 					else if(message!=Vrui::VRDevicePipe::PACKET_REQUEST)
@@ -426,56 +529,123 @@ void VRDeviceServer::disconnectClientOnError(VRDeviceServer::ClientStateList::it
 	fprintf(stderr,"VRDeviceServer: Disconnecting client %s due to exception %s\n",(*csIt)->clientName.c_str(),err.what());
 	fflush(stderr);
 	
-	/* Disconnect the client: */
+	/* Disconnect and delete the client: */
 	disconnectClient(*csIt,true,false);
 	
 	/* Remove the dead client from the list: */
-	delete *csIt;
 	*csIt=clientStates.back();
 	clientStates.pop_back();
 	}
 
-bool VRDeviceServer::writeStateUpdates(VRDeviceServer::ClientStateList::iterator csIt)
+VRDeviceServer::UpdateBufferPtr VRDeviceServer::encodeStateUpdates(bool fullState)
 	{
-	/* Bail out if the client is not streaming or does not understand incremental state updates: */
+	/* Calculate the size of the update batch: */
+	int numTrackers=fullState?state.getNumTrackers():int(updatedTrackers.size());
+	int numButtons=fullState?state.getNumButtons():int(updatedButtons.size());
+	int numValuators=fullState?state.getNumValuators():int(updatedValuators.size());
+	size_t headerSize=sizeof(Vrui::VRDevicePipe::MessageIdType)+sizeof(Misc::UInt16);
+	size_t batchSize=0;
+	for(int i=0;i<numTrackers;++i)
+		batchSize+=headerSize+Misc::Marshaller<Vrui::VRDeviceState::TrackerState>::getSize(state.getTrackerState(fullState?i:updatedTrackers[i]))+sizeof(Vrui::VRDeviceState::TimeStamp)+sizeof(Misc::UInt8);
+	batchSize+=size_t(numButtons)*(headerSize+sizeof(Misc::UInt8));
+	batchSize+=size_t(numValuators)*(headerSize+sizeof(Vrui::VRDeviceState::ValuatorState));
+	
+	/* Encode the update batch in the same format as individual update messages written to a client's pipe: */
+	UpdateBufferPtr result=new IO::FixedMemoryFile(batchSize);
+	for(int i=0;i<numTrackers;++i)
+		{
+		int trackerIndex=fullState?i:updatedTrackers[i];
+		result->write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::TRACKER_UPDATE);
+		result->write<Misc::UInt16>(Misc::UInt16(trackerIndex));
+		Misc::Marshaller<Vrui::VRDeviceState::TrackerState>::write(state.getTrackerState(trackerIndex),*result);
+		result->write<Vrui::VRDeviceState::TimeStamp>(state.getTrackerTimeStamp(trackerIndex));
+		result->write<Misc::UInt8>(state.getTrackerValid(trackerIndex)?1U:0U);
+		}
+	for(int i=0;i<numButtons;++i)
+		{
+		int buttonIndex=fullState?i:updatedButtons[i];
+		result->write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::BUTTON_UPDATE);
+		result->write<Misc::UInt16>(Misc::UInt16(buttonIndex));
+		result->write<Misc::UInt8>(state.getButtonState(buttonIndex)?1U:0U);
+		}
+	for(int i=0;i<numValuators;++i)
+		{
+		int valuatorIndex=fullState?i:updatedValuators[i];
+		result->write<Vrui::VRDevicePipe::MessageIdType>(Vrui::VRDevicePipe::VALUATOR_UPDATE);
+		result->write<Misc::UInt16>(Misc::UInt16(valuatorIndex));
+		result->write<Vrui::VRDeviceState::ValuatorState>(state.getValuatorState(valuatorIndex));
+		}
+	
+	return result;
+	}
+
+bool VRDeviceServer::sendStateUpdates(VRDeviceServer::ClientState* client,VRDeviceServer::UpdateBufferPtr updates)
+	{
+	/* Start sending a new update batch: */
+	if(client->pendingUpdates!=updates)
+		{
+		client->pendingUpdates=updates;
+		client->pendingOffset=0;
+		}
+	
+	/* Send the update batch's remaining data directly from its buffer, bypassing the client pipe's write buffer: */
+	const char* data=static_cast<const char*>(updates->getMemory());
+	size_t dataSize=updates->getWriteSize();
+	while(client->pendingOffset<dataSize)
+		{
+		ssize_t sendResult=send(client->pipe.getFd(),data+client->pendingOffset,dataSize-client->pendingOffset,MSG_DONTWAIT|MSG_NOSIGNAL);
+		if(sendResult>0)
+			client->pendingOffset+=size_t(sendResult);
+		else if(errno==EAGAIN||errno==EWOULDBLOCK)
+			{
+			/* Keep the rest of the batch pending until the client's socket becomes writable again: */
+			return false;
+			}
+		else if(errno!=EINTR)
+			Misc::throwStdErr("VRDeviceServer: Fatal error %d (%s) while sending state updates",errno,strerror(errno));
+		}
+	
+	/* The batch has been sent completely: */
+	client->pendingUpdates=0;
+	return true;
+	}
+
+void VRDeviceServer::finishPendingUpdates(VRDeviceServer::ClientState* client)
+	{
+	if(client->pendingUpdates!=0)
+		{
+		/* Write the rest of the pending update batch through the client's pipe, blocking if necessary: */
+		const char* data=static_cast<const char*>(client->pendingUpdates->getMemory());
+		client->pipe.writeRaw(data+client->pendingOffset,client->pendingUpdates->getWriteSize()-client->pendingOffset);
+		client->pipe.flush();
+		client->pendingUpdates=0;
+		}
+	}
+
+bool VRDeviceServer::writeStateUpdates(VRDeviceServer::ClientStateList::iterator csIt,VRDeviceServer::UpdateBufferPtr& updates)
+	{
+	/* Bail out if the client is not streaming, receives states through another transport, or does not understand incremental state updates: */
 	ClientState* client=*csIt;
-	if(!client->streaming||client->protocolVersion<7U)
+	if(!client->streaming||client->streamTransport!=Vrui::VRDevicePipe::STREAM_PIPE||client->protocolVersion<7U)
+		return true;
+	
+	/* Don't queue updates behind a blocked client; instead, send it the full state once it unblocks: */
+	if(client->pendingUpdates!=0)
+		{
+		client->stale=true;
 		return true;
+		}
 	
 	/* Send state updates to client: */
 	try
 		{
-		/* Send tracker state updates: */
-		for(std::vector<int>::iterator utIt=updatedTrackers.begin();utIt!=updatedTrackers.end();++utIt)
-			{
-			/* Send tracker update message: */
-			client->pipe.writeMessage(Vrui::VRDevicePipe::TRACKER_UPDATE);
-			client->pipe.write<Misc::UInt16>(Misc::UInt16(*utIt));
-			Misc::Marshaller<Vrui::VRDeviceState::TrackerState>::write(state.getTrackerState(*utIt),client->pipe);
-			client->pipe.write<Vrui::VRDeviceState::TimeStamp>(state.getTrackerTimeStamp(*utIt));
-			client->pipe.write<Misc::UInt8>(state.getTrackerValid(*utIt)?1U:0U);
-			}
-		
-		/* Send button updates: */
-		for(std::vector<int>::iterator ubIt=updatedButtons.begin();ubIt!=updatedButtons.end();++ubIt)
-			{
-			/* Send button update message: */
-			client->pipe.writeMessage(Vrui::VRDevicePipe::BUTTON_UPDATE);
-			client->pipe.write<Misc::UInt16>(Misc::UInt16(*ubIt));
-			client->pipe.write<Misc::UInt8>(state.getButtonState(*ubIt)?1U:0U);
-			}
-		
-		/* Send valuator updates: */
-		for(std::vector<int>::iterator uvIt=updatedValuators.begin();uvIt!=updatedValuators.end();++uvIt)
-			{
-			/* Send valuator update message: */
-			client->pipe.writeMessage(Vrui::VRDevicePipe::VALUATOR_UPDATE);
-			client->pipe.write<Misc::UInt16>(Misc::UInt16(*uvIt));
-			client->pipe.write<Vrui::VRDeviceState::ValuatorState>(state.getValuatorState(*uvIt));
-			}
+		/* Encode the update batch if this is the first client receiving it: */
+		if(updates==0)
+			updates=encodeStateUpdates(false);
 		
-		/* Finish the message set: */
-		client->pipe.flush();
+		/* Send the update batch and wait for the client's socket to become writable if it could not be sent completely: */
+		if(!sendStateUpdates(client,updates))
+			dispatcher.setIOEventListenerEventTypeMask(client->listenerKey,Threads::EventDispatcher::ReadWrite);
 		}
 	catch(const std::runtime_error& err)
 		{
@@ -487,11 +657,121 @@ bool VRDeviceServer::writeStateUpdates(VRDeviceServer::ClientStateList::iterator
 	return true;
 	}
 
+bool VRDeviceServer::datagramKeyframeTimerCallback(Threads::EventDispatcher::ListenerKey eventKey,void* userData)
+	{
+	VRDeviceServer* thisPtr=static_cast<VRDeviceServer*>(userData);
+	
+	/* Request a keyframe from the run loop: */
+	thisPtr->datagramKeyframeDue=true;
+	
+	return false;
+	}
+
+size_t VRDeviceServer::getUpdateMessageSize(const char* message) const
+	{
+	/* Read the message identifier and component index: */
+	Vrui::VRDevicePipe::MessageIdType messageId;
+	memcpy(&messageId,message,sizeof(Vrui::VRDevicePipe::MessageIdType));
+	Misc::UInt16 index;
+	memcpy(&index,message+sizeof(Vrui::VRDevicePipe::MessageIdType),sizeof(Misc::UInt16));
+	size_t result=sizeof(Vrui::VRDevicePipe::MessageIdType)+sizeof(Misc::UInt16);
+	
+	/* Add the size of the message body, in the same format as written by encodeStateUpdates: */
+	if(messageId==Vrui::VRDevicePipe::TRACKER_UPDATE)
+		result+=Misc::Marshaller<Vrui::VRDeviceState::TrackerState>::getSize(state.getTrackerState(index))+sizeof(Vrui::VRDeviceState::TimeStamp)+sizeof(Misc::UInt8);
+	else if(messageId==Vrui::VRDevicePipe::BUTTON_UPDATE)
+		result+=sizeof(Misc::UInt8);
+	else
+		result+=sizeof(Vrui::VRDeviceState::ValuatorState);
+	
+	return result;
+	}
+
+void VRDeviceServer::sendDatagram(Vrui::VRDevicePipe::DatagramHeader& header,const char* updates,size_t updatesSize)
+	{
+	/* Assemble the datagram from the header and the update messages without copying: */
+	header.sequenceNumber=datagramSequenceNumber;
+	++datagramSequenceNumber;
+	struct iovec parts[2];
+	parts[0].iov_base=&header;
+	parts[0].iov_len=sizeof(Vrui::VRDevicePipe::DatagramHeader);
+	parts[1].iov_base=const_cast<char*>(updates);
+	parts[1].iov_len=updatesSize;
+	struct msghdr datagram;
+	memset(&datagram,0,sizeof(struct msghdr));
+	datagram.msg_iov=parts;
+	datagram.msg_iovlen=2;
+	datagram.msg_namelen=sizeof(Comm::IPv4SocketAddress);
+	
+	/* Datagrams are unreliable; ignore any send errors, and never block on a full socket send buffer: */
+	if(datagramMulticastAddress!=0)
+		{
+		/* Send the datagram once to the multicast group: */
+		datagram.msg_name=datagramMulticastAddress;
+		sendmsg(datagramSocket.getFd(),&datagram,MSG_DONTWAIT);
+		}
+	else
+		{
+		/* Send the datagram to each datagram client individually: */
+		for(ClientStateList::iterator csIt=clientStates.begin();csIt!=clientStates.end();++csIt)
+			if((*csIt)->streaming&&(*csIt)->streamTransport==Vrui::VRDevicePipe::STREAM_DATAGRAM)
+				{
+				datagram.msg_name=(*csIt)->datagramAddress;
+				sendmsg(datagramSocket.getFd(),&datagram,MSG_DONTWAIT);
+				}
+		}
+	}
+
+void VRDeviceServer::sendDatagrams(VRDeviceServer::UpdateBufferPtr& updates,bool keyframe)
+	{
+	/* Encode the full device state if a keyframe is requested or due, or the batch of changes otherwise: */
+	Vrui::VRDevicePipe::DatagramHeader header;
+	header.timeStamp=VRDeviceManager::getTimeStamp();
+	header.flags=0x0U;
+	UpdateBufferPtr datagramUpdates;
+	if(keyframe||numDatagramBatches>=datagramKeyframeInterval)
+		{
+		header.flags|=Vrui::VRDevicePipe::DATAGRAM_KEYFRAME;
+		datagramUpdates=encodeStateUpdates(true);
+		numDatagramBatches=0;
+		}
+	else
+		{
+		if(updates==0)
+			updates=encodeStateUpdates(false);
+		datagramUpdates=updates;
+		}
+	++numDatagramBatches;
+	
+	/* Split the batch into as many datagrams as needed, each containing only complete update messages with absolute values: */
+	const char* data=static_cast<const char*>(datagramUpdates->getMemory());
+	size_t dataSize=datagramUpdates->getWriteSize();
+	size_t maxUpdatesSize=Vrui::VRDevicePipe::maxDatagramSize-sizeof(Vrui::VRDevicePipe::DatagramHeader);
+	size_t begin=0;
+	do
+		{
+		/* Collect as many complete update messages as fit into a single datagram: */
+		size_t end=begin;
+		while(end<dataSize)
+			{
+			size_t messageSize=getUpdateMessageSize(data+end);
+			if(end+messageSize-begin>maxUpdatesSize)
+				break;
+			end+=messageSize;
+			}
+		
+		/* Send the datagram: */
+		sendDatagram(header,data+begin,end-begin);
+		begin=end;
+		}
+	while(begin<dataSize);
+	}
+
 bool VRDeviceServer::writeServerState(VRDeviceServer::ClientStateList::iterator csIt)
 	{
-	/* Bail out if the client is not streaming or understands incremental state updates: */
+	/* Bail out if the client is not streaming, receives states through another transport, or understands incremental state updates: */
 	ClientState* client=*csIt;
-	if(client->protocolVersion>=7U||!client->streaming)
+	if(client->protocolVersion>=7U||!client->streaming||client->streamTransport!=Vrui::VRDevicePipe::STREAM_PIPE)
 		return true;
 	
 	/* Send state to client: */
@@ -524,6 +804,9 @@ bool VRDeviceServer::writeBatteryState(VRDeviceServer::ClientStateList::iterator
 	/* Send battery state to client: */
 	try
 		{
+		/* Finish sending any pending update batch: */
+		finishPendingUpdates(client);
+		
 		/* Send battery state update message: */
 		client->pipe.writeMessage(Vrui::VRDevicePipe::BATTERYSTATE_UPDATE);
 		
@@ -553,6 +836,9 @@ bool VRDeviceServer::writeHmdConfiguration(VRDeviceServer::ClientStateList::iter
 	
 	try
 		{
+		/* Finish sending any pending update batch: */
+		finishPendingUpdates(client);
+		
 		/* Send HMD configuration to client: */
 		hmdConfigurationVersions.hmdConfiguration->write(hmdConfigurationVersions.eyePosVersion,hmdConfigurationVersions.eyeVersion,hmdConfigurationVersions.distortionMeshVersion,client->pipe);
 		client->pipe.flush();
@@ -570,6 +856,11 @@ bool VRDeviceServer::writeHmdConfiguration(VRDeviceServer::ClientStateList::iter
 VRDeviceServer::VRDeviceServer(VRDeviceManager* sDeviceManager,const Misc::ConfigurationFile& configFile)
 	:VRDeviceManager::VRStreamer(sDeviceManager),
 	 listenSocket(configFile.retrieveValue<int>("./serverPort",-1),5),
+	 sharedState(0),
+	 datagramSocket(-1,0),
+	 datagramMulticastGroup(configFile.retrieveString("./datagramMulticastGroup","")),datagramMulticastAddress(0),
+	 datagramKeyframeInterval(configFile.retrieveValue<unsigned int>("./datagramKeyframeInterval",30U)),
+	 numDatagramClients(0),datagramSequenceNumber(0U),numDatagramBatches(0U),datagramKeyframeDue(false),
 	 numActiveClients(0),numStreamingClients(0),
 	 haveUpdates(false),
 	 managerTrackerStateVersion(0U),streamingTrackerStateVersion(0U),
@@ -587,6 +878,54 @@ VRDeviceServer::VRDeviceServer(VRDeviceManager* sDeviceManager,const Misc::Confi
 	hmdConfigurationVersions=new HMDConfigurationVersions[numHmdConfigurations];
 	for(unsigned int i=0;i<hmdConfigurations.size();++i)
 		hmdConfigurationVersions[i].hmdConfiguration=hmdConfigurations[i];
+	
+	/* Prepare sending device state update datagrams: */
+	if(datagramKeyframeInterval==0U)
+		datagramKeyframeInterval=1U;
+	if(!datagramMulticastGroup.empty())
+		{
+		/* Send datagrams to the configured multicast group: */
+		datagramMulticastAddress=new Comm::IPv4SocketAddress(configFile.retrieveValue<int>("./datagramMulticastPort",listenSocket.getPortId()),Comm::IPv4Address(datagramMulticastGroup.c_str()));
+		datagramSocket.setMulticastTTL(configFile.retrieveValue<unsigned int>("./datagramMulticastTTL",1U));
+		datagramSocket.setMulticastLoopback(true);
+		if(configFile.hasTag("./datagramMulticastInterface"))
+			datagramSocket.setMulticastInterface(Comm::IPv4Address(configFile.retrieveString("./datagramMulticastInterface").c_str()));
+		}
+	
+	/* Periodically send the full device state to datagram clients, to repair lost datagrams even while the device state does not change: */
+	double datagramKeyframePeriod=configFile.retrieveValue<double>("./datagramKeyframePeriod",0.5);
+	if(datagramKeyframePeriod>0.0)
+		{
+		Threads::EventDispatcher::Time period(datagramKeyframePeriod);
+		Threads::EventDispatcher::Time firstTime=Threads::EventDispatcher::Time::now();
+		firstTime+=period;
+		dispatcher.addTimerEventListener(firstTime,period,datagramKeyframeTimerCallback,this);
+		}
+	
+	/* Check if the device state should be published to local clients through shared memory: */
+	if(configFile.retrieveValue<bool>("./enableSharedMemory",true))
+		{
+		/* Create a shared memory segment whose name is derived from the listening port: */
+		std::string sharedStateName="/VRDeviceDaemon-";
+		char portId[10];
+		sharedStateName.append(Misc::print(listenSocket.getPortId(),portId+sizeof(portId)-1));
+		try
+			{
+			Threads::Mutex::Lock stateLock(stateMutex);
+			sharedState=new Vrui::VRDeviceSharedState(sharedStateName.c_str(),state);
+			
+			#ifdef VERBOSE
+			printf("VRDeviceServer: Publishing device state in shared memory segment %s\n",sharedStateName.c_str());
+			fflush(stdout);
+			#endif
+			}
+		catch(const std::runtime_error& err)
+			{
+			/* Disable shared memory and carry on: */
+			fprintf(stderr,"VRDeviceServer: Disabling shared memory due to exception %s\n",err.what());
+			fflush(stderr);
+			}
+		}
 	}
 
 VRDeviceServer::~VRDeviceServer(void)
@@ -602,6 +941,8 @@ VRDeviceServer::~VRDeviceServer(void)
 	/* Clean up: */
 	delete[] batteryStateVersions;
 	delete[] hmdConfigurationVersions;
+	delete sharedState;
+	delete datagramMulticastAddress;
 	}
 
 void VRDeviceServer::trackerUpdated(int trackerIndex)
@@ -664,18 +1005,30 @@ void VRDeviceServer::run(void)
 	while(dispatcher.dispatchNextEvent())
 		{
 		/* Check if any streaming update needs to be sent: */
-		if(numStreamingClients>0&&(haveUpdates||streamingTrackerStateVersion!=managerTrackerStateVersion))
+		if((numStreamingClients>0||sharedState!=0)&&(haveUpdates||streamingTrackerStateVersion!=managerTrackerStateVersion))
 			{
 			Threads::Mutex::Lock stateLock(stateMutex);
 			
+			/* Publish the current device state to shared memory clients: */
+			if(sharedState!=0)
+				sharedState->write(state);
+			
 			/* Check if any incremental device state updates need to be sent: */
 			if(haveUpdates)
 				{
-				/* Send incremental updates to all clients in streaming mode: */
+				/* Send incremental updates to all clients in streaming mode, encoding them only once: */
+				UpdateBufferPtr updates;
 				for(ClientStateList::iterator csIt=clientStates.begin();csIt!=clientStates.end();++csIt)
-					if(!writeStateUpdates(csIt))
+					if(!writeStateUpdates(csIt,updates))
 						--csIt;
 				
+				/* Send incremental updates or a keyframe to all datagram clients: */
+				if(numDatagramClients>0)
+					{
+					sendDatagrams(updates,datagramKeyframeDue);
+					datagramKeyframeDue=false;
+					}
+				
 				/* Reset the update arrays: */
 				haveUpdates=false;
 				updatedTrackers.clear();
@@ -696,6 +1049,18 @@ void VRDeviceServer::run(void)
 				}
 			}
 		
+		/* Send a periodic keyframe to datagram clients if no update batch carried it: */
+		if(datagramKeyframeDue)
+			{
+			datagramKeyframeDue=false;
+			if(numDatagramClients>0)
+				{
+				Threads::Mutex::Lock stateLock(stateMutex);
+				UpdateBufferPtr updates;
+				sendDatagrams(updates,true);
+				}
+			}
+		
 		/* Check if any device battery states need to be sent: */
 		if(streamingBatteryStateVersion!=managerBatteryStateVersion)
 			{
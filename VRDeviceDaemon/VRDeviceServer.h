@@ -23,8 +23,11 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <string>
 #include <vector>
+#include <Misc/Autopointer.h>
 #include <Threads/EventDispatcher.h>
+#include <IO/FixedMemoryFile.h>
 #include <Comm/ListeningTCPSocket.h>
+#include <Comm/UDPSocket.h>
 #include <Vrui/Internal/VRDevicePipe.h>
 
 #include <VRDeviceDaemon/VRDeviceManager.h>
@@ -33,15 +36,21 @@ Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 namespace Misc {
 class ConfigurationFile;
 }
+namespace Comm {
+class IPv4SocketAddress;
+}
 namespace Vrui {
 class BatteryState;
 class HMDConfiguration;
+class VRDeviceSharedState;
 }
 
 class VRDeviceServer:public VRDeviceManager::VRStreamer
 	{
 	/* Embedded classes: */
 	private:
+	typedef Misc::Autopointer<IO::FixedMemoryFile> UpdateBufferPtr; // Type for pointers to pre-encoded device state update batches shared between all streaming clients
+	
 	struct ClientState // Class containing state of connected client
 		{
 		/* Elements: */
@@ -58,9 +67,15 @@ class VRDeviceServer:public VRDeviceManager::VRStreamer
 		bool clientExpectsValidFlags; // Flag whether the connected client expects to receive tracker valid flags
 		bool active; // Flag whether the client is currently active
 		bool streaming; // Flag whether client is currently in streaming mode
+		int streamTransport; // Transport over which the client receives streamed device state updates
+		Comm::IPv4SocketAddress* datagramAddress; // Socket address to which to send device state datagrams if the client receives unicast datagrams, or null
+		UpdateBufferPtr pendingUpdates; // Update batch that could only be partially sent to the client because its socket send buffer was full
+		size_t pendingOffset; // Amount of data from the pending update batch that has already been sent
+		bool stale; // Flag whether the client missed update batches while it was blocked, and needs to receive the full device state once it unblocks
 		
 		/* Constructors and destructors: */
 		ClientState(VRDeviceServer* sServer,Comm::ListeningTCPSocket& listenSocket); // Accepts next incoming connection on given listening socket and establishes VR device connection
+		~ClientState(void);
 		};
 	
 	typedef std::vector<ClientState*> ClientStateList; // Data type for lists of states of connected clients
@@ -98,6 +113,15 @@ class VRDeviceServer:public VRDeviceManager::VRStreamer
 	private:
 	Threads::EventDispatcher dispatcher; // Event dispatcher to handle communication with multiple clients in parallel
 	Comm::ListeningTCPSocket listenSocket; // Main socket the server listens on for incoming connections
+	Vrui::VRDeviceSharedState* sharedState; // Shared memory segment publishing the device state to clients on the same host, or null if disabled
+	Comm::UDPSocket datagramSocket; // Socket to send device state update datagrams to streaming clients
+	std::string datagramMulticastGroup; // Address of the multicast group to which to send device state update datagrams, or empty to send unicast datagrams to each client
+	Comm::IPv4SocketAddress* datagramMulticastAddress; // Socket address of the multicast group, or null if datagrams are sent unicast
+	unsigned int datagramKeyframeInterval; // Number of update batches after which to send the full device state instead of a batch of changes
+	int numDatagramClients; // Number of streaming clients that receive device state updates as datagrams
+	Misc::UInt32 datagramSequenceNumber; // Sequence number for the next device state update datagram
+	unsigned int numDatagramBatches; // Number of update batches sent as datagrams since the most recent keyframe
+	bool datagramKeyframeDue; // Flag set by a periodic timer to send the full device state to datagram clients even if the device state did not change
 	ClientStateList clientStates; // List of currently connected clients
 	int numActiveClients; // Number of clients that are currently active
 	int numStreamingClients; // Number of clients that are currently streaming
@@ -120,7 +144,14 @@ class VRDeviceServer:public VRDeviceManager::VRStreamer
 	void disconnectClient(ClientState* client,bool removeListener,bool removeFromList); // Disconnects the given client due to a communication error; removes listener and/or dead client from list if respective flags are true
 	static bool clientMessageCallback(Threads::EventDispatcher::ListenerKey eventKey,int eventType,void* userData); // Callback called when a message from a client arrives
 	void disconnectClientOnError(ClientStateList::iterator csIt,const std::runtime_error& err); // Forcefully disconnects a client after a communication error
-	bool writeStateUpdates(ClientStateList::iterator csIt); // Writes changes in the device manager's device state to the given client; returns false on error
+	UpdateBufferPtr encodeStateUpdates(bool fullState); // Encodes the device manager's (locked) changed or full device state into a new update batch
+	bool sendStateUpdates(ClientState* client,UpdateBufferPtr updates); // Sends as much of the given update batch to the given client as possible without blocking and keeps the rest pending; returns true if the batch was sent completely
+	void finishPendingUpdates(ClientState* client); // Blocks until any partially sent update batch has been sent completely to the given client
+	bool writeStateUpdates(ClientStateList::iterator csIt,UpdateBufferPtr& updates); // Writes the given batch of changes in the device manager's device state to the given client, encoding the batch first if it is null; returns false on error
+	static bool datagramKeyframeTimerCallback(Threads::EventDispatcher::ListenerKey eventKey,void* userData); // Callback called periodically to request a keyframe for datagram clients
+	size_t getUpdateMessageSize(const char* message) const; // Returns the size of the encoded update message starting at the given position in an update batch
+	void sendDatagram(Vrui::VRDevicePipe::DatagramHeader& header,const char* updates,size_t updatesSize); // Sends a single datagram with the given header and update messages to all datagram clients, and advances the header's sequence number
+	void sendDatagrams(UpdateBufferPtr& updates,bool keyframe); // Sends the given batch of changes, or the full device state if the flag is true or a keyframe is due, as datagrams to all datagram clients, encoding the batch first if it is null
 	bool writeServerState(ClientStateList::iterator csIt); // Writes the device manager's current (locked) state to the given client; returns false on error
 	bool writeBatteryState(ClientStateList::iterator csIt,unsigned int deviceIndex); // Writes the device manager's given battery state to the given client; returns false on error
 	bool writeHmdConfiguration(ClientStateList::iterator csIt,HMDConfigurationVersions& hmdConfigurationVersions); // Writes the given HMD configuration to the given client; returns false on error
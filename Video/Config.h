@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #define VIDEO_CONFIG_INCLUDED
 
 #define VIDEO_CONFIG_HAVE_V4L2 1
-#define VIDEO_CONFIG_HAVE_DC1394 1
-#define VIDEO_CONFIG_HAVE_THEORA 1
+#define VIDEO_CONFIG_HAVE_DC1394 0
+#define VIDEO_CONFIG_HAVE_THEORA 0
 
 #endif
@@ -0,0 +1,335 @@
+/***********************************************************************
+FrameProfiler - Low-overhead instrumentation to record the durations of
+the phases of Vrui frames into per-thread ring buffers, to export them
+as timelines, and to summarize them for in-VR display.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/FrameProfiler.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <Misc/ThrowStdErr.h>
+#include <Realtime/Time.h>
+#include <Threads/Mutex.h>
+
+namespace Vrui {
+
+/**********************************************
+Declaration of struct FrameProfiler::ThreadBuffer:
+**********************************************/
+
+struct FrameProfiler::ThreadBuffer
+	{
+	/* Elements: */
+	public:
+	std::string name; // Name under which the thread's events are exported
+	unsigned int threadIndex; // Index of the thread in order of first recorded event
+	size_t capacity; // Number of events retained in the ring buffer
+	Event* events; // The ring buffer of events
+	volatile size_t numRecorded; // Total number of events recorded by the thread so far
+	
+	/* Constructors and destructors: */
+	ThreadBuffer(const char* sName,unsigned int sThreadIndex,size_t sCapacity)
+		:threadIndex(sThreadIndex),capacity(sCapacity),events(new Event[capacity]),numRecorded(0)
+		{
+		if(sName!=0)
+			name=sName;
+		else
+			{
+			char nameBuffer[32];
+			snprintf(nameBuffer,sizeof(nameBuffer),"Thread %u",threadIndex);
+			name=nameBuffer;
+			}
+		}
+	~ThreadBuffer(void)
+		{
+		delete[] events;
+		}
+	
+	/* Methods: */
+	void snapshot(std::vector<Event>& result,unsigned int firstFrameIndex,unsigned int numFrames) const // Appends a consistent copy of the currently retained events recorded during the given range of frames to the given list
+		{
+		/* Find the range of potentially valid events: */
+		size_t end=numRecorded;
+		__sync_synchronize();
+		size_t begin=end>capacity?end-capacity:0;
+		
+		/* Find the oldest event in the frame range by walking backwards from the newest event: */
+		size_t first=end;
+		while(first>begin&&events[(first-1)%capacity].frameIndex-firstFrameIndex<numFrames)
+			--first;
+		
+		/* Copy the events: */
+		size_t resultBase=result.size();
+		for(size_t i=first;i<end;++i)
+			result.push_back(events[i%capacity]);
+		
+		/* Discard the events that might have been overwritten while copying: */
+		__sync_synchronize();
+		size_t newEnd=numRecorded;
+		if(newEnd+1>first+capacity)
+			{
+			size_t numInvalid=newEnd+1-(first+capacity);
+			if(numInvalid>end-first)
+				numInvalid=end-first;
+			result.erase(result.begin()+resultBase,result.begin()+resultBase+numInvalid);
+			}
+		}
+	};
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+struct ThreadBufferList // Structure holding the event buffers of all threads that recorded events
+	{
+	/* Elements: */
+	public:
+	Threads::Mutex mutex; // Mutex serializing access to the list
+	std::vector<FrameProfiler::ThreadBuffer*> buffers; // List of thread buffers
+	size_t bufferSize; // Number of events retained per thread for new threads
+	
+	/* Constructors and destructors: */
+	ThreadBufferList(void)
+		:bufferSize(65536)
+		{
+		}
+	~ThreadBufferList(void)
+		{
+		for(std::vector<FrameProfiler::ThreadBuffer*>::iterator bIt=buffers.begin();bIt!=buffers.end();++bIt)
+			delete *bIt;
+		}
+	};
+
+ThreadBufferList threadBufferList;
+__thread FrameProfiler::ThreadBuffer* localThreadBuffer=0;
+__thread const char* localThreadName=0;
+
+void writeJsonString(FILE* file,const char* string) // Writes a string as a quoted JSON string
+	{
+	fputc('\"',file);
+	for(const char* sPtr=string;*sPtr!='\0';++sPtr)
+		{
+		if(*sPtr=='\"'||*sPtr=='\\')
+			fputc('\\',file);
+		if((unsigned char)(*sPtr)>=0x20U)
+			fputc(*sPtr,file);
+		}
+	fputc('\"',file);
+	}
+
+}
+
+/**************************************
+Static elements of class FrameProfiler:
+**************************************/
+
+volatile bool FrameProfiler::enabled=false;
+volatile unsigned int FrameProfiler::frameIndex=0;
+
+/******************************
+Methods of class FrameProfiler:
+******************************/
+
+FrameProfiler::ThreadBuffer* FrameProfiler::getThreadBuffer(void)
+	{
+	if(localThreadBuffer==0)
+		{
+		/* Create and register a new buffer for the calling thread: */
+		Threads::Mutex::Lock listLock(threadBufferList.mutex);
+		localThreadBuffer=new ThreadBuffer(localThreadName,threadBufferList.buffers.size(),threadBufferList.bufferSize);
+		threadBufferList.buffers.push_back(localThreadBuffer);
+		}
+	
+	return localThreadBuffer;
+	}
+
+FrameProfiler::TimeStamp FrameProfiler::getTimeStamp(void)
+	{
+	Realtime::TimePointMonotonic now;
+	return TimeStamp(now.tv_sec)*TimeStamp(1000000000)+TimeStamp(now.tv_nsec);
+	}
+
+void FrameProfiler::setEnabled(bool newEnabled)
+	{
+	enabled=newEnabled;
+	}
+
+void FrameProfiler::setBufferSize(unsigned int newBufferSize)
+	{
+	Threads::Mutex::Lock listLock(threadBufferList.mutex);
+	threadBufferList.bufferSize=newBufferSize>0?newBufferSize:1;
+	}
+
+void FrameProfiler::setThreadName(const char* newThreadName)
+	{
+	/* Remember the name for when the calling thread records its first event: */
+	localThreadName=newThreadName;
+	
+	/* Rename the calling thread's buffer if it already exists: */
+	if(localThreadBuffer!=0)
+		{
+		Threads::Mutex::Lock listLock(threadBufferList.mutex);
+		localThreadBuffer->name=newThreadName;
+		}
+	}
+
+void FrameProfiler::startFrame(void)
+	{
+	++frameIndex;
+	}
+
+void FrameProfiler::record(const char* phase,unsigned int beginFrameIndex,FrameProfiler::TimeStamp begin,FrameProfiler::TimeStamp end)
+	{
+	/* Write the event into the calling thread's ring buffer and publish it: */
+	ThreadBuffer* tb=getThreadBuffer();
+	Event& event=tb->events[tb->numRecorded%tb->capacity];
+	event.phase=phase;
+	event.frameIndex=beginFrameIndex;
+	event.begin=begin;
+	event.end=end;
+	__sync_synchronize();
+	++tb->numRecorded;
+	}
+
+void FrameProfiler::getPhaseStatistics(unsigned int numFrames,FrameProfiler::PhaseStatisticsList& statistics)
+	{
+	statistics.clear();
+	if(numFrames==0)
+		return;
+	
+	/* Collect the events of all threads that were recorded during the requested range of completed frames: */
+	unsigned int firstFrame=frameIndex-numFrames;
+	std::vector<Event> events;
+	{
+	Threads::Mutex::Lock listLock(threadBufferList.mutex);
+	for(std::vector<ThreadBuffer*>::iterator bIt=threadBufferList.buffers.begin();bIt!=threadBufferList.buffers.end();++bIt)
+		(*bIt)->snapshot(events,firstFrame,numFrames+1);
+	}
+	
+	/* Accumulate the per-frame durations of all phases: */
+	std::vector<std::vector<double> > frameDurations;
+	for(std::vector<Event>::iterator eIt=events.begin();eIt!=events.end();++eIt)
+		{
+		/* Skip events outside the frame range: */
+		unsigned int frameOffset=eIt->frameIndex-firstFrame;
+		if(frameOffset>=numFrames)
+			continue;
+		
+		/* Find the event's phase in the statistics list: */
+		size_t phaseIndex;
+		for(phaseIndex=0;phaseIndex<statistics.size()&&statistics[phaseIndex].phase!=eIt->phase&&strcmp(statistics[phaseIndex].phase,eIt->phase)!=0;++phaseIndex)
+			;
+		if(phaseIndex==statistics.size())
+			{
+			/* Start a new phase: */
+			PhaseStatistics ps;
+			ps.phase=eIt->phase;
+			ps.numFrames=0;
+			ps.average=0.0;
+			ps.max=0.0;
+			statistics.push_back(ps);
+			frameDurations.push_back(std::vector<double>(numFrames,-1.0));
+			}
+		
+		/* Add the event's duration to its frame: */
+		double& fd=frameDurations[phaseIndex][frameOffset];
+		if(fd<0.0)
+			fd=0.0;
+		fd+=double(eIt->end-eIt->begin)*1.0e-9;
+		}
+	
+	/* Calculate the per-phase averages and maxima: */
+	for(size_t phaseIndex=0;phaseIndex<statistics.size();++phaseIndex)
+		{
+		PhaseStatistics& ps=statistics[phaseIndex];
+		double sum=0.0;
+		for(std::vector<double>::iterator fdIt=frameDurations[phaseIndex].begin();fdIt!=frameDurations[phaseIndex].end();++fdIt)
+			if(*fdIt>=0.0)
+				{
+				++ps.numFrames;
+				sum+=*fdIt;
+				if(ps.max<*fdIt)
+					ps.max=*fdIt;
+				}
+		ps.average=sum/double(ps.numFrames);
+		}
+	}
+
+void FrameProfiler::writeChromeTrace(const char* fileName)
+	{
+	FILE* file=fopen(fileName,"w");
+	if(file==0)
+		Misc::throwStdErr("Vrui::FrameProfiler::writeChromeTrace: Unable to open output file %s",fileName);
+	
+	/* Collect the retained events and names of all threads: */
+	std::vector<std::vector<Event> > threadEvents;
+	std::vector<std::string> threadNames;
+	{
+	Threads::Mutex::Lock listLock(threadBufferList.mutex);
+	for(std::vector<ThreadBuffer*>::iterator bIt=threadBufferList.buffers.begin();bIt!=threadBufferList.buffers.end();++bIt)
+		{
+		threadEvents.push_back(std::vector<Event>());
+		(*bIt)->snapshot(threadEvents.back(),0U,~0U);
+		threadNames.push_back((*bIt)->name);
+		}
+	}
+	
+	/* Find the earliest event to serve as the trace's time origin: */
+	TimeStamp origin=0;
+	bool haveOrigin=false;
+	for(std::vector<std::vector<Event> >::iterator teIt=threadEvents.begin();teIt!=threadEvents.end();++teIt)
+		for(std::vector<Event>::iterator eIt=teIt->begin();eIt!=teIt->end();++eIt)
+			if(!haveOrigin||origin>eIt->begin)
+				{
+				origin=eIt->begin;
+				haveOrigin=true;
+				}
+	
+	/* Write thread names as metadata events, followed by all complete events, with time stamps in microseconds: */
+	fprintf(file,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	bool first=true;
+	for(size_t threadIndex=0;threadIndex<threadEvents.size();++threadIndex)
+		{
+		fprintf(file,"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",first?"":",",(unsigned int)threadIndex);
+		writeJsonString(file,threadNames[threadIndex].c_str());
+		fprintf(file,"}}");
+		first=false;
+		
+		for(std::vector<Event>::iterator eIt=threadEvents[threadIndex].begin();eIt!=threadEvents[threadIndex].end();++eIt)
+			{
+			fprintf(file,",\n{\"name\":");
+			writeJsonString(file,eIt->phase);
+			fprintf(file,",\"cat\":\"Vrui\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",(unsigned int)threadIndex,double(eIt->begin-origin)*1.0e-3,double(eIt->end-eIt->begin)*1.0e-3,eIt->frameIndex);
+			}
+		}
+	fprintf(file,"\n]}\n");
+	
+	bool writeError=ferror(file)!=0;
+	fclose(file);
+	if(writeError)
+		Misc::throwStdErr("Vrui::FrameProfiler::writeChromeTrace: Error while writing to output file %s",fileName);
+	}
+
+}
@@ -0,0 +1,113 @@
+/***********************************************************************
+FrameProfiler - Low-overhead instrumentation to record the durations of
+the phases of Vrui frames into per-thread ring buffers, to export them
+as timelines, and to summarize them for in-VR display.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_FRAMEPROFILER_INCLUDED
+#define VRUI_FRAMEPROFILER_INCLUDED
+
+#include <vector>
+#include <Misc/SizedTypes.h>
+
+namespace Vrui {
+
+class FrameProfiler
+	{
+	/* Embedded classes: */
+	public:
+	typedef Misc::SInt64 TimeStamp; // Type for monotonic time stamps in nanoseconds
+	
+	struct Event // Structure for a recorded frame phase
+		{
+		/* Elements: */
+		public:
+		const char* phase; // Name of the phase; must be a string with static storage duration
+		unsigned int frameIndex; // Index of the frame during which the phase began
+		TimeStamp begin,end; // Time stamps of the beginning and end of the phase
+		};
+	
+	class Scope // Class to record a phase for the lifetime of an object
+		{
+		/* Elements: */
+		private:
+		const char* phase; // Name of the recorded phase
+		unsigned int beginFrameIndex; // Index of the frame during which the phase began
+		TimeStamp begin; // Time stamp at which the phase began, or 0 if profiling was disabled
+		
+		/* Constructors and destructors: */
+		public:
+		Scope(const char* sPhase) // Begins recording the given phase if profiling is enabled
+			:phase(sPhase),beginFrameIndex(frameIndex),begin(enabled?getTimeStamp():0)
+			{
+			}
+		~Scope(void) // Ends recording the phase
+			{
+			if(begin!=0)
+				record(phase,beginFrameIndex,begin,getTimeStamp());
+			}
+		};
+	
+	struct PhaseStatistics // Structure summarizing the durations of one phase over a range of frames
+		{
+		/* Elements: */
+		public:
+		const char* phase; // Name of the phase
+		unsigned int numFrames; // Number of frames during which the phase occurred
+		double average; // Average total duration of the phase per frame in which it occurred, in seconds
+		double max; // Maximum total duration of the phase in any single frame, in seconds
+		};
+	
+	typedef std::vector<PhaseStatistics> PhaseStatisticsList;
+	
+	struct ThreadBuffer; // Structure for a thread's ring buffer of recorded events
+	
+	/* Elements: */
+	private:
+	static volatile bool enabled; // Flag whether phases are currently being recorded
+	static volatile unsigned int frameIndex; // Index of the current frame
+	
+	/* Private methods: */
+	static ThreadBuffer* getThreadBuffer(void); // Returns the calling thread's event buffer; creates it if it doesn't exist yet
+	
+	/* Methods: */
+	public:
+	static TimeStamp getTimeStamp(void); // Returns the current monotonic time stamp
+	static bool isEnabled(void) // Returns true if phases are currently being recorded
+		{
+		return enabled;
+		}
+	static void setEnabled(bool newEnabled); // Enables or disables recording
+	static void setBufferSize(unsigned int newBufferSize); // Sets the number of events retained per thread for threads that have not recorded any events yet
+	static void setThreadName(const char* newThreadName); // Sets the name under which the calling thread's events are exported; name must be a string with static storage duration
+	static void startFrame(void); // Advances the current frame index; called by the main thread at the beginning of each frame
+	static unsigned int getFrameIndex(void) // Returns the index of the current frame
+		{
+		return frameIndex;
+		}
+	static void record(const char* phase,unsigned int beginFrameIndex,TimeStamp begin,TimeStamp end); // Records a phase that began during the frame of the given index for the calling thread
+	static void getPhaseStatistics(unsigned int numFrames,PhaseStatisticsList& statistics); // Summarizes the phases of the given number of most recently completed frames across all threads
+	static void writeChromeTrace(const char* fileName); // Writes all retained events of all threads to a JSON file in Chrome's trace event format
+	};
+
+}
+
+#endif
@@ -23,9 +23,11 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <Vrui/Internal/MultipipeDispatcher.h>
 
+#include <string.h>
 #include <Misc/ThrowStdErr.h>
 #include <Misc/Marshaller.h>
 #include <Misc/StringMarshaller.h>
+#include <Math/Math.h>
 #include <Cluster/MulticastPipe.h>
 #include <GL/GLMarshallers.h>
 #include <Vrui/InputDevice.h>
@@ -36,6 +38,52 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 namespace Vrui {
 
+namespace {
+
+/****************
+Helper constants:
+****************/
+
+enum UpdateFlags // Enumerated type for flags describing an input device state update
+	{
+	KeyframeUpdate=0x1, // Update contains the full state of all input devices
+	QuantizedValuators=0x2, // Valuator values are sent as 16-bit fixed-point numbers
+	QuantizedOrientations=0x4 // Input device orientations are sent as 16-bit fixed-point quaternions
+	};
+
+enum DeviceChanges // Enumerated type for bit masks of changed input device state components
+	{
+	TrackingChanged=0x1,
+	ButtonsChanged=0x2,
+	ValuatorsChanged=0x4,
+	AllChanged=0x7
+	};
+
+/****************
+Helper functions:
+****************/
+
+inline Misc::SInt16 quantize(double value) // Converts a value in [-1, 1] to 16-bit fixed point
+	{
+	if(value<-1.0)
+		value=-1.0;
+	else if(value>1.0)
+		value=1.0;
+	return Misc::SInt16(Math::floor(value*32767.0+0.5));
+	}
+
+inline double dequantize(Misc::SInt16 value) // Converts a 16-bit fixed-point value to a value in [-1, 1]
+	{
+	return double(value)/32767.0;
+	}
+
+inline Rotation dequantizeOrientation(const Misc::SInt16 quaternion[4]) // Converts a 16-bit fixed-point quaternion to a rotation
+	{
+	return Rotation::fromQuaternion(dequantize(quaternion[0]),dequantize(quaternion[1]),dequantize(quaternion[2]),dequantize(quaternion[3]));
+	}
+
+}
+
 /************************************
 Methods of class MultipipeDispatcher:
 ************************************/
@@ -45,9 +93,13 @@ MultipipeDispatcher::MultipipeDispatcher(InputDeviceManager* sInputDeviceManager
 	 pipe(sPipe),
 	 totalNumButtons(0),
 	 totalNumValuators(0),
+	 keyframeInterval(60),framesToKeyframe(0),
+	 quantizeValuators(false),quantizeOrientations(false),
 	 trackingStates(0),
 	 buttonStates(0),
-	 valuatorStates(0)
+	 valuatorStates(0),
+	 deviceChanges(0),
+	 quantizedOrientations(0)
 	{
 	if(pipe->isMaster())
 		{
@@ -152,6 +204,8 @@ MultipipeDispatcher::MultipipeDispatcher(InputDeviceManager* sInputDeviceManager
 	trackingStates=new InputDeviceTrackingState[numInputDevices];
 	buttonStates=new bool[totalNumButtons];
 	valuatorStates=new double[totalNumValuators];
+	deviceChanges=new Misc::UInt8[numInputDevices];
+	quantizedOrientations=new Misc::SInt16[numInputDevices*4];
 	}
 
 MultipipeDispatcher::~MultipipeDispatcher(void)
@@ -166,6 +220,8 @@ MultipipeDispatcher::~MultipipeDispatcher(void)
 	delete[] trackingStates;
 	delete[] buttonStates;
 	delete[] valuatorStates;
+	delete[] deviceChanges;
+	delete[] quantizedOrientations;
 	}
 
 std::string MultipipeDispatcher::getFeatureName(const InputDeviceFeature& feature) const
@@ -241,49 +297,241 @@ void MultipipeDispatcher::updateInputDevices(void)
 	{
 	if(pipe->isMaster())
 		{
-		/* Gather the current state of all input devices: */
+		/* Check whether to send a full update of all input device states: */
+		bool keyframe=framesToKeyframe==0;
+		framesToKeyframe=keyframe?keyframeInterval-1:framesToKeyframe-1;
+		
+		/* Compare the current state of all input devices to the state last sent to the slave nodes: */
 		bool* bsPtr=buttonStates;
 		double* vsPtr=valuatorStates;
 		for(int i=0;i<numInputDevices;++i)
 			{
-			trackingStates[i].deviceRayDirection=inputDevices[i]->getDeviceRayDirection();
-			trackingStates[i].deviceRayStart=inputDevices[i]->getDeviceRayStart();
-			trackingStates[i].transformation=inputDevices[i]->getTransformation();
-			trackingStates[i].linearVelocity=inputDevices[i]->getLinearVelocity();
-			trackingStates[i].angularVelocity=inputDevices[i]->getAngularVelocity();
-			for(int j=0;j<inputDevices[i]->getNumButtons();++j,++bsPtr)
-				*bsPtr=inputDevices[i]->getButtonState(j);
-			for(int j=0;j<inputDevices[i]->getNumValuators();++j,++vsPtr)
-				*vsPtr=inputDevices[i]->getValuator(j);
+			InputDevice* device=inputDevices[i];
+			Misc::UInt8 changes=keyframe?Misc::UInt8(AllChanged):Misc::UInt8(0);
+			
+			/* Get the device's tracking state as the slave nodes will receive it: */
+			InputDeviceTrackingState ts;
+			ts.deviceRayDirection=device->getDeviceRayDirection();
+			ts.deviceRayStart=device->getDeviceRayStart();
+			ts.transformation=device->getTransformation();
+			ts.linearVelocity=device->getLinearVelocity();
+			ts.angularVelocity=device->getAngularVelocity();
+			if(quantizeOrientations)
+				{
+				Misc::SInt16* qoPtr=quantizedOrientations+i*4;
+				const Scalar* q=ts.transformation.getRotation().getQuaternion();
+				for(int j=0;j<4;++j)
+					qoPtr[j]=quantize(q[j]);
+				ts.transformation=TrackerState(ts.transformation.getTranslation(),dequantizeOrientation(qoPtr));
+				
+				/* Use the quantized orientation on the master node as well to keep it in sync with the slave nodes: */
+				device->setTransformation(ts.transformation);
+				}
+			if(memcmp(&ts,&trackingStates[i],sizeof(InputDeviceTrackingState))!=0)
+				{
+				trackingStates[i]=ts;
+				changes|=TrackingChanged;
+				}
+			
+			for(int j=0;j<device->getNumButtons();++j,++bsPtr)
+				{
+				bool buttonState=device->getButtonState(j);
+				if(*bsPtr!=buttonState)
+					{
+					*bsPtr=buttonState;
+					changes|=ButtonsChanged;
+					}
+				}
+			
+			for(int j=0;j<device->getNumValuators();++j,++vsPtr)
+				{
+				double valuatorState=device->getValuator(j);
+				if(quantizeValuators)
+					{
+					/* Use the quantized valuator value on the master node as well to keep it in sync with the slave nodes: */
+					valuatorState=dequantize(quantize(valuatorState));
+					device->setValuator(j,valuatorState);
+					}
+				if(*vsPtr!=valuatorState)
+					{
+					*vsPtr=valuatorState;
+					changes|=ValuatorsChanged;
+					}
+				}
+			
+			deviceChanges[i]=changes;
 			}
 		
-		/* Send the input device states to the slave nodes: */
-		pipe->write<InputDeviceTrackingState>(trackingStates,numInputDevices);
-		pipe->write<bool>(buttonStates,totalNumButtons);
-		pipe->write<double>(valuatorStates,totalNumValuators);
+		/* Send the update flags: */
+		Misc::UInt8 flags=0x0;
+		if(keyframe)
+			flags|=KeyframeUpdate;
+		if(quantizeValuators)
+			flags|=QuantizedValuators;
+		if(quantizeOrientations)
+			flags|=QuantizedOrientations;
+		pipe->write<Misc::UInt8>(flags);
+		
+		/* Send a bit mask of changed input devices: */
+		for(int i=0;i<numInputDevices;i+=8)
+			{
+			Misc::UInt8 mask=0x0;
+			for(int j=0;j<8&&i+j<numInputDevices;++j)
+				if(deviceChanges[i+j]!=0)
+					mask|=Misc::UInt8(1U<<j);
+			pipe->write<Misc::UInt8>(mask);
+			}
+		
+		/* Send the changed state components of all changed input devices: */
+		bsPtr=buttonStates;
+		vsPtr=valuatorStates;
+		for(int i=0;i<numInputDevices;++i)
+			{
+			int numButtons=inputDevices[i]->getNumButtons();
+			int numValuators=inputDevices[i]->getNumValuators();
+			if(deviceChanges[i]!=0)
+				pipe->write<Misc::UInt8>(deviceChanges[i]);
+			
+			if(deviceChanges[i]&TrackingChanged)
+				{
+				const InputDeviceTrackingState& ts=trackingStates[i];
+				if(quantizeOrientations)
+					{
+					pipe->write(ts.deviceRayDirection.getComponents(),3);
+					pipe->write(ts.deviceRayStart);
+					pipe->write(ts.transformation.getTranslation().getComponents(),3);
+					pipe->write(quantizedOrientations+i*4,4);
+					pipe->write(ts.linearVelocity.getComponents(),3);
+					pipe->write(ts.angularVelocity.getComponents(),3);
+					}
+				else
+					pipe->write<InputDeviceTrackingState>(ts);
+				}
+			
+			if(deviceChanges[i]&ButtonsChanged)
+				{
+				/* Send button states as a bit field: */
+				for(int j=0;j<numButtons;j+=8)
+					{
+					Misc::UInt8 bits=0x0;
+					for(int k=0;k<8&&j+k<numButtons;++k)
+						if(bsPtr[j+k])
+							bits|=Misc::UInt8(1U<<k);
+					pipe->write<Misc::UInt8>(bits);
+					}
+				}
+			
+			if(deviceChanges[i]&ValuatorsChanged)
+				{
+				if(quantizeValuators)
+					{
+					for(int j=0;j<numValuators;++j)
+						pipe->write<Misc::SInt16>(quantize(vsPtr[j]));
+					}
+				else
+					pipe->write<double>(vsPtr,numValuators);
+				}
+			
+			bsPtr+=numButtons;
+			vsPtr+=numValuators;
+			}
 		}
 	else
 		{
-		/* Receive the input device states from the master node: */
-		pipe->read<InputDeviceTrackingState>(trackingStates,numInputDevices);
-		pipe->read<bool>(buttonStates,totalNumButtons);
-		pipe->read<double>(valuatorStates,totalNumValuators);
+		/* Receive the update flags: */
+		Misc::UInt8 flags=pipe->read<Misc::UInt8>();
+		
+		/* Receive the bit mask of changed input devices: */
+		for(int i=0;i<numInputDevices;i+=8)
+			{
+			Misc::UInt8 mask=pipe->read<Misc::UInt8>();
+			for(int j=0;j<8&&i+j<numInputDevices;++j)
+				deviceChanges[i+j]=(mask&(1U<<j))!=0?Misc::UInt8(1):Misc::UInt8(0);
+			}
 		
-		/* Set the state of all input devices: */
+		/* Receive the changed state components of all changed input devices and update the devices: */
 		bool* bsPtr=buttonStates;
 		double* vsPtr=valuatorStates;
 		for(int i=0;i<numInputDevices;++i)
 			{
-			inputDevices[i]->setDeviceRay(trackingStates[i].deviceRayDirection,trackingStates[i].deviceRayStart);
-			inputDevices[i]->setTransformation(trackingStates[i].transformation);
-			inputDevices[i]->setLinearVelocity(trackingStates[i].linearVelocity);
-			inputDevices[i]->setAngularVelocity(trackingStates[i].angularVelocity);
-			for(int j=0;j<inputDevices[i]->getNumButtons();++j,++bsPtr)
-				inputDevices[i]->setButtonState(j,*bsPtr);
-			for(int j=0;j<inputDevices[i]->getNumValuators();++j,++vsPtr)
-				inputDevices[i]->setValuator(j,*vsPtr);
+			InputDevice* device=inputDevices[i];
+			int numButtons=device->getNumButtons();
+			int numValuators=device->getNumValuators();
+			if(deviceChanges[i]!=0)
+				deviceChanges[i]=pipe->read<Misc::UInt8>();
+			
+			if(deviceChanges[i]&TrackingChanged)
+				{
+				InputDeviceTrackingState& ts=trackingStates[i];
+				if(flags&QuantizedOrientations)
+					{
+					pipe->read(ts.deviceRayDirection.getComponents(),3);
+					pipe->read(ts.deviceRayStart);
+					Vector translation;
+					pipe->read(translation.getComponents(),3);
+					Misc::SInt16 quaternion[4];
+					pipe->read(quaternion,4);
+					ts.transformation=TrackerState(translation,dequantizeOrientation(quaternion));
+					pipe->read(ts.linearVelocity.getComponents(),3);
+					pipe->read(ts.angularVelocity.getComponents(),3);
+					}
+				else
+					pipe->read<InputDeviceTrackingState>(ts);
+				
+				device->setDeviceRay(ts.deviceRayDirection,ts.deviceRayStart);
+				device->setTransformation(ts.transformation);
+				device->setLinearVelocity(ts.linearVelocity);
+				device->setAngularVelocity(ts.angularVelocity);
+				}
+			
+			if(deviceChanges[i]&ButtonsChanged)
+				{
+				/* Receive button states as a bit field: */
+				for(int j=0;j<numButtons;j+=8)
+					{
+					Misc::UInt8 bits=pipe->read<Misc::UInt8>();
+					for(int k=0;k<8&&j+k<numButtons;++k)
+						{
+						bsPtr[j+k]=(bits&(1U<<k))!=0;
+						device->setButtonState(j+k,bsPtr[j+k]);
+						}
+					}
+				}
+			
+			if(deviceChanges[i]&ValuatorsChanged)
+				{
+				if(flags&QuantizedValuators)
+					{
+					for(int j=0;j<numValuators;++j)
+						vsPtr[j]=dequantize(pipe->read<Misc::SInt16>());
+					}
+				else
+					pipe->read<double>(vsPtr,numValuators);
+				for(int j=0;j<numValuators;++j)
+					device->setValuator(j,vsPtr[j]);
+				}
+			
+			bsPtr+=numButtons;
+			vsPtr+=numValuators;
 			}
 		}
 	}
 
+void MultipipeDispatcher::setKeyframeInterval(unsigned int newKeyframeInterval)
+	{
+	keyframeInterval=newKeyframeInterval>0?newKeyframeInterval:1;
+	
+	/* Send a full update on the next frame: */
+	framesToKeyframe=0;
+	}
+
+void MultipipeDispatcher::setQuantization(bool newQuantizeValuators,bool newQuantizeOrientations)
+	{
+	quantizeValuators=newQuantizeValuators;
+	quantizeOrientations=newQuantizeOrientations;
+	
+	/* Send a full update on the next frame: */
+	framesToKeyframe=0;
+	}
+
 }
@@ -1,7 +1,7 @@
 /***********************************************************************
 MultipipeDispatcher - Class to distribute input device and ancillary
 data between the nodes in a multipipe VR environment.
-Copyright (c) 2004-2013 Oliver Kreylos
+Copyright (c) 2004-2020 Oliver Kreylos
 
 This file is part of the Virtual Reality User Interface Library (Vrui).
 
@@ -26,6 +26,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <string>
 #include <vector>
+#include <Misc/SizedTypes.h>
 #include <Geometry/Vector.h>
 #include <Geometry/OrthonormalTransformation.h>
 #include <Vrui/Geometry.h>
@@ -66,10 +67,18 @@ class MultipipeDispatcher:public InputDeviceAdapter
 	std::vector<std::string> buttonNames; // Array of button names for all dispatched input devices
 	std::vector<std::string> valuatorNames; // Array of button names for all dispatched input devices
 	
+	/* Master state: */
+	unsigned int keyframeInterval; // Number of frames between full updates of all input device states
+	unsigned int framesToKeyframe; // Number of frames until the next full update
+	bool quantizeValuators; // Flag whether valuator values are sent as 16-bit fixed-point numbers
+	bool quantizeOrientations; // Flag whether input device orientations are sent as 16-bit fixed-point quaternions
+	
 	/* Transient state to marshall input device states over a multicast pipe: */
-	InputDeviceTrackingState* trackingStates; // Array of input device tracking states
-	bool* buttonStates; // Array of input device button states
-	double* valuatorStates; // Array of input device valuator states
+	InputDeviceTrackingState* trackingStates; // Array of input device tracking states, as most recently sent to or received by the slave nodes
+	bool* buttonStates; // Array of input device button states, as most recently sent to or received by the slave nodes
+	double* valuatorStates; // Array of input device valuator states, as most recently sent to or received by the slave nodes
+	Misc::UInt8* deviceChanges; // Array of bit masks of changed state components for each input device
+	Misc::SInt16* quantizedOrientations; // Array of quantized orientation quaternions, four components per input device
 	
 	/* Constructors and destructors: */
 	public:
@@ -80,6 +89,10 @@ class MultipipeDispatcher:public InputDeviceAdapter
 	virtual std::string getFeatureName(const InputDeviceFeature& feature) const;
 	virtual int getFeatureIndex(InputDevice* device,const char* featureName) const;
 	virtual void updateInputDevices(void);
+	
+	/* New methods: */
+	void setKeyframeInterval(unsigned int newKeyframeInterval); // Sets the number of frames between full updates of all input device states on the master node; 1 sends full updates every frame
+	void setQuantization(bool newQuantizeValuators,bool newQuantizeOrientations); // Selects whether the master node sends valuator values and input device orientations as 16-bit fixed-point numbers; the master node's input devices receive the same quantized values
 	};
 
 }
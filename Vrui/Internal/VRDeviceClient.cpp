@@ -25,13 +25,23 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 
 #include <Vrui/Internal/VRDeviceClient.h>
 
+#include <poll.h>
+#include <string>
 #include <Misc/SizedTypes.h>
 #include <Misc/Time.h>
+#include <Misc/MessageLogger.h>
+#include <Misc/Pipe.h>
+#include <Misc/StringMarshaller.h>
 #include <Misc/StandardValueCoders.h>
 #include <Misc/ConfigurationFile.h>
 #include <Realtime/Time.h>
+#include <IO/FixedMemoryFile.h>
+#include <Comm/IPv4Address.h>
+#include <Comm/IPv4SocketAddress.h>
+#include <Comm/UDPSocket.h>
 #include <Vrui/Internal/VRDeviceDescriptor.h>
 #include <Vrui/Internal/HMDConfiguration.h>
+#include <Vrui/Internal/VRDeviceSharedState.h>
 
 #if DEBUG_PROTOCOL
 #include <iostream>
@@ -105,8 +115,11 @@ void* VRDeviceClient::streamReceiveThreadMethod(void)
 					}
 				}
 				
-				/* Signal packet reception: */
+				/* Signal packet reception while holding the lock, so that startStream cannot miss the first packet if no more packets follow: */
+				{
+				Threads::MutexCond::Lock packetSignalLock(packetSignalCond);
 				packetSignalCond.broadcast();
+				}
 				
 				/* Invoke packet notification callback: */
 				if(packetNotificationCallback!=0)
@@ -256,7 +269,131 @@ void* VRDeviceClient::streamReceiveThreadMethod(void)
 	return 0;
 	}
 
-void VRDeviceClient::initClient(void)
+void* VRDeviceClient::sharedStateReceiveThreadMethod(void)
+	{
+	/* Wait for device state updates in the shared memory segment until streaming stops: */
+	Misc::UInt32 sequenceNumber=sharedState->getSequenceNumber();
+	while(sharedStateStreaming&&!connectionDead)
+		{
+		/* Wait for the next update; time out periodically to check for shutdown: */
+		if(!sharedState->waitForUpdate(sequenceNumber,Misc::Time(1,0))||!sharedStateStreaming)
+			continue;
+		
+		/* Read the new device state: */
+		try
+			{
+			Threads::Mutex::Lock stateLock(stateMutex);
+			sequenceNumber=sharedState->read(state);
+			}
+		catch(const std::runtime_error& err)
+			{
+			/* Signal an error and shut down: */
+			if(errorCallback!=0)
+				{
+				std::string msg="VRDeviceClient: Caught exception ";
+				msg.append(err.what());
+				(*errorCallback)(ProtocolError(msg,this));
+				}
+			connectionDead=true;
+			packetSignalCond.broadcast();
+			break;
+			}
+		
+		/* Signal packet reception: */
+		packetSignalCond.broadcast();
+		
+		/* Invoke packet notification callback: */
+		if(packetNotificationCallback!=0)
+			(*packetNotificationCallback)(this);
+		}
+	
+	return 0;
+	}
+
+void* VRDeviceClient::datagramReceiveThreadMethod(void)
+	{
+	/* Create a buffer to receive datagrams: */
+	IO::FixedMemoryFile datagram(VRDevicePipe::maxDatagramSize);
+	
+	/* Datagrams are sent in the server's byte order; swap them like the pipe does: */
+	datagram.setSwapOnRead(pipe.mustSwapOnRead());
+	
+	/* Receive datagrams until streaming stops: */
+	bool haveSequenceNumber=false;
+	Misc::UInt32 lastSequenceNumber=0U;
+	while(datagramStreaming&&!connectionDead)
+		{
+		try
+			{
+			/* Wait for the next datagram or a wake-up from stopStream; time out periodically to check for shutdown: */
+			struct pollfd pollFds[2];
+			pollFds[0].fd=datagramSocket->getFd();
+			pollFds[0].events=POLLIN;
+			pollFds[1].fd=datagramWakeupPipe->getReadFd();
+			pollFds[1].events=POLLIN;
+			if(poll(pollFds,2,1000)<=0||!datagramStreaming)
+				continue;
+			if(!(pollFds[0].revents&POLLIN))
+				continue;
+			size_t datagramSize=datagramSocket->receiveMessage(datagram.getMemory(),VRDevicePipe::maxDatagramSize);
+			if(datagramSize<sizeof(VRDevicePipe::DatagramHeader))
+				continue;
+			datagram.setReadDataSize(datagramSize);
+			
+			/* Read the datagram header and drop the datagram if it is older than the most recently applied one: */
+			Misc::UInt32 sequenceNumber=datagram.read<Misc::UInt32>();
+			datagram.read<Misc::SInt32>();
+			datagram.read<Misc::UInt32>();
+			if(haveSequenceNumber&&Misc::SInt32(sequenceNumber-lastSequenceNumber)<=0)
+				continue;
+			haveSequenceNumber=true;
+			lastSequenceNumber=sequenceNumber;
+			
+			/* Apply all device state updates contained in the datagram: */
+			{
+			Threads::Mutex::Lock stateLock(stateMutex);
+			while(!datagram.eof())
+				{
+				VRDevicePipe::MessageIdType message=datagram.read<VRDevicePipe::MessageIdType>();
+				unsigned int index=datagram.read<Misc::UInt16>();
+				if(message==VRDevicePipe::TRACKER_UPDATE&&index<(unsigned int)state.getNumTrackers())
+					{
+					state.setTrackerState(index,Misc::Marshaller<VRDeviceState::TrackerState>::read(datagram));
+					VRDeviceState::TimeStamp trackerTimeStamp=datagram.read<VRDeviceState::TimeStamp>();
+					if(!local)
+						trackerTimeStamp+=timeStampDelta;
+					state.setTrackerTimeStamp(index,trackerTimeStamp);
+					state.setTrackerValid(index,datagram.read<Misc::UInt8>()!=0U);
+					}
+				else if(message==VRDevicePipe::BUTTON_UPDATE&&index<(unsigned int)state.getNumButtons())
+					state.setButtonState(index,datagram.read<Misc::UInt8>()!=0U);
+				else if(message==VRDevicePipe::VALUATOR_UPDATE&&index<(unsigned int)state.getNumValuators())
+					state.setValuatorState(index,datagram.read<VRDeviceState::ValuatorState>());
+				else
+					{
+					/* Ignore the rest of the malformed datagram: */
+					break;
+					}
+				}
+			}
+			
+			/* Signal packet reception: */
+			packetSignalCond.broadcast();
+			
+			/* Invoke packet notification callback: */
+			if(packetNotificationCallback!=0)
+				(*packetNotificationCallback)(this);
+			}
+		catch(const std::runtime_error& err)
+			{
+			/* Ignore truncated datagrams and transient receive errors; datagrams are unreliable anyway */
+			}
+		}
+	
+	return 0;
+	}
+
+void VRDeviceClient::initClient(bool useSharedMemory,bool useDatagrams)
 	{
 	/* Determine whether client and server are running on the same host: */
 	local=pipe.getAddress()==pipe.getPeerAddress();
@@ -355,18 +492,93 @@ void VRDeviceClient::initClient(void)
 		numPowerFeatures=pipe.read<Misc::UInt32>();
 		numHapticFeatures=pipe.read<Misc::UInt32>();
 		}
+	
+	/* Check if device states should be received through shared memory: */
+	if(useSharedMemory&&local&&serverProtocolVersionNumber>=10U)
+		{
+		/* Request the name of the server's shared memory segment: */
+		pipe.writeMessage(VRDevicePipe::SHAREDSTATE_REQUEST);
+		pipe.flush();
+		if(!pipe.waitForData(Misc::Time(10,0)))
+			throw ProtocolError("VRDeviceClient: Timeout while waiting for SHAREDSTATE_REPLY",this);
+		if(pipe.readMessage()!=VRDevicePipe::SHAREDSTATE_REPLY)
+			throw ProtocolError("VRDeviceClient: Mismatching message while waiting for SHAREDSTATE_REPLY",this);
+		std::string sharedStateName=Misc::readCppString(pipe);
+		
+		if(!sharedStateName.empty())
+			{
+			/* Open the shared memory segment: */
+			try
+				{
+				sharedState=new VRDeviceSharedState(sharedStateName.c_str());
+				if(!sharedState->matchesLayout(state))
+					{
+					delete sharedState;
+					sharedState=0;
+					throw std::runtime_error("Mismatching device state layout");
+					}
+				}
+			catch(const std::runtime_error& err)
+				{
+				/* Fall back to receiving device states through the pipe: */
+				Misc::formattedConsoleWarning("VRDeviceClient: Unable to receive device states through shared memory due to exception %s",err.what());
+				}
+			}
+		}
+	
+	/* Check if streamed device states should be received as datagrams: */
+	if(sharedState==0&&useDatagrams&&serverProtocolVersionNumber>=11U)
+		{
+		/* Request the server's datagram stream parameters: */
+		pipe.writeMessage(VRDevicePipe::DATAGRAM_REQUEST);
+		pipe.flush();
+		if(!pipe.waitForData(Misc::Time(10,0)))
+			throw ProtocolError("VRDeviceClient: Timeout while waiting for DATAGRAM_REPLY",this);
+		if(pipe.readMessage()!=VRDevicePipe::DATAGRAM_REPLY)
+			throw ProtocolError("VRDeviceClient: Mismatching message while waiting for DATAGRAM_REPLY",this);
+		std::string multicastGroup=Misc::readCppString(pipe);
+		unsigned int multicastPort=pipe.read<Misc::UInt16>();
+		
+		/* Open a datagram socket: */
+		try
+			{
+			if(multicastGroup.empty())
+				{
+				/* Receive unicast datagrams on a random port: */
+				datagramSocket=new Comm::UDPSocket(-1,0);
+				}
+			else
+				{
+				/* Receive multicast datagrams on the group's port, shared with other clients on the same host: */
+				datagramSocket=new Comm::UDPSocket(multicastPort,0,true);
+				datagramSocket->joinMulticastGroup(Comm::IPv4Address(multicastGroup.c_str()),Comm::IPv4Address());
+				}
+			
+			/* Create a pipe to wake up the datagram receiving thread: */
+			datagramWakeupPipe=new Misc::Pipe(true);
+			}
+		catch(const std::runtime_error& err)
+			{
+			/* Fall back to receiving device states through the pipe: */
+			delete datagramSocket;
+			datagramSocket=0;
+			Misc::formattedConsoleWarning("VRDeviceClient: Unable to receive device states as datagrams due to exception %s",err.what());
+			}
+		}
 	}
 
-VRDeviceClient::VRDeviceClient(const char* deviceServerName,int deviceServerPort)
+VRDeviceClient::VRDeviceClient(const char* deviceServerName,int deviceServerPort,bool useSharedMemory,bool useDatagrams)
 	:pipe(deviceServerName,deviceServerPort),
 	 serverProtocolVersionNumber(0),serverHasTimeStamps(false),
 	 batteryStates(0),batteryStateUpdatedCallback(0),
 	 numHmdConfigurations(0),hmdConfigurations(0),hmdConfigurationUpdatedCallbacks(0),
 	 numPowerFeatures(0),numHapticFeatures(0),
 	 active(false),streaming(false),connectionDead(false),
-	 packetNotificationCallback(0),errorCallback(0)
+	 packetNotificationCallback(0),errorCallback(0),
+	 sharedState(0),sharedStateStreaming(false),
+	 datagramSocket(0),datagramStreaming(false),datagramWakeupPipe(0)
 	{
-	initClient();
+	initClient(useSharedMemory,useDatagrams);
 	}
 
 VRDeviceClient::VRDeviceClient(const Misc::ConfigurationFileSection& configFileSection)
@@ -376,9 +588,11 @@ VRDeviceClient::VRDeviceClient(const Misc::ConfigurationFileSection& configFileS
 	 numHmdConfigurations(0),hmdConfigurations(0),hmdConfigurationUpdatedCallbacks(0),
 	 numPowerFeatures(0),numHapticFeatures(0),
 	 active(false),streaming(false),connectionDead(false),
-	 packetNotificationCallback(0),errorCallback(0)
+	 packetNotificationCallback(0),errorCallback(0),
+	 sharedState(0),sharedStateStreaming(false),
+	 datagramSocket(0),datagramStreaming(false),datagramWakeupPipe(0)
 	{
-	initClient();
+	initClient(configFileSection.retrieveValue<bool>("./useSharedMemory",true),configFileSection.retrieveValue<bool>("./useDatagrams",false));
 	}
 
 VRDeviceClient::~VRDeviceClient(void)
@@ -410,6 +624,11 @@ VRDeviceClient::~VRDeviceClient(void)
 	/* Delete battery states and HMD configurations: */
 	delete[] batteryStates;
 	delete[] hmdConfigurations;
+	
+	/* Release the shared memory segment and datagram socket: */
+	delete sharedState;
+	delete datagramSocket;
+	delete datagramWakeupPipe;
 	}
 
 const HMDConfiguration& VRDeviceClient::getHmdConfiguration(unsigned int index) const
@@ -456,6 +675,22 @@ void VRDeviceClient::getPacket(void)
 			}
 		else
 			{
+			if(sharedState!=0)
+				{
+				/* Read the server's current state directly from shared memory: */
+				try
+					{
+					Threads::Mutex::Lock stateLock(stateMutex);
+					sharedState->read(state);
+					return;
+					}
+				catch(const std::runtime_error& err)
+					{
+					/* Fall back to requesting the server's state through the pipe: */
+					Misc::formattedConsoleWarning("VRDeviceClient: Unable to read device state from shared memory due to exception %s",err.what());
+					}
+				}
+			
 			/* Send packet request message: */
 			pipe.writeMessage(VRDevicePipe::PACKET_REQUEST);
 			pipe.flush();
@@ -577,10 +812,37 @@ void VRDeviceClient::startStream(VRDeviceClient::Callback* newPacketNotification
 		{
 		Threads::MutexCond::Lock packetSignalLock(packetSignalCond);
 		pipe.writeMessage(VRDevicePipe::STARTSTREAM_REQUEST);
+		if(serverProtocolVersionNumber>=10U)
+			{
+			/* Tell the server over which transport to send device states: */
+			if(sharedState!=0)
+				pipe.write<Misc::UInt8>(VRDevicePipe::STREAM_SHAREDMEMORY);
+			else if(datagramSocket!=0)
+				{
+				/* Send the port on which to receive unicast datagrams: */
+				pipe.write<Misc::UInt8>(VRDevicePipe::STREAM_DATAGRAM);
+				pipe.write<Misc::UInt16>(Misc::UInt16(datagramSocket->getPortId()));
+				}
+			else
+				pipe.write<Misc::UInt8>(VRDevicePipe::STREAM_PIPE);
+			}
 		pipe.flush();
 		packetSignalCond.wait(packetSignalLock);
 		streaming=true;
 		}
+		
+		if(sharedState!=0)
+			{
+			/* Start the shared memory state receiving thread: */
+			sharedStateStreaming=true;
+			sharedStateReceiveThread.start(this,&VRDeviceClient::sharedStateReceiveThreadMethod);
+			}
+		else if(datagramSocket!=0)
+			{
+			/* Start the datagram receiving thread: */
+			datagramStreaming=true;
+			datagramReceiveThread.start(this,&VRDeviceClient::datagramReceiveThreadMethod);
+			}
 		}
 	else
 		{
@@ -595,6 +857,34 @@ void VRDeviceClient::stopStream(void)
 	if(streaming)
 		{
 		streaming=false;
+		
+		if(sharedState!=0)
+			{
+			/* Shut down the shared memory state receiving thread: */
+			sharedStateStreaming=false;
+			sharedState->wakeReaders();
+			sharedStateReceiveThread.join();
+			}
+		else if(datagramSocket!=0)
+			{
+			/* Shut down the datagram receiving thread, and wake it up through its wake-up pipe: */
+			datagramStreaming=false;
+			try
+				{
+				datagramWakeupPipe->write<char>(0);
+				}
+			catch(const std::runtime_error& err)
+				{
+				/* Thread will notice on its next time-out */
+				}
+			datagramReceiveThread.join();
+			
+			/* Drain the wake-up pipe: */
+			char wakeup;
+			while(datagramWakeupPipe->read(&wakeup,1)>0)
+				;
+			}
+		
 		if(!connectionDead)
 			{
 			/* Send stop streaming message: */
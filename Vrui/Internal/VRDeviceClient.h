@@ -38,10 +38,15 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 /* Forward declarations: */
 namespace Misc {
 class ConfigurationFileSection;
+class Pipe;
+}
+namespace Comm {
+class UDPSocket;
 }
 namespace Vrui {
 class VRDeviceDescriptor;
 class HMDConfiguration;
+class VRDeviceSharedState;
 }
 
 namespace Vrui {
@@ -96,14 +101,23 @@ class VRDeviceClient
 	Callback* packetNotificationCallback; // Function called when a new state packet arrives from the server in streaming mode (called from background thread)
 	ErrorCallback* errorCallback; // Function called when a protocol error occurs in streaming mode (called from background thread)
 	VRDeviceState::TimeStamp timeStampDelta; // Offset between server's time stamps and the client's local clock source
+	VRDeviceSharedState* sharedState; // Shared memory segment through which a local server publishes its device state, or null if device states are received through the pipe
+	volatile bool sharedStateStreaming; // Flag to keep the shared state receiving thread running
+	Threads::Thread sharedStateReceiveThread; // Thread waiting for device state updates in the shared memory segment in stream mode
+	Comm::UDPSocket* datagramSocket; // Socket receiving device state update datagrams from the server, or null if device states are received through the pipe
+	volatile bool datagramStreaming; // Flag to keep the datagram receiving thread running
+	Misc::Pipe* datagramWakeupPipe; // Pipe to wake up the datagram receiving thread when streaming stops, or null if device states are received through the pipe
+	Threads::Thread datagramReceiveThread; // Thread receiving device state update datagrams in stream mode
 	
 	/* Private methods: */
 	void* streamReceiveThreadMethod(void); // Stream packet receiving thread method
-	void initClient(void); // Initializes communication between device server and client
+	void* sharedStateReceiveThreadMethod(void); // Shared memory state receiving thread method
+	void* datagramReceiveThreadMethod(void); // Device state update datagram receiving thread method
+	void initClient(bool useSharedMemory,bool useDatagrams); // Initializes communication between device server and client; tries receiving device states through shared memory or as datagrams if the respective flags are true
 	
 	/* Constructors and destructors: */
 	public:
-	VRDeviceClient(const char* deviceServerName,int deviceServerPort); // Connects client to given server
+	VRDeviceClient(const char* deviceServerName,int deviceServerPort,bool useSharedMemory =true,bool useDatagrams =false); // Connects client to given server; receives streamed device states through shared memory if the server is local and supports it and the first flag is true, or otherwise as unreliable datagrams if the server supports it and the second flag is true
 	VRDeviceClient(const Misc::ConfigurationFileSection& configFileSection); // Connects client to server listed in current configuration file section
 	~VRDeviceClient(void); // Disconnects client from server
 	
@@ -112,6 +126,14 @@ class VRDeviceClient
 		{
 		return local;
 		}
+	bool usesSharedMemory(void) const // Returns true if device states are received through shared memory
+		{
+		return sharedState!=0;
+		}
+	bool usesDatagrams(void) const // Returns true if streamed device states are received as datagrams
+		{
+		return datagramSocket!=0;
+		}
 	int getNumVirtualDevices(void) const // Returns the number of managed virtual input devices
 		{
 		return int(virtualDevices.size());
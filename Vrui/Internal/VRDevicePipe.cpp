@@ -29,6 +29,7 @@ namespace Vrui {
 Static elements of class VRDevicePipe:
 *************************************/
 
-const Misc::UInt32 VRDevicePipe::protocolVersionNumber=9U;
+const Misc::UInt32 VRDevicePipe::protocolVersionNumber=11U;
+const size_t VRDevicePipe::maxDatagramSize=65000;
 
 }
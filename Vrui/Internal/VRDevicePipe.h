@@ -54,9 +54,36 @@ class VRDevicePipe:public Comm::TCPPipe
 		HAPTICTICK_REQUEST, // Requests a haptic tick on a virtual input device
 		TRACKER_UPDATE, // Sends new state for a single tracker
 		BUTTON_UPDATE, // Sends new state for a single button
-		VALUATOR_UPDATE // Sends new state for a single valuator
+		VALUATOR_UPDATE, // Sends new state for a single valuator
+		SHAREDSTATE_REQUEST, // Requests the name of the server's shared memory device state segment
+		SHAREDSTATE_REPLY, // Server's reply with the name of its shared memory device state segment, or an empty string
+		DATAGRAM_REQUEST, // Requests the parameters of the server's datagram stream
+		DATAGRAM_REPLY // Server's reply with its datagram stream's multicast group address or an empty string, and multicast port
 		};
 	
+	enum StreamTransport // Enumerated type for transports over which streaming clients receive device state updates
+		{
+		STREAM_PIPE, // Device state updates are sent as messages through the pipe
+		STREAM_SHAREDMEMORY, // Device state updates are read from a shared memory segment
+		STREAM_DATAGRAM // Device state updates are sent as unreliable UDP datagrams, unicast or multicast
+		};
+	
+	struct DatagramHeader // Header of a device state update datagram; followed by a sequence of tracker, button, and valuator update messages
+		{
+		/* Elements: */
+		public:
+		Misc::UInt32 sequenceNumber; // Sequence number to detect lost or reordered datagrams
+		Misc::SInt32 timeStamp; // Time at which the datagram was sent in the server's time stamp clock
+		Misc::UInt32 flags; // Datagram flags
+		};
+	
+	enum DatagramFlags // Enumerated type for device state update datagram flags
+		{
+		DATAGRAM_KEYFRAME=0x1 // Datagram contains the full device state instead of only changed components
+		};
+	
+	static const size_t maxDatagramSize; // Maximum size of a device state update datagram including its header
+	
 	/* Constructors and destructors: */
 	VRDevicePipe(const char* hostName,int portId) // Creates a pipe connected to a remote host
 		:Comm::TCPPipe(hostName,portId)
@@ -0,0 +1,307 @@
+/***********************************************************************
+VRDeviceSharedState - Class to share the current state of a VR device
+server with clients running on the same host through a seqlock-protected
+shared memory segment.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/Internal/VRDeviceSharedState.h>
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include <Misc/ThrowStdErr.h>
+#include <Misc/Time.h>
+
+namespace Vrui {
+
+namespace {
+
+/****************
+Helper functions:
+****************/
+
+const Misc::UInt32 sharedStateMagic=0x56524453U; // Magic number identifying a VR device shared state segment
+const Misc::UInt32 sharedStateVersion=1U; // Version number of the shared state segment layout
+const long readTimeout=100000000L; // Maximum time in nanoseconds to wait for a consistent snapshot of the shared state
+
+inline size_t alignOffset(size_t offset) // Aligns a segment offset to a 16-byte boundary
+	{
+	return (offset+15)&~size_t(15);
+	}
+
+}
+
+/*********************************************
+Embedded classes of class VRDeviceSharedState:
+*********************************************/
+
+struct VRDeviceSharedState::Header
+	{
+	/* Elements: */
+	public:
+	Misc::UInt32 magic; // Magic number to identify shared state segments
+	Misc::UInt32 version; // Version number of the segment layout
+	Misc::UInt32 trackerStateSize; // Size of a tracker state structure, to detect ABI mismatches between server and client
+	volatile Misc::UInt32 sequenceNumber; // Seqlock sequence number; odd while the state is being written; also used as futex to wake up readers
+	Misc::UInt32 numTrackers,numButtons,numValuators; // Layout of the shared device state
+	Misc::UInt32 trackerStatesOffset,trackerTimeStampsOffset,trackerValidsOffset,buttonStatesOffset,valuatorStatesOffset; // Offsets of the state arrays from the beginning of the segment
+	};
+
+/************************************
+Methods of class VRDeviceSharedState:
+************************************/
+
+void VRDeviceSharedState::setPointers(void)
+	{
+	trackerStates=reinterpret_cast<VRDeviceState::TrackerState*>(memory+header->trackerStatesOffset);
+	trackerTimeStamps=reinterpret_cast<VRDeviceState::TimeStamp*>(memory+header->trackerTimeStampsOffset);
+	trackerValids=memory+header->trackerValidsOffset;
+	buttonStates=memory+header->buttonStatesOffset;
+	valuatorStates=reinterpret_cast<VRDeviceState::ValuatorState*>(memory+header->valuatorStatesOffset);
+	}
+
+VRDeviceSharedState::VRDeviceSharedState(const char* sName,const VRDeviceState& state)
+	:name(sName),owner(true),size(0),memory(0),header(0)
+	{
+	/* Calculate the segment layout: */
+	size_t numTrackers=state.getNumTrackers();
+	size_t numButtons=state.getNumButtons();
+	size_t numValuators=state.getNumValuators();
+	size_t trackerStatesOffset=alignOffset(sizeof(Header));
+	size_t trackerTimeStampsOffset=alignOffset(trackerStatesOffset+numTrackers*sizeof(VRDeviceState::TrackerState));
+	size_t trackerValidsOffset=alignOffset(trackerTimeStampsOffset+numTrackers*sizeof(VRDeviceState::TimeStamp));
+	size_t buttonStatesOffset=alignOffset(trackerValidsOffset+numTrackers*sizeof(Misc::UInt8));
+	size_t valuatorStatesOffset=alignOffset(buttonStatesOffset+numButtons*sizeof(Misc::UInt8));
+	size=alignOffset(valuatorStatesOffset+numValuators*sizeof(VRDeviceState::ValuatorState));
+	
+	/* Remove a stale segment of the same name left behind by a crashed server: */
+	shm_unlink(name.c_str());
+	
+	/* Create the shared memory segment; clients only need read access: */
+	int fd=shm_open(name.c_str(),O_RDWR|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	if(fd<0)
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to create shared memory segment %s due to error %d (%s)",name.c_str(),errno,strerror(errno));
+	
+	/* Set the segment's size and map it into the process' address space: */
+	void* address=(void*)-1;
+	if(ftruncate(fd,off_t(size))==0)
+		address=mmap(0,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+	int error=errno;
+	close(fd);
+	if(address==(void*)-1)
+		{
+		shm_unlink(name.c_str());
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to map shared memory segment %s due to error %d (%s)",name.c_str(),error,strerror(error));
+		}
+	memory=static_cast<Misc::UInt8*>(address);
+	
+	/* Initialize the segment header: */
+	header=reinterpret_cast<Header*>(memory);
+	header->magic=sharedStateMagic;
+	header->version=sharedStateVersion;
+	header->trackerStateSize=Misc::UInt32(sizeof(VRDeviceState::TrackerState));
+	header->sequenceNumber=0U;
+	header->numTrackers=Misc::UInt32(numTrackers);
+	header->numButtons=Misc::UInt32(numButtons);
+	header->numValuators=Misc::UInt32(numValuators);
+	header->trackerStatesOffset=Misc::UInt32(trackerStatesOffset);
+	header->trackerTimeStampsOffset=Misc::UInt32(trackerTimeStampsOffset);
+	header->trackerValidsOffset=Misc::UInt32(trackerValidsOffset);
+	header->buttonStatesOffset=Misc::UInt32(buttonStatesOffset);
+	header->valuatorStatesOffset=Misc::UInt32(valuatorStatesOffset);
+	setPointers();
+	
+	/* Write the initial state: */
+	write(state);
+	}
+
+VRDeviceSharedState::VRDeviceSharedState(const char* sName)
+	:name(sName),owner(false),size(0),memory(0),header(0)
+	{
+	/* Open the shared memory segment: */
+	int fd=shm_open(name.c_str(),O_RDONLY,0);
+	if(fd<0)
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to open shared memory segment %s due to error %d (%s)",name.c_str(),errno,strerror(errno));
+	
+	/* Query the segment's size and map it into the process' address space: */
+	struct stat segmentStats;
+	void* address=(void*)-1;
+	if(fstat(fd,&segmentStats)==0&&size_t(segmentStats.st_size)>=sizeof(Header))
+		{
+		size=size_t(segmentStats.st_size);
+		address=mmap(0,size,PROT_READ,MAP_SHARED,fd,0);
+		}
+	close(fd);
+	if(address==(void*)-1)
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Unable to map shared memory segment %s",name.c_str());
+	memory=static_cast<Misc::UInt8*>(address);
+	header=reinterpret_cast<Header*>(memory);
+	
+	/* Check the segment header for compatibility: */
+	if(header->magic!=sharedStateMagic||header->version!=sharedStateVersion||header->trackerStateSize!=sizeof(VRDeviceState::TrackerState)||size_t(header->valuatorStatesOffset)+header->numValuators*sizeof(VRDeviceState::ValuatorState)>size)
+		{
+		munmap(memory,size);
+		Misc::throwStdErr("Vrui::VRDeviceSharedState: Shared memory segment %s has incompatible format",name.c_str());
+		}
+	setPointers();
+	}
+
+VRDeviceSharedState::~VRDeviceSharedState(void)
+	{
+	/* Unmap the shared memory segment: */
+	munmap(memory,size);
+	
+	/* Remove the segment if this object created it; mapped clients keep their mappings: */
+	if(owner)
+		shm_unlink(name.c_str());
+	}
+
+bool VRDeviceSharedState::matchesLayout(const VRDeviceState& state) const
+	{
+	return int(header->numTrackers)==state.getNumTrackers()&&int(header->numButtons)==state.getNumButtons()&&int(header->numValuators)==state.getNumValuators();
+	}
+
+void VRDeviceSharedState::write(const VRDeviceState& state)
+	{
+	/* Mark the shared state as being written: */
+	header->sequenceNumber=header->sequenceNumber+1U;
+	__sync_synchronize();
+	
+	/* Copy the state arrays: */
+	memcpy(trackerStates,state.getTrackerStates(),header->numTrackers*sizeof(VRDeviceState::TrackerState));
+	memcpy(trackerTimeStamps,state.getTrackerTimeStamps(),header->numTrackers*sizeof(VRDeviceState::TimeStamp));
+	const VRDeviceState::ValidFlag* tvPtr=state.getTrackerValids();
+	for(Misc::UInt32 i=0;i<header->numTrackers;++i)
+		trackerValids[i]=tvPtr[i]?1U:0U;
+	const VRDeviceState::ButtonState* bsPtr=state.getButtonStates();
+	for(Misc::UInt32 i=0;i<header->numButtons;++i)
+		buttonStates[i]=bsPtr[i]?1U:0U;
+	memcpy(valuatorStates,state.getValuatorStates(),header->numValuators*sizeof(VRDeviceState::ValuatorState));
+	
+	/* Mark the shared state as complete: */
+	__sync_synchronize();
+	header->sequenceNumber=header->sequenceNumber+1U;
+	
+	/* Wake up all waiting readers: */
+	#ifdef __linux__
+	syscall(SYS_futex,&header->sequenceNumber,FUTEX_WAKE,0x7fffffff,0,0,0);
+	#endif
+	}
+
+Misc::UInt32 VRDeviceSharedState::getSequenceNumber(void) const
+	{
+	return header->sequenceNumber&~0x1U;
+	}
+
+bool VRDeviceSharedState::waitForUpdate(Misc::UInt32 sequenceNumber,const Misc::Time& timeout) const
+	{
+	/* Check if there already is a newer state: */
+	Misc::UInt32 current=header->sequenceNumber;
+	if(current!=sequenceNumber)
+		return true;
+	
+	#ifdef __linux__
+	/* Sleep on the sequence number until a writer wakes us up or the timeout elapses: */
+	struct timespec to=timeout;
+	syscall(SYS_futex,&header->sequenceNumber,FUTEX_WAIT,current,&to,0,0);
+	#else
+	/* Poll the sequence number: */
+	struct timespec pollInterval;
+	pollInterval.tv_sec=0;
+	pollInterval.tv_nsec=500000;
+	double remaining=double(timeout.tv_sec)+double(timeout.tv_nsec)/1.0e9;
+	while(header->sequenceNumber==current&&remaining>0.0)
+		{
+		nanosleep(&pollInterval,0);
+		remaining-=0.0005;
+		}
+	#endif
+	
+	return header->sequenceNumber!=sequenceNumber;
+	}
+
+void VRDeviceSharedState::wakeReaders(void) const
+	{
+	#ifdef __linux__
+	syscall(SYS_futex,&header->sequenceNumber,FUTEX_WAKE,0x7fffffff,0,0,0);
+	#endif
+	}
+
+Misc::UInt32 VRDeviceSharedState::read(VRDeviceState& state) const
+	{
+	/* Give up if no consistent snapshot can be taken within the timeout, e.g., if the writer died during a write: */
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC,&deadline);
+	deadline.tv_nsec+=readTimeout;
+	if(deadline.tv_nsec>=1000000000L)
+		{
+		++deadline.tv_sec;
+		deadline.tv_nsec-=1000000000L;
+		}
+	for(unsigned int numRetries=0;;++numRetries)
+		{
+		/* Check the timeout every once in a while: */
+		if(numRetries>=1024U)
+			{
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC,&now);
+			if(now.tv_sec>deadline.tv_sec||(now.tv_sec==deadline.tv_sec&&now.tv_nsec>=deadline.tv_nsec))
+				Misc::throwStdErr("Vrui::VRDeviceSharedState::read: Timeout while waiting for consistent device state in shared memory segment %s",name.c_str());
+			
+			/* Let the writer finish: */
+			sched_yield();
+			numRetries=0;
+			}
+		
+		/* Wait until no write is in progress: */
+		Misc::UInt32 sequenceNumber=header->sequenceNumber;
+		if(sequenceNumber&0x1U)
+			continue;
+		__sync_synchronize();
+		
+		/* Copy the state arrays: */
+		memcpy(state.getTrackerStates(),trackerStates,header->numTrackers*sizeof(VRDeviceState::TrackerState));
+		memcpy(state.getTrackerTimeStamps(),trackerTimeStamps,header->numTrackers*sizeof(VRDeviceState::TimeStamp));
+		VRDeviceState::ValidFlag* tvPtr=state.getTrackerValids();
+		for(Misc::UInt32 i=0;i<header->numTrackers;++i)
+			tvPtr[i]=trackerValids[i]!=0U;
+		VRDeviceState::ButtonState* bsPtr=state.getButtonStates();
+		for(Misc::UInt32 i=0;i<header->numButtons;++i)
+			bsPtr[i]=buttonStates[i]!=0U;
+		memcpy(state.getValuatorStates(),valuatorStates,header->numValuators*sizeof(VRDeviceState::ValuatorState));
+		
+		/* Return the snapshot if no write happened while copying: */
+		__sync_synchronize();
+		if(header->sequenceNumber==sequenceNumber)
+			return sequenceNumber;
+		}
+	}
+
+}
@@ -0,0 +1,85 @@
+/***********************************************************************
+VRDeviceSharedState - Class to share the current state of a VR device
+server with clients running on the same host through a seqlock-protected
+shared memory segment.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_INTERNAL_VRDEVICESHAREDSTATE_INCLUDED
+#define VRUI_INTERNAL_VRDEVICESHAREDSTATE_INCLUDED
+
+#include <string>
+#include <Misc/SizedTypes.h>
+#include <Vrui/Internal/VRDeviceState.h>
+
+/* Forward declarations: */
+namespace Misc {
+class Time;
+}
+
+namespace Vrui {
+
+class VRDeviceSharedState
+	{
+	/* Embedded classes: */
+	private:
+	struct Header; // Structure at the beginning of the shared memory segment
+	
+	/* Elements: */
+	std::string name; // OS-level name of the shared memory segment
+	bool owner; // Flag whether this object created the shared memory segment and writes to it
+	size_t size; // Size of the mapped shared memory segment
+	Misc::UInt8* memory; // Base pointer to the mapped shared memory segment
+	Header* header; // Pointer to the segment's header
+	VRDeviceState::TrackerState* trackerStates; // Array of tracker states inside the segment
+	VRDeviceState::TimeStamp* trackerTimeStamps; // Array of tracker time stamps inside the segment
+	Misc::UInt8* trackerValids; // Array of tracker valid flags inside the segment
+	Misc::UInt8* buttonStates; // Array of button states inside the segment
+	VRDeviceState::ValuatorState* valuatorStates; // Array of valuator states inside the segment
+	
+	/* Private methods: */
+	void setPointers(void); // Sets the array pointers from the segment's header
+	
+	/* Constructors and destructors: */
+	public:
+	VRDeviceSharedState(const char* sName,const VRDeviceState& state); // Creates a shared memory segment of the given name for writing, with the layout of the given device state
+	VRDeviceSharedState(const char* sName); // Opens an existing shared memory segment of the given name for reading
+	private:
+	VRDeviceSharedState(const VRDeviceSharedState& source); // Prohibit copy constructor
+	VRDeviceSharedState& operator=(const VRDeviceSharedState& source); // Prohibit assignment operator
+	public:
+	~VRDeviceSharedState(void); // Unmaps the shared memory segment, and removes it if this object created it
+	
+	/* Methods: */
+	const std::string& getName(void) const // Returns the shared memory segment's name
+		{
+		return name;
+		}
+	bool matchesLayout(const VRDeviceState& state) const; // Returns true if the shared memory segment has the same layout as the given device state
+	void write(const VRDeviceState& state); // Writes the given device state into the shared memory segment and wakes up all waiting readers
+	Misc::UInt32 getSequenceNumber(void) const; // Returns the sequence number of the most recent completed write
+	bool waitForUpdate(Misc::UInt32 sequenceNumber,const Misc::Time& timeout) const; // Waits until a write newer than the given sequence number completes, or the given time interval elapses; returns true if a new state is available
+	void wakeReaders(void) const; // Wakes up all readers currently waiting for an update without changing the state
+	Misc::UInt32 read(VRDeviceState& state) const; // Copies a consistent snapshot of the shared state into the given device state; returns the snapshot's sequence number; throws an exception if no consistent snapshot can be taken within a short timeout
+	};
+
+}
+
+#endif
@@ -79,6 +79,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <GLMotif/Button.h>
 #include <GLMotif/CascadeButton.h>
 #include <GLMotif/QuikwritingTextEntryMethod.h>
+#include <SceneGraph/SceneCache.h>
 #include <AL/Config.h>
 #include <AL/ALContextData.h>
 #include <Vrui/Internal/Config.h>
@@ -114,6 +115,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/ToolManager.h>
 #include <Vrui/Internal/ToolKillZone.h>
 #include <Vrui/VisletManager.h>
+#include <Vrui/FrameProfiler.h>
 #include <Vrui/Internal/InputDeviceDataSaver.h>
 #include <Vrui/Internal/ScaleBar.h>
 
@@ -852,7 +854,15 @@ void VruiState::initialize(const Misc::ConfigurationFileSection& configFileSecti
 	if(multiplexer!=0)
 		{
 		multipipeDispatcher=new MultipipeDispatcher(inputDeviceManager,pipe);
-		if(!master)
+		if(master)
+			{
+			/* Configure how input device states are sent to the slaves: */
+			multipipeDispatcher->setKeyframeInterval(configFileSection.retrieveValue<unsigned int>("./multipipeInputKeyframeInterval",60));
+			bool quantizeValuators=configFileSection.retrieveValue<bool>("./multipipeQuantizeValuators",false);
+			bool quantizeOrientations=configFileSection.retrieveValue<bool>("./multipipeQuantizeOrientations",false);
+			multipipeDispatcher->setQuantization(quantizeValuators,quantizeOrientations);
+			}
+		else
 			{
 			/* On slaves, multipipe dispatcher is owned by input device manager: */
 			multipipeDispatcher=0;
@@ -1077,6 +1087,19 @@ void VruiState::initialize(const Misc::ConfigurationFileSection& configFileSecti
 	/* Initialize the suggested animation frame interval: */
 	animationFrameInterval=configFileSection.retrieveValue<double>("./animationFrameInterval",animationFrameInterval);
 	
+	/* Limit the time spent on deferrable OpenGL context initializations per window and frame, in ms: */
+	GLContextData::setThingUpdateBudget(configFileSection.retrieveValue<double>("./glThingUpdateBudget",0.0)/1000.0);
+	
+	/* Enable caching of pre-parsed scene graph files if a cache directory is configured: */
+	try
+		{
+		SceneGraph::SceneCache::setCacheDirectory(configFileSection.retrieveString("./sceneGraphCacheDirectory",""));
+		}
+	catch(const std::runtime_error& err)
+		{
+		Misc::formattedConsoleWarning("Vrui: Disabling scene graph cache due to exception %s",err.what());
+		}
+	
 	/* Initialize latency mitigation: */
 	predictVsync=configFileSection.retrieveValue<bool>("./predictVsync",predictVsync);
 	if(predictVsync)
@@ -1499,6 +1522,10 @@ void VruiState::prepareMainLoop(void)
 
 void VruiState::update(void)
 	{
+	/* Start profiling a new frame: */
+	FrameProfiler::startFrame();
+	FrameProfiler::Scope updateScope("Vrui::update");
+	
 	/*********************************************************************
 	Update the application time and all related state:
 	*********************************************************************/
@@ -1506,6 +1533,8 @@ void VruiState::update(void)
 	double lastLastFrame=lastFrame;
 	if(master)
 		{
+		FrameProfiler::Scope frameTimingScope("FrameTiming");
+		
 		/* Take an application timer snapshot: */
 		lastFrame=appTime.peekTime();
 		if(synchFrameTime>0.0)
@@ -1581,6 +1610,8 @@ void VruiState::update(void)
 	*********************************************************************/
 	
 	int navBroadcastMask=navigationTransformationChangedMask;
+	{
+	FrameProfiler::Scope inputDevicesScope("InputDevices");
 	if(master)
 		{
 		/* Check if device state prediction is enabled and at least a few vsync periods have passed: */
@@ -1628,9 +1659,12 @@ void VruiState::update(void)
 		inputDeviceManager->updateInputDevices();
 		textEventDispatcher->readEventQueues(*pipe);
 		}
+	}
 	
 	if(multiplexer!=0)
 		{
+		FrameProfiler::Scope stateDistributionScope("StateDistribution");
+		
 		/* Broadcast the current navigation transformation and/or display center/size: */
 		pipe->broadcast<int>(navBroadcastMask);
 		if(navBroadcastMask&0x1)
@@ -1699,6 +1733,9 @@ void VruiState::update(void)
 	Update all managers:
 	*********************************************************************/
 	
+	{
+	FrameProfiler::Scope toolsScope("Tools");
+	
 	/* Set the widget manager's time: */
 	widgetManager->setTime(lastFrame);
 	
@@ -1731,6 +1768,7 @@ void VruiState::update(void)
 		
 		loadInputGraph=false;
 		}
+	}
 	
 	/* Update viewer states: */
 	for(int i=0;i<numViewers;++i)
@@ -1774,10 +1812,14 @@ void VruiState::update(void)
 	
 	/* Call frame functions of all loaded vislets: */
 	if(visletManager!=0)
+		{
+		FrameProfiler::Scope visletsScope("Vislets");
 		visletManager->frame();
+		}
 	
 	/* Call all additional frame callbacks: */
 	{
+	FrameProfiler::Scope frameCallbacksScope("FrameCallbacks");
 	Threads::Mutex::Lock frameCallbacksLock(frameCallbacksMutex);
 	for(std::vector<FrameCallbackSlot>::iterator fcIt=frameCallbacks.begin();fcIt!=frameCallbacks.end();++fcIt)
 		{
@@ -1793,7 +1835,10 @@ void VruiState::update(void)
 	}
 	
 	/* Call frame function: */
+	{
+	FrameProfiler::Scope frameFunctionScope("FrameFunction");
 	frameFunction(frameFunctionData);
+	}
 	
 	/* Finish any pending messages on the main pipe, in case an application didn't clean up: */
 	if(multiplexer!=0)
@@ -1820,6 +1865,8 @@ void setClipPlane(GLClipPlaneTracker* cpt,const Plane& clipPlane,GLint clipPlane
 
 void VruiState::display(DisplayState* displayState,GLContextData& contextData) const
 	{
+	FrameProfiler::Scope displayScope("Vrui::display");
+	
 	/* Initialize lighting state through the display state's light tracker: */
 	GLLightTracker* lt=contextData.getLightTracker();
 	lt->setLightingEnabled(true);
@@ -1918,7 +1965,10 @@ void VruiState::display(DisplayState* displayState,GLContextData& contextData) c
 			/* Go to navigational coordinates: */
 			glLoadMatrix(displayState->modelviewNavigational);
 			}
+		{
+		FrameProfiler::Scope displayFunctionScope("DisplayFunction");
 		displayFunction(contextData,displayFunctionData);
+		}
 		if(navigationTransformationEnabled)
 			{
 			/* Go back to physical coordinates: */
@@ -2766,10 +2816,10 @@ Cluster::MulticastPipe* getMainPipe(void)
 	return vruiState->pipe;
 	}
 
-Cluster::MulticastPipe* openPipe(void)
+Cluster::MulticastPipe* openPipe(bool compressed)
 	{
 	if(vruiState->multiplexer!=0)
-		return new Cluster::MulticastPipe(vruiState->multiplexer);
+		return new Cluster::MulticastPipe(vruiState->multiplexer,compressed);
 	else
 		return 0;
 	}
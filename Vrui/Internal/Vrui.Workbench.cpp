@@ -80,6 +80,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Vrui/ToolManager.h>
 #include <Vrui/VisletManager.h>
 #include <Vrui/ViewSpecification.h>
+#include <Vrui/FrameProfiler.h>
 
 #include <Vrui/Internal/Vrui.h>
 #include <Vrui/Internal/Config.h>
@@ -122,6 +123,32 @@ struct SynchronousIOCallbackSlot
 
 typedef std::vector<SynchronousIOCallbackSlot> SynchronousIOCallbackList;
 
+struct VruiFrameLatencyStatistics // Structure to accumulate the latencies between updating the Vrui state and completing the corresponding frames' buffer swaps
+	{
+	/* Elements: */
+	public:
+	unsigned int numFrames; // Number of measured frames
+	double latencySum; // Sum of all measured latencies in seconds
+	double latencyMax; // Maximum measured latency in seconds
+	
+	/* Constructors and destructors: */
+	VruiFrameLatencyStatistics(void)
+		:numFrames(0),latencySum(0.0),latencyMax(0.0)
+		{
+		}
+	
+	/* Methods: */
+	void addFrame(const Realtime::TimePointMonotonic& updateTime) // Adds a frame whose state was updated at the given time and whose buffer swaps just completed
+		{
+		Realtime::TimePointMonotonic now;
+		double latency=double(now-updateTime);
+		++numFrames;
+		latencySum+=latency;
+		if(latencyMax<latency)
+			latencyMax=latency;
+		}
+	};
+
 struct VruiWindowGroup
 	{
 	/* Embedded classes: */
@@ -188,6 +215,7 @@ VRWindow** vruiTotalWindows=0;
 Threads::Thread* vruiRenderingThreads=0;
 Threads::Barrier vruiRenderingBarrier;
 volatile bool vruiStopRenderingThreads=false;
+bool vruiPipelineFrames=false;
 #endif
 int vruiNumSoundContexts=0;
 SoundContext** vruiSoundContexts=0;
@@ -198,6 +226,7 @@ pid_t* vruiSlavePids=0;
 int vruiSlaveArgc=0;
 char** vruiSlaveArgv=0;
 char** vruiSlaveArgvShadow=0;
+bool vruiPrintClusterStatistics=false;
 volatile bool vruiAsynchronousShutdown=false;
 
 /*****************************************
@@ -612,6 +641,61 @@ bool vruiCreateWindowGroup(const VruiWindowGroupCreator& group)
 	return allWindowsOk;
 	}
 
+void vruiPrintWaitTimes(const char* name,const Cluster::Multiplexer::WaitTimeHistogram& waits)
+	{
+	std::cout<<"Vrui:   "<<name<<": "<<waits.numWaits<<" waits, average "<<waits.getAverageWaitTime()*1000.0<<" ms, maximum "<<waits.maxWaitTime*1000.0<<" ms"<<std::endl;
+	if(waits.numWaits>0)
+		{
+		/* Print all non-empty histogram bins: */
+		std::cout<<"Vrui:    ";
+		for(unsigned int i=0;i<Cluster::Multiplexer::numWaitTimeBins;++i)
+			if(waits.bins[i]>0)
+				{
+				if(i<Cluster::Multiplexer::numWaitTimeBins-1)
+					std::cout<<" <"<<Cluster::Multiplexer::WaitTimeHistogram::getBinLimit(i)*1000.0<<" ms: "<<waits.bins[i];
+				else
+					std::cout<<" longer: "<<waits.bins[i];
+				}
+		std::cout<<std::endl;
+		}
+	}
+
+void vruiPrintMultiplexerStatistics(const Cluster::Multiplexer& multiplexer)
+	{
+	/* Print the master's overall traffic statistics: */
+	Cluster::Multiplexer::TrafficStatistics ts=multiplexer.getTrafficStatistics();
+	std::cout<<"Vrui: Cluster communication statistics:"<<std::endl;
+	std::cout<<"Vrui:   Sent "<<ts.numSentPackets<<" packets, "<<ts.numSentBytes<<" bytes in "<<ts.numSendCalls<<" system calls"<<std::endl;
+	std::cout<<"Vrui:   Re-sent "<<ts.numResentPackets<<" packets, "<<ts.numResentBytes<<" bytes; sent "<<ts.numParityPackets<<" parity packets, "<<ts.numBulkPackets<<" bulk packets, "<<ts.numBulkRewinds<<" bulk rewinds"<<std::endl;
+	vruiPrintWaitTimes("Barriers",ts.barrierWaits);
+	vruiPrintWaitTimes("Gathers",ts.gatherWaits);
+	
+	/* Print the statistics of all open pipes: */
+	std::vector<Cluster::Multiplexer::PipeStatistics> pipeStatistics;
+	multiplexer.getPipeStatistics(pipeStatistics);
+	for(std::vector<Cluster::Multiplexer::PipeStatistics>::iterator psIt=pipeStatistics.begin();psIt!=pipeStatistics.end();++psIt)
+		{
+		std::cout<<"Vrui:   Pipe "<<psIt->pipeId<<": "<<psIt->numPackets<<" packets, "<<psIt->numBytes<<" bytes, ";
+		std::cout<<psIt->numResentPackets<<" re-sent packets, "<<psIt->numLossNacks<<" loss reports, "<<psIt->barrierWaits.numWaits<<" barriers, "<<psIt->gatherWaits.numWaits<<" gathers"<<std::endl;
+		}
+	
+	/* Print the health statistics of all slaves and find the slowest one: */
+	unsigned int slowestSlave=0;
+	size_t maxNumLastArrivals=0;
+	for(unsigned int slaveIndex=1;slaveIndex<multiplexer.getNumNodes();++slaveIndex)
+		{
+		Cluster::Multiplexer::SlaveStatistics ss=multiplexer.getSlaveStatistics(slaveIndex);
+		std::cout<<"Vrui:   Slave "<<slaveIndex<<": "<<ss.numLossNacks<<" loss reports, last to arrive at "<<ss.numLastArrivals<<" barriers, "<<ss.maxStreamLag<<" bytes behind"<<std::endl;
+		if(maxNumLastArrivals<ss.numLastArrivals)
+			{
+			slowestSlave=slaveIndex;
+			maxNumLastArrivals=ss.numLastArrivals;
+			}
+		}
+	if(slowestSlave!=0)
+		std::cout<<"Vrui:   Slave "<<slowestSlave<<" held up the most barriers"<<std::endl;
+	}
+
 #if GLSUPPORT_CONFIG_USE_TLS
 
 void* vruiRenderingThreadFunction(VruiWindowGroupCreator group)
@@ -619,6 +703,9 @@ void* vruiRenderingThreadFunction(VruiWindowGroupCreator group)
 	Threads::Thread::setCancelState(Threads::Thread::CANCEL_ENABLE);
 	// Threads::Thread::setCancelType(Threads::Thread::CANCEL_ASYNCHRONOUS);
 	
+	/* Name this thread in recorded frame profiles: */
+	FrameProfiler::setThreadName("Rendering");
+	
 	/* Create all windows in this thread's group: */
 	bool allWindowsOk=vruiCreateWindowGroup(group);
 	
@@ -643,15 +730,24 @@ void* vruiRenderingThreadFunction(VruiWindowGroupCreator group)
 		for(std::vector<VruiWindowGroupCreator::VruiWindow>::iterator wIt=group.windows.begin();wIt!=group.windows.end();++wIt)
 			vruiWindows[wIt->windowIndex]->draw();
 		
-		/* Wait until all threads are done rendering: */
-		glFinish();
-		vruiRenderingBarrier.synchronize();
-		
-		if(vruiState->multiplexer)
+		if(vruiPipelineFrames)
 			{
-			/* Wait until all other nodes are done rendering: */
+			/* Submit all rendering commands and let the main thread start on the next frame while the GPU finishes this one: */
+			glFlush();
 			vruiRenderingBarrier.synchronize();
 			}
+		else
+			{
+			/* Wait until all threads are done rendering: */
+			glFinish();
+			vruiRenderingBarrier.synchronize();
+			
+			if(vruiState->multiplexer)
+				{
+				/* Wait until all other nodes are done rendering: */
+				vruiRenderingBarrier.synchronize();
+				}
+			}
 		
 		/* Swap all windows' buffers: */
 		for(std::vector<VruiWindowGroupCreator::VruiWindow>::iterator wIt=group.windows.begin();wIt!=group.windows.end();++wIt)
@@ -1043,10 +1139,13 @@ void init(int& argc,char**& argv,char**&)
 				std::string multicastGroup=vruiConfigFile->retrieveString("./multipipeMulticastGroup");
 				int multicastPort=vruiConfigFile->retrieveValue<int>("./multipipeMulticastPort");
 				unsigned int multicastSendBufferSize=vruiConfigFile->retrieveValue<unsigned int>("./multipipeSendBufferSize",16);
+				unsigned int multicastFecGroupSize=vruiConfigFile->retrieveValue<unsigned int>("./multipipeFecGroupSize",0);
+				unsigned int multicastBarrierTreeDegree=vruiConfigFile->retrieveValue<unsigned int>("./multipipeBarrierTreeDegree",0);
 				
 				/* Create the multicast multiplexer: */
-				vruiMultiplexer=new Cluster::Multiplexer(vruiNumSlaves,0,master.c_str(),masterPort,multicastGroup.c_str(),multicastPort);
+				vruiMultiplexer=new Cluster::Multiplexer(vruiNumSlaves,0,master.c_str(),masterPort,multicastGroup.c_str(),multicastPort,multicastBarrierTreeDegree);
 				vruiMultiplexer->setSendBufferSize(multicastSendBufferSize);
+				vruiMultiplexer->setFecGroupSize(multicastFecGroupSize);
 				
 				/* Determine the fully-qualified name of this process's executable: */
 				char exeName[PATH_MAX];
@@ -1142,6 +1241,10 @@ void init(int& argc,char**& argv,char**&)
 				
 				/* Register Vrui's cluster multiplexer with the Opener object of the Cluster library: */
 				Cluster::Opener::getOpener()->setMultiplexer(vruiMultiplexer);
+				Cluster::Opener::getOpener()->setLocalReplicaReads(vruiConfigFile->retrieveValue<bool>("./multipipeLocalReplicaReads",false));
+				
+				/* Check whether to print cluster communication statistics on exit: */
+				vruiPrintClusterStatistics=vruiConfigFile->retrieveValue<bool>("./multipipePrintStatistics",false);
 				}
 			catch(const std::runtime_error& err)
 				{
@@ -1454,11 +1557,29 @@ void startDisplay(void)
 		for(int i=0;i<vruiNumWindows;++i)
 			vruiWindows[i]=0;
 		
+		#if GLSUPPORT_CONFIG_USE_TLS
+		/* Check whether to update the next frame while rendering threads finish the current frame: */
+		vruiPipelineFrames=vruiConfigFile->retrieveValue<bool>("./pipelineFrames",false);
+		if(vruiPipelineFrames&&(vruiState->multiplexer!=0||vruiState->predictVsync))
+			{
+			/* Pipelining would break cluster swap locking and defeat vsync prediction: */
+			if(vruiVerbose&&vruiMaster)
+				std::cout<<"Vrui: Disabling pipelined frames in cluster or vsync prediction mode"<<std::endl;
+			vruiPipelineFrames=false;
+			}
+		#endif
+		
 		/* Initialize X11 if any windows need to be opened: */
 		if(vruiNumWindows>0)
 			{
+			#if GLSUPPORT_CONFIG_USE_TLS
+			/* Enable thread management in X11 library if the main thread handles events while rendering threads swap buffers: */
+			if(vruiPipelineFrames&&vruiNumWindows>1)
+				XInitThreads();
+			#endif
+			
 			/* Enable thread management in X11 library: */
-			// XInitThreads(); Not necessary; Vrui never makes X calls to the same display concurrently from different threads
+			// XInitThreads(); Not necessary otherwise; Vrui never makes X calls to the same display concurrently from different threads
 			
 			/* Set error handlers: */
 			XSetErrorHandler(vruiXErrorHandler);
@@ -1532,6 +1653,15 @@ void startDisplay(void)
 		/* Check if there are multiple window groups, so multiple threads can be used: */
 		vruiNumWindowGroups=int(windowGroups.getNumEntries());
 		bool allWindowsOk=true;
+		#if GLSUPPORT_CONFIG_USE_TLS
+		if(vruiPipelineFrames&&vruiNumWindowGroups<=1)
+			{
+			/* Pipelining requires separate rendering threads: */
+			if(vruiVerbose&&vruiMaster)
+				std::cout<<"Vrui: Disabling pipelined frames with fewer than two window groups"<<std::endl;
+			vruiPipelineFrames=false;
+			}
+		#endif
 		if(vruiNumWindowGroups>1)
 			{
 			#if GLSUPPORT_CONFIG_USE_TLS
@@ -1853,9 +1983,17 @@ void vruiInnerLoopMultiWindow(void)
 	Realtime::TimePointMonotonic nextFrameRate;
 	nextFrameRate+=Realtime::TimeVector(1,0);
 	unsigned int numFrames=0;
+	Realtime::TimePointMonotonic updateTime; // Time at which the Vrui state was updated for the current frame
+	#if GLSUPPORT_CONFIG_USE_TLS
+	bool swapPending=false; // Flag whether the rendering threads are still finishing the previous frame in pipelined mode
+	Realtime::TimePointMonotonic pendingUpdateTime; // Time at which the Vrui state was updated for the previous frame in pipelined mode
+	#endif
+	VruiFrameLatencyStatistics latencyStats;
 	while(keepRunning)
 		{
 		/* Handle all events, blocking if there are none unless in continuous mode: */
+		{
+		FrameProfiler::Scope eventsScope("Events");
 		if(firstFrame||vruiState->updateContinuously)
 			{
 			/* Check for and handle events without blocking: */
@@ -1867,6 +2005,7 @@ void vruiInnerLoopMultiWindow(void)
 			while(!vruiHandleAllEvents(true))
 				;
 			}
+		}
 		
 		/* Check for asynchronous shutdown: */
 		keepRunning=keepRunning&&!vruiAsynchronousShutdown;
@@ -1884,6 +2023,7 @@ void vruiInnerLoopMultiWindow(void)
 			}
 		
 		/* Update the Vrui state: */
+		updateTime.set();
 		vruiState->update();
 		
 		/* Reset the AL thing manager: */
@@ -1891,8 +2031,22 @@ void vruiInnerLoopMultiWindow(void)
 		
 		#if ALSUPPORT_CONFIG_HAVE_OPENAL
 		/* Update all sound contexts: */
+		{
+		FrameProfiler::Scope soundScope("Sound");
 		for(int i=0;i<vruiNumSoundContexts;++i)
 			vruiSoundContexts[i]->draw();
+		}
+		#endif
+		
+		#if GLSUPPORT_CONFIG_USE_TLS
+		if(swapPending)
+			{
+			/* Wait until all threads are done swapping the previous frame's buffers: */
+			FrameProfiler::Scope waitScope("WaitForRendering");
+			vruiRenderingBarrier.synchronize();
+			latencyStats.addFrame(pendingUpdateTime);
+			swapPending=false;
+			}
 		#endif
 		
 		/* Reset the GL thing manager: */
@@ -1902,24 +2056,36 @@ void vruiInnerLoopMultiWindow(void)
 			{
 			#if GLSUPPORT_CONFIG_USE_TLS
 			
+			FrameProfiler::Scope waitScope("WaitForRendering");
+			
 			/* Start the rendering cycle by synchronizing with the render threads: */
 			vruiRenderingBarrier.synchronize();
 			
 			/* Wait until all threads are done rendering: */
 			vruiRenderingBarrier.synchronize();
 			
-			if(vruiState->multiplexer!=0)
+			if(vruiPipelineFrames)
 				{
-				/* Synchronize with other nodes: */
-				vruiState->pipe->barrier();
+				/* Update the next frame while the render threads finish and swap this frame: */
+				swapPending=true;
+				pendingUpdateTime=updateTime;
+				}
+			else
+				{
+				if(vruiState->multiplexer!=0)
+					{
+					/* Synchronize with other nodes: */
+					vruiState->pipe->barrier();
+					
+					/* Notify the render threads to swap buffers: */
+					vruiRenderingBarrier.synchronize();
+					}
 				
-				/* Notify the render threads to swap buffers: */
+				/* Wait until all threads are done swapping buffers: */
 				vruiRenderingBarrier.synchronize();
+				latencyStats.addFrame(updateTime);
 				}
 			
-			/* Wait until all threads are done swapping buffers: */
-			vruiRenderingBarrier.synchronize();
-			
 			#else
 			
 			/* Render to all window groups in turn: */
@@ -1932,6 +2098,7 @@ void vruiInnerLoopMultiWindow(void)
 			if(vruiState->multiplexer!=0)
 				{
 				/* Synchronize with other nodes: */
+				FrameProfiler::Scope clusterBarrierScope("ClusterBarrier");
 				glFinish();
 				vruiState->pipe->barrier();
 				}
@@ -1945,6 +2112,7 @@ void vruiInnerLoopMultiWindow(void)
 					wgIt->window->swapBuffers();
 					}
 				}
+			latencyStats.addFrame(updateTime);
 			
 			#endif
 			}
@@ -1957,6 +2125,7 @@ void vruiInnerLoopMultiWindow(void)
 			if(vruiState->multiplexer!=0)
 				{
 				/* Synchronize with other nodes: */
+				FrameProfiler::Scope clusterBarrierScope("ClusterBarrier");
 				glFinish();
 				vruiState->pipe->barrier();
 				}
@@ -1967,6 +2136,7 @@ void vruiInnerLoopMultiWindow(void)
 				vruiWindows[i]->makeCurrent();
 				vruiWindows[i]->swapBuffers();
 				}
+			latencyStats.addFrame(updateTime);
 			}
 		else if(vruiState->multiplexer!=0)
 			{
@@ -1990,11 +2160,38 @@ void vruiInnerLoopMultiWindow(void)
 		
 		firstFrame=false;
 		}
+	
+	#if GLSUPPORT_CONFIG_USE_TLS
+	if(swapPending)
+		{
+		/* Wait until all threads are done swapping the last frame's buffers: */
+		vruiRenderingBarrier.synchronize();
+		latencyStats.addFrame(pendingUpdateTime);
+		}
+	#endif
+	
 	if(vruiNumWindows==0&&vruiState->master)
 		{
 		printf("\n");
 		fflush(stdout);
 		}
+	
+	/* Report the measured frame latency: */
+	#if GLSUPPORT_CONFIG_USE_TLS
+	bool reportLatency=vruiVerbose||vruiPipelineFrames;
+	#else
+	bool reportLatency=vruiVerbose;
+	#endif
+	if(reportLatency&&vruiState->master&&latencyStats.numFrames>0)
+		{
+		std::cout<<"Vrui: Average state update to buffer swap latency "<<latencyStats.latencySum*1000.0/double(latencyStats.numFrames)<<" ms";
+		std::cout<<" (maximum "<<latencyStats.latencyMax*1000.0<<" ms) over "<<latencyStats.numFrames<<" frames";
+		#if GLSUPPORT_CONFIG_USE_TLS
+		if(vruiPipelineFrames)
+			std::cout<<" in pipelined mode";
+		#endif
+		std::cout<<std::endl;
+		}
 	}
 
 void vruiInnerLoopSingleWindow(void)
@@ -2016,6 +2213,8 @@ void vruiInnerLoopSingleWindow(void)
 		#endif
 		
 		/* Handle all events, blocking if there are none unless in continuous mode: */
+		{
+		FrameProfiler::Scope eventsScope("Events");
 		if(firstFrame||vruiState->updateContinuously)
 			{
 			/* Check for and handle events without blocking: */
@@ -2027,6 +2226,7 @@ void vruiInnerLoopSingleWindow(void)
 			while(!vruiHandleAllEvents(true))
 				;
 			}
+		}
 		
 		/* Check for asynchronous shutdown: */
 		keepRunning=keepRunning&&!vruiAsynchronousShutdown;
@@ -2051,8 +2251,11 @@ void vruiInnerLoopSingleWindow(void)
 		
 		#if ALSUPPORT_CONFIG_HAVE_OPENAL
 		/* Update all sound contexts: */
+		{
+		FrameProfiler::Scope soundScope("Sound");
 		for(int i=0;i<vruiNumSoundContexts;++i)
 			vruiSoundContexts[i]->draw();
+		}
 		#endif
 		
 		#if VRUI_INSTRUMENT_MAINLOOP
@@ -2071,6 +2274,7 @@ void vruiInnerLoopSingleWindow(void)
 		if(vruiState->multiplexer!=0)
 			{
 			/* Synchronize with other nodes: */
+			FrameProfiler::Scope clusterBarrierScope("ClusterBarrier");
 			glFinish();
 			vruiState->pipe->barrier();
 			}
@@ -2170,6 +2374,13 @@ void mainLoop(void)
 	/* Listen for pipe commands on stdin: */
 	vruiReadFdSet.add(fileno(stdin));
 	
+	/* Configure the frame profiler: */
+	FrameProfiler::setThreadName("Main");
+	FrameProfiler::setBufferSize(vruiConfigFile->retrieveValue<unsigned int>("./frameProfilerBufferSize",65536U));
+	if(vruiConfigFile->retrieveValue<bool>("./profileFrames",false))
+		FrameProfiler::setEnabled(true);
+	std::string frameProfilerTraceFileName=vruiConfigFile->retrieveString("./frameProfilerTraceFileName",std::string());
+	
 	/* Perform the main loop until the quit command is entered: */
 	if(vruiVerbose&&vruiMaster)
 		std::cout<<"Vrui: Entering main loop"<<std::endl;
@@ -2187,6 +2398,21 @@ void mainLoop(void)
 	if(vruiVerbose&&vruiMaster)
 		std::cout<<" Ok"<<std::endl;
 	
+	/* Export the recorded frame profile: */
+	if(!frameProfilerTraceFileName.empty()&&vruiMaster)
+		{
+		try
+			{
+			FrameProfiler::writeChromeTrace(frameProfilerTraceFileName.c_str());
+			if(vruiVerbose)
+				std::cout<<"Vrui: Wrote frame profile to "<<frameProfilerTraceFileName<<std::endl;
+			}
+		catch(const std::runtime_error& err)
+			{
+			std::cerr<<"Vrui: Unable to write frame profile due to exception "<<err.what()<<std::endl;
+			}
+		}
+	
 	/* Shut down the rendering system: */
 	if(vruiVerbose&&vruiMaster)
 		std::cout<<"Vrui: Shutting down graphics subsystem..."<<std::flush;
@@ -2262,6 +2488,10 @@ void deinit(void)
 		/* Unregister the multiplexer from the Cluster::Opener object: */
 		Cluster::Opener::getOpener()->setMultiplexer(0);
 		
+		/* Print cluster communication statistics if requested: */
+		if(vruiPrintClusterStatistics&&vruiMaster)
+			vruiPrintMultiplexerStatistics(*vruiMultiplexer);
+		
 		/* Destroy the multiplexer: */
 		if(vruiVerbose&&vruiMaster)
 			std::cout<<"Vrui: Shutting down intra-cluster communication..."<<std::flush;
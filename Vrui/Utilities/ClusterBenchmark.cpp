@@ -0,0 +1,437 @@
+/***********************************************************************
+ClusterBenchmark - Program to measure the multicast pipe throughput and
+the barrier and gather latencies of a simulated cluster running on the
+local host, with emulated packet loss, reordering, latency, and
+bandwidth limits.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <new>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <Misc/SizedTypes.h>
+#include <Cluster/Multiplexer.h>
+#include <Cluster/MulticastPipe.h>
+#include <Cluster/NetworkEmulator.h>
+
+/**************************************
+Settings and results of benchmark runs:
+**************************************/
+
+struct BenchmarkSettings
+	{
+	/* Elements: */
+	public:
+	unsigned int numSlaves; // Number of slave nodes in the simulated cluster
+	int masterPortNumber; // Port number for the master node; slave nodes use consecutive port numbers
+	unsigned int fecGroupSize; // Forward error correction group size for the multiplexer
+	unsigned int barrierTreeDegree; // Barrier tree degree for the multiplexer
+	size_t dataSize; // Amount of data to send through a multicast pipe in bytes
+	size_t chunkSize; // Amount of data written or read in a single call
+	bool bulk; // Flag whether to send most of each chunk as a bulk transfer
+	bool compress; // Flag whether the multicast pipe compresses data
+	unsigned int asyncQueueSize; // Size of the multicast pipe's asynchronous send queue in packets; 0 sends synchronously
+	unsigned int numIterations; // Number of barriers and gathers to time
+	};
+
+struct NodeResults
+	{
+	/* Elements: */
+	public:
+	double throughput; // Multicast pipe throughput in bytes per second
+	double averageWriteTime; // Average time the master spent writing a chunk in seconds
+	double maxWriteTime; // Longest time the master spent writing a chunk in seconds
+	double barrierLatency; // Average barrier latency in seconds
+	double gatherLatency; // Average gather latency in seconds
+	unsigned int numDataErrors; // Number of slave nodes that received corrupted data
+	unsigned int numGatherErrors; // Number of gather operations that returned a wrong value
+	Cluster::Multiplexer::TrafficStatistics statistics; // Traffic statistics of the node at the end of the run
+	Cluster::MulticastPipe::CompressionStatistics compressionStatistics; // Compression statistics of the node's multicast pipe
+	bool finished; // Flag whether the node finished the benchmark run
+	};
+
+/****************
+Helper functions:
+****************/
+
+double getTime(void)
+	{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return double(now.tv_sec)+double(now.tv_nsec)*1.0e-9;
+	}
+
+void runNode(const BenchmarkSettings& s,unsigned int nodeIndex,NodeResults& results)
+	{
+	/* Connect the node to the cluster through the network emulator, which binds to the two port numbers following the slaves' port numbers: */
+	bool master=nodeIndex==0;
+	int masterPortNumber=master?s.masterPortNumber:s.masterPortNumber+int(s.numSlaves)+2;
+	int slavePortNumber=master?s.masterPortNumber+int(s.numSlaves)+1:s.masterPortNumber+int(nodeIndex);
+	Cluster::Multiplexer multiplexer(s.numSlaves,nodeIndex,"localhost",masterPortNumber,"localhost",slavePortNumber,s.barrierTreeDegree);
+	multiplexer.setFecGroupSize(s.fecGroupSize);
+	multiplexer.waitForConnection();
+	
+	{
+	Cluster::MulticastPipe pipe(&multiplexer,s.compress);
+	if(s.asyncQueueSize>0)
+		pipe.setAsyncSend(s.asyncQueueSize);
+	
+	/* Measure pipe throughput, and check the received data on the slaves: */
+	size_t numWords=s.chunkSize/sizeof(Misc::UInt32);
+	Misc::UInt32* buffer=new Misc::UInt32[numWords];
+	unsigned int dataError=0;
+	pipe.barrier();
+	double start=getTime();
+	Misc::UInt32 nextWord=0;
+	size_t numChunks=0;
+	double totalWriteTime=0.0;
+	results.maxWriteTime=0.0;
+	for(size_t sent=0;sent<s.dataSize;sent+=numWords*sizeof(Misc::UInt32),++numChunks)
+		{
+		if(master)
+			{
+			for(size_t i=0;i<numWords;++i,++nextWord)
+				buffer[i]=nextWord;
+			double writeStart=getTime();
+			if(s.bulk)
+				{
+				/* Send the chunk's first word through the stream and the rest as a bulk transfer: */
+				pipe.write(buffer,1);
+				pipe.bulkBroadcast(buffer+1,(numWords-1)*sizeof(Misc::UInt32));
+				}
+			else
+				pipe.write(buffer,numWords);
+			
+			/* Send each chunk as a separate message in asynchronous mode: */
+			if(s.asyncQueueSize>0)
+				pipe.finishMessage();
+			double writeTime=getTime()-writeStart;
+			totalWriteTime+=writeTime;
+			if(results.maxWriteTime<writeTime)
+				results.maxWriteTime=writeTime;
+			}
+		else
+			{
+			if(s.bulk)
+				{
+				pipe.read(buffer,1);
+				pipe.bulkBroadcast(buffer+1,(numWords-1)*sizeof(Misc::UInt32));
+				}
+			else
+				pipe.read(buffer,numWords);
+			for(size_t i=0;i<numWords;++i,++nextWord)
+				if(buffer[i]!=nextWord)
+					dataError=1;
+			}
+		}
+	pipe.flush();
+	pipe.barrier();
+	results.throughput=double(s.dataSize)/(getTime()-start);
+	results.averageWriteTime=numChunks>0?totalWriteTime/double(numChunks):0.0;
+	delete[] buffer;
+	results.numDataErrors=pipe.gather(dataError,Cluster::GatherOperation::SUM);
+	results.compressionStatistics=pipe.getCompressionStatistics();
+	
+	/* Measure barrier latency: */
+	start=getTime();
+	for(unsigned int i=0;i<s.numIterations;++i)
+		pipe.barrier();
+	results.barrierLatency=(getTime()-start)/double(s.numIterations);
+	
+	/* Measure gather latency, and check the gathered values: */
+	unsigned int expectedSum=(s.numSlaves*(s.numSlaves+1))/2;
+	results.numGatherErrors=0;
+	start=getTime();
+	for(unsigned int i=0;i<s.numIterations;++i)
+		if(pipe.gather(nodeIndex,Cluster::GatherOperation::SUM)!=expectedSum)
+			++results.numGatherErrors;
+	results.gatherLatency=(getTime()-start)/double(s.numIterations);
+	
+	/* Wait for all nodes to finish before shutting down the cluster: */
+	pipe.barrier();
+	}
+	
+	results.statistics=multiplexer.getTrafficStatistics();
+	
+	/* Keep the master's multiplexer alive for a moment to answer slaves that missed the completion message of the final barrier: */
+	if(master)
+		usleep(1000000);
+	
+	results.finished=true;
+	}
+
+bool runBenchmark(const BenchmarkSettings& settings,const Cluster::NetworkEmulator::LinkParameters& linkParameters,NodeResults* nodeResults,Cluster::NetworkEmulator::LinkStatistics& downstreamStatistics)
+	{
+	/* Run all cluster nodes in their own processes, as multiplexers match pipes across nodes by the IDs of the threads creating them: */
+	unsigned int numNodes=settings.numSlaves+1;
+	pid_t* nodePids=new pid_t[numNodes];
+	for(unsigned int i=0;i<numNodes;++i)
+		{
+		new(&nodeResults[i]) NodeResults;
+		nodeResults[i].finished=false;
+		nodePids[i]=fork();
+		if(nodePids[i]==0)
+			{
+			/* Run the node and return its results through shared memory: */
+			int exitCode=0;
+			try
+				{
+				runNode(settings,i,nodeResults[i]);
+				}
+			catch(const std::runtime_error& err)
+				{
+				std::cerr<<"Node "<<i<<": Caught exception "<<err.what()<<std::endl;
+				exitCode=1;
+				}
+			_exit(exitCode);
+			}
+		}
+	
+	bool ok=true;
+	try
+		{
+		/* Create a network emulator between the master node and the slave nodes: */
+		int* slavePortNumbers=new int[settings.numSlaves];
+		for(unsigned int i=0;i<settings.numSlaves;++i)
+			slavePortNumbers[i]=settings.masterPortNumber+int(i)+1;
+		Cluster::NetworkEmulator emulator(settings.masterPortNumber,settings.numSlaves,slavePortNumbers,settings.masterPortNumber+int(settings.numSlaves)+1,settings.masterPortNumber+int(settings.numSlaves)+2);
+		delete[] slavePortNumbers;
+		emulator.setDownstreamParameters(linkParameters);
+		emulator.setUpstreamParameters(linkParameters);
+		
+		/* Wait for all nodes to finish: */
+		for(unsigned int i=0;i<numNodes;++i)
+			{
+			int status;
+			waitpid(nodePids[i],&status,0);
+			if(!nodeResults[i].finished)
+				ok=false;
+			}
+		
+		downstreamStatistics=emulator.getDownstreamStatistics();
+		}
+	catch(const std::runtime_error& err)
+		{
+		std::cerr<<"Caught exception "<<err.what()<<std::endl;
+		for(unsigned int i=0;i<numNodes;++i)
+			kill(nodePids[i],SIGTERM);
+		ok=false;
+		}
+	delete[] nodePids;
+	
+	return ok;
+	}
+
+void printUsage(void)
+	{
+	std::cout<<"Usage: ClusterBenchmark [option 1] ... [option n]"<<std::endl;
+	std::cout<<"  Options:"<<std::endl;
+	std::cout<<"  -maxSlaves <number>"<<std::endl;
+	std::cout<<"     Runs the benchmark on clusters of 1, 2, 4, ... up to the given number of"<<std::endl;
+	std::cout<<"     slave nodes. Default: 8"<<std::endl;
+	std::cout<<"  -port <port number>"<<std::endl;
+	std::cout<<"     Port number for the master node; slaves and the network emulator use the"<<std::endl;
+	std::cout<<"     following port numbers."<<std::endl;
+	std::cout<<"     Default: 26000"<<std::endl;
+	std::cout<<"  -size <size in MB>"<<std::endl;
+	std::cout<<"     Amount of data to send through a multicast pipe. Default: 64"<<std::endl;
+	std::cout<<"  -chunk <size in bytes>"<<std::endl;
+	std::cout<<"     Amount of data written or read in a single call. Default: 65536"<<std::endl;
+	std::cout<<"  -bulk"<<std::endl;
+	std::cout<<"     Sends most of each chunk as a zero-copy bulk transfer."<<std::endl;
+	std::cout<<"  -compress"<<std::endl;
+	std::cout<<"     Compresses data sent through the multicast pipe, and reports the"<<std::endl;
+	std::cout<<"     compression ratio and the master's compression time."<<std::endl;
+	std::cout<<"  -async <queue size>"<<std::endl;
+	std::cout<<"     Sends each chunk as an asynchronous message through a queue holding the"<<std::endl;
+	std::cout<<"     given number of packets, and reports the time the master spent writing"<<std::endl;
+	std::cout<<"     chunks. Default: 0 (synchronous)"<<std::endl;
+	std::cout<<"  -iterations <number>"<<std::endl;
+	std::cout<<"     Number of barriers and gathers to time. Default: 1000"<<std::endl;
+	std::cout<<"  -loss <probability>"<<std::endl;
+	std::cout<<"     Probability of dropping a datagram. Default: 0"<<std::endl;
+	std::cout<<"  -reorder <probability>"<<std::endl;
+	std::cout<<"     Probability of delaying a datagram behind the following ones. Default: 0"<<std::endl;
+	std::cout<<"  -latency <latency in ms>"<<std::endl;
+	std::cout<<"     One-way latency of all links. Default: 0"<<std::endl;
+	std::cout<<"  -bandwidth <bandwidth in MB/s>"<<std::endl;
+	std::cout<<"     Bandwidth of all links; 0 means unlimited. Default: 0"<<std::endl;
+	std::cout<<"  -fec <group size>"<<std::endl;
+	std::cout<<"     Forward error correction group size; 0 disables FEC. Default: 0"<<std::endl;
+	std::cout<<"  -treeDegree <degree>"<<std::endl;
+	std::cout<<"     Maximum number of children of each node in the tree along which slaves"<<std::endl;
+	std::cout<<"     report barriers and gathers; 0 reports directly to the master. Default: 0"<<std::endl;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	unsigned int maxSlaves=8;
+	BenchmarkSettings settings;
+	settings.masterPortNumber=26000;
+	settings.fecGroupSize=0;
+	settings.barrierTreeDegree=0;
+	settings.dataSize=64*1024*1024;
+	settings.chunkSize=65536;
+	settings.bulk=false;
+	settings.compress=false;
+	settings.asyncQueueSize=0;
+	settings.numIterations=1000;
+	Cluster::NetworkEmulator::LinkParameters linkParameters;
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"h")==0)
+				{
+				printUsage();
+				return 0;
+				}
+			else if(strcasecmp(argv[i]+1,"bulk")==0)
+				settings.bulk=true;
+			else if(strcasecmp(argv[i]+1,"compress")==0)
+				settings.compress=true;
+			else if(i+1>=argc)
+				{
+				std::cerr<<"Dangling option "<<argv[i]<<std::endl;
+				return 1;
+				}
+			else if(strcasecmp(argv[i]+1,"maxSlaves")==0)
+				maxSlaves=(unsigned int)(atoi(argv[++i]));
+			else if(strcasecmp(argv[i]+1,"port")==0)
+				settings.masterPortNumber=atoi(argv[++i]);
+			else if(strcasecmp(argv[i]+1,"size")==0)
+				settings.dataSize=size_t(atof(argv[++i])*1024.0*1024.0);
+			else if(strcasecmp(argv[i]+1,"chunk")==0)
+				settings.chunkSize=size_t(atoi(argv[++i]));
+			else if(strcasecmp(argv[i]+1,"iterations")==0)
+				settings.numIterations=(unsigned int)(atoi(argv[++i]));
+			else if(strcasecmp(argv[i]+1,"loss")==0)
+				linkParameters.lossRate=atof(argv[++i]);
+			else if(strcasecmp(argv[i]+1,"reorder")==0)
+				linkParameters.reorderRate=atof(argv[++i]);
+			else if(strcasecmp(argv[i]+1,"latency")==0)
+				linkParameters.latency=atof(argv[++i])*1.0e-3;
+			else if(strcasecmp(argv[i]+1,"bandwidth")==0)
+				linkParameters.bandwidth=atof(argv[++i])*1024.0*1024.0;
+			else if(strcasecmp(argv[i]+1,"fec")==0)
+				settings.fecGroupSize=(unsigned int)(atoi(argv[++i]));
+			else if(strcasecmp(argv[i]+1,"treeDegree")==0)
+				settings.barrierTreeDegree=(unsigned int)(atoi(argv[++i]));
+			else if(strcasecmp(argv[i]+1,"async")==0)
+				settings.asyncQueueSize=(unsigned int)(atoi(argv[++i]));
+			else
+				{
+				std::cerr<<"Unknown option "<<argv[i]<<std::endl;
+				printUsage();
+				return 1;
+				}
+			}
+		else
+			{
+			std::cerr<<"Unknown parameter "<<argv[i]<<std::endl;
+			printUsage();
+			return 1;
+			}
+		}
+	if(maxSlaves<1)
+		maxSlaves=1;
+	if(settings.chunkSize<2*sizeof(Misc::UInt32))
+		settings.chunkSize=2*sizeof(Misc::UInt32);
+	if(settings.numIterations<1)
+		settings.numIterations=1;
+	
+	/* Allocate shared memory to receive results from the cluster nodes: */
+	size_t resultsSize=(maxSlaves+1)*sizeof(NodeResults);
+	void* resultsMemory=mmap(0,resultsSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0);
+	if(resultsMemory==MAP_FAILED)
+		{
+		std::cerr<<"Unable to allocate shared memory"<<std::endl;
+		return 1;
+		}
+	NodeResults* nodeResults=static_cast<NodeResults*>(resultsMemory);
+	
+	/* Run the benchmark for increasing cluster sizes: */
+	std::cout<<"Slaves  Throughput  Barrier  Gather  Dropped  Recovered  NACKs  Resent  Errors"<<std::endl;
+	std::cout<<"          (MB/s)     (us)    (us)                             (KB)"<<std::endl;
+	bool ok=true;
+	for(settings.numSlaves=1;settings.numSlaves<=maxSlaves;settings.numSlaves*=2)
+		{
+		/* Always include the maximum cluster size: */
+		if(settings.numSlaves*2>maxSlaves)
+			settings.numSlaves=maxSlaves;
+		
+		Cluster::NetworkEmulator::LinkStatistics downstreamStatistics;
+		if(!runBenchmark(settings,linkParameters,nodeResults,downstreamStatistics))
+			{
+			std::cout<<std::setw(6)<<settings.numSlaves<<"  failed"<<std::endl;
+			ok=false;
+			break;
+			}
+		
+		/* Accumulate the slaves' loss recovery statistics: */
+		size_t numRecoveredPackets=0;
+		size_t numLossNacks=0;
+		for(unsigned int i=1;i<=settings.numSlaves;++i)
+			{
+			numRecoveredPackets+=nodeResults[i].statistics.numRecoveredPackets;
+			numLossNacks+=nodeResults[i].statistics.numLossNacks;
+			}
+		
+		/* Print the results as measured by the master: */
+		const NodeResults& r=nodeResults[0];
+		unsigned int numErrors=r.numDataErrors+r.numGatherErrors;
+		std::cout<<std::setw(6)<<settings.numSlaves;
+		std::cout<<"  "<<std::setw(10)<<std::fixed<<std::setprecision(1)<<r.throughput/(1024.0*1024.0);
+		std::cout<<"  "<<std::setw(7)<<std::setprecision(1)<<r.barrierLatency*1.0e6;
+		std::cout<<"  "<<std::setw(6)<<std::setprecision(1)<<r.gatherLatency*1.0e6;
+		std::cout<<"  "<<std::setw(7)<<downstreamStatistics.numLostDatagrams+downstreamStatistics.numQueueDrops;
+		std::cout<<"  "<<std::setw(9)<<numRecoveredPackets;
+		std::cout<<"  "<<std::setw(5)<<numLossNacks;
+		std::cout<<"  "<<std::setw(6)<<r.statistics.numResentBytes/1024;
+		std::cout<<"  "<<std::setw(6)<<numErrors<<std::endl;
+		if(settings.compress)
+			{
+			/* Print the master's compression statistics: */
+			const Cluster::MulticastPipe::CompressionStatistics& cs=r.compressionStatistics;
+			std::cout<<"        Compression: "<<cs.numCompressedBlocks<<" of "<<cs.numBlocks<<" blocks compressed, ratio ";
+			std::cout<<std::setprecision(2)<<(cs.numSentBytes>0?double(cs.numUncompressedBytes)/double(cs.numSentBytes):1.0);
+			std::cout<<", "<<std::setprecision(1)<<cs.codecTime*1.0e3<<" ms"<<std::endl;
+			}
+		
+		/* Print the time the master's application thread was blocked writing chunks: */
+		std::cout<<"        Chunk writes: "<<std::setprecision(3)<<r.averageWriteTime*1.0e3<<" ms average, "<<r.maxWriteTime*1.0e3<<" ms maximum"<<std::endl;
+		if(numErrors!=0)
+			ok=false;
+		}
+	
+	munmap(resultsMemory,resultsSize);
+	
+	return ok?0:1;
+	}
@@ -0,0 +1,355 @@
+/***********************************************************************
+ParseBenchmark - Program to measure the throughput and accuracy of
+IO::ValueSource and IO::CSVSource when parsing representative ASCII
+data formats, such as point sets, earthquake catalogs, and mesh
+indices.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <IO/File.h>
+#include <IO/OpenFile.h>
+#include <IO/ValueSource.h>
+#include <IO/CSVSource.h>
+
+/****************
+Helper functions:
+****************/
+
+double getTime(void)
+	{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return double(now.tv_sec)+double(now.tv_nsec)*1.0e-9;
+	}
+
+double randomValue(double min,double max) // Returns a uniformly distributed random number
+	{
+	return min+(max-min)*double(rand())/double(RAND_MAX);
+	}
+
+class Format // Base class for benchmarked ASCII formats
+	{
+	/* Elements: */
+	protected:
+	std::vector<double> values; // The numeric values written to the file, as converted by the C library
+	
+	/* Protected methods: */
+	void printValue(FILE* file,const char* format,double value) // Writes a value to the file and remembers its exact conversion
+		{
+		char buffer[64];
+		snprintf(buffer,sizeof(buffer),format,value);
+		fputs(buffer,file);
+		values.push_back(strtod(buffer,0));
+		}
+	
+	/* Constructors and destructors: */
+	public:
+	virtual ~Format(void)
+		{
+		}
+	
+	/* Methods: */
+	virtual const char* getName(void) const =0; // Returns the format's name
+	virtual void write(FILE* file,size_t size) =0; // Writes approximately the given amount of data in the format to the given file
+	virtual size_t parse(IO::FilePtr file,std::vector<double>& parsedValues) const =0; // Parses the given file and returns the number of parsed values
+	const std::vector<double>& getValues(void) const // Returns the values written to the file
+		{
+		return values;
+		}
+	};
+
+class PointSetFormat:public Format // Whitespace-separated point coordinates, parsed via ValueSource
+	{
+	/* Methods from Format: */
+	public:
+	virtual const char* getName(void) const
+		{
+		return "Point set (ValueSource)";
+		}
+	virtual void write(FILE* file,size_t size)
+		{
+		while(size_t(ftell(file))<size)
+			{
+			printValue(file,"%.6f",randomValue(-10000.0,10000.0));
+			fputc(' ',file);
+			printValue(file,"%.6f",randomValue(-10000.0,10000.0));
+			fputc(' ',file);
+			printValue(file,"%.3f",randomValue(-100.0,100.0));
+			fputc('\n',file);
+			}
+		}
+	virtual size_t parse(IO::FilePtr file,std::vector<double>& parsedValues) const
+		{
+		IO::ValueSource source(file);
+		source.skipWs();
+		while(!source.eof())
+			parsedValues.push_back(source.readNumber());
+		return parsedValues.size();
+		}
+	};
+
+class CatalogFormat:public Format // Earthquake catalog with time stamps, positions, magnitudes, and string fields, parsed via CSVSource
+	{
+	/* Methods from Format: */
+	public:
+	virtual const char* getName(void) const
+		{
+		return "Earthquake catalog (CSVSource)";
+		}
+	virtual void write(FILE* file,size_t size)
+		{
+		fputs("time,latitude,longitude,depth,mag,magType,net\n",file);
+		while(size_t(ftell(file))<size)
+			{
+			fprintf(file,"2020-%02d-%02dT%02d:%02d:%02d.%03dZ,",rand()%12+1,rand()%28+1,rand()%24,rand()%60,rand()%60,rand()%1000);
+			printValue(file,"%.4f",randomValue(-90.0,90.0));
+			fputc(',',file);
+			printValue(file,"%.4f",randomValue(-180.0,180.0));
+			fputc(',',file);
+			printValue(file,"%.2f",randomValue(0.0,700.0));
+			fputc(',',file);
+			printValue(file,"%.1f",randomValue(-1.0,8.0));
+			fputs(",ml,nc\n",file);
+			}
+		}
+	virtual size_t parse(IO::FilePtr file,std::vector<double>& parsedValues) const
+		{
+		IO::CSVSource source(file);
+		source.skipRecord();
+		while(!source.eof())
+			{
+			source.skipField();
+			for(int i=0;i<4;++i)
+				parsedValues.push_back(source.readField<double>());
+			source.skipRecord();
+			}
+		return parsedValues.size();
+		}
+	};
+
+class ScientificFormat:public Format // Full-precision values in exponential notation, parsed via CSVSource
+	{
+	/* Methods from Format: */
+	public:
+	virtual const char* getName(void) const
+		{
+		return "Full precision (CSVSource)";
+		}
+	virtual void write(FILE* file,size_t size)
+		{
+		while(size_t(ftell(file))<size)
+			{
+			for(int i=0;i<4;++i)
+				{
+				if(i>0)
+					fputc(',',file);
+				printValue(file,"%.17g",randomValue(-1.0,1.0)*pow(10.0,double(rand()%41-20)));
+				}
+			fputc('\n',file);
+			}
+		}
+	virtual size_t parse(IO::FilePtr file,std::vector<double>& parsedValues) const
+		{
+		IO::CSVSource source(file);
+		while(!source.eof())
+			parsedValues.push_back(source.readField<double>());
+		return parsedValues.size();
+		}
+	};
+
+class IndexFormat:public Format // Whitespace-separated mesh vertex indices, parsed via ValueSource
+	{
+	/* Methods from Format: */
+	public:
+	virtual const char* getName(void) const
+		{
+		return "Mesh indices (ValueSource)";
+		}
+	virtual void write(FILE* file,size_t size)
+		{
+		while(size_t(ftell(file))<size)
+			{
+			fputs("3",file);
+			for(int i=0;i<3;++i)
+				{
+				fputc(' ',file);
+				printValue(file,"%.0f",double(rand()%10000000));
+				}
+			fputc('\n',file);
+			}
+		}
+	virtual size_t parse(IO::FilePtr file,std::vector<double>& parsedValues) const
+		{
+		IO::ValueSource source(file);
+		source.skipWs();
+		while(!source.eof())
+			{
+			source.readUnsignedInteger();
+			for(int i=0;i<3;++i)
+				parsedValues.push_back(double(source.readInteger()));
+			}
+		return parsedValues.size();
+		}
+	};
+
+void printUsage(void)
+	{
+	std::cout<<"Usage: ParseBenchmark [option 1] ... [option n]"<<std::endl;
+	std::cout<<"  Options:"<<std::endl;
+	std::cout<<"  -h"<<std::endl;
+	std::cout<<"     Prints this help message"<<std::endl;
+	std::cout<<"  -size <size in MB>"<<std::endl;
+	std::cout<<"     Approximate size of the generated file for each format. Default: 64"<<std::endl;
+	std::cout<<"  -iterations <number>"<<std::endl;
+	std::cout<<"     Number of times each file is parsed; the fastest run is reported."<<std::endl;
+	std::cout<<"     Default: 3"<<std::endl;
+	std::cout<<"  -dir <directory name>"<<std::endl;
+	std::cout<<"     Directory in which to create the temporary files. Default: /tmp"<<std::endl;
+	}
+
+int main(int argc,char* argv[])
+	{
+	/* Parse the command line: */
+	size_t size=64*1024*1024;
+	unsigned int numIterations=3;
+	std::string dirName="/tmp";
+	for(int i=1;i<argc;++i)
+		{
+		if(argv[i][0]=='-')
+			{
+			if(strcasecmp(argv[i]+1,"h")==0)
+				{
+				printUsage();
+				return 0;
+				}
+			else if(i+1>=argc)
+				{
+				std::cerr<<"Dangling option "<<argv[i]<<std::endl;
+				return 1;
+				}
+			else if(strcasecmp(argv[i]+1,"size")==0)
+				size=size_t(atof(argv[++i])*1024.0*1024.0);
+			else if(strcasecmp(argv[i]+1,"iterations")==0)
+				numIterations=(unsigned int)(atoi(argv[++i]));
+			else if(strcasecmp(argv[i]+1,"dir")==0)
+				dirName=argv[++i];
+			else
+				{
+				std::cerr<<"Unknown option "<<argv[i]<<std::endl;
+				printUsage();
+				return 1;
+				}
+			}
+		else
+			{
+			std::cerr<<"Unknown parameter "<<argv[i]<<std::endl;
+			printUsage();
+			return 1;
+			}
+		}
+	if(numIterations<1)
+		numIterations=1;
+	
+	/* Create the benchmarked formats: */
+	std::vector<Format*> formats;
+	formats.push_back(new PointSetFormat);
+	formats.push_back(new CatalogFormat);
+	formats.push_back(new ScientificFormat);
+	formats.push_back(new IndexFormat);
+	
+	std::cout<<"Format                            Size (MB)     Values  Throughput (MB/s)  Errors"<<std::endl;
+	bool ok=true;
+	for(std::vector<Format*>::iterator fIt=formats.begin();fIt!=formats.end();++fIt)
+		{
+		/* Write the format's test file: */
+		std::string fileName=dirName+"/ParseBenchmarkXXXXXX";
+		std::vector<char> fileNameBuffer(fileName.begin(),fileName.end());
+		fileNameBuffer.push_back('\0');
+		int fd=mkstemp(&fileNameBuffer[0]);
+		if(fd<0)
+			{
+			std::cerr<<"Unable to create temporary file in "<<dirName<<std::endl;
+			ok=false;
+			break;
+			}
+		FILE* file=fdopen(fd,"w");
+		srand(1);
+		(*fIt)->write(file,size);
+		size_t fileSize=size_t(ftell(file));
+		fclose(file);
+		
+		/* Parse the file repeatedly and keep the fastest time: */
+		double bestTime=0.0;
+		size_t numValues=0;
+		size_t numErrors=0;
+		try
+			{
+			for(unsigned int iteration=0;iteration<numIterations;++iteration)
+				{
+				std::vector<double> parsedValues;
+				parsedValues.reserve((*fIt)->getValues().size());
+				double start=getTime();
+				numValues=(*fIt)->parse(IO::openFile(&fileNameBuffer[0]),parsedValues);
+				double time=getTime()-start;
+				if(iteration==0||bestTime>time)
+					bestTime=time;
+				
+				/* Compare the parsed values against the C library's conversions: */
+				const std::vector<double>& values=(*fIt)->getValues();
+				numErrors=numValues>values.size()?numValues-values.size():values.size()-numValues;
+				for(size_t i=0;i<numValues&&i<values.size();++i)
+					if(parsedValues[i]!=values[i])
+						++numErrors;
+				}
+			}
+		catch(const std::runtime_error& err)
+			{
+			std::cerr<<"Error "<<err.what()<<" while parsing format "<<(*fIt)->getName()<<std::endl;
+			numErrors=~size_t(0);
+			}
+		unlink(&fileNameBuffer[0]);
+		
+		/* Print the results: */
+		std::cout<<std::setw(32)<<std::left<<(*fIt)->getName()<<std::right;
+		std::cout<<"  "<<std::setw(9)<<std::fixed<<std::setprecision(1)<<double(fileSize)/(1024.0*1024.0);
+		std::cout<<"  "<<std::setw(9)<<numValues;
+		std::cout<<"  "<<std::setw(17)<<std::setprecision(1)<<double(fileSize)/(bestTime*1024.0*1024.0);
+		std::cout<<"  "<<std::setw(6)<<numErrors<<std::endl;
+		if(numErrors!=0)
+			ok=false;
+		}
+	
+	/* Clean up: */
+	for(std::vector<Format*>::iterator fIt=formats.begin();fIt!=formats.end();++fIt)
+		delete *fIt;
+	
+	return ok?0:1;
+	}
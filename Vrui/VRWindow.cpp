@@ -81,6 +81,7 @@ Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
 #include <Images/WriteImageFile.h>
 #include <GLMotif/WidgetManager.h>
 #include <Vrui/Vrui.h>
+#include <Vrui/FrameProfiler.h>
 #include <Vrui/InputDeviceManager.h>
 #include <Vrui/Internal/InputDeviceAdapterMouse.h>
 #include <Vrui/Internal/InputDeviceAdapterMultitouch.h>
@@ -2217,6 +2218,8 @@ void VRWindow::requestScreenshot(const char* sScreenshotImageFileName)
 
 void VRWindow::draw(void)
 	{
+	FrameProfiler::Scope drawScope("VRWindow::draw");
+	
 	/* Update the window's display state: */
 	displayState->window=this;
 	displayState->windowIndex=windowIndex;
@@ -2241,7 +2244,14 @@ void VRWindow::draw(void)
 		}
 	
 	/* Update things in the window's GL context data: */
+	{
+	FrameProfiler::Scope updateThingsScope("UpdateThings");
 	getContextData().updateThings();
+	}
+	
+	/* Render another frame soon if some thing initializations had to be postponed: */
+	if(getContextData().hasDeferredThings())
+		requestUpdate();
 	
 	/* Determine whether it is currently possible to render into this window: */
 	bool canRender=enabled&&screens[0]->isEnabled()&&screens[1]->isEnabled()&&viewers[0]->isEnabled()&&viewers[1]->isEnabled();
@@ -2625,6 +2635,8 @@ void VRWindow::draw(void)
 
 void VRWindow::swapBuffers(void)
 	{
+	FrameProfiler::Scope swapBuffersScope("VRWindow::swapBuffers");
+	
 	/* Check if we need to do lens correction right before vsync: */
 	if(preSwapDelay>0.0f)
 		{
@@ -0,0 +1,369 @@
+/***********************************************************************
+ClusterStatisticsViewer - Vislet class to view live statistics of the
+intra-cluster communication of a cluster-based Vrui environment, for
+debugging and optimization purposes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/Vislets/ClusterStatisticsViewer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Misc/StandardValueCoders.h>
+#include <Misc/ConfigurationFile.h>
+#include <Misc/MessageLogger.h>
+#include <Math/Math.h>
+#include <GL/gl.h>
+#include <GL/GLColor.h>
+#include <GL/GLColorTemplates.h>
+#include <GL/GLFont.h>
+#include <Vrui/Vrui.h>
+#include <Vrui/VisletManager.h>
+#include <Vrui/DisplayState.h>
+
+namespace Vrui {
+
+namespace Vislets {
+
+/***********************************************
+Methods of class ClusterStatisticsViewerFactory:
+***********************************************/
+
+ClusterStatisticsViewerFactory::ClusterStatisticsViewerFactory(VisletManager& visletManager)
+	:VisletFactory("ClusterStatisticsViewer",visletManager),
+	 updateInterval(1.0),
+	 fontName("HelveticaMediumUpright")
+	{
+	/* Load class settings: */
+	Misc::ConfigurationFileSection cfs=visletManager.getVisletClassSection(getClassName());
+	
+	updateInterval=cfs.retrieveValue<double>("./updateInterval",updateInterval);
+	fontName=cfs.retrieveString("./fontName",fontName);
+	
+	/* Set vislet class' factory pointer: */
+	ClusterStatisticsViewer::factory=this;
+	}
+
+ClusterStatisticsViewerFactory::~ClusterStatisticsViewerFactory(void)
+	{
+	/* Reset vislet class' factory pointer: */
+	ClusterStatisticsViewer::factory=0;
+	}
+
+Vislet* ClusterStatisticsViewerFactory::createVislet(int numArguments,const char* const arguments[]) const
+	{
+	return new ClusterStatisticsViewer(numArguments,arguments);
+	}
+
+void ClusterStatisticsViewerFactory::destroyVislet(Vislet* vislet) const
+	{
+	delete vislet;
+	}
+
+extern "C" void resolveClusterStatisticsViewerDependencies(Plugins::FactoryManager<VisletFactory>& manager)
+	{
+	}
+
+extern "C" VisletFactory* createClusterStatisticsViewerFactory(Plugins::FactoryManager<VisletFactory>& manager)
+	{
+	/* Get pointer to vislet manager: */
+	VisletManager* visletManager=static_cast<VisletManager*>(&manager);
+	
+	/* Create factory object and insert it into class hierarchy: */
+	ClusterStatisticsViewerFactory* factory=new ClusterStatisticsViewerFactory(*visletManager);
+	
+	/* Return factory object: */
+	return factory;
+	}
+
+extern "C" void destroyClusterStatisticsViewerFactory(VisletFactory* factory)
+	{
+	delete factory;
+	}
+
+/************************************************
+Static elements of class ClusterStatisticsViewer:
+************************************************/
+
+ClusterStatisticsViewerFactory* ClusterStatisticsViewer::factory=0;
+
+/****************************************
+Methods of class ClusterStatisticsViewer:
+****************************************/
+
+void ClusterStatisticsViewer::updateStatistics(double interval)
+	{
+	Cluster::Multiplexer* multiplexer=getClusterMultiplexer();
+	lines.clear();
+	slowestSlaveLine=0;
+	for(unsigned int i=0;i<Cluster::Multiplexer::numWaitTimeBins;++i)
+		waitBins[i]=0;
+	char line[256];
+	
+	if(multiplexer==0)
+		{
+		lines.push_back("Not running in cluster mode");
+		slowestSlaveLine=lines.size();
+		return;
+		}
+	
+	/* Calculate the node's traffic during the update interval: */
+	Cluster::Multiplexer::TrafficStatistics ts=multiplexer->getTrafficStatistics();
+	Cluster::Multiplexer::TrafficStatistics& lts=lastTrafficStatistics;
+	double rate=interval>0.0?1.0/interval:0.0;
+	snprintf(line,sizeof(line),"Node %u of %u",multiplexer->getNodeIndex(),multiplexer->getNumNodes());
+	lines.push_back(line);
+	if(multiplexer->isMaster())
+		{
+		snprintf(line,sizeof(line),"Sent %.0f packets/s, %.3f MB/s",double(ts.numSentPackets-lts.numSentPackets)*rate,double(ts.numSentBytes-lts.numSentBytes)*rate/(1024.0*1024.0));
+		lines.push_back(line);
+		snprintf(line,sizeof(line),"Re-sent %.0f packets/s, %.3f MB/s",double(ts.numResentPackets-lts.numResentPackets)*rate,double(ts.numResentBytes-lts.numResentBytes)*rate/(1024.0*1024.0));
+		lines.push_back(line);
+		}
+	else
+		{
+		snprintf(line,sizeof(line),"Received %.0f packets/s, %.3f MB/s",double(ts.numReceivedPackets-lts.numReceivedPackets)*rate,double(ts.numReceivedBytes-lts.numReceivedBytes)*rate/(1024.0*1024.0));
+		lines.push_back(line);
+		snprintf(line,sizeof(line),"Recovered %.0f packets/s, reported %.0f losses/s",double(ts.numRecoveredPackets-lts.numRecoveredPackets)*rate,double(ts.numLossNacks-lts.numLossNacks)*rate);
+		lines.push_back(line);
+		}
+	
+	/* Calculate the barrier and gather waits during the update interval: */
+	const WaitTimeHistogram* waits[2]={&ts.barrierWaits,&ts.gatherWaits};
+	const WaitTimeHistogram* lastWaits[2]={&lts.barrierWaits,&lts.gatherWaits};
+	const char* waitNames[2]={"Barriers","Gathers"};
+	for(int i=0;i<2;++i)
+		{
+		size_t numWaits=waits[i]->numWaits-lastWaits[i]->numWaits;
+		double waitTime=waits[i]->totalWaitTime-lastWaits[i]->totalWaitTime;
+		snprintf(line,sizeof(line),"%s: %.0f/s, average wait %.3f ms",waitNames[i],double(numWaits)*rate,numWaits>0?waitTime*1000.0/double(numWaits):0.0);
+		lines.push_back(line);
+		for(unsigned int bin=0;bin<Cluster::Multiplexer::numWaitTimeBins;++bin)
+			waitBins[bin]+=waits[i]->bins[bin]-lastWaits[i]->bins[bin];
+		}
+	lastTrafficStatistics=ts;
+	
+	slowestSlaveLine=lines.size();
+	if(multiplexer->isMaster())
+		{
+		/* Calculate the slaves' health during the update interval and find the slave that held up the most barriers: */
+		unsigned int numSlaves=multiplexer->getNumNodes()-1;
+		lastSlaveStatistics.resize(numSlaves);
+		size_t maxNumLastArrivals=0;
+		for(unsigned int i=0;i<numSlaves;++i)
+			{
+			Cluster::Multiplexer::SlaveStatistics ss=multiplexer->getSlaveStatistics(i+1);
+			size_t numLastArrivals=ss.numLastArrivals-lastSlaveStatistics[i].numLastArrivals;
+			snprintf(line,sizeof(line),"Slave %u: %.0f losses/s, last at %.0f barriers/s, %u bytes behind",i+1,double(ss.numLossNacks-lastSlaveStatistics[i].numLossNacks)*rate,double(numLastArrivals)*rate,ss.maxStreamLag);
+			if(maxNumLastArrivals<numLastArrivals)
+				{
+				slowestSlaveLine=lines.size();
+				maxNumLastArrivals=numLastArrivals;
+				}
+			lines.push_back(line);
+			lastSlaveStatistics[i]=ss;
+			}
+		if(maxNumLastArrivals==0)
+			slowestSlaveLine=lines.size();
+		}
+	}
+
+ClusterStatisticsViewer::ClusterStatisticsViewer(int numArguments,const char* const arguments[])
+	:updateInterval(factory->updateInterval),lastUpdateTime(0.0),
+	 slowestSlaveLine(0),
+	 font(0)
+	{
+	/* Parse the command line: */
+	for(int i=0;i<numArguments;++i)
+		{
+		if(arguments[i][0]=='-')
+			{
+			if(strcasecmp(arguments[i]+1,"ui")==0||strcasecmp(arguments[i]+1,"updateInterval")==0)
+				{
+				++i;
+				if(i<numArguments)
+					updateInterval=atof(arguments[i]);
+				else
+					Misc::formattedConsoleError("ClusterStatisticsViewer: Ignoring dangling %s option",arguments[i-1]);
+				}
+			else
+				Misc::formattedConsoleError("ClusterStatisticsViewer: Ignoring unknown %s option",arguments[i]);
+			}
+		else
+			Misc::formattedConsoleError("ClusterStatisticsViewer: Ignoring unknown %s parameter",arguments[i]);
+		}
+	if(updateInterval<0.1)
+		updateInterval=0.1;
+	
+	/* Initialize the wait time histogram: */
+	for(unsigned int i=0;i<Cluster::Multiplexer::numWaitTimeBins;++i)
+		waitBins[i]=0;
+	
+	/* Load the font and set it up for rendering in pixel coordinates: */
+	font=loadFont(factory->fontName.c_str());
+	font->setTextHeight(12.0f);
+	font->setHAlignment(GLFont::Left);
+	font->setVAlignment(GLFont::VCenter);
+	font->setAntialiasing(true);
+	}
+
+ClusterStatisticsViewer::~ClusterStatisticsViewer(void)
+	{
+	delete font;
+	}
+
+VisletFactory* ClusterStatisticsViewer::getFactory(void) const
+	{
+	return factory;
+	}
+
+void ClusterStatisticsViewer::enable(bool startup)
+	{
+	/* Start measuring from the multiplexer's current statistics: */
+	Cluster::Multiplexer* multiplexer=getClusterMultiplexer();
+	if(multiplexer!=0)
+		{
+		lastTrafficStatistics=multiplexer->getTrafficStatistics();
+		lastSlaveStatistics.clear();
+		if(multiplexer->isMaster())
+			for(unsigned int i=1;i<multiplexer->getNumNodes();++i)
+				lastSlaveStatistics.push_back(multiplexer->getSlaveStatistics(i));
+		}
+	lastUpdateTime=getApplicationTime();
+	updateStatistics(0.0);
+	
+	/* Call the base class method: */
+	Vislet::enable(startup);
+	}
+
+void ClusterStatisticsViewer::disable(bool shutdown)
+	{
+	lines.clear();
+	
+	/* Call the base class method: */
+	Vislet::disable(shutdown);
+	}
+
+void ClusterStatisticsViewer::frame(void)
+	{
+	/* Update the statistics periodically: */
+	double now=getApplicationTime();
+	if(now-lastUpdateTime>=updateInterval)
+		{
+		updateStatistics(now-lastUpdateTime);
+		lastUpdateTime=now;
+		}
+	
+	/* Keep updating: */
+	scheduleUpdate(lastUpdateTime+updateInterval);
+	}
+
+void ClusterStatisticsViewer::display(GLContextData& contextData) const
+	{
+	if(lines.empty())
+		return;
+	
+	/* Get the viewport size of the current window: */
+	const DisplayState& ds=getDisplayState(contextData);
+	
+	/* Set up OpenGL state: */
+	glPushAttrib(GL_ENABLE_BIT|GL_LINE_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glLineWidth(1.0f);
+	
+	/* Go to pixel coordinates: */
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0.0,ds.viewport[2],0.0,ds.viewport[3],0.0,1.0);
+	
+	/* Get display colors: */
+	Color bg=getBackgroundColor();
+	Color fg=getForegroundColor();
+	Color mid(Math::mid(bg[0],fg[0]),Math::mid(bg[1],fg[1]),Math::mid(bg[2],fg[2]));
+	Color highlight(1.0f,0.25f,0.25f);
+	
+	/* Draw the statistics text, highlighting the slowest slave: */
+	double rowHeight=double(font->getTextHeight())*1.5;
+	double x0=double(ds.viewport[2])*0.05;
+	double y=double(ds.viewport[3])*0.95-rowHeight*0.5;
+	font->setBackgroundColor(bg);
+	for(unsigned int i=0;i<lines.size();++i,y-=rowHeight)
+		{
+		font->setForegroundColor(i==slowestSlaveLine?highlight:fg);
+		font->drawString(GLFont::Vector(GLfloat(x0),GLfloat(y),0.0f),lines[i].c_str());
+		}
+	
+	/* Find the largest histogram bin: */
+	size_t maxBin=0;
+	for(unsigned int i=0;i<Cluster::Multiplexer::numWaitTimeBins;++i)
+		if(maxBin<waitBins[i])
+			maxBin=waitBins[i];
+	if(maxBin>0)
+		{
+		/* Draw the wait time histogram below the text, one bar per bin: */
+		double barWidth=double(ds.viewport[2])*0.4/double(Cluster::Multiplexer::numWaitTimeBins);
+		double histHeight=rowHeight*4.0;
+		double yBottom=y-histHeight;
+		glBegin(GL_QUADS);
+		glColor(fg);
+		for(unsigned int i=0;i<Cluster::Multiplexer::numWaitTimeBins;++i)
+			{
+			double x=x0+double(i)*barWidth;
+			double h=histHeight*double(waitBins[i])/double(maxBin);
+			glVertex2d(x+1.0,yBottom);
+			glVertex2d(x+barWidth-1.0,yBottom);
+			glVertex2d(x+barWidth-1.0,yBottom+h);
+			glVertex2d(x+1.0,yBottom+h);
+			}
+		glEnd();
+		
+		/* Draw the histogram's baseline: */
+		glBegin(GL_LINES);
+		glColor(mid);
+		glVertex2d(x0,yBottom);
+		glVertex2d(x0+double(Cluster::Multiplexer::numWaitTimeBins)*barWidth,yBottom);
+		glEnd();
+		
+		/* Label the histogram's range: */
+		char label[64];
+		font->setForegroundColor(fg);
+		snprintf(label,sizeof(label),"%.3f ms",Cluster::Multiplexer::WaitTimeHistogram::getBinLimit(0)*1000.0);
+		font->drawString(GLFont::Vector(GLfloat(x0),GLfloat(yBottom-rowHeight*0.5),0.0f),label);
+		snprintf(label,sizeof(label),"%.0f ms",Cluster::Multiplexer::WaitTimeHistogram::getBinLimit(Cluster::Multiplexer::numWaitTimeBins-2)*1000.0);
+		font->drawString(GLFont::Vector(GLfloat(x0+double(Cluster::Multiplexer::numWaitTimeBins-1)*barWidth),GLfloat(yBottom-rowHeight*0.5),0.0f),label);
+		}
+	
+	/* Restore OpenGL state: */
+	glPopAttrib();
+	
+	/* Return to physical coordinates: */
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	}
+
+}
+
+}
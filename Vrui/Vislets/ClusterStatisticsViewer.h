@@ -0,0 +1,100 @@
+/***********************************************************************
+ClusterStatisticsViewer - Vislet class to view live statistics of the
+intra-cluster communication of a cluster-based Vrui environment, for
+debugging and optimization purposes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_VISLETS_CLUSTERSTATISTICSVIEWER_INCLUDED
+#define VRUI_VISLETS_CLUSTERSTATISTICSVIEWER_INCLUDED
+
+#include <string>
+#include <vector>
+#include <Cluster/Multiplexer.h>
+#include <Vrui/Vislet.h>
+
+/* Forward declarations: */
+class GLFont;
+
+namespace Vrui {
+
+namespace Vislets {
+
+class ClusterStatisticsViewer;
+
+class ClusterStatisticsViewerFactory:public Vrui::VisletFactory
+	{
+	friend class ClusterStatisticsViewer;
+	
+	/* Elements: */
+	double updateInterval; // Default time between statistics updates in seconds
+	std::string fontName; // Name of the font used to display the statistics
+	
+	/* Constructors and destructors: */
+	public:
+	ClusterStatisticsViewerFactory(Vrui::VisletManager& visletManager);
+	virtual ~ClusterStatisticsViewerFactory(void);
+	
+	/* Methods from VisletFactory: */
+	virtual Vislet* createVislet(int numVisletArguments,const char* const visletArguments[]) const;
+	virtual void destroyVislet(Vislet* vislet) const;
+	};
+
+class ClusterStatisticsViewer:public Vrui::Vislet
+	{
+	friend class ClusterStatisticsViewerFactory;
+	
+	/* Embedded classes: */
+	private:
+	typedef Cluster::Multiplexer::WaitTimeHistogram WaitTimeHistogram;
+	
+	/* Elements: */
+	static ClusterStatisticsViewerFactory* factory; // Pointer to the factory object for this class
+	double updateInterval; // Time between statistics updates in seconds
+	double lastUpdateTime; // Application time of the most recent statistics update
+	Cluster::Multiplexer::TrafficStatistics lastTrafficStatistics; // Traffic statistics at the most recent update
+	std::vector<Cluster::Multiplexer::SlaveStatistics> lastSlaveStatistics; // Slave health statistics at the most recent update (master only)
+	std::vector<std::string> lines; // Lines of text describing the statistics of the most recent update interval
+	unsigned int slowestSlaveLine; // Index of the text line describing the slowest slave, or number of lines if there is none
+	size_t waitBins[Cluster::Multiplexer::numWaitTimeBins]; // Histogram of barrier and gather wait times during the most recent update interval
+	GLFont* font; // Font to display the statistics
+	
+	/* Private methods: */
+	void updateStatistics(double interval); // Updates the displayed statistics from the multiplexer's current statistics
+	
+	/* Constructors and destructors: */
+	public:
+	ClusterStatisticsViewer(int numArguments,const char* const arguments[]);
+	virtual ~ClusterStatisticsViewer(void);
+	
+	/* Methods from Vislet: */
+	public:
+	virtual VisletFactory* getFactory(void) const;
+	virtual void enable(bool startup);
+	virtual void disable(bool shutdown);
+	virtual void frame(void);
+	virtual void display(GLContextData& contextData) const;
+	};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,295 @@
+/***********************************************************************
+FrameProfilerViewer - Vislet class to view a live histogram of the
+durations of the phases of recent Vrui frames, as recorded by the frame
+profiler, for debugging and optimization purposes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#include <Vrui/Vislets/FrameProfilerViewer.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <Misc/StandardValueCoders.h>
+#include <Misc/ConfigurationFile.h>
+#include <Misc/MessageLogger.h>
+#include <Math/Math.h>
+#include <GL/gl.h>
+#include <GL/GLColor.h>
+#include <GL/GLColorTemplates.h>
+#include <GL/GLFont.h>
+#include <Vrui/Vrui.h>
+#include <Vrui/VisletManager.h>
+#include <Vrui/DisplayState.h>
+
+namespace Vrui {
+
+namespace Vislets {
+
+/*******************************************
+Methods of class FrameProfilerViewerFactory:
+*******************************************/
+
+FrameProfilerViewerFactory::FrameProfilerViewerFactory(VisletManager& visletManager)
+	:VisletFactory("FrameProfilerViewer",visletManager),
+	 numFrames(60),updateInterval(10),
+	 fontName("HelveticaMediumUpright")
+	{
+	/* Load class settings: */
+	Misc::ConfigurationFileSection cfs=visletManager.getVisletClassSection(getClassName());
+	
+	numFrames=cfs.retrieveValue<unsigned int>("./numFrames",numFrames);
+	updateInterval=cfs.retrieveValue<unsigned int>("./updateInterval",updateInterval);
+	fontName=cfs.retrieveString("./fontName",fontName);
+	
+	/* Set vislet class' factory pointer: */
+	FrameProfilerViewer::factory=this;
+	}
+
+FrameProfilerViewerFactory::~FrameProfilerViewerFactory(void)
+	{
+	/* Reset vislet class' factory pointer: */
+	FrameProfilerViewer::factory=0;
+	}
+
+Vislet* FrameProfilerViewerFactory::createVislet(int numArguments,const char* const arguments[]) const
+	{
+	return new FrameProfilerViewer(numArguments,arguments);
+	}
+
+void FrameProfilerViewerFactory::destroyVislet(Vislet* vislet) const
+	{
+	delete vislet;
+	}
+
+extern "C" void resolveFrameProfilerViewerDependencies(Plugins::FactoryManager<VisletFactory>& manager)
+	{
+	}
+
+extern "C" VisletFactory* createFrameProfilerViewerFactory(Plugins::FactoryManager<VisletFactory>& manager)
+	{
+	/* Get pointer to vislet manager: */
+	VisletManager* visletManager=static_cast<VisletManager*>(&manager);
+	
+	/* Create factory object and insert it into class hierarchy: */
+	FrameProfilerViewerFactory* factory=new FrameProfilerViewerFactory(*visletManager);
+	
+	/* Return factory object: */
+	return factory;
+	}
+
+extern "C" void destroyFrameProfilerViewerFactory(VisletFactory* factory)
+	{
+	delete factory;
+	}
+
+/********************************************
+Static elements of class FrameProfilerViewer:
+********************************************/
+
+FrameProfilerViewerFactory* FrameProfilerViewer::factory=0;
+
+/************************************
+Methods of class FrameProfilerViewer:
+************************************/
+
+FrameProfilerViewer::FrameProfilerViewer(int numArguments,const char* const arguments[])
+	:numFrames(factory->numFrames),updateInterval(factory->updateInterval),framesToUpdate(0),
+	 profilerWasEnabled(false),
+	 font(0),
+	 numberRenderer(12.0f,false)
+	{
+	/* Parse the command line: */
+	for(int i=0;i<numArguments;++i)
+		{
+		if(arguments[i][0]=='-')
+			{
+			if(strcasecmp(arguments[i]+1,"nf")==0||strcasecmp(arguments[i]+1,"numFrames")==0)
+				{
+				++i;
+				if(i<numArguments)
+					numFrames=atoi(arguments[i]);
+				else
+					Misc::formattedConsoleError("FrameProfilerViewer: Ignoring dangling %s option",arguments[i-1]);
+				}
+			else if(strcasecmp(arguments[i]+1,"ui")==0||strcasecmp(arguments[i]+1,"updateInterval")==0)
+				{
+				++i;
+				if(i<numArguments)
+					updateInterval=atoi(arguments[i]);
+				else
+					Misc::formattedConsoleError("FrameProfilerViewer: Ignoring dangling %s option",arguments[i-1]);
+				}
+			else
+				Misc::formattedConsoleError("FrameProfilerViewer: Ignoring unknown %s option",arguments[i]);
+			}
+		else
+			Misc::formattedConsoleError("FrameProfilerViewer: Ignoring unknown %s parameter",arguments[i]);
+		}
+	if(numFrames<1)
+		numFrames=1;
+	if(updateInterval<1)
+		updateInterval=1;
+	
+	/* Load the label font and set it up for rendering in pixel coordinates: */
+	font=loadFont(factory->fontName.c_str());
+	font->setTextHeight(12.0f);
+	font->setHAlignment(GLFont::Right);
+	font->setVAlignment(GLFont::VCenter);
+	font->setAntialiasing(true);
+	}
+
+FrameProfilerViewer::~FrameProfilerViewer(void)
+	{
+	delete font;
+	}
+
+VisletFactory* FrameProfilerViewer::getFactory(void) const
+	{
+	return factory;
+	}
+
+void FrameProfilerViewer::enable(bool startup)
+	{
+	/* Start recording frame phases: */
+	profilerWasEnabled=FrameProfiler::isEnabled();
+	FrameProfiler::setEnabled(true);
+	framesToUpdate=0;
+	
+	/* Call the base class method: */
+	Vislet::enable(startup);
+	}
+
+void FrameProfilerViewer::disable(bool shutdown)
+	{
+	/* Stop recording frame phases unless they were recorded before: */
+	FrameProfiler::setEnabled(profilerWasEnabled);
+	statistics.clear();
+	
+	/* Call the base class method: */
+	Vislet::disable(shutdown);
+	}
+
+void FrameProfilerViewer::frame(void)
+	{
+	/* Update the phase statistics periodically: */
+	if(framesToUpdate==0)
+		{
+		FrameProfiler::getPhaseStatistics(numFrames,statistics);
+		framesToUpdate=updateInterval;
+		}
+	--framesToUpdate;
+	}
+
+void FrameProfilerViewer::display(GLContextData& contextData) const
+	{
+	if(statistics.empty())
+		return;
+	
+	/* Get the viewport size of the current window: */
+	const DisplayState& ds=getDisplayState(contextData);
+	
+	/* Set up OpenGL state: */
+	glPushAttrib(GL_ENABLE_BIT|GL_LINE_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glLineWidth(1.0f);
+	
+	/* Go to pixel coordinates: */
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0.0,ds.viewport[2],0.0,ds.viewport[3],0.0,1.0);
+	
+	/* Get graph colors: */
+	Color bg=getBackgroundColor();
+	Color fg=getForegroundColor();
+	Color mid(Math::mid(bg[0],fg[0]),Math::mid(bg[1],fg[1]),Math::mid(bg[2],fg[2]));
+	
+	/* Find the closest power of ten above the maximum phase duration: */
+	double maxDuration=0.0;
+	for(FrameProfiler::PhaseStatisticsList::const_iterator sIt=statistics.begin();sIt!=statistics.end();++sIt)
+		if(maxDuration<sIt->max)
+			maxDuration=sIt->max;
+	double top=maxDuration>0.0?Math::pow(10.0,Math::ceil(Math::log10(maxDuration))):1.0e-3;
+	
+	/* Calculate histogram layout: */
+	double rowHeight=double(font->getTextHeight())*1.5;
+	double x0=double(ds.viewport[2])*0.2;
+	double xs=double(ds.viewport[2])*0.6/top;
+	double y0=double(ds.viewport[3])*0.95-rowHeight*0.5;
+	
+	/* Draw a grid at tenths of the scale: */
+	double yBottom=y0-double(statistics.size()-1)*rowHeight-rowHeight*0.5;
+	glBegin(GL_LINES);
+	glColor(mid);
+	for(int i=0;i<=10;++i)
+		{
+		double x=x0+top*double(i)/10.0*xs;
+		glVertex2d(x,yBottom);
+		glVertex2d(x,y0+rowHeight*0.5);
+		}
+	glEnd();
+	numberRenderer.drawNumber(GLNumberRenderer::Vector(x0+top*xs,yBottom-2.0,0.0),top*1000.0,2,contextData,0,1);
+	
+	/* Draw one histogram row per phase: */
+	font->setBackgroundColor(bg);
+	font->setForegroundColor(fg);
+	double y=y0;
+	for(FrameProfiler::PhaseStatisticsList::const_iterator sIt=statistics.begin();sIt!=statistics.end();++sIt,y-=rowHeight)
+		{
+		/* Draw the phase's name: */
+		font->drawString(GLFont::Vector(GLfloat(x0-10.0),GLfloat(y),0.0f),sIt->phase);
+		
+		/* Draw a bar for the phase's average duration: */
+		double h=rowHeight*0.3;
+		glBegin(GL_QUADS);
+		glColor(fg);
+		glVertex2d(x0,y-h);
+		glVertex2d(x0+sIt->average*xs,y-h);
+		glVertex2d(x0+sIt->average*xs,y+h);
+		glVertex2d(x0,y+h);
+		glEnd();
+		
+		/* Draw a marker for the phase's maximum duration: */
+		glBegin(GL_LINES);
+		glVertex2d(x0+sIt->average*xs,y);
+		glVertex2d(x0+sIt->max*xs,y);
+		glVertex2d(x0+sIt->max*xs,y-h);
+		glVertex2d(x0+sIt->max*xs,y+h);
+		glEnd();
+		
+		/* Label the bar with the phase's average duration in milliseconds: */
+		numberRenderer.drawNumber(GLNumberRenderer::Vector(x0+sIt->max*xs+5.0,y,0.0),sIt->average*1000.0,2,contextData,-1,0);
+		}
+	
+	/* Restore OpenGL state: */
+	glPopAttrib();
+	
+	/* Return to physical coordinates: */
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	}
+
+}
+
+}
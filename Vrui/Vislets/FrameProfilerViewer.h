@@ -0,0 +1,94 @@
+/***********************************************************************
+FrameProfilerViewer - Vislet class to view a live histogram of the
+durations of the phases of recent Vrui frames, as recorded by the frame
+profiler, for debugging and optimization purposes.
+Copyright (c) 2020 Oliver Kreylos
+
+This file is part of the Virtual Reality User Interface Library (Vrui).
+
+The Virtual Reality User Interface Library is free software; you can
+redistribute it and/or modify it under the terms of the GNU General
+Public License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+The Virtual Reality User Interface Library is distributed in the hope
+that it will be useful, but WITHOUT ANY WARRANTY; without even the
+implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with the Virtual Reality User Interface Library; if not, write to the
+Free Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+02111-1307 USA
+***********************************************************************/
+
+#ifndef VRUI_VISLETS_FRAMEPROFILERVIEWER_INCLUDED
+#define VRUI_VISLETS_FRAMEPROFILERVIEWER_INCLUDED
+
+#include <string>
+#include <GL/GLNumberRenderer.h>
+#include <Vrui/Vislet.h>
+#include <Vrui/FrameProfiler.h>
+
+/* Forward declarations: */
+class GLFont;
+
+namespace Vrui {
+
+namespace Vislets {
+
+class FrameProfilerViewer;
+
+class FrameProfilerViewerFactory:public Vrui::VisletFactory
+	{
+	friend class FrameProfilerViewer;
+	
+	/* Elements: */
+	unsigned int numFrames; // Default number of recent frames summarized in the histogram
+	unsigned int updateInterval; // Default number of frames between histogram updates
+	std::string fontName; // Name of the font used to label the histogram
+	
+	/* Constructors and destructors: */
+	public:
+	FrameProfilerViewerFactory(Vrui::VisletManager& visletManager);
+	virtual ~FrameProfilerViewerFactory(void);
+	
+	/* Methods from VisletFactory: */
+	virtual Vislet* createVislet(int numVisletArguments,const char* const visletArguments[]) const;
+	virtual void destroyVislet(Vislet* vislet) const;
+	};
+
+class FrameProfilerViewer:public Vrui::Vislet
+	{
+	friend class FrameProfilerViewerFactory;
+	
+	/* Elements: */
+	private:
+	static FrameProfilerViewerFactory* factory; // Pointer to the factory object for this class
+	unsigned int numFrames; // Number of recent frames summarized in the histogram
+	unsigned int updateInterval; // Number of frames between histogram updates
+	unsigned int framesToUpdate; // Number of frames until the next histogram update
+	bool profilerWasEnabled; // Flag whether the frame profiler was enabled before this vislet was enabled
+	FrameProfiler::PhaseStatisticsList statistics; // Most recent per-phase statistics
+	GLFont* font; // Font to label the histogram
+	GLNumberRenderer numberRenderer; // Helper object to draw numbers
+	
+	/* Constructors and destructors: */
+	public:
+	FrameProfilerViewer(int numArguments,const char* const arguments[]);
+	virtual ~FrameProfilerViewer(void);
+	
+	/* Methods from Vislet: */
+	public:
+	virtual VisletFactory* getFactory(void) const;
+	virtual void enable(bool startup);
+	virtual void disable(bool shutdown);
+	virtual void frame(void);
+	virtual void display(GLContextData& contextData) const;
+	};
+
+}
+
+}
+
+#endif
@@ -202,7 +202,7 @@ bool isMaster(void); // Returns true if the multipipe node the caller is running
 int getNodeIndex(void); // Returns index of the multipipe node the caller is running on (0: master node)
 int getNumNodes(void); // Returns number of multipipe nodes, including master
 Cluster::MulticastPipe* getMainPipe(void); // Returns Vrui's main frame pipe; safe to use inside frame function, user must call finishMessage() when done (returns 0 if called in a non-cluster environment)
-Cluster::MulticastPipe* openPipe(void); // Opens a pipe for 1-to-n communication from master to all slaves (returns 0 if called in a non-cluster environment)
+Cluster::MulticastPipe* openPipe(bool compressed =false); // Opens a pipe for 1-to-n communication from master to all slaves, optionally compressing the sent data (returns 0 if called in a non-cluster environment)
 
 /* Manage glyph rendering: */
 GlyphRenderer* getGlyphRenderer(void); // Returns pointer to the glyph renderer